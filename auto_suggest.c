@@ -44,19 +44,25 @@ void generate_suggestions(AppData *app, const char *input) {
             }
         }
         
-        // Suggest matching commands from history
-        for (int i = app->history_count - 1; i >= 0 && app->suggestion_count < MAX_SUGGESTIONS; i--) {
-            if (strncmp(app->command_history[i], input, strlen(input)) == 0) {
+        // Suggest matching commands from recent history
+        gsize input_len = strlen(input);
+        guint count = history_store_count(app->history);
+        guint oldest = count > MAX_HISTORY_SUGGESTION_SCAN ? count - MAX_HISTORY_SUGGESTION_SCAN : 0;
+        for (guint i = count; i > oldest && app->suggestion_count < MAX_SUGGESTIONS; i--) {
+            gsize length;
+            const char *entry = history_store_peek(app->history, i - 1, &length);
+            if (entry && length >= input_len && strncmp(entry, input, input_len) == 0) {
                 // Check if not already in suggestions
                 gboolean already_exists = FALSE;
                 for (int j = 0; j < app->suggestion_count; j++) {
-                    if (strcmp(app->suggestions[j], app->command_history[i]) == 0) {
+                    if (strlen(app->suggestions[j]) == length &&
+                        strncmp(app->suggestions[j], entry, length) == 0) {
                         already_exists = TRUE;
                         break;
                     }
                 }
                 if (!already_exists) {
-                    app->suggestions[app->suggestion_count++] = g_strdup(app->command_history[i]);
+                    app->suggestions[app->suggestion_count++] = g_strndup(entry, length);
                 }
             }
         }
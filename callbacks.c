@@ -3,13 +3,21 @@
 
 void on_run_clicked(GtkButton *button, gpointer user_data) {
     AppData *app = user_data;
-    const char *command = gtk_entry_get_text(GTK_ENTRY(app->entry));
+    // Copied: dialogs opened by the command run a nested main loop
+    char *command = g_strdup(gtk_entry_get_text(GTK_ENTRY(app->entry)));
     
-    if (strlen(command) == 0) return;
+    if (strlen(command) == 0) {
+        g_free(command);
+        return;
+    }
     
     hide_suggestions(app);
     
-    add_to_history(app, command);
+    HistoryRecord record = { 0 };
+    char *cwd = g_get_current_dir();
+    record.cwd = cwd;
+    record.start_time = g_get_real_time() / G_USEC_PER_SEC;
+    gint64 started = g_get_monotonic_time();
     
     GtkTextIter iter;
     gtk_text_buffer_get_end_iter(app->buffer, &iter);
@@ -44,6 +52,15 @@ void on_run_clicked(GtkButton *button, gpointer user_data) {
     
     execute_command(app, command, app->buffer, app->textview);
     
+    // Recorded once finished so the entry carries its outcome
+    gint64 elapsed_ms = (g_get_monotonic_time() - started) / 1000;
+    record.duration_ms = MIN(elapsed_ms, G_MAXUINT32);
+    record.exit_status = app->last_exit_status;
+    record.output_bytes = app->last_output_bytes;
+    add_to_history(app, command, &record);
+    g_free(cwd);
+    g_free(command);
+    
     gtk_text_buffer_get_end_iter(app->buffer, &iter);
     GtkTextMark *mark = gtk_text_buffer_create_mark(app->buffer, "end", &iter, FALSE);
     gtk_text_view_scroll_to_mark(GTK_TEXT_VIEW(app->textview), mark, 0.0, FALSE, 0.0, 0.0);
@@ -186,9 +203,113 @@ void on_voice_clicked(GtkButton *button, gpointer user_data) {
     g_thread_new("voice_recognition", voice_recognition_thread, app);
 }
 
+// Reverse history search (Ctrl+R), bash style: typing narrows the search,
+// Ctrl+R again finds the next older match, Enter runs it, Esc cancels
+static void update_reverse_search_label(AppData *app, gboolean failed) {
+    char *match = app->rsearch_match >= 0 ? history_store_dup(app->history, app->rsearch_match) : NULL;
+    char *text = g_strdup_printf("(%sreverse-i-search)`%s': %s", failed ? "failed " : "",
+                                 app->rsearch_query->str, match ? match : "");
+    gtk_label_set_text(GTK_LABEL(app->rsearch_label), text);
+    g_free(text);
+    g_free(match);
+}
+
+static void run_reverse_search(AppData *app, int before) {
+    int found = history_search_find(app->history_search, app->rsearch_query->str, before);
+    if (found >= 0) {
+        app->rsearch_match = found;
+        char *entry = history_store_dup(app->history, found);
+        gtk_entry_set_text(GTK_ENTRY(app->entry), entry ? entry : "");
+        gtk_editable_set_position(GTK_EDITABLE(app->entry), -1);
+        g_free(entry);
+    }
+    update_reverse_search_label(app, found < 0 && app->rsearch_query->len > 0);
+}
+
+static void start_reverse_search(AppData *app) {
+    hide_suggestions(app);
+    app->rsearch_active = TRUE;
+    app->rsearch_match = -1;
+    g_string_truncate(app->rsearch_query, 0);
+    g_free(app->rsearch_saved_text);
+    app->rsearch_saved_text = g_strdup(gtk_entry_get_text(GTK_ENTRY(app->entry)));
+    update_reverse_search_label(app, FALSE);
+    gtk_widget_show(app->rsearch_label);
+}
+
+static void end_reverse_search(AppData *app, gboolean restore) {
+    app->rsearch_active = FALSE;
+    gtk_widget_hide(app->rsearch_label);
+    if (restore && app->rsearch_saved_text) {
+        gtk_entry_set_text(GTK_ENTRY(app->entry), app->rsearch_saved_text);
+        gtk_editable_set_position(GTK_EDITABLE(app->entry), -1);
+    } else if (app->rsearch_match >= 0) {
+        // Up/Down continue from the accepted entry
+        app->history_index = app->rsearch_match;
+    }
+    g_free(app->rsearch_saved_text);
+    app->rsearch_saved_text = NULL;
+}
+
+// Returns TRUE when the key was consumed by the search
+static gboolean handle_reverse_search_key(AppData *app, GdkEventKey *event) {
+    gboolean ctrl = (event->state & GDK_CONTROL_MASK) != 0;
+    
+    if (event->keyval == GDK_KEY_Escape || (ctrl && event->keyval == GDK_KEY_g)) {
+        end_reverse_search(app, TRUE);
+        return TRUE;
+    }
+    
+    if (event->keyval == GDK_KEY_Return || event->keyval == GDK_KEY_KP_Enter) {
+        end_reverse_search(app, FALSE);
+        gtk_widget_activate(app->run_button);
+        return TRUE;
+    }
+    
+    if (event->keyval == GDK_KEY_BackSpace) {
+        if (app->rsearch_query->len > 0) {
+            const char *prev = g_utf8_find_prev_char(app->rsearch_query->str,
+                                                     app->rsearch_query->str + app->rsearch_query->len);
+            g_string_truncate(app->rsearch_query, prev ? prev - app->rsearch_query->str : 0);
+            app->rsearch_match = -1;
+            run_reverse_search(app, -1);
+        }
+        return TRUE;
+    }
+    
+    // Movement keys accept the match for editing and keep their usual meaning
+    if (event->keyval == GDK_KEY_Left || event->keyval == GDK_KEY_Right ||
+        event->keyval == GDK_KEY_Up || event->keyval == GDK_KEY_Down ||
+        event->keyval == GDK_KEY_Tab) {
+        end_reverse_search(app, FALSE);
+        return FALSE;
+    }
+    
+    gunichar c = gdk_keyval_to_unicode(event->keyval);
+    if (!ctrl && !(event->state & GDK_MOD1_MASK) && c != 0 && g_unichar_isprint(c)) {
+        g_string_append_unichar(app->rsearch_query, c);
+        // The current match stays selected while it still contains the query
+        run_reverse_search(app, app->rsearch_match >= 0 ? app->rsearch_match + 1 : -1);
+    }
+    return TRUE;
+}
+
 gboolean on_entry_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data) {
     AppData *app = user_data;
     
+    if ((event->state & GDK_CONTROL_MASK) && (event->keyval == GDK_KEY_r || event->keyval == GDK_KEY_R)) {
+        if (!app->rsearch_active) {
+            start_reverse_search(app);
+        } else if (app->rsearch_query->len > 0) {
+            run_reverse_search(app, app->rsearch_match);
+        }
+        return TRUE;
+    }
+    
+    if (app->rsearch_active && handle_reverse_search_key(app, event)) {
+        return TRUE;
+    }
+    
     if (event->keyval == GDK_KEY_Tab) {
         if (app->suggestion_count > 0) {
             apply_suggestion(app, app->selected_suggestion >= 0 ? app->selected_suggestion : 0);
@@ -217,17 +338,21 @@ gboolean on_entry_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user
             return TRUE;
         }
         // Otherwise, navigate command history
-        if (app->history_count == 0) return TRUE;
+        int count = history_store_count(app->history);
+        if (count == 0) return TRUE;
         
-        if (app->history_index < 0) {
-            app->history_index = app->history_count - 1;
-        } else if (app->history_index > 0) {
+        if (app->history_index < 0 || app->history_index > count) {
+            app->history_index = count;
+        }
+        if (app->history_index > 0) {
             app->history_index--;
         }
         
-        if (app->history_index >= 0 && app->history_index < app->history_count) {
-            gtk_entry_set_text(GTK_ENTRY(app->entry), app->command_history[app->history_index]);
+        char *entry = history_store_dup(app->history, app->history_index);
+        if (entry) {
+            gtk_entry_set_text(GTK_ENTRY(app->entry), entry);
             gtk_editable_set_position(GTK_EDITABLE(app->entry), -1);
+            g_free(entry);
         }
         return TRUE;
     }
@@ -247,6 +372,10 @@ gboolean on_entry_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user
 
 void on_entry_changed(GtkEditable *editable, gpointer user_data) {
     AppData *app = user_data;
+    
+    // Text set by reverse search should not pop up suggestions
+    if (app->rsearch_active) return;
+    
     const char *text = gtk_entry_get_text(GTK_ENTRY(app->entry));
     
     if (strlen(text) > 0) {
@@ -266,6 +395,45 @@ void on_window_destroy(GtkWidget *widget, gpointer user_data) {
     destroy_app_data(app_data);
 }
 
+// Refreshes the status line from the newest metrics sample
+#define STATUS_STALL_SECONDS 10     // how long a PSI stall stays on the status line
+
+gboolean update_status_label(gpointer user_data) {
+    AppData *app = user_data;
+    MetricsSample sample;
+    if (!metrics_sampler_latest(&sample)) return G_SOURCE_CONTINUE;
+
+    char *net_in = g_format_size((guint64)sample.net_rx_rate);
+    char *net_out = g_format_size((guint64)sample.net_tx_rate);
+    char *disk_read = g_format_size((guint64)sample.disk_read_rate);
+    char *disk_write = g_format_size((guint64)sample.disk_write_rate);
+    char text[256];
+    int length = snprintf(text, sizeof(text), "CPU %4.1f%%  Mem %4.1f%%  Net ↓%s/s ↑%s/s  Disk r %s/s w %s/s",
+                          sample.cpu_percent, sample.memory_percent, net_in, net_out, disk_read, disk_write);
+    // A PSI trigger fired recently
+    PsiStallEvent stall;
+    if (psi_monitor_latest_stall(&stall) &&
+        g_get_monotonic_time() - stall.timestamp < STATUS_STALL_SECONDS * G_USEC_PER_SEC &&
+        length < (int)sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, "  ⚠ %s stall (%s %.1f%%)",
+                 psi_resource_name(stall.resource), stall.full ? "full" : "some", stall.avg10);
+    }
+    gtk_label_set_text(GTK_LABEL(app->status_label), text);
+    g_free(net_in);
+    g_free(net_out);
+    g_free(disk_read);
+    g_free(disk_write);
+    return G_SOURCE_CONTINUE;
+}
+
+void on_status_label_destroy(GtkWidget *widget, gpointer user_data) {
+    AppData *app = user_data;
+    if (app->status_timer) {
+        g_source_remove(app->status_timer);
+        app->status_timer = 0;
+    }
+}
+
 // Network Information Menu Callback  
 void on_network_info_clicked(GtkMenuItem *menuitem, gpointer user_data) {
     AppData *app = (AppData *)user_data;
@@ -276,7 +444,7 @@ void on_network_info_clicked(GtkMenuItem *menuitem, gpointer user_data) {
                                                      "_Close", GTK_RESPONSE_CLOSE,
                                                      NULL);
     
-    gtk_window_set_default_size(GTK_WINDOW(dialog), 700, 600);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 900, 750);
     gtk_window_set_resizable(GTK_WINDOW(dialog), TRUE);
     
     GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
@@ -293,7 +461,7 @@ void on_network_info_clicked(GtkMenuItem *menuitem, gpointer user_data) {
                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     gtk_widget_set_hexpand(scrolled, TRUE);
     gtk_widget_set_vexpand(scrolled, TRUE);
-    gtk_widget_set_size_request(scrolled, 680, 550);
+    gtk_widget_set_size_request(scrolled, 680, 200);
     
     GtkWidget *textview = gtk_text_view_new();
     gtk_text_view_set_editable(GTK_TEXT_VIEW(textview), FALSE);
@@ -310,36 +478,13 @@ void on_network_info_clicked(GtkMenuItem *menuitem, gpointer user_data) {
     
     GtkTextBuffer *buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(textview));
     
-    // Build network information directly
-    char network_info[4096] = "";
-    strcat(network_info, "=== NETWORK INTERFACES ===\n\n");
+    // Live interface rates above, addresses below
+    GtkWidget *network_frame = gtk_frame_new("Interfaces");
+    gtk_widget_set_margin_bottom(network_frame, 10);
+    gtk_container_add(GTK_CONTAINER(network_frame), network_panel_new());
+    gtk_box_pack_start(GTK_BOX(content_area), network_frame, FALSE, FALSE, 0);
     
-    FILE *net_dev = fopen("/proc/net/dev", "r");
-    if (net_dev) {
-        char line[256];
-        // Skip header lines
-        fgets(line, sizeof(line), net_dev);
-        fgets(line, sizeof(line), net_dev);
-        
-        while (fgets(line, sizeof(line), net_dev)) {
-            char interface[16];
-            unsigned long rx_bytes, tx_bytes;
-            
-            if (sscanf(line, "%[^:]:%lu %*u %*u %*u %*u %*u %*u %*u %lu", 
-                      interface, &rx_bytes, &tx_bytes) >= 3) {
-                char temp[256];
-                snprintf(temp, sizeof(temp), "Interface: %s\n", interface);
-                strcat(network_info, temp);
-                snprintf(temp, sizeof(temp), "  RX: %lu KB (%lu MB)\n", 
-                        rx_bytes / 1024, rx_bytes / 1024 / 1024);
-                strcat(network_info, temp);
-                snprintf(temp, sizeof(temp), "  TX: %lu KB (%lu MB)\n\n", 
-                        tx_bytes / 1024, tx_bytes / 1024 / 1024);
-                strcat(network_info, temp);
-            }
-        }
-        fclose(net_dev);
-    }
+    char network_info[4096] = "";
     
     // Add IP information
     strcat(network_info, "=== IP INFORMATION ===\n\n");
@@ -362,6 +507,13 @@ void on_network_info_clicked(GtkMenuItem *menuitem, gpointer user_data) {
     gtk_widget_destroy(dialog);
 }
 
+void on_connections_clicked(GtkMenuItem *menuitem, gpointer user_data) {
+    AppData *app = user_data;
+    GtkWidget *dialog = create_socket_inspector_dialog(GTK_WINDOW(app->window));
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
 // Disk Usage Menu Callback
 void on_disk_usage_clicked(GtkMenuItem *menuitem, gpointer user_data) {
     AppData *app = (AppData *)user_data;
@@ -372,7 +524,7 @@ void on_disk_usage_clicked(GtkMenuItem *menuitem, gpointer user_data) {
                                                      "_Close", GTK_RESPONSE_CLOSE,
                                                      NULL);
     
-    gtk_window_set_default_size(GTK_WINDOW(dialog), 700, 600);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 900, 650);
     gtk_window_set_resizable(GTK_WINDOW(dialog), TRUE);
     
     GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
@@ -389,7 +541,7 @@ void on_disk_usage_clicked(GtkMenuItem *menuitem, gpointer user_data) {
                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     gtk_widget_set_hexpand(scrolled, TRUE);
     gtk_widget_set_vexpand(scrolled, TRUE);
-    gtk_widget_set_size_request(scrolled, 680, 550);
+    gtk_widget_set_size_request(scrolled, 680, 300);
     
     GtkWidget *textview = gtk_text_view_new();
     gtk_text_view_set_editable(GTK_TEXT_VIEW(textview), FALSE);
@@ -438,29 +590,6 @@ void on_disk_usage_clicked(GtkMenuItem *menuitem, gpointer user_data) {
         }
     }
     
-    // Add disk I/O statistics
-    strcat(disk_info, "=== DISK I/O STATISTICS ===\n\n");
-    FILE *diskstats = fopen("/proc/diskstats", "r");
-    if (diskstats) {
-        char line[256], device[32];
-        unsigned long reads, writes;
-        
-        while (fgets(line, sizeof(line), diskstats)) {
-            if (sscanf(line, "%*d %*d %s %lu %*u %*u %*u %lu", device, &reads, &writes) >= 3) {
-                if (strstr(device, "sd") || strstr(device, "nvme") || strstr(device, "hd")) {
-                    char temp[256];
-                    snprintf(temp, sizeof(temp), "Device: %s\n", device);
-                    strcat(disk_info, temp);
-                    snprintf(temp, sizeof(temp), "  Read Operations:  %lu\n", reads);
-                    strcat(disk_info, temp);
-                    snprintf(temp, sizeof(temp), "  Write Operations: %lu\n\n", writes);
-                    strcat(disk_info, temp);
-                }
-            }
-        }
-        fclose(diskstats);
-    }
-    
     // Add df command output for additional info
     strcat(disk_info, "=== DETAILED FILESYSTEM INFO ===\n\n");
     FILE *df_output = popen("df -h 2>/dev/null | head -10", "r");
@@ -477,6 +606,12 @@ void on_disk_usage_clicked(GtkMenuItem *menuitem, gpointer user_data) {
     gtk_container_add(GTK_CONTAINER(scrolled), textview);
     gtk_box_pack_start(GTK_BOX(content_area), scrolled, TRUE, TRUE, 0);
     
+    // Live disk I/O below the filesystem usage
+    GtkWidget *disk_frame = gtk_frame_new("Disk I/O");
+    gtk_widget_set_margin_top(disk_frame, 10);
+    gtk_container_add(GTK_CONTAINER(disk_frame), disk_panel_new());
+    gtk_box_pack_start(GTK_BOX(content_area), disk_frame, FALSE, FALSE, 0);
+    
     gtk_widget_show_all(dialog);
     gtk_dialog_run(GTK_DIALOG(dialog));
     gtk_widget_destroy(dialog);
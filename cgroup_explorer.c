@@ -0,0 +1,605 @@
+// cgroup_explorer.c
+// Control group view for container hosts, where per-process numbers are
+// the wrong level of detail. The walker goes over the cgroup v2 hierarchy
+// under /sys/fs/cgroup with getdents64 and openat, relative to a
+// directory descriptor per group that stays open between walks (up to
+// CGROUP_MAX_OPEN_DIRS of them). fstatat on the name tells a group that
+// was removed and recreated apart from the one we hold. Each group's
+// cpu.stat, memory.current, memory.max, memory.stat and io.stat are read,
+// and CPU and I/O rates come from the change since the previous walk.
+//
+// cgroup v2 counters already include all descendants, so a parent's
+// figures are the aggregate of its subtree and nothing is summed here.
+//
+// Walks run on a worker thread; the dialog updates its tree in place, so
+// expanded groups stay expanded and the sort order holds.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define CGROUP_ROOT "/sys/fs/cgroup"
+#define CGROUP_HYBRID_ROOT "/sys/fs/cgroup/unified"     // systemd's hybrid layout
+#define CGROUP_DENTS_BUFFER (32 * 1024)
+#define CGROUP_READ_BUFFER (16 * 1024)     // io.stat grows with the number of devices
+#define CGROUP_MAX_OPEN_DIRS 4096          // beyond this, directories are reopened each walk
+#define CGROUP_REFRESH_SECONDS 2
+
+typedef struct {
+    guint64 d_ino;
+    gint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+} LinuxDirent64;
+
+typedef struct {
+    char *path;                 // relative to the root, "" for the root itself
+    int dir_fd;                 // -1 when not kept open
+    ino_t ino;
+    guint64 usage_usec;         // counters at the last walk
+    guint64 throttled_usec;
+    guint64 read_bytes, write_bytes;
+    guint64 ios;
+    gint64 sampled_at;          // monotonic microseconds, 0 before the first walk
+    guint generation;
+} CgroupNode;
+
+struct _CgroupWalker {
+    char *root_path;
+    int root_fd;
+    CgroupNode *root;
+    GHashTable *nodes;          // path -> CgroupNode*, the root included
+    guint open_dirs;
+    guint generation;
+    gint64 now;
+    char *dents;
+    char buffer[CGROUP_READ_BUFFER];
+};
+
+static void cgroup_node_free(gpointer data) {
+    CgroupNode *node = data;
+    if (node->dir_fd >= 0) close(node->dir_fd);
+    g_free(node->path);
+    g_free(node);
+}
+
+// Only the unified hierarchy has cgroup.controllers
+static int open_unified(const char *root, struct stat *st) {
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    if (fstatat(fd, "cgroup.controllers", st, 0) < 0 || fstat(fd, st) < 0) {
+        close(fd);
+        errno = ENOTSUP;
+        return -1;
+    }
+    return fd;
+}
+
+// Opens root, or when NULL the unified hierarchy at CGROUP_ROOT (or at
+// CGROUP_HYBRID_ROOT next to v1 controllers); NULL with errno set when
+// there is no cgroup v2 mount
+CgroupWalker* cgroup_walker_new(const char *root) {
+    struct stat st;
+    if (!root) {
+        root = CGROUP_ROOT;
+        int fd = open_unified(root, &st);
+        if (fd >= 0) {
+            close(fd);
+        } else {
+            root = CGROUP_HYBRID_ROOT;
+        }
+    }
+    int fd = open_unified(root, &st);
+    if (fd < 0) return NULL;
+
+    CgroupWalker *walker = g_new0(CgroupWalker, 1);
+    walker->root_path = g_strdup(root);
+    walker->root_fd = fd;
+    walker->nodes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, cgroup_node_free);
+    walker->root = g_new0(CgroupNode, 1);
+    walker->root->path = g_strdup("");
+    walker->root->dir_fd = -1;          // root_fd serves; freed separately
+    walker->root->ino = st.st_ino;
+    g_hash_table_insert(walker->nodes, walker->root->path, walker->root);
+    walker->dents = g_malloc(CGROUP_DENTS_BUFFER);
+    return walker;
+}
+
+void cgroup_walker_free(CgroupWalker *walker) {
+    if (!walker) return;
+    g_hash_table_destroy(walker->nodes);
+    close(walker->root_fd);
+    g_free(walker->root_path);
+    g_free(walker->dents);
+    g_free(walker);
+}
+
+// A small cgroup file into the walker buffer, NUL-terminated
+static gssize read_group_file(CgroupWalker *walker, int dir_fd, const char *name) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    gssize total = 0;
+    while (total < CGROUP_READ_BUFFER - 1) {
+        gssize n = read(fd, walker->buffer + total, CGROUP_READ_BUFFER - 1 - total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        total += n;
+    }
+    close(fd);
+    walker->buffer[total] = '\0';
+    return total;
+}
+
+// Value of "key N" in a flat-keyed file like cpu.stat or memory.stat
+static guint64 keyed_value(const char *text, const char *key) {
+    gsize length = strlen(key);
+    const char *p = text;
+    while (p && *p) {
+        if (strncmp(p, key, length) == 0 && p[length] == ' ') {
+            return g_ascii_strtoull(p + length + 1, NULL, 10);
+        }
+        p = strchr(p, '\n');
+        if (p) p++;
+    }
+    return 0;
+}
+
+// "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0", one line per device
+static void sum_io_stat(const char *text, guint64 *read_bytes, guint64 *write_bytes, guint64 *ios) {
+    *read_bytes = *write_bytes = *ios = 0;
+    for (const char *p = text; *p; p++) {
+        if (p != text && p[-1] != ' ') continue;
+        if (strncmp(p, "rbytes=", 7) == 0) {
+            *read_bytes += g_ascii_strtoull(p + 7, NULL, 10);
+        } else if (strncmp(p, "wbytes=", 7) == 0) {
+            *write_bytes += g_ascii_strtoull(p + 7, NULL, 10);
+        } else if (strncmp(p, "rios=", 5) == 0 || strncmp(p, "wios=", 5) == 0) {
+            *ios += g_ascii_strtoull(p + 5, NULL, 10);
+        }
+    }
+}
+
+static double per_second(guint64 now, guint64 before, double seconds) {
+    return now >= before && seconds > 0 ? (now - before) / seconds : 0.0;
+}
+
+static void read_group(CgroupWalker *walker, CgroupNode *node, int dir_fd, CgroupInfo *info) {
+    double seconds = node->sampled_at ? (walker->now - node->sampled_at) / (double)G_USEC_PER_SEC : 0;
+
+    if (read_group_file(walker, dir_fd, "cpu.stat") > 0) {
+        guint64 usage = keyed_value(walker->buffer, "usage_usec");
+        guint64 throttled = keyed_value(walker->buffer, "throttled_usec");
+        info->has_cpu = TRUE;
+        info->cpu_percent = per_second(usage, node->usage_usec, seconds) / 1e4;
+        info->throttled_percent = MIN(100.0, per_second(throttled, node->throttled_usec, seconds) / 1e4);
+        node->usage_usec = usage;
+        node->throttled_usec = throttled;
+    }
+
+    if (read_group_file(walker, dir_fd, "memory.current") > 0) {
+        info->has_memory = TRUE;
+        info->memory_current = g_ascii_strtoull(walker->buffer, NULL, 10);
+        if (read_group_file(walker, dir_fd, "memory.max") > 0 && walker->buffer[0] != 'm') {
+            info->memory_max = g_ascii_strtoull(walker->buffer, NULL, 10);
+        }
+        if (read_group_file(walker, dir_fd, "memory.stat") > 0) {
+            info->memory_anon = keyed_value(walker->buffer, "anon");
+            info->memory_file = keyed_value(walker->buffer, "file");
+        }
+    }
+
+    // Present but empty for a group that has done no I/O
+    if (read_group_file(walker, dir_fd, "io.stat") >= 0) {
+        guint64 read_bytes, write_bytes, ios;
+        sum_io_stat(walker->buffer, &read_bytes, &write_bytes, &ios);
+        info->has_io = TRUE;
+        info->io_read_rate = per_second(read_bytes, node->read_bytes, seconds);
+        info->io_write_rate = per_second(write_bytes, node->write_bytes, seconds);
+        info->io_iops = per_second(ios, node->ios, seconds);
+        node->read_bytes = read_bytes;
+        node->write_bytes = write_bytes;
+        node->ios = ios;
+    }
+    node->sampled_at = walker->now;
+}
+
+static int compare_names(gconstpointer a, gconstpointer b) {
+    return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+// Names of the subdirectories, i.e. the child groups. Collected before
+// descending, since the dents buffer is shared by every level.
+static GPtrArray* list_children(CgroupWalker *walker, int dir_fd) {
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+    lseek(dir_fd, 0, SEEK_SET);
+
+    long n;
+    while ((n = syscall(SYS_getdents64, dir_fd, walker->dents, CGROUP_DENTS_BUFFER)) > 0) {
+        for (long offset = 0; offset < n;) {
+            LinuxDirent64 *dent = (LinuxDirent64 *)(walker->dents + offset);
+            offset += dent->d_reclen;
+            if (dent->d_name[0] == '.') continue;
+
+            gboolean is_dir = dent->d_type == DT_DIR;
+            if (dent->d_type == DT_UNKNOWN) {
+                struct stat st;
+                is_dir = fstatat(dir_fd, dent->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (is_dir) g_ptr_array_add(names, g_strdup(dent->d_name));
+        }
+    }
+    g_ptr_array_sort(names, compare_names);
+    return names;
+}
+
+static void walk_group(CgroupWalker *walker, CgroupNode *node, int dir_fd, const char *name,
+                       int parent, int depth, GArray *groups) {
+    CgroupInfo info;
+    memset(&info, 0, sizeof(info));
+    g_strlcpy(info.name, name, sizeof(info.name));
+    info.parent = parent;
+    info.depth = depth;
+    read_group(walker, node, dir_fd, &info);
+    int index = groups->len;
+    g_array_append_val(groups, info);
+
+    GPtrArray *children = list_children(walker, dir_fd);
+    for (guint i = 0; i < children->len; i++) {
+        const char *child_name = g_ptr_array_index(children, i);
+        struct stat st;
+        if (fstatat(dir_fd, child_name, &st, AT_SYMLINK_NOFOLLOW) < 0) continue;   // just removed
+
+        char *path = node->path[0] ? g_strconcat(node->path, "/", child_name, NULL) : g_strdup(child_name);
+        CgroupNode *child = g_hash_table_lookup(walker->nodes, path);
+        if (child && child->ino != st.st_ino) {
+            // Same name, different group: forget the old counters
+            if (child->dir_fd >= 0) walker->open_dirs--;
+            g_hash_table_remove(walker->nodes, path);
+            child = NULL;
+        }
+        if (!child) {
+            child = g_new0(CgroupNode, 1);
+            child->path = path;
+            child->dir_fd = -1;
+            child->ino = st.st_ino;
+            g_hash_table_insert(walker->nodes, child->path, child);
+        } else {
+            g_free(path);
+        }
+        child->generation = walker->generation;
+
+        int child_fd = child->dir_fd;
+        if (child_fd < 0) {
+            child_fd = openat(dir_fd, child_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (child_fd < 0) continue;
+            if (walker->open_dirs < CGROUP_MAX_OPEN_DIRS) {
+                child->dir_fd = child_fd;
+                walker->open_dirs++;
+            }
+        }
+        walk_group(walker, child, child_fd, child_name, index, depth + 1, groups);
+        if (child->dir_fd < 0) close(child_fd);
+    }
+    g_ptr_array_free(children, TRUE);
+}
+
+const char* cgroup_walker_root(CgroupWalker *walker) {
+    return walker->root_path;
+}
+
+static gboolean is_stale(gpointer key, gpointer value, gpointer user_data) {
+    CgroupWalker *walker = user_data;
+    CgroupNode *node = value;
+    if (node == walker->root || node->generation == walker->generation) return FALSE;
+    if (node->dir_fd >= 0) walker->open_dirs--;
+    return TRUE;
+}
+
+// Walks the hierarchy into groups (CgroupInfo, parents before their
+// children). Rates cover the time since the previous walk and are zero
+// for groups seen for the first time.
+gboolean cgroup_walker_refresh(CgroupWalker *walker, GArray *groups) {
+    if (!walker) return FALSE;
+
+    g_array_set_size(groups, 0);
+    walker->generation++;
+    walker->now = g_get_monotonic_time();
+    walker->root->generation = walker->generation;
+    walk_group(walker, walker->root, walker->root_fd, "/", -1, 0, groups);
+    g_hash_table_foreach_remove(walker->nodes, is_stale, walker);
+    return TRUE;
+}
+
+// Control Groups dialog
+
+enum {
+    CGROUP_COL_NAME,
+    CGROUP_COL_CPU,
+    CGROUP_COL_THROTTLED,
+    CGROUP_COL_MEMORY,
+    CGROUP_COL_LIMIT,
+    CGROUP_COL_ANON,
+    CGROUP_COL_FILE,
+    CGROUP_COL_READ,
+    CGROUP_COL_WRITE,
+    CGROUP_COL_IOPS,
+    CGROUP_N_COLUMNS
+};
+
+typedef struct {
+    GtkTreeRowReference *row;
+    guint generation;
+} CgroupRow;
+
+typedef struct {
+    GtkWidget *dialog;
+    GtkTreeStore *store;
+    GtkWidget *view;
+    GtkWidget *status_label;
+    GHashTable *rows;           // path -> CgroupRow*
+    guint generation;
+    CgroupWalker *walker;       // used by one worker at a time
+    int walker_error;
+    guint timer;
+    gboolean busy;
+    gboolean closed;
+    int refs;                   // the dialog and a running walk
+} CgroupExplorer;
+
+typedef struct {
+    CgroupExplorer *explorer;
+    GArray *groups;
+    gint64 elapsed_us;
+} CgroupWalk;
+
+static void cgroup_row_free(gpointer data) {
+    CgroupRow *row = data;
+    gtk_tree_row_reference_free(row->row);
+    g_free(row);
+}
+
+static void cgroup_explorer_unref(CgroupExplorer *explorer) {
+    if (--explorer->refs > 0) return;
+    cgroup_walker_free(explorer->walker);
+    g_hash_table_destroy(explorer->rows);
+    g_object_unref(explorer->store);
+    g_free(explorer);
+}
+
+static gboolean remove_stale_row(gpointer key, gpointer value, gpointer user_data) {
+    CgroupExplorer *explorer = user_data;
+    CgroupRow *row = value;
+    if (row->generation == explorer->generation) return FALSE;
+
+    // Invalid already when an ancestor went first
+    GtkTreePath *path = gtk_tree_row_reference_get_path(row->row);
+    if (path) {
+        GtkTreeIter iter;
+        if (gtk_tree_model_get_iter(GTK_TREE_MODEL(explorer->store), &iter, path)) {
+            gtk_tree_store_remove(explorer->store, &iter);
+        }
+        gtk_tree_path_free(path);
+    }
+    return TRUE;
+}
+
+static void apply_cgroup_walk(CgroupExplorer *explorer, CgroupWalk *walk) {
+    GtkTreeModel *model = GTK_TREE_MODEL(explorer->store);
+    gboolean first = g_hash_table_size(explorer->rows) == 0;
+    GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+    GArray *iters = g_array_sized_new(FALSE, FALSE, sizeof(GtkTreeIter), walk->groups->len);
+    g_array_set_size(iters, walk->groups->len);
+    explorer->generation++;
+
+    for (guint i = 0; i < walk->groups->len; i++) {
+        const CgroupInfo *group = &g_array_index(walk->groups, CgroupInfo, i);
+        char *path = group->parent < 0 ? g_strdup("")
+                   : g_strconcat(g_ptr_array_index(paths, group->parent), "/", group->name, NULL);
+        g_ptr_array_add(paths, path);
+
+        GtkTreeIter *iter = &g_array_index(iters, GtkTreeIter, i);
+        CgroupRow *row = g_hash_table_lookup(explorer->rows, path);
+        GtkTreePath *tree_path = row ? gtk_tree_row_reference_get_path(row->row) : NULL;
+        if (tree_path) {
+            gtk_tree_model_get_iter(model, iter, tree_path);
+            gtk_tree_path_free(tree_path);
+        } else {
+            GtkTreeIter *parent = group->parent < 0 ? NULL : &g_array_index(iters, GtkTreeIter, group->parent);
+            gtk_tree_store_append(explorer->store, iter, parent);
+            row = g_new0(CgroupRow, 1);
+            tree_path = gtk_tree_model_get_path(model, iter);
+            row->row = gtk_tree_row_reference_new(model, tree_path);
+            gtk_tree_path_free(tree_path);
+            g_hash_table_replace(explorer->rows, g_strdup(path), row);
+        }
+        row->generation = explorer->generation;
+
+        gtk_tree_store_set(explorer->store, iter,
+                           CGROUP_COL_NAME, group->name,
+                           CGROUP_COL_CPU, group->has_cpu ? group->cpu_percent : -1.0f,
+                           CGROUP_COL_THROTTLED, group->has_cpu ? group->throttled_percent : -1.0f,
+                           CGROUP_COL_MEMORY, group->memory_current,
+                           CGROUP_COL_LIMIT, group->memory_max,
+                           CGROUP_COL_ANON, group->memory_anon,
+                           CGROUP_COL_FILE, group->memory_file,
+                           CGROUP_COL_READ, group->io_read_rate,
+                           CGROUP_COL_WRITE, group->io_write_rate,
+                           CGROUP_COL_IOPS, group->io_iops,
+                           -1);
+    }
+    g_hash_table_foreach_remove(explorer->rows, remove_stale_row, explorer);
+
+    // Open the top level the first time round
+    if (first && walk->groups->len > 0) {
+        GtkTreePath *root = gtk_tree_path_new_first();
+        gtk_tree_view_expand_row(GTK_TREE_VIEW(explorer->view), root, FALSE);
+        gtk_tree_path_free(root);
+    }
+
+    char text[128];
+    snprintf(text, sizeof(text), "%s: %u groups, walked in %.1f ms",
+             cgroup_walker_root(explorer->walker), walk->groups->len, walk->elapsed_us / 1000.0);
+    gtk_label_set_text(GTK_LABEL(explorer->status_label), text);
+    g_array_free(iters, TRUE);
+    g_ptr_array_free(paths, TRUE);
+}
+
+static gboolean on_cgroup_walk_done(gpointer user_data) {
+    CgroupWalk *walk = user_data;
+    CgroupExplorer *explorer = walk->explorer;
+
+    explorer->busy = FALSE;
+    if (!explorer->closed) apply_cgroup_walk(explorer, walk);
+    g_array_free(walk->groups, TRUE);
+    g_free(walk);
+    cgroup_explorer_unref(explorer);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer run_cgroup_walk(gpointer user_data) {
+    CgroupWalk *walk = user_data;
+    gint64 start = g_get_monotonic_time();
+    cgroup_walker_refresh(walk->explorer->walker, walk->groups);
+    walk->elapsed_us = g_get_monotonic_time() - start;
+    g_idle_add(on_cgroup_walk_done, walk);
+    return NULL;
+}
+
+static void start_cgroup_walk(CgroupExplorer *explorer) {
+    if (explorer->busy || !explorer->walker) return;
+
+    CgroupWalk *walk = g_new0(CgroupWalk, 1);
+    walk->explorer = explorer;
+    walk->groups = g_array_new(FALSE, FALSE, sizeof(CgroupInfo));
+    explorer->busy = TRUE;
+    explorer->refs++;
+    g_thread_unref(g_thread_new("cgroup-walk", run_cgroup_walk, walk));
+}
+
+static gboolean on_cgroup_timer(gpointer user_data) {
+    start_cgroup_walk(user_data);
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_cgroup_dialog_destroy(GtkWidget *widget, gpointer user_data) {
+    CgroupExplorer *explorer = user_data;
+    explorer->closed = TRUE;
+    if (explorer->timer) g_source_remove(explorer->timer);
+    cgroup_explorer_unref(explorer);
+}
+
+static void cgroup_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                             GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    int column_id = GPOINTER_TO_INT(user_data);
+    char text[32] = "";
+
+    if (column_id == CGROUP_COL_CPU || column_id == CGROUP_COL_THROTTLED || column_id == CGROUP_COL_IOPS) {
+        float value = 0;
+        gtk_tree_model_get(model, iter, column_id, &value, -1);
+        if (value >= 0) snprintf(text, sizeof(text), column_id == CGROUP_COL_IOPS ? "%.0f" : "%.1f", value);
+    } else if (column_id == CGROUP_COL_READ || column_id == CGROUP_COL_WRITE) {
+        double rate = 0;
+        gtk_tree_model_get(model, iter, column_id, &rate, -1);
+        char *size = g_format_size((guint64)rate);
+        snprintf(text, sizeof(text), "%s/s", size);
+        g_free(size);
+    } else {
+        guint64 bytes = 0;
+        gtk_tree_model_get(model, iter, column_id, &bytes, -1);
+        if (bytes > 0) {
+            char *size = g_format_size(bytes);
+            g_strlcpy(text, size, sizeof(text));
+            g_free(size);
+        }
+    }
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void add_cgroup_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column;
+
+    if (column_id == CGROUP_COL_NAME) {
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+        gtk_tree_view_column_set_expand(column, TRUE);
+    } else {
+        g_object_set(renderer, "xalign", 1.0, NULL);
+        column = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(column, title);
+        gtk_tree_view_column_pack_start(column, renderer, TRUE);
+        gtk_tree_view_column_set_cell_data_func(column, renderer, cgroup_cell_data,
+                                                GINT_TO_POINTER(column_id), NULL);
+    }
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+GtkWidget* create_cgroup_explorer_dialog(GtkWindow *parent) {
+    CgroupExplorer *explorer = g_new0(CgroupExplorer, 1);
+    explorer->refs = 1;
+    explorer->rows = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, cgroup_row_free);
+    explorer->walker = cgroup_walker_new(NULL);
+    explorer->walker_error = explorer->walker ? 0 : errno;
+
+    explorer->dialog = gtk_dialog_new_with_buttons("Control Groups",
+                                                   parent,
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   "_Close", GTK_RESPONSE_CLOSE,
+                                                   NULL);
+    gtk_window_set_default_size(GTK_WINDOW(explorer->dialog), 1100, 650);
+    gtk_window_set_resizable(GTK_WINDOW(explorer->dialog), TRUE);
+    GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(explorer->dialog));
+
+    explorer->status_label = gtk_label_new("Walking the cgroup hierarchy…");
+    gtk_label_set_xalign(GTK_LABEL(explorer->status_label), 0.0);
+    gtk_widget_set_margin_top(explorer->status_label, 10);
+    gtk_widget_set_margin_left(explorer->status_label, 10);
+    gtk_box_pack_start(GTK_BOX(content_area), explorer->status_label, FALSE, FALSE, 0);
+
+    explorer->store = gtk_tree_store_new(CGROUP_N_COLUMNS,
+                                         G_TYPE_STRING, G_TYPE_FLOAT, G_TYPE_FLOAT,
+                                         G_TYPE_UINT64, G_TYPE_UINT64, G_TYPE_UINT64, G_TYPE_UINT64,
+                                         G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_FLOAT);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(explorer->store), CGROUP_COL_CPU, GTK_SORT_DESCENDING);
+    explorer->view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(explorer->store));
+    add_cgroup_column(explorer->view, "Group", CGROUP_COL_NAME);
+    add_cgroup_column(explorer->view, "CPU %", CGROUP_COL_CPU);
+    add_cgroup_column(explorer->view, "Throttled %", CGROUP_COL_THROTTLED);
+    add_cgroup_column(explorer->view, "Memory", CGROUP_COL_MEMORY);
+    add_cgroup_column(explorer->view, "Limit", CGROUP_COL_LIMIT);
+    add_cgroup_column(explorer->view, "Anon", CGROUP_COL_ANON);
+    add_cgroup_column(explorer->view, "File", CGROUP_COL_FILE);
+    add_cgroup_column(explorer->view, "Read", CGROUP_COL_READ);
+    add_cgroup_column(explorer->view, "Write", CGROUP_COL_WRITE);
+    add_cgroup_column(explorer->view, "IOPS", CGROUP_COL_IOPS);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_hexpand(scrolled, TRUE);
+    gtk_widget_set_vexpand(scrolled, TRUE);
+    gtk_widget_set_margin_top(scrolled, 10);
+    gtk_widget_set_margin_bottom(scrolled, 10);
+    gtk_widget_set_margin_left(scrolled, 10);
+    gtk_widget_set_margin_right(scrolled, 10);
+    gtk_container_add(GTK_CONTAINER(scrolled), explorer->view);
+    gtk_box_pack_start(GTK_BOX(content_area), scrolled, TRUE, TRUE, 0);
+
+    g_signal_connect(explorer->dialog, "destroy", G_CALLBACK(on_cgroup_dialog_destroy), explorer);
+
+    if (explorer->walker) {
+        start_cgroup_walk(explorer);
+        explorer->timer = g_timeout_add_seconds(CGROUP_REFRESH_SECONDS, on_cgroup_timer, explorer);
+    } else {
+        char text[256];
+        snprintf(text, sizeof(text), "No cgroup v2 hierarchy at " CGROUP_ROOT " or " CGROUP_HYBRID_ROOT ": %s",
+                 g_strerror(explorer->walker_error));
+        gtk_label_set_text(GTK_LABEL(explorer->status_label), text);
+    }
+
+    gtk_widget_show_all(explorer->dialog);
+    return explorer->dialog;
+}
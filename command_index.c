@@ -0,0 +1,440 @@
+// command_index.c
+// SymSpell-style deletion index over every executable on $PATH plus the
+// command names seen in history. Used by suggest_command() for the
+// "Did you mean" hint after an exit status of 127.
+
+#include "custom_shell.h"
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <limits.h>
+
+#define COMMAND_INDEX_MAX_DISTANCE 2
+#define COMMAND_INDEX_PREFIX_LENGTH 7
+#define COMMAND_INDEX_BATCH 32
+#define COMMAND_INDEX_MAX_NAME 255
+
+typedef struct {
+    char *name;
+    guint weight;       // how often it was run from history
+    gboolean on_path;   // provided by at least one $PATH directory
+    gboolean builtin;   // shell builtin or Command Sphere command
+} IndexedCommand;
+
+// Shell builtins and Command Sphere commands never show up on $PATH
+static const char *builtin_names[] = {
+    "cd", "pwd", "echo", "exit", "help", "history", "calc", "clear",
+    "alias", "export", "source", "type", "jobs", "fg", "bg", "umask",
+    "system_info", "custom_menu", "custom_commands",
+    NULL
+};
+
+static GMutex index_lock;
+static GPtrArray *index_words = NULL;      // IndexedCommand*, position is the id
+static GHashTable *index_by_name = NULL;   // name -> id + 1
+static GHashTable *index_deletes = NULL;   // delete variant -> GArray of ids
+static char **index_path_dirs = NULL;
+static gint index_ready = 0;
+
+// Lowercased, prefix-limited form of a name; deletes are generated from this
+static void index_key(const char *name, char *key) {
+    int i;
+    for (i = 0; name[i] && i < COMMAND_INDEX_PREFIX_LENGTH; i++) {
+        key[i] = g_ascii_tolower(name[i]);
+    }
+    key[i] = '\0';
+}
+
+static void collect_deletes(const char *word, int distance, GHashTable *variants) {
+    int len = strlen(word);
+    if (len <= 1) return;
+
+    char variant[COMMAND_INDEX_PREFIX_LENGTH + 1];
+    for (int i = 0; i < len; i++) {
+        memcpy(variant, word, i);
+        memcpy(variant + i, word + i + 1, len - i);
+        if (g_hash_table_contains(variants, variant)) continue;
+        g_hash_table_add(variants, g_strdup(variant));
+        if (distance > 1) {
+            collect_deletes(variant, distance - 1, variants);
+        }
+    }
+}
+
+// Optimal string alignment distance, case-insensitive, giving up (-1) once
+// every cell of a row exceeds max_distance
+int command_edit_distance(const char *s1, const char *s2, int max_distance) {
+    int len1 = strlen(s1);
+    int len2 = strlen(s2);
+
+    if (abs(len1 - len2) > max_distance) return -1;
+    if (len1 > COMMAND_INDEX_MAX_NAME || len2 > COMMAND_INDEX_MAX_NAME) return -1;
+
+    int rows[3][COMMAND_INDEX_MAX_NAME + 1];
+    int *prev2 = rows[0], *prev = rows[1], *cur = rows[2];
+
+    for (int j = 0; j <= len2; j++) prev[j] = j;
+
+    for (int i = 1; i <= len1; i++) {
+        int row_min;
+        cur[0] = i;
+        row_min = cur[0];
+        char a = g_ascii_tolower(s1[i - 1]);
+
+        for (int j = 1; j <= len2; j++) {
+            char b = g_ascii_tolower(s2[j - 1]);
+            int cost = (a == b) ? 0 : 1;
+            int best = prev[j] + 1;
+            if (cur[j - 1] + 1 < best) best = cur[j - 1] + 1;
+            if (prev[j - 1] + cost < best) best = prev[j - 1] + cost;
+            if (i > 1 && j > 1 && a == g_ascii_tolower(s2[j - 2]) &&
+                g_ascii_tolower(s1[i - 2]) == b && prev2[j - 2] + 1 < best) {
+                best = prev2[j - 2] + 1;
+            }
+            cur[j] = best;
+            if (best < row_min) row_min = best;
+        }
+        if (row_min > max_distance) return -1;
+
+        int *tmp = prev2;
+        prev2 = prev;
+        prev = cur;
+        cur = tmp;
+    }
+
+    return prev[len2] <= max_distance ? prev[len2] : -1;
+}
+
+static IndexedCommand* index_insert_locked(const char *name) {
+    gpointer found = g_hash_table_lookup(index_by_name, name);
+    if (found) {
+        return g_ptr_array_index(index_words, GPOINTER_TO_UINT(found) - 1);
+    }
+
+    IndexedCommand *cmd = g_new0(IndexedCommand, 1);
+    guint id = index_words->len;
+    cmd->name = g_strdup(name);
+    g_ptr_array_add(index_words, cmd);
+    g_hash_table_insert(index_by_name, cmd->name, GUINT_TO_POINTER(id + 1));
+
+    char key[COMMAND_INDEX_PREFIX_LENGTH + 1];
+    index_key(name, key);
+
+    GHashTable *variants = g_hash_table_new(g_str_hash, g_str_equal);
+    g_hash_table_add(variants, g_strdup(key));
+    collect_deletes(key, COMMAND_INDEX_MAX_DISTANCE, variants);
+
+    GHashTableIter iter;
+    gpointer variant;
+    g_hash_table_iter_init(&iter, variants);
+    while (g_hash_table_iter_next(&iter, &variant, NULL)) {
+        GArray *ids = g_hash_table_lookup(index_deletes, variant);
+        if (ids) {
+            g_free(variant);
+        } else {
+            ids = g_array_new(FALSE, FALSE, sizeof(guint));
+            g_hash_table_insert(index_deletes, variant, ids);
+        }
+        g_array_append_val(ids, id);
+    }
+    g_hash_table_destroy(variants);
+
+    return cmd;
+}
+
+static void free_id_array(gpointer data) {
+    g_array_free(data, TRUE);
+}
+
+static gboolean is_executable_entry(int dir_fd, const char *name, unsigned char d_type) {
+    if (d_type == DT_DIR) return FALSE;
+    if (d_type != DT_REG) {
+        struct stat st;
+        if (fstatat(dir_fd, name, &st, 0) != 0 || !S_ISREG(st.st_mode)) return FALSE;
+    }
+    return faccessat(dir_fd, name, X_OK, 0) == 0;
+}
+
+static gboolean command_on_any_path_dir(const char *name) {
+    for (int i = 0; index_path_dirs && index_path_dirs[i]; i++) {
+        if (!*index_path_dirs[i]) continue;
+        int dir_fd = open(index_path_dirs[i], O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd < 0) continue;
+        gboolean found = is_executable_entry(dir_fd, name, DT_UNKNOWN);
+        close(dir_fd);
+        if (found) return TRUE;
+    }
+    return FALSE;
+}
+
+static void index_add_path_batch(GPtrArray *batch) {
+    g_mutex_lock(&index_lock);
+    for (guint i = 0; i < batch->len; i++) {
+        IndexedCommand *cmd = index_insert_locked(g_ptr_array_index(batch, i));
+        cmd->on_path = TRUE;
+    }
+    g_mutex_unlock(&index_lock);
+    g_ptr_array_set_size(batch, 0);
+}
+
+// Insert in small batches so a lookup on the UI thread never waits long
+static void index_scan_directory(const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) return;
+
+    GPtrArray *batch = g_ptr_array_new_with_free_func(g_free);
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        if (strlen(entry->d_name) > COMMAND_INDEX_MAX_NAME) continue;
+        if (!is_executable_entry(dirfd(d), entry->d_name, entry->d_type)) continue;
+
+        g_ptr_array_add(batch, g_strdup(entry->d_name));
+        if (batch->len >= COMMAND_INDEX_BATCH) {
+            index_add_path_batch(batch);
+        }
+    }
+    if (batch->len > 0) {
+        index_add_path_batch(batch);
+    }
+    g_ptr_array_free(batch, TRUE);
+    closedir(d);
+}
+
+static void index_handle_path_event(const char *dir, const struct inotify_event *event) {
+    if (event->len == 0 || event->name[0] == '.') return;
+    if (strlen(event->name) > COMMAND_INDEX_MAX_NAME) return;
+
+    gboolean available;
+    if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        available = command_on_any_path_dir(event->name);
+    } else {
+        int dir_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd < 0) return;
+        available = is_executable_entry(dir_fd, event->name, DT_UNKNOWN);
+        close(dir_fd);
+        if (!available && (event->mask & IN_ATTRIB)) {
+            available = command_on_any_path_dir(event->name);
+        }
+    }
+
+    g_mutex_lock(&index_lock);
+    gpointer found = g_hash_table_lookup(index_by_name, event->name);
+    if (available) {
+        index_insert_locked(event->name)->on_path = TRUE;
+    } else if (found) {
+        IndexedCommand *cmd = g_ptr_array_index(index_words, GPOINTER_TO_UINT(found) - 1);
+        cmd->on_path = FALSE;
+    }
+    g_mutex_unlock(&index_lock);
+}
+
+// First word of a command line, if it can be a command name at all
+static gboolean command_name_from_line(const char *line, gsize length, char *name) {
+    const char *end = line + length;
+    while (line < end && isspace((unsigned char)*line)) line++;
+    gsize len = 0;
+    while (line + len < end && !isspace((unsigned char)line[len])) len++;
+    if (len == 0 || len > COMMAND_INDEX_MAX_NAME) return FALSE;
+
+    memcpy(name, line, len);
+    name[len] = '\0';
+    // Paths and variable assignments are not command names
+    return !strchr(name, '/') && !strchr(name, '=');
+}
+
+static void index_add_history_batch(GHashTable *counts) {
+    g_mutex_lock(&index_lock);
+    GHashTableIter iter;
+    gpointer name, runs;
+    g_hash_table_iter_init(&iter, counts);
+    while (g_hash_table_iter_next(&iter, &name, &runs)) {
+        index_insert_locked(name)->weight += GPOINTER_TO_UINT(runs);
+    }
+    g_mutex_unlock(&index_lock);
+    g_hash_table_remove_all(counts);
+}
+
+// Weights start from the saved history, one per run of each command name.
+// The thread reads the log through its own store so the UI thread's store
+// is never touched off the main loop.
+static void index_seed_from_history(void) {
+    HistoryStore *store = history_store_open(NULL);
+    GHashTable *counts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    char name[COMMAND_INDEX_MAX_NAME + 1];
+
+    guint total = history_store_count(store);
+    for (guint i = 0; i < total; i++) {
+        gsize length;
+        const char *entry = history_store_peek(store, i, &length);
+        if (!entry || !command_name_from_line(entry, length, name)) continue;
+
+        gpointer runs = g_hash_table_lookup(counts, name);
+        if (runs) {
+            g_hash_table_insert(counts, g_strdup(name), GUINT_TO_POINTER(GPOINTER_TO_UINT(runs) + 1));
+        } else {
+            g_hash_table_insert(counts, g_strdup(name), GUINT_TO_POINTER(1));
+            if (g_hash_table_size(counts) >= COMMAND_INDEX_BATCH) {
+                index_add_history_batch(counts);
+            }
+        }
+    }
+    if (g_hash_table_size(counts) > 0) {
+        index_add_history_batch(counts);
+    }
+    g_hash_table_destroy(counts);
+    history_store_close(store);
+}
+
+// Builds the index in the background from saved history and $PATH, then
+// keeps it current by watching the $PATH directories for installs and removals
+static gpointer command_index_thread(gpointer user_data) {
+    index_seed_from_history();
+
+    int inotify_fd = inotify_init1(IN_CLOEXEC);
+    GHashTable *watches = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GHashTable *seen_dirs = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (int i = 0; index_path_dirs[i]; i++) {
+        const char *dir = index_path_dirs[i];
+        // An empty entry means the current directory, which is not worth indexing
+        if (!*dir || g_hash_table_contains(seen_dirs, dir)) continue;
+        g_hash_table_add(seen_dirs, (gpointer)dir);
+
+        if (inotify_fd >= 0) {
+            int wd = inotify_add_watch(inotify_fd, dir,
+                                       IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM |
+                                       IN_ATTRIB | IN_ONLYDIR);
+            if (wd >= 0) {
+                g_hash_table_insert(watches, GINT_TO_POINTER(wd), (gpointer)dir);
+            }
+        }
+        index_scan_directory(dir);
+    }
+    g_hash_table_destroy(seen_dirs);
+    g_atomic_int_set(&index_ready, 1);
+
+    if (inotify_fd < 0 || g_hash_table_size(watches) == 0) {
+        if (inotify_fd >= 0) close(inotify_fd);
+        g_hash_table_destroy(watches);
+        return NULL;
+    }
+
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t len = read(inotify_fd, buf, sizeof(buf));
+        if (len <= 0) {
+            if (len < 0 && errno == EINTR) continue;
+            break;
+        }
+        for (char *p = buf; p < buf + len; ) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            const char *dir = g_hash_table_lookup(watches, GINT_TO_POINTER(event->wd));
+            if (dir) {
+                index_handle_path_event(dir, event);
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    close(inotify_fd);
+    g_hash_table_destroy(watches);
+    return NULL;
+}
+
+// Safe to call repeatedly; the first call seeds builtins and starts the scan
+void command_index_init(void) {
+    static gsize initialized = 0;
+    if (!g_once_init_enter(&initialized)) return;
+
+    index_words = g_ptr_array_new();
+    index_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+    index_deletes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_id_array);
+
+    g_mutex_lock(&index_lock);
+    for (int i = 0; builtin_names[i] != NULL; i++) {
+        index_insert_locked(builtin_names[i])->builtin = TRUE;
+    }
+    g_mutex_unlock(&index_lock);
+
+    const char *path = getenv("PATH");
+    index_path_dirs = g_strsplit(path ? path : "/usr/local/bin:/usr/bin:/bin", ":", -1);
+    g_thread_unref(g_thread_new("command_index", command_index_thread, NULL));
+
+    g_once_init_leave(&initialized, 1);
+}
+
+gboolean command_index_is_ready(void) {
+    return g_atomic_int_get(&index_ready) != 0;
+}
+
+// Record a command name that was run successfully; frequent ones rank higher
+void command_index_note_command(const char *command_line) {
+    char name[COMMAND_INDEX_MAX_NAME + 1];
+    if (!command_line || !command_name_from_line(command_line, strlen(command_line), name)) return;
+
+    command_index_init();
+    g_mutex_lock(&index_lock);
+    index_insert_locked(name)->weight++;
+    g_mutex_unlock(&index_lock);
+}
+
+// Closest known command within COMMAND_INDEX_MAX_DISTANCE edits, or NULL.
+// Ties go to the command run most often, then to the closest length.
+char* command_index_lookup(const char *word) {
+    if (!word || !*word || strlen(word) > COMMAND_INDEX_MAX_NAME) return NULL;
+
+    command_index_init();
+
+    char key[COMMAND_INDEX_PREFIX_LENGTH + 1];
+    index_key(word, key);
+
+    GHashTable *variants = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    g_hash_table_add(variants, g_strdup(key));
+    collect_deletes(key, COMMAND_INDEX_MAX_DISTANCE, variants);
+
+    int word_len = strlen(word);
+    IndexedCommand *best = NULL;
+    int best_distance = COMMAND_INDEX_MAX_DISTANCE + 1;
+    GHashTable *checked = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    g_mutex_lock(&index_lock);
+
+    GHashTableIter iter;
+    gpointer variant;
+    g_hash_table_iter_init(&iter, variants);
+    while (g_hash_table_iter_next(&iter, &variant, NULL)) {
+        GArray *ids = g_hash_table_lookup(index_deletes, variant);
+        if (!ids) continue;
+
+        for (guint i = 0; i < ids->len; i++) {
+            guint id = g_array_index(ids, guint, i);
+            if (!g_hash_table_add(checked, GUINT_TO_POINTER(id + 1))) continue;
+
+            IndexedCommand *cmd = g_ptr_array_index(index_words, id);
+            if (!cmd->on_path && !cmd->builtin && cmd->weight == 0) continue;
+
+            int distance = command_edit_distance(word, cmd->name, COMMAND_INDEX_MAX_DISTANCE);
+            // Distance 0 means the name itself is known, so it is no correction
+            if (distance <= 0 || distance > best_distance) continue;
+
+            if (best && distance == best_distance) {
+                if (cmd->weight < best->weight) continue;
+                if (cmd->weight == best->weight) {
+                    int cmd_gap = abs((int)strlen(cmd->name) - word_len);
+                    int best_gap = abs((int)strlen(best->name) - word_len);
+                    if (cmd_gap > best_gap) continue;
+                    if (cmd_gap == best_gap && strcmp(cmd->name, best->name) >= 0) continue;
+                }
+            }
+            best = cmd;
+            best_distance = distance;
+        }
+    }
+
+    char *result = best ? g_strdup(best->name) : NULL;
+    g_mutex_unlock(&index_lock);
+
+    g_hash_table_destroy(checked);
+    g_hash_table_destroy(variants);
+    return result;
+}
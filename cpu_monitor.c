@@ -0,0 +1,208 @@
+// cpu_monitor.c
+// Per-core CPU view in the System Monitor: one sparkline per core, fed from
+// the metrics sampler's core ring. Each sparkline keeps a cairo image
+// surface used as a ring of columns; a tick renders only the new columns
+// into it, and the draw handler blits the surface in two pieces so the
+// oldest column lands on the left.
+//
+// Columns are stacked from the bottom: user, system, irq + softirq, iowait
+// and steal, so a saturated core or a starved vCPU shows up at a glance.
+
+#include "custom_shell.h"
+
+#define SPARKLINE_WIDTH 120
+#define SPARKLINE_HEIGHT 28
+#define SPARKLINE_COLUMN 2      // pixels per sample
+#define SPARKLINE_SAMPLES (SPARKLINE_WIDTH / SPARKLINE_COLUMN)
+#define CPU_MONITOR_PER_LINE 8
+
+typedef struct _CpuMonitor CpuMonitor;
+
+typedef struct {
+    CpuMonitor *monitor;
+    GtkWidget *area;
+    GtkWidget *label;
+    cairo_surface_t *surface;
+} CoreSparkline;
+
+struct _CpuMonitor {
+    guint cpu_count;
+    CoreSparkline *cores;
+    GtkWidget *summary;
+    guint64 cursor;             // position in the sampler's core ring
+    guint column;               // samples drawn so far; the next slot is column % SPARKLINE_SAMPLES
+    guint timer;
+    CpuCoreSample *samples;     // SPARKLINE_SAMPLES * cpu_count scratch
+};
+
+static const struct {
+    double r, g, b;
+} sparkline_colors[] = {
+    { 0.30, 0.69, 0.31 },   // user
+    { 0.13, 0.59, 0.95 },   // system
+    { 1.00, 0.76, 0.03 },   // irq + softirq
+    { 0.61, 0.35, 0.71 },   // iowait
+    { 0.96, 0.26, 0.21 },   // steal
+};
+
+static void clear_surface(cairo_surface_t *surface) {
+    cairo_t *cr = cairo_create(surface);
+    cairo_set_source_rgb(cr, 0.13, 0.13, 0.13);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+}
+
+static void draw_column(cairo_surface_t *surface, guint slot, const CpuCoreSample *sample) {
+    cairo_t *cr = cairo_create(surface);
+    double x = slot * SPARKLINE_COLUMN;
+
+    cairo_set_source_rgb(cr, 0.13, 0.13, 0.13);
+    cairo_rectangle(cr, x, 0, SPARKLINE_COLUMN, SPARKLINE_HEIGHT);
+    cairo_fill(cr);
+
+    float shares[] = {
+        sample->user, sample->system, sample->irq + sample->softirq, sample->iowait, sample->steal
+    };
+    double y = SPARKLINE_HEIGHT;
+    for (gsize i = 0; i < G_N_ELEMENTS(shares); i++) {
+        double height = shares[i] * SPARKLINE_HEIGHT / 100.0;
+        if (height <= 0) continue;
+        y -= height;
+        cairo_set_source_rgb(cr, sparkline_colors[i].r, sparkline_colors[i].g, sparkline_colors[i].b);
+        cairo_rectangle(cr, x, y, SPARKLINE_COLUMN, height);
+        cairo_fill(cr);
+    }
+    cairo_destroy(cr);
+}
+
+static gboolean on_sparkline_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    CoreSparkline *core = user_data;
+    double split = (core->monitor->column % SPARKLINE_SAMPLES) * SPARKLINE_COLUMN;
+
+    // Oldest columns (from the write position onwards) first, then the rest
+    cairo_set_source_surface(cr, core->surface, -split, 0);
+    cairo_rectangle(cr, 0, 0, SPARKLINE_WIDTH - split, SPARKLINE_HEIGHT);
+    cairo_fill(cr);
+    cairo_set_source_surface(cr, core->surface, SPARKLINE_WIDTH - split, 0);
+    cairo_rectangle(cr, SPARKLINE_WIDTH - split, 0, split, SPARKLINE_HEIGHT);
+    cairo_fill(cr);
+    return TRUE;
+}
+
+static void update_labels(CpuMonitor *monitor, const CpuCoreSample *latest) {
+    char text[128];
+    guint busiest = 0;
+    for (guint i = 0; i < monitor->cpu_count; i++) {
+        const CpuCoreSample *core = &latest[i];
+        if (core->busy > latest[busiest].busy) busiest = i;
+        if (core->steal >= 1.0f) {
+            snprintf(text, sizeof(text), "cpu%u %3.0f%% st %.0f%%", i, core->busy, core->steal);
+        } else {
+            snprintf(text, sizeof(text), "cpu%u %3.0f%%", i, core->busy);
+        }
+        gtk_label_set_text(GTK_LABEL(monitor->cores[i].label), text);
+    }
+
+    MetricsSample sample;
+    if (metrics_sampler_latest(&sample)) {
+        snprintf(text, sizeof(text),
+                 "All cores: user %.1f%%  system %.1f%%  irq %.1f%%  softirq %.1f%%  iowait %.1f%%  steal %.1f%%  "
+                 "(busiest: cpu%u at %.0f%%)",
+                 sample.cpu.user, sample.cpu.system, sample.cpu.irq, sample.cpu.softirq,
+                 sample.cpu.iowait, sample.cpu.steal, busiest, latest[busiest].busy);
+        gtk_label_set_text(GTK_LABEL(monitor->summary), text);
+    }
+}
+
+// Draws whatever the sampler produced since the last tick
+static gboolean cpu_monitor_tick(gpointer user_data) {
+    CpuMonitor *monitor = user_data;
+    guint count = metrics_sampler_cpu_since(&monitor->cursor, monitor->samples, SPARKLINE_SAMPLES);
+    if (count == 0) return G_SOURCE_CONTINUE;
+
+    for (guint s = 0; s < count; s++) {
+        const CpuCoreSample *sample = monitor->samples + (gsize)s * monitor->cpu_count;
+        guint slot = monitor->column % SPARKLINE_SAMPLES;
+        for (guint i = 0; i < monitor->cpu_count; i++) {
+            draw_column(monitor->cores[i].surface, slot, &sample[i]);
+        }
+        monitor->column++;
+    }
+    for (guint i = 0; i < monitor->cpu_count; i++) {
+        gtk_widget_queue_draw(monitor->cores[i].area);
+    }
+    update_labels(monitor, monitor->samples + (gsize)(count - 1) * monitor->cpu_count);
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_cpu_monitor_destroy(GtkWidget *widget, gpointer user_data) {
+    CpuMonitor *monitor = user_data;
+    g_source_remove(monitor->timer);
+    for (guint i = 0; i < monitor->cpu_count; i++) {
+        cairo_surface_destroy(monitor->cores[i].surface);
+    }
+    g_free(monitor->cores);
+    g_free(monitor->samples);
+    g_free(monitor);
+}
+
+GtkWidget* cpu_monitor_new(void) {
+    guint cpu_count = metrics_sampler_cpu_count();
+    if (cpu_count == 0) {
+        return gtk_label_new("Per-core CPU: sampler not running");
+    }
+
+    CpuMonitor *monitor = g_new0(CpuMonitor, 1);
+    monitor->cpu_count = cpu_count;
+    monitor->cores = g_new0(CoreSparkline, cpu_count);
+    monitor->samples = g_new(CpuCoreSample, (gsize)SPARKLINE_SAMPLES * cpu_count);
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    monitor->summary = gtk_label_new("All cores: waiting for the first sample");
+    gtk_label_set_xalign(GTK_LABEL(monitor->summary), 0.0);
+    gtk_label_set_line_wrap(GTK_LABEL(monitor->summary), TRUE);
+    gtk_box_pack_start(GTK_BOX(box), monitor->summary, FALSE, FALSE, 0);
+
+    GtkWidget *legend = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(legend),
+                         "<span foreground='#4caf50'>■</span> user  "
+                         "<span foreground='#2196f3'>■</span> system  "
+                         "<span foreground='#ffc107'>■</span> irq/softirq  "
+                         "<span foreground='#9c59b5'>■</span> iowait  "
+                         "<span foreground='#f44336'>■</span> steal");
+    gtk_label_set_xalign(GTK_LABEL(legend), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), legend, FALSE, FALSE, 0);
+
+    GtkWidget *flow = gtk_flow_box_new();
+    gtk_flow_box_set_selection_mode(GTK_FLOW_BOX(flow), GTK_SELECTION_NONE);
+    gtk_flow_box_set_homogeneous(GTK_FLOW_BOX(flow), TRUE);
+    gtk_flow_box_set_max_children_per_line(GTK_FLOW_BOX(flow), CPU_MONITOR_PER_LINE);
+    gtk_box_pack_start(GTK_BOX(box), flow, FALSE, FALSE, 0);
+
+    for (guint i = 0; i < cpu_count; i++) {
+        CoreSparkline *core = &monitor->cores[i];
+        core->monitor = monitor;
+        core->surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, SPARKLINE_WIDTH, SPARKLINE_HEIGHT);
+        clear_surface(core->surface);
+
+        GtkWidget *cell = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
+        char text[32];
+        snprintf(text, sizeof(text), "cpu%u", i);
+        core->label = gtk_label_new(text);
+        gtk_label_set_xalign(GTK_LABEL(core->label), 0.0);
+        gtk_box_pack_start(GTK_BOX(cell), core->label, FALSE, FALSE, 0);
+
+        core->area = gtk_drawing_area_new();
+        gtk_widget_set_size_request(core->area, SPARKLINE_WIDTH, SPARKLINE_HEIGHT);
+        g_signal_connect(core->area, "draw", G_CALLBACK(on_sparkline_draw), core);
+        gtk_box_pack_start(GTK_BOX(cell), core->area, FALSE, FALSE, 0);
+
+        gtk_container_add(GTK_CONTAINER(flow), cell);
+    }
+
+    // Backfill from what the sampler already holds, then follow it
+    cpu_monitor_tick(monitor);
+    monitor->timer = g_timeout_add(metrics_sampler_interval(), cpu_monitor_tick, monitor);
+    g_signal_connect(box, "destroy", G_CALLBACK(on_cpu_monitor_destroy), monitor);
+    return box;
+}
@@ -11,13 +11,37 @@
 #include <errno.h>
 #include <ctype.h>
 #include <glib.h>
+#include <glib-unix.h>
 #include <dirent.h>
 
-#define MAX_HISTORY 50
+#define MAX_HISTORY_SUGGESTION_SCAN 2000
 #define MAX_COMMAND_LENGTH 1000
 #define MAX_SUGGESTIONS 10
 #define MAX_BUILTIN_COMMANDS 7
 
+// Persistent command history (history_store.c)
+typedef struct _HistoryStore HistoryStore;
+typedef struct _HistorySearchIndex HistorySearchIndex;
+
+#define HISTORY_STATUS_UNKNOWN G_MININT32
+
+// What is recorded about each command besides its text
+typedef struct {
+    gint64 start_time;      // unix seconds, 0 when unknown
+    guint32 duration_ms;
+    int exit_status;        // HISTORY_STATUS_UNKNOWN for entries without metadata
+    guint64 output_bytes;
+    const char *cwd;        // NULL when unknown
+} HistoryRecord;
+
+typedef struct {
+    gint64 since;           // only entries started at or after this unix time, 0 for all
+    gboolean failed_only;   // non-zero exit status
+    const char *cwd;        // only entries run in this directory, NULL for all
+    gboolean slowest;       // longest running first instead of newest first
+    guint limit;            // 0 for no limit
+} HistoryQuery;
+
 // Audio analysis results structure - must be declared early for function declarations
 typedef struct {
     double energy_level;
@@ -42,9 +66,19 @@ typedef struct {
     GtkWidget *history_button;
     GtkWidget *voice_button;
     int theme_index; // 0: light, 1: dark, 2: hacker, 3: solarized
-    char *command_history[MAX_HISTORY];
-    int history_count;
+    HistoryStore *history;
     int history_index;
+    int last_exit_status;     // of the last execute_command, for history records
+    guint64 last_output_bytes;
+    HistorySearchIndex *history_search;
+    guint history_watch;      // source on history_store_watch_fd, 0 when none
+    GtkWidget *rsearch_label;
+    gboolean rsearch_active;  // Ctrl+R reverse search in progress
+    GString *rsearch_query;
+    int rsearch_match;
+    char *rsearch_saved_text;
+    GtkWidget *status_label;  // CPU/memory/network/disk line under the entry
+    guint status_timer;
     GtkCssProvider *css_provider;
     GtkWidget *suggestion_popup;
     GtkWidget *suggestion_listbox;
@@ -64,8 +98,29 @@ typedef struct {
 void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, GtkTextView *textview);
 void apply_css(AppData *app, const char *css);
 void cycle_theme(AppData *app);
-void add_to_history(AppData *app, const char *command);
+void add_to_history(AppData *app, const char *command, const HistoryRecord *record);
 void show_history(AppData *app);
+void run_history_command(AppData *app, const char *args, GtkTextBuffer *buffer);
+
+// Append-only history log with an mmap'd offset index
+HistoryStore* history_store_open(const char *path);
+void history_store_close(HistoryStore *store);
+gboolean history_store_append(HistoryStore *store, const char *command, const HistoryRecord *record);
+guint history_store_sync(HistoryStore *store);
+guint history_store_count(HistoryStore *store);
+const char* history_store_peek(HistoryStore *store, guint index, gsize *length);
+char* history_store_dup(HistoryStore *store, guint index);
+gboolean history_store_get_record(HistoryStore *store, guint index, HistoryRecord *record);
+GArray* history_store_query(HistoryStore *store, const HistoryQuery *query);
+int history_store_watch_fd(HistoryStore *store);
+guint history_store_poll_changes(HistoryStore *store);
+gboolean on_history_file_changed(gint fd, GIOCondition condition, gpointer user_data);
+
+// Trigram index for incremental reverse history search (Ctrl+R)
+HistorySearchIndex* history_search_index_new(HistoryStore *store);
+void history_search_index_free(HistorySearchIndex *index);
+void history_search_index_update(HistorySearchIndex *index);
+int history_search_find(HistorySearchIndex *index, const char *query, int before);
 void on_run_clicked(GtkButton *button, gpointer user_data);
 void on_clear_clicked(GtkButton *button, gpointer user_data);
 void on_time_clicked(GtkMenuItem *menuitem, gpointer user_data);
@@ -77,6 +132,8 @@ gboolean voice_recognition_complete(gpointer user_data);
 gboolean on_entry_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data);
 void on_entry_changed(GtkEditable *editable, gpointer user_data);
 void on_window_destroy(GtkWidget *widget, gpointer user_data);
+gboolean update_status_label(gpointer user_data);
+void on_status_label_destroy(GtkWidget *widget, gpointer user_data);
 void activate(GtkApplication *app, gpointer user_data);
 void destroy_app_data(AppData *app_data);
 double calculate_expression(const char *expr); // Calculator function
@@ -94,6 +151,17 @@ char* suggest_command(const char* wrong_command);
 char* suggest_typo_fix(const char* text);
 gboolean command_exists_in_path(const char* command);
 
+// Command name index ($PATH executables + history) backing suggest_command
+void command_index_init(void);
+gboolean command_index_is_ready(void);
+void command_index_note_command(const char *command_line);
+char* command_index_lookup(const char *word);
+int command_edit_distance(const char *s1, const char *s2, int max_distance);
+
+// Unknown flag/subcommand correction from cached --help parsing
+typedef void (*FlagFixFunc)(char *suggestion, gpointer user_data);   // takes ownership
+void suggest_flag_fix(const char *command_line, const char *output, FlagFixFunc done, gpointer user_data);
+
 // Main voice recognition function - called directly from button click
 char* recognize_speech_from_mic(void);
 
@@ -135,8 +203,43 @@ typedef struct {
     float cpu_percent;
     long memory_kb;
     char user[64];
+    // /proc/<pid>/io; unreadable for other users' processes without root
+    gboolean io_available;
+    guint64 io_read_bytes;      // storage reads and writes, page cache excluded
+    guint64 io_write_bytes;
+    guint64 io_syscr;           // read and write syscalls
+    guint64 io_syscw;
+    float io_read_rate;         // per second since the previous sample
+    float io_write_rate;
+    float io_syscr_rate;
+    float io_syscw_rate;
 } ProcessInfo;
 
+// Process creation/exit events from the proc connector (proc_events.c)
+typedef enum {
+    PROC_CHANGE_STARTED,
+    PROC_CHANGE_EXEC,
+    PROC_CHANGE_EXITED
+} ProcChange;
+
+typedef struct _ProcEvents ProcEvents;
+typedef void (*ProcEventFunc)(ProcChange change, int pid, gpointer user_data);
+ProcEvents* proc_events_open(void);
+void proc_events_close(ProcEvents *events);
+int proc_events_fd(ProcEvents *events);
+gboolean proc_events_dispatch(ProcEvents *events, ProcEventFunc func, gpointer user_data);
+
+// Incremental /proc scanner (proc_scanner.c)
+typedef struct _ProcScanner ProcScanner;
+ProcScanner* proc_scanner_new(void);
+void proc_scanner_free(ProcScanner *scanner);
+int proc_scanner_refresh(ProcScanner *scanner);
+int proc_scanner_update(ProcScanner *scanner);
+void proc_scanner_track_io(ProcScanner *scanner, gboolean enabled);
+void proc_scanner_apply(ProcScanner *scanner, ProcChange change, int pid);
+gboolean proc_scanner_lookup(ProcScanner *scanner, int pid, ProcessInfo *proc);
+int proc_scanner_snapshot(ProcScanner *scanner, ProcessInfo **processes);
+
 // System Information Functions
 void display_system_info(void);
 void display_memory_info(void);
@@ -151,11 +254,357 @@ void display_temperature_info(void);
 void list_processes_detailed(void);
 int kill_process_by_pid(int pid);
 int get_process_list(ProcessInfo **processes);
+void process_list_track_io(gboolean enabled);
+gboolean get_process_info(int pid, ProcessInfo *info);
+guint process_list_watch(ProcEventFunc func, gpointer user_data);
+void process_list_unwatch(guint id);
 void monitor_syscalls(int pid, int duration_seconds);
 
+// ptrace-based syscall profiler (syscall_tracer.c, syscall_names.c)
+typedef struct _SyscallTracer SyscallTracer;
+
+typedef struct {
+    int nr;
+    guint64 count;
+    guint64 errors;
+    guint64 total_ns;       // time between entry and exit stops
+    guint64 max_ns;
+} SyscallStats;
+
+SyscallTracer* syscall_tracer_start(int pid);
+void syscall_tracer_request_stop(SyscallTracer *tracer);
+void syscall_tracer_stop(SyscallTracer *tracer);
+void syscall_tracer_free(SyscallTracer *tracer);
+gboolean syscall_tracer_running(SyscallTracer *tracer);
+int syscall_tracer_error(SyscallTracer *tracer);
+guint syscall_tracer_snapshot(SyscallTracer *tracer, GArray *stats);
+const char* syscall_name(int nr);
+GtkWidget* create_syscall_trace_dialog(GtkWindow *parent, int pid);
+
+// Proportional memory from /proc/<pid>/smaps_rollup (proc_memory.c)
+typedef struct {
+    long rss_kb;
+    long pss_kb;                // shared pages split among the processes mapping them
+    long uss_kb;                // private pages, freed when the process exits
+    long anon_kb;
+    long swap_kb;
+    long swap_pss_kb;
+} ProcMemory;
+
+typedef struct _ProcMemoryCache ProcMemoryCache;
+gboolean proc_memory_read(int pid, ProcMemory *memory);
+ProcMemoryCache* proc_memory_cache_new(void);
+void proc_memory_cache_free(ProcMemoryCache *cache);
+void proc_memory_cache_request(ProcMemoryCache *cache, const int *pids, guint count);
+void proc_memory_cache_retain(ProcMemoryCache *cache, const int *pids, guint count);
+gboolean proc_memory_cache_lookup(ProcMemoryCache *cache, int pid, ProcMemory *memory);
+GtkWidget* create_memory_map_dialog(GtkWindow *parent, int pid);
+
+// TCP/UDP socket listing over NETLINK_SOCK_DIAG (socket_diag.c)
+#define SOCKET_STATES_ALL 0xffffffffu
+
+typedef struct {
+    guint8 protocol;            // IPPROTO_TCP or IPPROTO_UDP
+    guint8 family;              // AF_INET or AF_INET6
+    guint8 state;               // TCP_* state number; UDP uses ESTABLISHED and CLOSE
+    guint16 local_port;
+    guint16 remote_port;
+    guint8 local_addr[16];      // network byte order, IPv4 in the first 4 bytes
+    guint8 remote_addr[16];
+    guint32 rx_queue;           // listening sockets: pending connections
+    guint32 tx_queue;           // listening sockets: backlog limit
+    guint32 uid;
+    guint64 inode;              // 0 for TIME-WAIT and other orphans
+    gboolean has_tcp_info;
+    guint32 rtt_us;
+    guint32 rttvar_us;
+    guint32 retransmits;        // over the connection's lifetime
+    int pid;                    // owner, 0 when unknown or not looked up
+    char process[16];
+} SocketInfo;
+
+gboolean socket_diag_dump(int protocol, guint32 states, GArray *sockets);
+void socket_diag_find_owners(GArray *sockets);
+const char* socket_state_name(const SocketInfo *sock);
+void socket_format_address(const SocketInfo *sock, gboolean remote, char *text, gsize size);
+GtkWidget* create_socket_inspector_dialog(GtkWindow *parent);
+
+// Non-blocking SIGTERM/SIGKILL escalation over pidfds (process_kill.c)
+#define PROCESS_KILL_DEFAULT_TIMEOUT_MS 2000
+
+typedef enum {
+    PROCESS_KILL_TERMINATED,    // exited after SIGTERM
+    PROCESS_KILL_KILLED,        // needed SIGKILL
+    PROCESS_KILL_FAILED
+} ProcessKillResult;
+
+typedef struct _ProcessKillTarget ProcessKillTarget;
+typedef void (*ProcessKillFunc)(int pid, ProcessKillResult result, int error, gpointer user_data);
+guint process_kill_default_timeout(void);
+ProcessKillTarget* process_kill_target_new(int pid);
+int process_kill_target_pid(const ProcessKillTarget *target);
+void process_kill_target_free(ProcessKillTarget *target);
+gboolean process_kill_start(ProcessKillTarget *target, guint escalate_ms, ProcessKillFunc func, gpointer user_data);
+gboolean process_kill_async(int pid, guint escalate_ms, ProcessKillFunc func, gpointer user_data);
+void process_kill_forget(gpointer user_data);
+ProcessKillResult process_kill_sync(int pid, guint escalate_ms);
+const char* process_kill_result_name(ProcessKillResult result);
+
 // Real-time Statistics
 void get_realtime_stats(double *cpu_usage, double *memory_usage);
 
+// Background sampler of system-wide counters (metrics_sampler.c)
+#define METRICS_DEFAULT_INTERVAL_MS 1000
+
+// Pressure stall information from /proc/pressure/{cpu,memory,io}: the
+// share of time some (or all non-idle) tasks were stalled on a resource
+typedef enum {
+    PSI_CPU,
+    PSI_MEMORY,
+    PSI_IO,
+    PSI_RESOURCES
+} PsiResource;
+
+typedef struct {
+    float some_avg10;           // percent, averaged over 10, 60 and 300 s
+    float some_avg60;
+    float some_avg300;
+    float full_avg10;
+    float full_avg60;
+    float full_avg300;
+    guint64 some_total_us;      // stall time since boot
+    guint64 full_total_us;
+} PsiSample;
+
+// Share of one CPU's (or all CPUs') time over an interval, in percent
+typedef struct {
+    float busy;                 // everything but idle and iowait
+    float user;                 // including nice
+    float system;
+    float iowait;
+    float irq;
+    float softirq;
+    float steal;
+} CpuCoreSample;
+
+typedef struct {
+    gint64 timestamp;           // monotonic microseconds
+    double cpu_percent;
+    CpuCoreSample cpu;          // all cores together
+    double memory_percent;
+    guint64 mem_total_kb;
+    guint64 mem_available_kb;
+    guint64 mem_free_kb;
+    guint64 mem_buffers_kb;
+    guint64 mem_cached_kb;
+    guint64 mem_dirty_kb;
+    guint64 swap_total_kb;
+    guint64 swap_free_kb;
+    guint64 net_rx_bytes;       // all interfaces but loopback, since boot
+    guint64 net_tx_bytes;
+    double net_rx_rate;         // bytes per second over the last interval
+    double net_tx_rate;
+    guint64 disk_read_bytes;    // whole disks, since boot
+    guint64 disk_write_bytes;
+    double disk_read_rate;
+    double disk_write_rate;
+    gboolean psi_available;     // FALSE without CONFIG_PSI or with psi=0
+    PsiSample psi[PSI_RESOURCES];
+} MetricsSample;
+
+#define METRICS_MAX_DISKS 32
+
+// One block device over the last interval, from /proc/diskstats
+typedef struct {
+    char name[32];
+    gboolean stacked;           // dm-*, md*: built on top of other disks
+    double read_rate;           // bytes per second
+    double write_rate;
+    float read_iops;
+    float write_iops;
+    float read_await_ms;        // per completed request, queueing included
+    float write_await_ms;
+    float await_ms;
+    float util_percent;         // share of the interval with requests in flight
+    float queue_depth;          // average requests in flight
+    guint64 read_bytes;         // since boot
+    guint64 write_bytes;
+} DiskDeviceSample;
+
+#define METRICS_MAX_INTERFACES 32
+
+// One network interface over the last interval, from /proc/net/dev
+typedef struct {
+    char name[32];
+    gboolean loopback;
+    int speed_mbps;             // link speed from sysfs, 0 when unknown
+    double rx_bps;              // bits per second
+    double tx_bps;
+    float rx_pps;               // packets per second
+    float tx_pps;
+    float rx_errors;            // per second
+    float tx_errors;
+    float rx_drops;
+    float tx_drops;
+    float link_percent;         // busier direction against the link speed
+    guint64 rx_bytes;           // since boot
+    guint64 tx_bytes;
+} NetInterfaceSample;
+
+typedef struct {
+    gint64 timestamp;           // monotonic microseconds, as in MetricsSample
+    guint count;
+    NetInterfaceSample interfaces[METRICS_MAX_INTERFACES];
+} NetInterfaceSet;
+
+#define METRICS_MAX_SENSORS 64
+
+// One temperature sensor, from a thermal zone or a hwmon tempN_input
+typedef struct {
+    char name[32];              // "thermal_zone0", "hwmon1/temp2"
+    char label[64];             // zone type, or hwmon chip name and tempN_label
+    gboolean valid;             // FALSE when the last read failed, e.g. a sleeping GPU
+    float celsius;
+    float critical_celsius;     // 0 when the sensor has no critical trip point
+} ThermalSensorSample;
+
+typedef struct {
+    gint64 timestamp;           // monotonic microseconds, as in MetricsSample
+    guint count;
+    guint total;                // sensors found; more than count past METRICS_MAX_SENSORS
+    ThermalSensorSample sensors[METRICS_MAX_SENSORS];
+} ThermalSensorSet;
+
+#define METRICS_TOP_PROCESSES 10
+
+// The busiest processes of one sample: the top METRICS_TOP_PROCESSES by
+// CPU, then the top by memory that were not among them
+typedef struct {
+    gint64 timestamp;           // monotonic microseconds, as in MetricsSample
+    guint total;                // processes scanned
+    guint count;
+    ProcessInfo processes[2 * METRICS_TOP_PROCESSES];
+} ProcessTopSet;
+
+// Fixed for the life of the machine, so /proc/cpuinfo is read only once
+typedef struct {
+    char model[128];
+    guint logical;              // processors the kernel lists
+    guint cores;                // physical cores over all packages
+    guint packages;
+    float max_mhz;              // 0 without cpufreq
+} CpuIdentity;
+
+const CpuIdentity* metrics_sampler_cpu_identity(void);
+void metrics_sampler_start(guint interval_ms);
+void metrics_sampler_stop(void);
+void metrics_sampler_set_interval(guint interval_ms);
+guint metrics_sampler_interval(void);
+gboolean metrics_sampler_latest(MetricsSample *sample);
+guint metrics_sampler_history(MetricsSample *samples, guint max);
+guint metrics_sampler_cpu_count(void);
+guint metrics_sampler_cpu_since(guint64 *cursor, CpuCoreSample *cores, guint max);
+guint metrics_sampler_disks(DiskDeviceSample *disks, guint max);
+guint metrics_sampler_network_since(guint64 *cursor, NetInterfaceSet *sets, guint max);
+guint metrics_sampler_sensors_since(guint64 *cursor, ThermalSensorSet *sets, guint max);
+void metrics_sampler_track_sensors(gboolean enabled);
+void metrics_sampler_track_processes(gboolean enabled);
+gboolean metrics_sampler_top_processes(ProcessTopSet *set);
+
+// Per-core CPU sparklines for the System Monitor (cpu_monitor.c)
+GtkWidget* cpu_monitor_new(void);
+
+// Live per-device disk table (disk_panel.c)
+GtkWidget* disk_panel_new(void);
+
+// Live per-interface network table and rate graph (network_panel.c)
+GtkWidget* network_panel_new(void);
+
+// Temperature table and history graph (thermal_panel.c)
+GtkWidget* thermal_panel_new(void);
+
+// Kernel PSI triggers, waited on with poll() (psi_monitor.c)
+typedef struct {
+    gint64 timestamp;           // monotonic microseconds
+    PsiResource resource;
+    gboolean full;              // all non-idle tasks stalled, not just some
+    float avg10;                // when the trigger fired
+} PsiStallEvent;
+
+gboolean psi_monitor_start(void);
+void psi_monitor_stop(void);
+guint psi_monitor_triggers(guint *stall_ms, int *error);
+guint psi_monitor_events_since(guint64 *cursor, PsiStallEvent *events, guint max);
+gboolean psi_monitor_latest_stall(PsiStallEvent *event);
+const char* psi_resource_name(PsiResource resource);
+
+// Live pressure averages and stall events (psi_panel.c)
+GtkWidget* psi_panel_new(void);
+
+// Prometheus text endpoint served from the sampler (metrics_exporter.c)
+gboolean metrics_exporter_start(void);
+void metrics_exporter_stop(void);
+
+// cgroup v2 hierarchy walker and explorer dialog (cgroup_explorer.c)
+typedef struct {
+    char name[256];             // directory name, "/" for the root
+    int parent;                 // index in the same array, -1 for the root
+    int depth;
+    gboolean has_cpu;           // cpu.stat was readable
+    gboolean has_memory;        // memory.current was readable (not at the root)
+    gboolean has_io;
+    float cpu_percent;          // of one CPU, since the previous walk
+    float throttled_percent;    // share of that time spent throttled
+    guint64 memory_current;     // bytes, descendants included
+    guint64 memory_max;         // bytes, 0 when unlimited
+    guint64 memory_anon;
+    guint64 memory_file;
+    double io_read_rate;        // bytes per second, all devices
+    double io_write_rate;
+    float io_iops;              // reads and writes per second
+} CgroupInfo;
+
+typedef struct _CgroupWalker CgroupWalker;
+CgroupWalker* cgroup_walker_new(const char *root);
+void cgroup_walker_free(CgroupWalker *walker);
+gboolean cgroup_walker_refresh(CgroupWalker *walker, GArray *groups);
+const char* cgroup_walker_root(CgroupWalker *walker);
+GtkWidget* create_cgroup_explorer_dialog(GtkWindow *parent);
+
+// Parallel du-style directory walker and analyzer dialog (disk_analyzer.c)
+typedef struct _DuScanner DuScanner;
+typedef struct _DuNode DuNode;
+
+typedef struct {
+    guint64 bytes;              // allocated, st_blocks * 512, this directory included
+    guint64 files;              // everything but directories, hard links counted once
+    guint64 dirs;               // directories below this one
+    gboolean complete;          // the whole subtree has been listed
+    int error;                  // errno when this directory could not be read
+} DuStats;
+
+typedef struct {
+    guint threads;
+    guint64 errors;             // entries and directories that could not be read
+    guint64 hard_links;         // further links to files already counted
+    guint64 steals;             // directories taken from another thread's deque
+    double elapsed;             // seconds, up to the end of the walk
+    gboolean finished;
+    gboolean cancelled;
+} DuProgress;
+
+DuScanner* du_scanner_start(const char *path, gboolean one_filesystem);
+void du_scanner_cancel(DuScanner *scanner);
+void du_scanner_wait(DuScanner *scanner);
+void du_scanner_free(DuScanner *scanner);
+gboolean du_scanner_finished(DuScanner *scanner);
+void du_scanner_progress(DuScanner *scanner, DuProgress *progress);
+DuNode* du_scanner_root(DuScanner *scanner);
+const char* du_node_name(const DuNode *node);
+void du_node_stats(DuNode *node, DuStats *stats);
+guint du_node_children(DuScanner *scanner, DuNode *node, guint from, GPtrArray *children);
+GtkWidget* create_disk_analyzer_dialog(GtkWindow *parent);
+
 // GTK Integration Functions
 GtkWidget* create_system_info_dialog(GtkWindow *parent);
 GtkWidget* create_memory_info_dialog(GtkWindow *parent);
@@ -168,8 +617,11 @@ void on_system_monitor_clicked(GtkMenuItem *menuitem, gpointer user_data);
 void on_memory_monitor_clicked(GtkMenuItem *menuitem, gpointer user_data);
 void on_filesystem_monitor_clicked(GtkMenuItem *menuitem, gpointer user_data);
 void on_process_manager_clicked(GtkMenuItem *menuitem, gpointer user_data);
+void on_cgroup_explorer_clicked(GtkMenuItem *menuitem, gpointer user_data);
 void on_network_info_clicked(GtkMenuItem *menuitem, gpointer user_data);
+void on_connections_clicked(GtkMenuItem *menuitem, gpointer user_data);
 void on_disk_usage_clicked(GtkMenuItem *menuitem, gpointer user_data);
+void on_disk_analyzer_clicked(GtkMenuItem *menuitem, gpointer user_data);
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -0,0 +1,892 @@
+// disk_analyzer.c
+// du-style directory sizes for one tree, where statvfs only gives the
+// totals of the whole filesystem. Directories are listed with getdents64
+// and every entry is stat'ed with fstatat(AT_SYMLINK_NOFOLLOW) relative to
+// the open directory, so symlinks are sized as links and never followed.
+// Subdirectories are opened with openat(O_NOFOLLOW) while their parent is
+// still open and queued as descriptors, so no path is ever resolved again
+// and a directory swapped for a symlink mid-walk cannot lead outside the
+// tree. Past a quarter of the soft RLIMIT_NOFILE, queued directories hold
+// no descriptor; they are reopened from the root one component at a time,
+// again without following symlinks, and must still be the same inode.
+// Sizes are allocated bytes (st_blocks * 512), which is what du reports,
+// and a file with several hard links is counted once, at the first
+// (dev, inode) seen.
+//
+// The walk runs on one thread per CPU (COMMAND_SPHERE_DU_THREADS to
+// override). Each thread has its own deque of directories still to list:
+// it pushes and pops at the tail, so it goes depth first over directories
+// it has just seen, and an idle thread steals from the head of another
+// thread's deque, where the shallow directories with the most work under
+// them are. Whatever a directory adds is propagated to all its ancestors
+// with atomic adds, so every node's figures are a lower bound that only
+// grows, and the dialog shows them while the scan is still running.
+//
+// The dialog loads rows lazily: a directory's children are inserted when
+// it is expanded, and rows already in the tree are refreshed on a timer.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+
+#define DU_DENTS_BUFFER (64 * 1024)
+#define DU_LOCK_SHARDS 64
+#define DU_MAX_THREADS 64
+#define DU_IDLE_WAIT_US 2000           // bounds a wake-up lost between a failed steal and the wait
+#define DU_REFRESH_MS 250
+
+typedef struct {
+    guint64 d_ino;
+    gint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+} LinuxDirent64;
+
+struct _DuNode {
+    DuNode *parent;
+    char *name;                 // the full path for the root
+    _Atomic guint64 bytes;      // this directory and everything found below it
+    _Atomic guint64 files;
+    _Atomic guint64 dirs;
+    _Atomic gint pending;       // this directory plus subdirectories not yet listed
+    _Atomic int error;
+    GPtrArray *children;        // DuNode*, NULL until the first; under du_child_lock()
+};
+
+typedef struct {
+    DuNode *node;
+    int fd;                     // the open directory, -1 when over the budget
+    dev_t dev;                  // what a reopen has to find
+    ino_t ino;
+} DuWork;
+
+typedef struct {
+    GMutex lock;
+    GQueue items;               // DuWork*, the owner's end is the tail
+} DuDeque;
+
+typedef struct {
+    DuScanner *scanner;
+    guint index;
+    guint32 seed;               // picks steal victims
+    char *dents;
+} DuWorker;
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+} DuInode;
+
+struct _DuScanner {
+    DuNode *root;
+    int root_fd;                // open for the whole walk, reopens start here
+    dev_t root_dev;
+    gboolean one_filesystem;
+    guint thread_count;
+    GThread **threads;          // NULL once joined
+    DuWorker *workers;
+    DuDeque *deques;
+    _Atomic guint64 outstanding;    // directories queued or being listed
+    _Atomic gint open_fds;          // descriptors held by queued directories
+    gint fd_budget;
+    _Atomic guint running;
+    _Atomic gboolean cancelled;
+    _Atomic guint sleepers;
+    _Atomic guint64 errors;
+    _Atomic guint64 hard_links;
+    _Atomic guint64 steals;
+    gint64 started_at;
+    _Atomic gint64 finished_at;
+    GMutex idle_lock;
+    GCond idle_cond;
+    GMutex child_locks[DU_LOCK_SHARDS];
+    GMutex inode_locks[DU_LOCK_SHARDS];
+    GHashTable *inodes[DU_LOCK_SHARDS];     // DuInode* of files with more than one link
+};
+
+static guint du_inode_hash(gconstpointer key) {
+    const DuInode *inode = key;
+    return g_int64_hash(&(gint64){ (gint64)inode->ino }) ^ (guint)inode->dev;
+}
+
+static gboolean du_inode_equal(gconstpointer a, gconstpointer b) {
+    const DuInode *x = a, *y = b;
+    return x->ino == y->ino && x->dev == y->dev;
+}
+
+static GMutex* du_child_lock(DuScanner *scanner, DuNode *node) {
+    return &scanner->child_locks[((guintptr)node >> 4) % DU_LOCK_SHARDS];
+}
+
+static DuNode* du_node_new(DuNode *parent, const char *name, guint64 bytes) {
+    DuNode *node = g_new0(DuNode, 1);
+    node->parent = parent;
+    node->name = g_strdup(name);
+    atomic_init(&node->bytes, bytes);
+    atomic_init(&node->files, 0);
+    atomic_init(&node->dirs, 0);
+    atomic_init(&node->pending, 1);
+    atomic_init(&node->error, 0);
+    return node;
+}
+
+static void du_add(DuNode *node, guint64 bytes, guint64 files, guint64 dirs) {
+    for (; node; node = node->parent) {
+        atomic_fetch_add_explicit(&node->bytes, bytes, memory_order_relaxed);
+        atomic_fetch_add_explicit(&node->files, files, memory_order_relaxed);
+        atomic_fetch_add_explicit(&node->dirs, dirs, memory_order_relaxed);
+    }
+}
+
+// A directory is complete once it and all its subdirectories are listed
+static void du_finish(DuNode *node) {
+    while (node && atomic_fetch_sub(&node->pending, 1) == 1) node = node->parent;
+}
+
+// TRUE when another link to the same file was counted already
+static gboolean du_seen_inode(DuScanner *scanner, dev_t dev, ino_t ino) {
+    DuInode key = { dev, ino };
+    guint shard = du_inode_hash(&key) % DU_LOCK_SHARDS;
+    gboolean seen;
+
+    g_mutex_lock(&scanner->inode_locks[shard]);
+    seen = g_hash_table_contains(scanner->inodes[shard], &key);
+    if (!seen) {
+        DuInode *inode = g_new(DuInode, 1);
+        *inode = key;
+        g_hash_table_add(scanner->inodes[shard], inode);
+    }
+    g_mutex_unlock(&scanner->inode_locks[shard]);
+    return seen;
+}
+
+static void du_push(DuWorker *worker, DuNode *node, int fd, const struct stat *st) {
+    DuScanner *scanner = worker->scanner;
+    DuWork *work = g_new(DuWork, 1);
+    work->node = node;
+    work->fd = fd;
+    work->dev = st->st_dev;
+    work->ino = st->st_ino;
+
+    atomic_fetch_add(&scanner->outstanding, 1);
+    DuDeque *deque = &scanner->deques[worker->index];
+    g_mutex_lock(&deque->lock);
+    g_queue_push_tail(&deque->items, work);
+    g_mutex_unlock(&deque->lock);
+
+    if (atomic_load_explicit(&scanner->sleepers, memory_order_relaxed) > 0) {
+        g_mutex_lock(&scanner->idle_lock);
+        g_cond_signal(&scanner->idle_cond);
+        g_mutex_unlock(&scanner->idle_lock);
+    }
+}
+
+static DuWork* du_take(DuWorker *worker) {
+    DuScanner *scanner = worker->scanner;
+    DuDeque *own = &scanner->deques[worker->index];
+
+    g_mutex_lock(&own->lock);
+    DuWork *work = g_queue_pop_tail(&own->items);
+    g_mutex_unlock(&own->lock);
+    if (work || scanner->thread_count == 1) return work;
+
+    // Nothing of our own: steal the oldest directory of someone else,
+    // starting from a random victim so idle threads spread out
+    worker->seed ^= worker->seed << 13;
+    worker->seed ^= worker->seed >> 17;
+    worker->seed ^= worker->seed << 5;
+    guint start = worker->seed % scanner->thread_count;
+    for (guint i = 0; i < scanner->thread_count && !work; i++) {
+        guint victim = (start + i) % scanner->thread_count;
+        if (victim == worker->index) continue;
+
+        DuDeque *deque = &scanner->deques[victim];
+        g_mutex_lock(&deque->lock);
+        work = g_queue_pop_head(&deque->items);
+        g_mutex_unlock(&deque->lock);
+    }
+    if (work) atomic_fetch_add_explicit(&scanner->steals, 1, memory_order_relaxed);
+    return work;
+}
+
+static int du_open_child(int dir_fd, const char *name) {
+    return openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+}
+
+static void du_close(DuScanner *scanner, int fd) {
+    close(fd);
+    atomic_fetch_sub_explicit(&scanner->open_fds, 1, memory_order_relaxed);
+}
+
+// A directory queued without a descriptor: walk down from the root through
+// the node names, then make sure it is still the directory that was queued
+static int du_reopen(DuScanner *scanner, DuWork *work) {
+    GPtrArray *chain = g_ptr_array_new();
+    for (DuNode *node = work->node; node->parent; node = node->parent) g_ptr_array_add(chain, node);
+
+    int fd = scanner->root_fd;
+    for (guint i = chain->len; i > 0 && fd >= 0; i--) {
+        int child = du_open_child(fd, ((DuNode *)chain->pdata[i - 1])->name);
+        int error = errno;
+        if (fd != scanner->root_fd) close(fd);
+        errno = error;
+        fd = child;
+    }
+    g_ptr_array_free(chain, TRUE);
+    if (fd < 0) return -1;
+
+    if (fd == scanner->root_fd) {
+        fd = fcntl(scanner->root_fd, F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_dev != work->dev || st.st_ino != work->ino) {
+        close(fd);
+        errno = ENOENT;
+        return -1;
+    }
+    atomic_fetch_add_explicit(&scanner->open_fds, 1, memory_order_relaxed);
+    return fd;
+}
+
+static void du_list(DuWorker *worker, DuWork *work) {
+    DuScanner *scanner = worker->scanner;
+    DuNode *node = work->node;
+
+    int fd = work->fd >= 0 ? work->fd : du_reopen(scanner, work);
+    if (fd < 0) {
+        atomic_store(&node->error, errno);
+        atomic_fetch_add(&scanner->errors, 1);
+        du_finish(node);
+        return;
+    }
+
+    // Totals of this directory's entries, propagated once at the end
+    guint64 bytes = 0, files = 0, dirs = 0;
+    long count = 0;
+    while (!atomic_load_explicit(&scanner->cancelled, memory_order_relaxed) &&
+           (count = syscall(SYS_getdents64, fd, worker->dents, DU_DENTS_BUFFER)) > 0) {
+        for (long offset = 0; offset < count; ) {
+            LinuxDirent64 *entry = (LinuxDirent64 *)(worker->dents + offset);
+            offset += entry->d_reclen;
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+            struct stat st;
+            if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+                atomic_fetch_add(&scanner->errors, 1);
+                continue;
+            }
+            guint64 allocated = (guint64)st.st_blocks * 512;
+
+            if (S_ISDIR(st.st_mode)) {
+                // Mount points below the root are left out, like du -x
+                if (scanner->one_filesystem && st.st_dev != scanner->root_dev) continue;
+
+                DuNode *child = du_node_new(node, name, allocated);
+                atomic_fetch_add(&node->pending, 1);
+                GMutex *lock = du_child_lock(scanner, node);
+                g_mutex_lock(lock);
+                if (!node->children) node->children = g_ptr_array_new();
+                g_ptr_array_add(node->children, child);
+                g_mutex_unlock(lock);
+
+                // Over the budget, or out of descriptors, it is reopened later
+                int child_fd = -1, error = 0;
+                if (atomic_fetch_add_explicit(&scanner->open_fds, 1, memory_order_relaxed) < scanner->fd_budget) {
+                    child_fd = du_open_child(fd, name);
+                    error = child_fd < 0 ? errno : 0;
+                }
+                if (child_fd < 0) {
+                    atomic_fetch_sub_explicit(&scanner->open_fds, 1, memory_order_relaxed);
+                }
+                if (error && error != EMFILE && error != ENFILE) {
+                    // Gone or not accessible, e.g. EACCES, or ELOOP after a swap
+                    atomic_store(&child->error, error);
+                    atomic_fetch_add(&scanner->errors, 1);
+                    du_finish(child);
+                } else {
+                    du_push(worker, child, child_fd, &st);
+                }
+                bytes += allocated;
+                dirs++;
+            } else {
+                if (st.st_nlink > 1 && du_seen_inode(scanner, st.st_dev, st.st_ino)) {
+                    atomic_fetch_add_explicit(&scanner->hard_links, 1, memory_order_relaxed);
+                    continue;
+                }
+                bytes += allocated;
+                files++;
+            }
+        }
+    }
+    if (count < 0) {
+        atomic_store(&node->error, errno);
+        atomic_fetch_add(&scanner->errors, 1);
+    }
+    du_close(scanner, fd);
+
+    du_add(node, bytes, files, dirs);
+    du_finish(node);
+}
+
+static gpointer du_worker(gpointer data) {
+    DuWorker *worker = data;
+    DuScanner *scanner = worker->scanner;
+
+    while (!atomic_load(&scanner->cancelled)) {
+        DuWork *work = du_take(worker);
+        if (!work) {
+            if (atomic_load(&scanner->outstanding) == 0) break;
+
+            g_mutex_lock(&scanner->idle_lock);
+            atomic_fetch_add(&scanner->sleepers, 1);
+            g_cond_wait_until(&scanner->idle_cond, &scanner->idle_lock,
+                              g_get_monotonic_time() + DU_IDLE_WAIT_US);
+            atomic_fetch_sub(&scanner->sleepers, 1);
+            g_mutex_unlock(&scanner->idle_lock);
+            continue;
+        }
+
+        du_list(worker, work);
+        g_free(work);
+
+        // The last directory: wake the others so they see the walk is over
+        if (atomic_fetch_sub(&scanner->outstanding, 1) == 1) {
+            g_mutex_lock(&scanner->idle_lock);
+            g_cond_broadcast(&scanner->idle_cond);
+            g_mutex_unlock(&scanner->idle_lock);
+        }
+    }
+
+    if (atomic_fetch_sub(&scanner->running, 1) == 1) {
+        atomic_store(&scanner->finished_at, g_get_monotonic_time());
+    }
+    return NULL;
+}
+
+DuScanner* du_scanner_start(const char *path, gboolean one_filesystem) {
+    // The root itself may be reached through a symlink
+    char *real = realpath(path, NULL);
+    if (!real) return NULL;
+
+    struct stat st;
+    int root_fd = open(real, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0 || fstat(root_fd, &st) < 0) {
+        int error = errno;
+        if (root_fd >= 0) close(root_fd);
+        free(real);
+        errno = error;
+        return NULL;
+    }
+
+    const char *env = getenv("COMMAND_SPHERE_DU_THREADS");
+    guint threads = env ? (guint)strtoul(env, NULL, 10) : 0;
+    if (threads == 0) threads = g_get_num_processors();
+    threads = CLAMP(threads, 1, DU_MAX_THREADS);
+
+    DuScanner *scanner = g_new0(DuScanner, 1);
+    scanner->root = du_node_new(NULL, real, (guint64)st.st_blocks * 512);
+    scanner->root_fd = root_fd;
+    scanner->root_dev = st.st_dev;
+    scanner->one_filesystem = one_filesystem;
+    scanner->thread_count = threads;
+    scanner->started_at = g_get_monotonic_time();
+    atomic_init(&scanner->outstanding, 0);
+    atomic_init(&scanner->open_fds, 0);
+    struct rlimit limit;
+    rlim_t soft = getrlimit(RLIMIT_NOFILE, &limit) == 0 ? limit.rlim_cur : 1024;
+    if (soft == RLIM_INFINITY || soft > G_MAXINT) soft = G_MAXINT;
+    // The /proc scanner may take half; a quarter still queues deep trees whole
+    scanner->fd_budget = MAX((gint)(soft / 4), 1);
+    atomic_init(&scanner->running, threads);
+    atomic_init(&scanner->cancelled, FALSE);
+    atomic_init(&scanner->sleepers, 0);
+    atomic_init(&scanner->errors, 0);
+    atomic_init(&scanner->hard_links, 0);
+    atomic_init(&scanner->steals, 0);
+    atomic_init(&scanner->finished_at, 0);
+    g_mutex_init(&scanner->idle_lock);
+    g_cond_init(&scanner->idle_cond);
+    for (guint i = 0; i < DU_LOCK_SHARDS; i++) {
+        g_mutex_init(&scanner->child_locks[i]);
+        g_mutex_init(&scanner->inode_locks[i]);
+        scanner->inodes[i] = g_hash_table_new_full(du_inode_hash, du_inode_equal, g_free, NULL);
+    }
+
+    scanner->deques = g_new0(DuDeque, threads);
+    scanner->workers = g_new0(DuWorker, threads);
+    for (guint i = 0; i < threads; i++) {
+        g_mutex_init(&scanner->deques[i].lock);
+        g_queue_init(&scanner->deques[i].items);
+        scanner->workers[i].scanner = scanner;
+        scanner->workers[i].index = i;
+        scanner->workers[i].seed = g_random_int() | 1;
+        scanner->workers[i].dents = g_malloc(DU_DENTS_BUFFER);
+    }
+
+    // The first thread starts on the root; the rest steal from it
+    int fd = fcntl(root_fd, F_DUPFD_CLOEXEC, 0);
+    if (fd >= 0) atomic_fetch_add_explicit(&scanner->open_fds, 1, memory_order_relaxed);
+    du_push(&scanner->workers[0], scanner->root, fd, &st);
+    free(real);
+    scanner->threads = g_new0(GThread *, threads);
+    for (guint i = 0; i < threads; i++) {
+        scanner->threads[i] = g_thread_new("du-scan", du_worker, &scanner->workers[i]);
+    }
+    return scanner;
+}
+
+void du_scanner_cancel(DuScanner *scanner) {
+    if (!scanner) return;
+    atomic_store(&scanner->cancelled, TRUE);
+    g_mutex_lock(&scanner->idle_lock);
+    g_cond_broadcast(&scanner->idle_cond);
+    g_mutex_unlock(&scanner->idle_lock);
+}
+
+void du_scanner_wait(DuScanner *scanner) {
+    if (!scanner || !scanner->threads) return;
+    for (guint i = 0; i < scanner->thread_count; i++) g_thread_join(scanner->threads[i]);
+    g_clear_pointer(&scanner->threads, g_free);
+}
+
+void du_scanner_free(DuScanner *scanner) {
+    if (!scanner) return;
+    du_scanner_cancel(scanner);
+    du_scanner_wait(scanner);
+
+    // Directories a cancelled walk never got to
+    for (guint i = 0; i < scanner->thread_count; i++) {
+        DuWork *work;
+        while ((work = g_queue_pop_head(&scanner->deques[i].items))) {
+            if (work->fd >= 0) du_close(scanner, work->fd);
+            g_free(work);
+        }
+        g_mutex_clear(&scanner->deques[i].lock);
+        g_free(scanner->workers[i].dents);
+    }
+    g_free(scanner->deques);
+    g_free(scanner->workers);
+
+    // Iteratively, deep trees would overflow the stack
+    GPtrArray *stack = g_ptr_array_new();
+    g_ptr_array_add(stack, scanner->root);
+    while (stack->len > 0) {
+        DuNode *node = g_ptr_array_remove_index_fast(stack, stack->len - 1);
+        if (node->children) {
+            for (guint i = 0; i < node->children->len; i++) g_ptr_array_add(stack, node->children->pdata[i]);
+            g_ptr_array_free(node->children, TRUE);
+        }
+        g_free(node->name);
+        g_free(node);
+    }
+    g_ptr_array_free(stack, TRUE);
+
+    for (guint i = 0; i < DU_LOCK_SHARDS; i++) {
+        g_mutex_clear(&scanner->child_locks[i]);
+        g_mutex_clear(&scanner->inode_locks[i]);
+        g_hash_table_destroy(scanner->inodes[i]);
+    }
+    g_mutex_clear(&scanner->idle_lock);
+    g_cond_clear(&scanner->idle_cond);
+    close(scanner->root_fd);
+    g_free(scanner);
+}
+
+gboolean du_scanner_finished(DuScanner *scanner) {
+    return atomic_load(&scanner->running) == 0;
+}
+
+void du_scanner_progress(DuScanner *scanner, DuProgress *progress) {
+    gint64 finished_at = atomic_load(&scanner->finished_at);
+    gint64 end = finished_at ? finished_at : g_get_monotonic_time();
+
+    progress->threads = scanner->thread_count;
+    progress->errors = atomic_load_explicit(&scanner->errors, memory_order_relaxed);
+    progress->hard_links = atomic_load_explicit(&scanner->hard_links, memory_order_relaxed);
+    progress->steals = atomic_load_explicit(&scanner->steals, memory_order_relaxed);
+    progress->elapsed = (end - scanner->started_at) / (double)G_USEC_PER_SEC;
+    progress->finished = finished_at != 0;
+    progress->cancelled = atomic_load(&scanner->cancelled);
+}
+
+DuNode* du_scanner_root(DuScanner *scanner) {
+    return scanner->root;
+}
+
+const char* du_node_name(const DuNode *node) {
+    return node->name;
+}
+
+void du_node_stats(DuNode *node, DuStats *stats) {
+    stats->bytes = atomic_load_explicit(&node->bytes, memory_order_relaxed);
+    stats->files = atomic_load_explicit(&node->files, memory_order_relaxed);
+    stats->dirs = atomic_load_explicit(&node->dirs, memory_order_relaxed);
+    stats->complete = atomic_load(&node->pending) == 0;
+    stats->error = atomic_load(&node->error);
+}
+
+guint du_node_children(DuScanner *scanner, DuNode *node, guint from, GPtrArray *children) {
+    guint added = 0;
+    GMutex *lock = du_child_lock(scanner, node);
+    g_mutex_lock(lock);
+    for (guint i = from; node->children && i < node->children->len; i++, added++) {
+        g_ptr_array_add(children, node->children->pdata[i]);
+    }
+    g_mutex_unlock(lock);
+    return added;
+}
+
+// Disk Analyzer dialog
+
+enum {
+    DU_COL_NAME,
+    DU_COL_BYTES,
+    DU_COL_FILES,
+    DU_COL_DIRS,
+    DU_COL_PERCENT,             // of the parent directory
+    DU_COL_STATUS,
+    DU_COL_NODE,                // NULL for the placeholder under an unexpanded row
+    DU_N_COLUMNS
+};
+
+typedef struct {
+    GtkTreeRowReference *row;   // in the store, not the sorted model
+    guint shown;                // children inserted so far
+    gboolean expanded;          // children are inserted as the scan finds them
+    gboolean placeholder;       // has the dummy child that makes it expandable
+} DuRow;
+
+typedef struct {
+    GtkWidget *dialog;
+    GtkWidget *path_entry;
+    GtkWidget *one_filesystem;
+    GtkWidget *scan_button;
+    GtkWidget *status_label;
+    GtkWidget *view;
+    GtkTreeStore *store;
+    GtkTreeModel *sorted;
+    GHashTable *rows;           // DuNode* -> DuRow*
+    DuScanner *scanner;
+    gboolean root_open;
+    guint timer;
+} DiskAnalyzer;
+
+static void du_row_free(gpointer data) {
+    DuRow *row = data;
+    gtk_tree_row_reference_free(row->row);
+    g_free(row);
+}
+
+static gboolean du_row_iter(DiskAnalyzer *analyzer, DuRow *row, GtkTreeIter *iter) {
+    GtkTreePath *path = gtk_tree_row_reference_get_path(row->row);
+    if (!path) return FALSE;
+    gboolean found = gtk_tree_model_get_iter(GTK_TREE_MODEL(analyzer->store), iter, path);
+    gtk_tree_path_free(path);
+    return found;
+}
+
+static void du_update_row(DiskAnalyzer *analyzer, DuNode *node, DuRow *row) {
+    GtkTreeIter iter;
+    if (!du_row_iter(analyzer, row, &iter)) return;
+
+    DuStats stats;
+    du_node_stats(node, &stats);
+    guint64 parent_bytes = node->parent ? atomic_load_explicit(&node->parent->bytes, memory_order_relaxed)
+                                        : stats.bytes;
+    int percent = parent_bytes > 0 ? (int)MIN(stats.bytes * 100 / parent_bytes, 100) : 0;
+    const char *status = stats.error ? g_strerror(stats.error)
+                       : stats.complete ? ""
+                       : atomic_load(&analyzer->scanner->cancelled) ? "incomplete" : "scanning…";
+
+    gtk_tree_store_set(analyzer->store, &iter,
+                       DU_COL_BYTES, stats.bytes,
+                       DU_COL_FILES, stats.files,
+                       DU_COL_DIRS, stats.dirs,
+                       DU_COL_PERCENT, percent,
+                       DU_COL_STATUS, status,
+                       -1);
+
+    if (!row->expanded && !row->placeholder && stats.dirs > 0) {
+        gtk_tree_store_insert_with_values(analyzer->store, NULL, &iter, -1,
+                                          DU_COL_NAME, "…", DU_COL_NODE, NULL, -1);
+        row->placeholder = TRUE;
+    }
+}
+
+static void du_insert_row(DiskAnalyzer *analyzer, GtkTreeIter *parent, DuNode *node) {
+    GtkTreeModel *model = GTK_TREE_MODEL(analyzer->store);
+    GtkTreeIter iter;
+    gtk_tree_store_insert_with_values(analyzer->store, &iter, parent, -1,
+                                      DU_COL_NAME, du_node_name(node),
+                                      DU_COL_NODE, node,
+                                      -1);
+
+    DuRow *row = g_new0(DuRow, 1);
+    GtkTreePath *path = gtk_tree_model_get_path(model, &iter);
+    row->row = gtk_tree_row_reference_new(model, path);
+    gtk_tree_path_free(path);
+    g_hash_table_insert(analyzer->rows, node, row);
+    du_update_row(analyzer, node, row);
+}
+
+static void du_load_children(DiskAnalyzer *analyzer, DuNode *node, DuRow *row) {
+    GtkTreeIter iter;
+    if (!du_row_iter(analyzer, row, &iter)) return;
+
+    GPtrArray *children = g_ptr_array_new();
+    row->shown += du_node_children(analyzer->scanner, node, row->shown, children);
+    for (guint i = 0; i < children->len; i++) du_insert_row(analyzer, &iter, children->pdata[i]);
+    g_ptr_array_free(children, TRUE);
+}
+
+static void du_update_status(DiskAnalyzer *analyzer) {
+    DuStats stats;
+    DuProgress progress;
+    du_node_stats(du_scanner_root(analyzer->scanner), &stats);
+    du_scanner_progress(analyzer->scanner, &progress);
+
+    char *size = g_format_size(stats.bytes);
+    const char *state = !progress.finished ? "Scanning" : progress.cancelled ? "Cancelled" : "Scanned";
+    char text[512];
+    int length = snprintf(text, sizeof(text),
+                          "%s %s: %s in %" G_GUINT64_FORMAT " files, %" G_GUINT64_FORMAT " directories — "
+                          "%.1f s, %.0f files/s on %u threads",
+                          state, du_node_name(du_scanner_root(analyzer->scanner)), size,
+                          stats.files, stats.dirs, progress.elapsed,
+                          progress.elapsed > 0 ? stats.files / progress.elapsed : 0.0, progress.threads);
+    if (progress.hard_links > 0 && length < (int)sizeof(text)) {
+        length += snprintf(text + length, sizeof(text) - length, ", %" G_GUINT64_FORMAT " extra hard links not counted",
+                           progress.hard_links);
+    }
+    if (progress.errors > 0 && length < (int)sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, ", %" G_GUINT64_FORMAT " unreadable", progress.errors);
+    }
+    gtk_label_set_text(GTK_LABEL(analyzer->status_label), text);
+    g_free(size);
+}
+
+static gboolean on_du_timer(gpointer user_data) {
+    DiskAnalyzer *analyzer = user_data;
+    // Checked first, so the last refresh sees the final figures
+    gboolean finished = du_scanner_finished(analyzer->scanner);
+
+    GPtrArray *expanded = g_ptr_array_new();
+    GHashTableIter rows;
+    gpointer key, value;
+    g_hash_table_iter_init(&rows, analyzer->rows);
+    while (g_hash_table_iter_next(&rows, &key, &value)) {
+        du_update_row(analyzer, key, value);
+        if (((DuRow *)value)->expanded) g_ptr_array_add(expanded, key);
+    }
+    for (guint i = 0; i < expanded->len; i++) {
+        DuNode *node = expanded->pdata[i];
+        du_load_children(analyzer, node, g_hash_table_lookup(analyzer->rows, node));
+    }
+    g_ptr_array_free(expanded, TRUE);
+
+    // The root opens by itself once it has something to show
+    DuRow *root = g_hash_table_lookup(analyzer->rows, du_scanner_root(analyzer->scanner));
+    if (!analyzer->root_open && root && root->shown > 0) {
+        GtkTreePath *path = gtk_tree_path_new_first();
+        gtk_tree_view_expand_row(GTK_TREE_VIEW(analyzer->view), path, FALSE);
+        gtk_tree_path_free(path);
+        analyzer->root_open = TRUE;
+    }
+
+    du_update_status(analyzer);
+    if (!finished) return G_SOURCE_CONTINUE;
+
+    gtk_button_set_label(GTK_BUTTON(analyzer->scan_button), "_Scan");
+    analyzer->timer = 0;
+    return G_SOURCE_REMOVE;
+}
+
+// Children go in just before the row opens, in place of the placeholder
+static gboolean on_du_test_expand_row(GtkTreeView *view, GtkTreeIter *sorted_iter,
+                                      GtkTreePath *path, gpointer user_data) {
+    DiskAnalyzer *analyzer = user_data;
+    GtkTreeModel *model = GTK_TREE_MODEL(analyzer->store);
+    GtkTreeIter iter, child;
+    DuNode *node = NULL;
+
+    gtk_tree_model_sort_convert_iter_to_child_iter(GTK_TREE_MODEL_SORT(analyzer->sorted), &iter, sorted_iter);
+    gtk_tree_model_get(model, &iter, DU_COL_NODE, &node, -1);
+    DuRow *row = node ? g_hash_table_lookup(analyzer->rows, node) : NULL;
+    if (!row || row->expanded) return FALSE;
+
+    row->expanded = TRUE;
+    du_load_children(analyzer, node, row);
+    if (row->placeholder && gtk_tree_model_iter_children(model, &child, &iter)) {
+        gtk_tree_store_remove(analyzer->store, &child);
+        row->placeholder = FALSE;
+    }
+    return FALSE;
+}
+
+static void du_clear(DiskAnalyzer *analyzer) {
+    if (analyzer->timer) g_source_remove(analyzer->timer);
+    analyzer->timer = 0;
+    // Rows point into the scanner's nodes, so they go first
+    g_hash_table_remove_all(analyzer->rows);
+    gtk_tree_store_clear(analyzer->store);
+    du_scanner_free(analyzer->scanner);
+    analyzer->scanner = NULL;
+    analyzer->root_open = FALSE;
+}
+
+static void on_du_scan_clicked(GtkWidget *widget, gpointer user_data) {
+    DiskAnalyzer *analyzer = user_data;
+
+    // A second click while running stops the walk and keeps what it found
+    if (analyzer->timer) {
+        du_scanner_cancel(analyzer->scanner);
+        return;
+    }
+
+    du_clear(analyzer);
+    const char *path = gtk_entry_get_text(GTK_ENTRY(analyzer->path_entry));
+    gboolean one_filesystem = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(analyzer->one_filesystem));
+    analyzer->scanner = du_scanner_start(path, one_filesystem);
+    if (!analyzer->scanner) {
+        char text[512];
+        snprintf(text, sizeof(text), "Cannot scan %s: %s", path, g_strerror(errno));
+        gtk_label_set_text(GTK_LABEL(analyzer->status_label), text);
+        return;
+    }
+
+    DuNode *root = du_scanner_root(analyzer->scanner);
+    du_insert_row(analyzer, NULL, root);
+    ((DuRow *)g_hash_table_lookup(analyzer->rows, root))->expanded = TRUE;
+    gtk_button_set_label(GTK_BUTTON(analyzer->scan_button), "_Cancel");
+    analyzer->timer = g_timeout_add(DU_REFRESH_MS, on_du_timer, analyzer);
+    du_update_status(analyzer);
+}
+
+static void on_du_dialog_destroy(GtkWidget *widget, gpointer user_data) {
+    DiskAnalyzer *analyzer = user_data;
+    du_clear(analyzer);
+    g_hash_table_destroy(analyzer->rows);
+    g_object_unref(analyzer->sorted);
+    g_object_unref(analyzer->store);
+    g_free(analyzer);
+}
+
+static void du_size_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                              GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    guint64 bytes = 0;
+    DuNode *node = NULL;
+    gtk_tree_model_get(model, iter, DU_COL_BYTES, &bytes, DU_COL_NODE, &node, -1);
+    char *size = node ? g_format_size(bytes) : NULL;
+    g_object_set(renderer, "text", size ? size : "", NULL);
+    g_free(size);
+}
+
+static void add_du_count_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    g_object_set(renderer, "xalign", 1.0, NULL);
+    GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+GtkWidget* create_disk_analyzer_dialog(GtkWindow *parent) {
+    DiskAnalyzer *analyzer = g_new0(DiskAnalyzer, 1);
+    analyzer->rows = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, du_row_free);
+
+    analyzer->dialog = gtk_dialog_new_with_buttons("Disk Analyzer",
+                                                   parent,
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   "_Close", GTK_RESPONSE_CLOSE,
+                                                   NULL);
+    gtk_window_set_default_size(GTK_WINDOW(analyzer->dialog), 900, 650);
+    gtk_window_set_resizable(GTK_WINDOW(analyzer->dialog), TRUE);
+    GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(analyzer->dialog));
+
+    GtkWidget *controls = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    gtk_widget_set_margin_top(controls, 10);
+    gtk_widget_set_margin_left(controls, 10);
+    gtk_widget_set_margin_right(controls, 10);
+    gtk_box_pack_start(GTK_BOX(controls), gtk_label_new("Directory:"), FALSE, FALSE, 0);
+    analyzer->path_entry = gtk_entry_new();
+    gtk_entry_set_text(GTK_ENTRY(analyzer->path_entry), g_get_home_dir());
+    gtk_box_pack_start(GTK_BOX(controls), analyzer->path_entry, TRUE, TRUE, 0);
+    analyzer->one_filesystem = gtk_check_button_new_with_label("Stay on this filesystem");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(analyzer->one_filesystem), TRUE);
+    gtk_box_pack_start(GTK_BOX(controls), analyzer->one_filesystem, FALSE, FALSE, 0);
+    analyzer->scan_button = gtk_button_new_with_mnemonic("_Scan");
+    gtk_box_pack_start(GTK_BOX(controls), analyzer->scan_button, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(content_area), controls, FALSE, FALSE, 0);
+
+    analyzer->status_label = gtk_label_new("Choose a directory and press Scan.");
+    gtk_label_set_xalign(GTK_LABEL(analyzer->status_label), 0.0);
+    gtk_label_set_ellipsize(GTK_LABEL(analyzer->status_label), PANGO_ELLIPSIZE_MIDDLE);
+    gtk_widget_set_margin_top(analyzer->status_label, 10);
+    gtk_widget_set_margin_left(analyzer->status_label, 10);
+    gtk_widget_set_margin_right(analyzer->status_label, 10);
+    gtk_box_pack_start(GTK_BOX(content_area), analyzer->status_label, FALSE, FALSE, 0);
+
+    analyzer->store = gtk_tree_store_new(DU_N_COLUMNS,
+                                         G_TYPE_STRING, G_TYPE_UINT64, G_TYPE_UINT64, G_TYPE_UINT64,
+                                         G_TYPE_INT, G_TYPE_STRING, G_TYPE_POINTER);
+    analyzer->sorted = gtk_tree_model_sort_new_with_model(GTK_TREE_MODEL(analyzer->store));
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(analyzer->sorted), DU_COL_BYTES, GTK_SORT_DESCENDING);
+    analyzer->view = gtk_tree_view_new_with_model(analyzer->sorted);
+
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes("Directory", renderer,
+                                                                         "text", DU_COL_NAME, NULL);
+    gtk_tree_view_column_set_expand(column, TRUE);
+    gtk_tree_view_column_set_sort_column_id(column, DU_COL_NAME);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(analyzer->view), column);
+
+    renderer = gtk_cell_renderer_text_new();
+    g_object_set(renderer, "xalign", 1.0, NULL);
+    column = gtk_tree_view_column_new();
+    gtk_tree_view_column_set_title(column, "Size");
+    gtk_tree_view_column_pack_start(column, renderer, TRUE);
+    gtk_tree_view_column_set_cell_data_func(column, renderer, du_size_cell_data, NULL, NULL);
+    gtk_tree_view_column_set_sort_column_id(column, DU_COL_BYTES);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(analyzer->view), column);
+
+    renderer = gtk_cell_renderer_progress_new();
+    column = gtk_tree_view_column_new_with_attributes("Share", renderer, "value", DU_COL_PERCENT, NULL);
+    gtk_tree_view_column_set_min_width(column, 120);
+    gtk_tree_view_column_set_sort_column_id(column, DU_COL_PERCENT);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(analyzer->view), column);
+
+    add_du_count_column(analyzer->view, "Files", DU_COL_FILES);
+    add_du_count_column(analyzer->view, "Directories", DU_COL_DIRS);
+
+    renderer = gtk_cell_renderer_text_new();
+    column = gtk_tree_view_column_new_with_attributes("Status", renderer, "text", DU_COL_STATUS, NULL);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(analyzer->view), column);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_hexpand(scrolled, TRUE);
+    gtk_widget_set_vexpand(scrolled, TRUE);
+    gtk_widget_set_margin_top(scrolled, 10);
+    gtk_widget_set_margin_bottom(scrolled, 10);
+    gtk_widget_set_margin_left(scrolled, 10);
+    gtk_widget_set_margin_right(scrolled, 10);
+    gtk_container_add(GTK_CONTAINER(scrolled), analyzer->view);
+    gtk_box_pack_start(GTK_BOX(content_area), scrolled, TRUE, TRUE, 0);
+
+    g_signal_connect(analyzer->scan_button, "clicked", G_CALLBACK(on_du_scan_clicked), analyzer);
+    g_signal_connect(analyzer->path_entry, "activate", G_CALLBACK(on_du_scan_clicked), analyzer);
+    g_signal_connect(analyzer->view, "test-expand-row", G_CALLBACK(on_du_test_expand_row), analyzer);
+    g_signal_connect(analyzer->dialog, "destroy", G_CALLBACK(on_du_dialog_destroy), analyzer);
+
+    gtk_widget_show_all(analyzer->dialog);
+    return analyzer->dialog;
+}
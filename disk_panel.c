@@ -0,0 +1,192 @@
+// disk_panel.c
+// Live block device table for the filesystem and disk usage dialogs. Rows
+// come from the metrics sampler's per-device breakdown (metrics_sampler.c),
+// so the panel never reads /proc itself; a timer at the sampler interval
+// updates rows in place, adding and removing devices as they come and go.
+
+#include "custom_shell.h"
+
+enum {
+    DISK_COL_NAME,
+    DISK_COL_READ_RATE,
+    DISK_COL_WRITE_RATE,
+    DISK_COL_READ_IOPS,
+    DISK_COL_WRITE_IOPS,
+    DISK_COL_READ_AWAIT,
+    DISK_COL_WRITE_AWAIT,
+    DISK_COL_QUEUE,
+    DISK_COL_UTIL,
+    DISK_COL_GENERATION,
+    DISK_N_COLUMNS
+};
+
+typedef struct {
+    GtkListStore *store;
+    GtkWidget *summary;
+    guint timer;
+    guint generation;
+    DiskDeviceSample disks[METRICS_MAX_DISKS];
+} DiskPanel;
+
+static gboolean find_disk_row(GtkTreeModel *model, const char *name, GtkTreeIter *iter) {
+    gboolean valid = gtk_tree_model_get_iter_first(model, iter);
+    while (valid) {
+        char *row_name = NULL;
+        gtk_tree_model_get(model, iter, DISK_COL_NAME, &row_name, -1);
+        gboolean same = g_strcmp0(row_name, name) == 0;
+        g_free(row_name);
+        if (same) return TRUE;
+        valid = gtk_tree_model_iter_next(model, iter);
+    }
+    return FALSE;
+}
+
+static gboolean disk_panel_tick(gpointer user_data) {
+    DiskPanel *panel = user_data;
+    GtkTreeModel *model = GTK_TREE_MODEL(panel->store);
+    guint count = metrics_sampler_disks(panel->disks, METRICS_MAX_DISKS);
+    if (count == 0) return G_SOURCE_CONTINUE;
+
+    panel->generation++;
+    const DiskDeviceSample *busiest = NULL;
+    for (guint i = 0; i < count; i++) {
+        const DiskDeviceSample *disk = &panel->disks[i];
+        char name[64];
+        snprintf(name, sizeof(name), disk->stacked ? "%s (stacked)" : "%s", disk->name);
+
+        GtkTreeIter iter;
+        if (!find_disk_row(model, name, &iter)) {
+            gtk_list_store_append(panel->store, &iter);
+        }
+        gtk_list_store_set(panel->store, &iter,
+                           DISK_COL_NAME, name,
+                           DISK_COL_READ_RATE, disk->read_rate,
+                           DISK_COL_WRITE_RATE, disk->write_rate,
+                           DISK_COL_READ_IOPS, disk->read_iops,
+                           DISK_COL_WRITE_IOPS, disk->write_iops,
+                           DISK_COL_READ_AWAIT, disk->read_await_ms,
+                           DISK_COL_WRITE_AWAIT, disk->write_await_ms,
+                           DISK_COL_QUEUE, disk->queue_depth,
+                           DISK_COL_UTIL, (int)(disk->util_percent + 0.5f),
+                           DISK_COL_GENERATION, panel->generation,
+                           -1);
+        if (!busiest || disk->util_percent > busiest->util_percent) busiest = disk;
+    }
+
+    // Devices that went away, e.g. an unplugged USB disk
+    GtkTreeIter iter;
+    gboolean valid = gtk_tree_model_get_iter_first(model, &iter);
+    while (valid) {
+        guint generation = 0;
+        gtk_tree_model_get(model, &iter, DISK_COL_GENERATION, &generation, -1);
+        valid = generation == panel->generation
+            ? gtk_tree_model_iter_next(model, &iter)
+            : gtk_list_store_remove(panel->store, &iter);
+    }
+
+    MetricsSample sample;
+    if (metrics_sampler_latest(&sample)) {
+        char *read = g_format_size((guint64)sample.disk_read_rate);
+        char *write = g_format_size((guint64)sample.disk_write_rate);
+        char text[256];
+        snprintf(text, sizeof(text), "All disks: read %s/s, write %s/s  (busiest: %s at %.0f%% util, await %.1f ms)",
+                 read, write, busiest->name, busiest->util_percent, busiest->await_ms);
+        gtk_label_set_text(GTK_LABEL(panel->summary), text);
+        g_free(read);
+        g_free(write);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void rate_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                           GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    double rate = 0;
+    char text[32];
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &rate, -1);
+    snprintf(text, sizeof(text), "%.2f", rate / (1024 * 1024));
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void float_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                            GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    float value = 0;
+    char text[32];
+    int column_id = GPOINTER_TO_INT(user_data);
+    gtk_tree_model_get(model, iter, column_id, &value, -1);
+    snprintf(text, sizeof(text), column_id == DISK_COL_READ_IOPS || column_id == DISK_COL_WRITE_IOPS
+             ? "%.0f" : "%.2f", value);
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void add_disk_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer;
+    GtkTreeViewColumn *column;
+
+    if (column_id == DISK_COL_NAME) {
+        renderer = gtk_cell_renderer_text_new();
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    } else if (column_id == DISK_COL_UTIL) {
+        renderer = gtk_cell_renderer_progress_new();
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "value", column_id, NULL);
+        gtk_tree_view_column_set_expand(column, TRUE);
+    } else {
+        renderer = gtk_cell_renderer_text_new();
+        g_object_set(renderer, "xalign", 1.0, NULL);
+        column = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(column, title);
+        gtk_tree_view_column_pack_start(column, renderer, TRUE);
+        gtk_tree_view_column_set_cell_data_func(column, renderer,
+                                                column_id <= DISK_COL_WRITE_RATE ? rate_cell_data : float_cell_data,
+                                                GINT_TO_POINTER(column_id), NULL);
+    }
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+static void on_disk_panel_destroy(GtkWidget *widget, gpointer user_data) {
+    DiskPanel *panel = user_data;
+    g_source_remove(panel->timer);
+    g_object_unref(panel->store);
+    g_free(panel);
+}
+
+GtkWidget* disk_panel_new(void) {
+    if (metrics_sampler_interval() == 0) {
+        return gtk_label_new("Disk I/O: sampler not running");
+    }
+
+    DiskPanel *panel = g_new0(DiskPanel, 1);
+    panel->store = gtk_list_store_new(DISK_N_COLUMNS,
+                                      G_TYPE_STRING, G_TYPE_DOUBLE, G_TYPE_DOUBLE,
+                                      G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT,
+                                      G_TYPE_FLOAT, G_TYPE_INT, G_TYPE_UINT);
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    panel->summary = gtk_label_new("All disks: waiting for the first sample");
+    gtk_label_set_xalign(GTK_LABEL(panel->summary), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), panel->summary, FALSE, FALSE, 0);
+
+    GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(panel->store));
+    add_disk_column(view, "Device", DISK_COL_NAME);
+    add_disk_column(view, "Read MB/s", DISK_COL_READ_RATE);
+    add_disk_column(view, "Write MB/s", DISK_COL_WRITE_RATE);
+    add_disk_column(view, "r/s", DISK_COL_READ_IOPS);
+    add_disk_column(view, "w/s", DISK_COL_WRITE_IOPS);
+    add_disk_column(view, "r_await ms", DISK_COL_READ_AWAIT);
+    add_disk_column(view, "w_await ms", DISK_COL_WRITE_AWAIT);
+    add_disk_column(view, "Queue", DISK_COL_QUEUE);
+    add_disk_column(view, "% Util", DISK_COL_UTIL);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(scrolled, -1, 160);
+    gtk_container_add(GTK_CONTAINER(scrolled), view);
+    gtk_box_pack_start(GTK_BOX(box), scrolled, TRUE, TRUE, 0);
+
+    disk_panel_tick(panel);
+    panel->timer = g_timeout_add(metrics_sampler_interval(), disk_panel_tick, panel);
+    g_signal_connect(box, "destroy", G_CALLBACK(on_disk_panel_destroy), panel);
+    return box;
+}
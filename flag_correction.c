@@ -0,0 +1,360 @@
+// flag_correction.c
+// Suggests the closest valid flag or subcommand when a command fails on an
+// unknown option. Nothing is looked up unless the failure output names one
+// of the command's own arguments. The binary is resolved on PATH and its
+// --help (or man page) is parsed on a worker thread, once per inode and
+// mtime, so the UI never waits on it and later failures spawn nothing.
+
+#include "custom_shell.h"
+#include <sys/stat.h>
+
+#define FLAG_HELP_TIMEOUT_SECONDS 2
+#define FLAG_HELP_MAX_BYTES (256 * 1024)
+#define FLAG_MAX_LENGTH 64
+#define FLAG_MIN_SUBCOMMANDS 3
+
+typedef struct {
+    GHashTable *flags;        // "--verbose", "-v"
+    GHashTable *subcommands;  // "commit", "push", ...
+} CommandFlagSet;
+
+static GHashTable *flag_cache = NULL;  // "dev:ino:mtime" -> CommandFlagSet*
+
+static void free_flag_set(gpointer data) {
+    CommandFlagSet *set = data;
+    g_hash_table_destroy(set->flags);
+    g_hash_table_destroy(set->subcommands);
+    g_free(set);
+}
+
+static gboolean is_flag_char(char c) {
+    return isalnum((unsigned char)c) || c == '-' || c == '_';
+}
+
+// Collect every "-x" and "--long-name" that starts a word in a help line
+static void parse_help_flags(const char *line, GHashTable *flags) {
+    for (const char *p = line; *p; p++) {
+        if (*p != '-') continue;
+        if (p > line && !strchr(" \t,[(|/", p[-1])) continue;
+
+        const char *start = p;
+        const char *name = (p[1] == '-') ? p + 2 : p + 1;
+        if (!isalnum((unsigned char)*name)) continue;
+
+        const char *end = name;
+        if (name == p + 1) {
+            // Short flags are a single character
+            end = name + 1;
+            if (is_flag_char(*end) && *end != '-') {
+                p = end;
+                continue;
+            }
+        } else {
+            while (is_flag_char(*end)) end++;
+            while (end > name && end[-1] == '-') end--;
+        }
+
+        if (end - start <= FLAG_MAX_LENGTH) {
+            g_hash_table_add(flags, g_strndup(start, end - start));
+        }
+        p = end - 1;
+    }
+}
+
+// Indented lowercase word followed by a description column, e.g. git's
+// "   commit    Record changes to the repository"
+static void parse_help_subcommand(const char *line, GHashTable *subcommands) {
+    const char *p = line;
+    while (*p == ' ') p++;
+    if (p - line < 2 || p - line > 8 || !islower((unsigned char)*p)) return;
+
+    const char *end = p;
+    while (islower((unsigned char)*end) || isdigit((unsigned char)*end) || *end == '-') end++;
+    if (end - p < 2 || end - p > 32) return;
+    if (*end != '\0' && *end != '\n' && strncmp(end, "  ", 2) != 0) return;
+
+    g_hash_table_add(subcommands, g_strndup(p, end - p));
+}
+
+static void parse_help_output(FILE *fp, CommandFlagSet *set) {
+    char line[1024];
+    size_t total = 0;
+    while (fgets(line, sizeof(line), fp) && total < FLAG_HELP_MAX_BYTES) {
+        total += strlen(line);
+        parse_help_flags(line, set->flags);
+        parse_help_subcommand(line, set->subcommands);
+    }
+}
+
+static void read_help_source(const char *command, CommandFlagSet *set) {
+    char *quoted = g_shell_quote(command);
+    char *help_cmd = g_strdup_printf("timeout %d %s --help 2>&1 </dev/null",
+                                     FLAG_HELP_TIMEOUT_SECONDS, quoted);
+    FILE *fp = popen(help_cmd, "r");
+    if (fp) {
+        parse_help_output(fp, set);
+        pclose(fp);
+    }
+    g_free(help_cmd);
+
+    // Fall back to the man page synopsis when --help is not supported
+    if (g_hash_table_size(set->flags) == 0) {
+        char *base = g_path_get_basename(command);
+        char *quoted_base = g_shell_quote(base);
+        help_cmd = g_strdup_printf("MANWIDTH=200 timeout %d man -P cat %s 2>/dev/null </dev/null",
+                                   FLAG_HELP_TIMEOUT_SECONDS, quoted_base);
+        fp = popen(help_cmd, "r");
+        if (fp) {
+            parse_help_output(fp, set);
+            pclose(fp);
+        }
+        g_free(help_cmd);
+        g_free(quoted_base);
+        g_free(base);
+    }
+    g_free(quoted);
+}
+
+typedef struct {
+    char *command_line;
+    char *output;
+    FlagFixFunc done;
+    gpointer user_data;
+} FlagFixRequest;
+
+// A --help parse in flight, with the failures waiting on it
+typedef struct {
+    char *key;
+    char *path;
+    CommandFlagSet *set;
+    GPtrArray *requests;        // FlagFixRequest*
+} FlagHelpJob;
+
+static GHashTable *flag_jobs = NULL;   // key -> FlagHelpJob*
+
+static void free_flag_fix_request(gpointer data) {
+    FlagFixRequest *request = data;
+    g_free(request->command_line);
+    g_free(request->output);
+    g_free(request);
+}
+
+// Cache key for the binary behind argv0, NULL when it is not a program on
+// PATH. Paths typed out ("./build.sh") are never re-run for their help.
+static char* flag_set_key(const char *argv0, char **path) {
+    if (strchr(argv0, '/')) return NULL;
+    *path = g_find_program_in_path(argv0);
+    if (!*path) return NULL;
+
+    struct stat st;
+    if (stat(*path, &st) != 0) {
+        g_clear_pointer(path, g_free);
+        return NULL;
+    }
+    return g_strdup_printf("%lu:%lu:%ld.%09ld",
+                           (unsigned long)st.st_dev, (unsigned long)st.st_ino,
+                           (long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec);
+}
+
+static const char* closest_in_set(GHashTable *candidates, const char *word, int max_distance) {
+    const char *best = NULL;
+    int best_distance = max_distance + 1;
+
+    GHashTableIter iter;
+    gpointer candidate;
+    g_hash_table_iter_init(&iter, candidates);
+    while (g_hash_table_iter_next(&iter, &candidate, NULL)) {
+        int distance = command_edit_distance(word, candidate, max_distance);
+        if (distance < 0 || distance > best_distance) continue;
+        if (distance == best_distance && best && strcmp(candidate, best) >= 0) continue;
+        best = candidate;
+        best_distance = distance;
+    }
+    return best;
+}
+
+static gboolean is_shell_operator(const char *token) {
+    static const char *operators[] = { "|", "||", "&&", ";", "&", ">", ">>", "<", "2>", "2>&1", NULL };
+    for (int i = 0; operators[i]; i++) {
+        if (strcmp(token, operators[i]) == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+// Replace the first occurrence of bad at or after *cursor in line
+static void replace_token(GString *line, gsize *cursor, const char *bad, const char *good) {
+    char *found = strstr(line->str + *cursor, bad);
+    if (!found) return;
+
+    gsize pos = found - line->str;
+    GString *rebuilt = g_string_new_len(line->str, pos);
+    g_string_append(rebuilt, good);
+    g_string_append(rebuilt, found + strlen(bad));
+    g_string_assign(line, rebuilt->str);
+    g_string_free(rebuilt, TRUE);
+    *cursor = pos + strlen(good);
+}
+
+// TRUE when the output mentions a flag or the first positional argument,
+// the only arguments build_flag_fix() would ever correct
+static gboolean output_names_argument(int argc, char **argv, const char *output) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (is_shell_operator(arg) || strcmp(arg, "--") == 0) break;
+
+        if (arg[0] == '-' && arg[1] != '\0') {
+            char flag[FLAG_MAX_LENGTH + 1];
+            snprintf(flag, sizeof(flag), "%.*s", (int)strcspn(arg, "="), arg);
+            const char *bare = flag + strspn(flag, "-");
+            if (*bare && strstr(output, bare)) return TRUE;
+        } else {
+            return strstr(output, arg) != NULL;
+        }
+    }
+    return FALSE;
+}
+
+// Corrected command line when an argument is an unknown flag or subcommand
+// that the failing command complained about, NULL otherwise
+static char* build_flag_fix(CommandFlagSet *set, const char *command_line, const char *output) {
+    if (g_hash_table_size(set->flags) == 0 && g_hash_table_size(set->subcommands) == 0) return NULL;
+
+    int argc = 0;
+    char **argv = NULL;
+    if (!g_shell_parse_argv(command_line, &argc, &argv, NULL)) return NULL;
+
+    GString *fixed = g_string_new(command_line);
+    gsize cursor = strlen(argv[0]);
+    gboolean changed = FALSE;
+    gboolean seen_positional = FALSE;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (is_shell_operator(arg) || strcmp(arg, "--") == 0) break;
+
+        if (arg[0] == '-' && arg[1] != '\0') {
+            char flag[FLAG_MAX_LENGTH + 1];
+            snprintf(flag, sizeof(flag), "%.*s", (int)strcspn(arg, "="), arg);
+            if (g_hash_table_contains(set->flags, flag)) continue;
+
+            // Only correct flags the command itself complained about
+            const char *bare = flag + strspn(flag, "-");
+            if (!*bare || !strstr(output, bare)) continue;
+
+            const char *suggestion = NULL;
+            if (flag[1] != '-' && strlen(flag) > 2) {
+                // "-verbose" usually means "--verbose"
+                char *long_form = g_strconcat("-", flag, NULL);
+                suggestion = g_hash_table_lookup(set->flags, long_form);
+                g_free(long_form);
+            } else if (flag[1] == '-') {
+                int max_distance = strlen(flag) > 8 ? 2 : 1;
+                suggestion = closest_in_set(set->flags, flag, max_distance);
+            }
+
+            if (suggestion) {
+                replace_token(fixed, &cursor, flag, suggestion);
+                changed = TRUE;
+            }
+        } else if (!seen_positional) {
+            seen_positional = TRUE;
+            if (g_hash_table_size(set->subcommands) < FLAG_MIN_SUBCOMMANDS) continue;
+            if (g_hash_table_contains(set->subcommands, arg)) continue;
+            if (!strstr(output, arg)) continue;
+
+            const char *suggestion = closest_in_set(set->subcommands, arg, 2);
+            if (suggestion) {
+                replace_token(fixed, &cursor, arg, suggestion);
+                changed = TRUE;
+            }
+        }
+    }
+
+    g_strfreev(argv);
+    if (!changed) {
+        g_string_free(fixed, TRUE);
+        return NULL;
+    }
+    return g_string_free(fixed, FALSE);
+}
+
+static gboolean on_help_job_done(gpointer user_data) {
+    FlagHelpJob *job = user_data;
+
+    // Cached even when empty so unparseable binaries are not respawned
+    g_hash_table_insert(flag_cache, job->key, job->set);
+    g_hash_table_steal(flag_jobs, job->key);
+
+    for (guint i = 0; i < job->requests->len; i++) {
+        FlagFixRequest *request = g_ptr_array_index(job->requests, i);
+        char *fix = build_flag_fix(job->set, request->command_line, request->output);
+        if (fix) request->done(fix, request->user_data);
+    }
+    g_ptr_array_free(job->requests, TRUE);
+    g_free(job->path);
+    g_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer run_help_job(gpointer user_data) {
+    FlagHelpJob *job = user_data;
+    read_help_source(job->path, job->set);
+    g_idle_add(on_help_job_done, job);
+    return NULL;
+}
+
+// Calls done with the corrected command line, on the GTK thread, if there
+// is one. Straight away when the binary's flags are cached, otherwise once
+// its help has been parsed in the background.
+void suggest_flag_fix(const char *command_line, const char *output, FlagFixFunc done, gpointer user_data) {
+    if (!command_line || !output || !*output) return;
+
+    int argc = 0;
+    char **argv = NULL;
+    if (!g_shell_parse_argv(command_line, &argc, &argv, NULL)) return;
+
+    // Most failures have nothing to do with flags; spawn nothing for them
+    char *path = NULL;
+    char *key = output_names_argument(argc, argv, output) ? flag_set_key(argv[0], &path) : NULL;
+    g_strfreev(argv);
+    if (!key) return;
+
+    if (!flag_cache) {
+        flag_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_flag_set);
+        flag_jobs = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+
+    CommandFlagSet *set = g_hash_table_lookup(flag_cache, key);
+    if (set) {
+        char *fix = build_flag_fix(set, command_line, output);
+        if (fix) done(fix, user_data);
+        g_free(key);
+        g_free(path);
+        return;
+    }
+
+    FlagFixRequest *request = g_new0(FlagFixRequest, 1);
+    request->command_line = g_strdup(command_line);
+    request->output = g_strdup(output);
+    request->done = done;
+    request->user_data = user_data;
+
+    FlagHelpJob *job = g_hash_table_lookup(flag_jobs, key);
+    if (job) {
+        g_ptr_array_add(job->requests, request);
+        g_free(key);
+        g_free(path);
+        return;
+    }
+
+    job = g_new0(FlagHelpJob, 1);
+    job->key = key;
+    job->path = path;
+    job->set = g_new0(CommandFlagSet, 1);
+    job->set->flags = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    job->set->subcommands = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    job->requests = g_ptr_array_new_with_free_func(free_flag_fix_request);
+    g_ptr_array_add(job->requests, request);
+    g_hash_table_insert(flag_jobs, job->key, job);
+    g_thread_unref(g_thread_new("flag-help", run_help_job, job));
+}
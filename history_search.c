@@ -0,0 +1,146 @@
+// history_search.c
+// Trigram index over the history store for incremental reverse search
+// (Ctrl+R). Each trigram maps to the ascending list of entry ids containing
+// it; a query is answered by walking the rarest of its trigrams' lists
+// backwards and verifying candidates, instead of scanning every entry.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+
+#define HISTORY_SEARCH_BUILD_CHUNK 5000
+
+struct _HistorySearchIndex {
+    HistoryStore *store;
+    GHashTable *postings;   // packed trigram -> GArray of guint entry ids
+    guint indexed_count;    // entries [0, indexed_count) are in postings
+    guint build_source;     // idle source still catching up, 0 when done
+};
+
+static guint pack_trigram(const char *p) {
+    return ((guint)(guchar)p[0] << 16) | ((guint)(guchar)p[1] << 8) | (guint)(guchar)p[2];
+}
+
+static void free_posting(gpointer data) {
+    g_array_free(data, TRUE);
+}
+
+static void index_entries(HistorySearchIndex *index, guint limit) {
+    while (index->indexed_count < limit) {
+        guint id = index->indexed_count++;
+        gsize length;
+        const char *entry = history_store_peek(index->store, id, &length);
+        if (!entry) continue;
+
+        for (gsize i = 0; i + 3 <= length; i++) {
+            gpointer key = GUINT_TO_POINTER(pack_trigram(entry + i));
+            GArray *posting = g_hash_table_lookup(index->postings, key);
+            if (!posting) {
+                posting = g_array_sized_new(FALSE, FALSE, sizeof(guint), 4);
+                g_hash_table_insert(index->postings, key, posting);
+            } else if (g_array_index(posting, guint, posting->len - 1) == id) {
+                continue; // trigram repeated within this entry
+            }
+            g_array_append_val(posting, id);
+        }
+    }
+}
+
+// Existing history is indexed in chunks from the main loop so a large
+// history never stalls startup; searches cover the unindexed tail linearly
+static gboolean build_step(gpointer user_data) {
+    HistorySearchIndex *index = user_data;
+    guint count = history_store_count(index->store);
+    guint limit = MIN(count, index->indexed_count + HISTORY_SEARCH_BUILD_CHUNK);
+
+    index_entries(index, limit);
+    if (index->indexed_count >= count) {
+        index->build_source = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+HistorySearchIndex* history_search_index_new(HistoryStore *store) {
+    HistorySearchIndex *index = g_new0(HistorySearchIndex, 1);
+    index->store = store;
+    index->postings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_posting);
+    if (history_store_count(store) > 0) {
+        index->build_source = g_idle_add_full(G_PRIORITY_LOW, build_step, index, NULL);
+    }
+    return index;
+}
+
+void history_search_index_free(HistorySearchIndex *index) {
+    if (!index) return;
+    if (index->build_source) {
+        g_source_remove(index->build_source);
+    }
+    g_hash_table_destroy(index->postings);
+    g_free(index);
+}
+
+// Index entries added to the store since the last call
+void history_search_index_update(HistorySearchIndex *index) {
+    if (!index) return;
+
+    guint count = history_store_count(index->store);
+    if (index->build_source || index->indexed_count >= count) return;
+
+    if (count - index->indexed_count > HISTORY_SEARCH_BUILD_CHUNK) {
+        index->build_source = g_idle_add_full(G_PRIORITY_LOW, build_step, index, NULL);
+    } else {
+        index_entries(index, count);
+    }
+}
+
+static gboolean entry_contains(HistorySearchIndex *index, guint id, const char *query, gsize query_len) {
+    gsize length;
+    const char *entry = history_store_peek(index->store, id, &length);
+    return entry && length >= query_len && memmem(entry, length, query, query_len) != NULL;
+}
+
+// Most recent entry older than before whose text contains query, or -1
+int history_search_find(HistorySearchIndex *index, const char *query, int before) {
+    if (!index || !query || !*query) return -1;
+
+    gsize query_len = strlen(query);
+    guint count = history_store_count(index->store);
+    guint limit = (before < 0 || (guint)before > count) ? count : (guint)before;
+
+    // Entries not yet indexed are the newest ones, so check them first
+    for (guint id = limit; id > index->indexed_count; id--) {
+        if (entry_contains(index, id - 1, query, query_len)) return id - 1;
+    }
+    limit = MIN(limit, index->indexed_count);
+
+    if (query_len < 3) {
+        for (guint id = limit; id > 0; id--) {
+            if (entry_contains(index, id - 1, query, query_len)) return id - 1;
+        }
+        return -1;
+    }
+
+    // Candidates come from the rarest trigram of the query
+    GArray *rarest = NULL;
+    for (gsize i = 0; i + 3 <= query_len; i++) {
+        GArray *posting = g_hash_table_lookup(index->postings, GUINT_TO_POINTER(pack_trigram(query + i)));
+        if (!posting) return -1;
+        if (!rarest || posting->len < rarest->len) rarest = posting;
+    }
+
+    // Binary search for the first posting at or past limit, then walk back
+    guint lo = 0, hi = rarest->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(rarest, guint, mid) < limit) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (guint i = lo; i > 0; i--) {
+        guint id = g_array_index(rarest, guint, i - 1);
+        if (entry_contains(index, id, query, query_len)) return id;
+    }
+    return -1;
+}
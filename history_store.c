@@ -0,0 +1,544 @@
+// history_store.c
+// Unlimited persistent command history. Commands are appended, one per line,
+// to a log file opened with O_APPEND; an offset index (one guint64 per entry)
+// is kept beside it and memory-mapped at startup, so launching never parses
+// the log. Only entries appended since the index was last written are scanned.
+// Several windows may share the file: each write is a single O_APPEND record,
+// and an inotify watch tells every instance to index the others' new entries.
+//
+// Entries recorded with metadata carry a prefix before a tab:
+//   ": <start>:<duration ms>:<exit status>:<output bytes>:<cwd>\t<command>"
+// The metadata is split into per-field arrays (columns) on the first query,
+// so filters and sorts over millions of entries touch only the fields used.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+
+#define HISTORY_FILE_NAME ".command_sphere_history"
+#define HISTORY_INDEX_SUFFIX ".idx"
+#define HISTORY_INDEX_MAGIC "CSHIDX1"
+#define HISTORY_INDEX_HEADER 16   // magic[8] + log inode
+#define HISTORY_RECORD_PREFIX ": "
+
+struct _HistoryStore {
+    char *log_path;
+    int log_fd;
+    int index_fd;             // -1 when the history is not persisted
+    int watch_fd;             // inotify on the log, -1 when unavailable
+
+    const char *log_map;      // read-only view of the log
+    gsize log_map_len;
+    guint64 scanned_end;      // log bytes already split into entries
+
+    const guint64 *index_map; // offsets inherited from the on-disk index
+    gsize index_map_len;
+    guint index_map_count;
+    GArray *tail_offsets;     // guint64 offsets of entries indexed this session
+
+    // Metadata columns for entries [0, columns_count)
+    guint columns_count;
+    GArray *col_start;        // gint64 unix seconds, 0 when unknown
+    GArray *col_duration;     // guint32 milliseconds
+    GArray *col_status;       // gint32 exit status or HISTORY_STATUS_UNKNOWN
+    GArray *col_output;       // guint64 bytes of output
+    GArray *col_cwd;          // guint32 id into cwd_names, 0 when unknown
+    GPtrArray *cwd_names;     // id -> interned directory (slot 0 unused)
+    GHashTable *cwd_ids;      // directory -> GUINT_TO_POINTER(id)
+};
+
+static guint64 entry_offset(HistoryStore *store, guint index) {
+    if (index < store->index_map_count) {
+        return store->index_map[index];
+    }
+    return g_array_index(store->tail_offsets, guint64, index - store->index_map_count);
+}
+
+guint history_store_count(HistoryStore *store) {
+    return store ? store->index_map_count + store->tail_offsets->len : 0;
+}
+
+// Make log_map cover at least the first length bytes of the log
+static gboolean map_log(HistoryStore *store, gsize length) {
+    if (length <= store->log_map_len) return TRUE;
+
+    void *map;
+    if (store->log_map) {
+        map = mremap((void *)store->log_map, store->log_map_len, length, MREMAP_MAYMOVE);
+    } else {
+        map = mmap(NULL, length, PROT_READ, MAP_SHARED, store->log_fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        if (store->log_map) munmap((void *)store->log_map, store->log_map_len);
+        store->log_map = NULL;
+        store->log_map_len = 0;
+        return FALSE;
+    }
+    store->log_map = map;
+    store->log_map_len = length;
+    return TRUE;
+}
+
+static void reset_index_file(HistoryStore *store, guint64 log_ino) {
+    char header[HISTORY_INDEX_HEADER] = HISTORY_INDEX_MAGIC;
+    memcpy(header + 8, &log_ino, sizeof(log_ino));
+    if (ftruncate(store->index_fd, 0) != 0 ||
+        pwrite(store->index_fd, header, sizeof(header), 0) != sizeof(header)) {
+        close(store->index_fd);
+        store->index_fd = -1;
+    }
+}
+
+// Map the offsets written by earlier sessions. Falls back to a full rescan if
+// the index belongs to a different log file or points past its end.
+static void load_index(HistoryStore *store, const struct stat *log_st) {
+    struct stat st;
+    if (fstat(store->index_fd, &st) != 0) return;
+
+    char header[HISTORY_INDEX_HEADER];
+    guint64 indexed_ino = 0;
+    gboolean valid = st.st_size >= HISTORY_INDEX_HEADER &&
+                     pread(store->index_fd, header, sizeof(header), 0) == sizeof(header) &&
+                     memcmp(header, HISTORY_INDEX_MAGIC, 8) == 0;
+    if (valid) {
+        memcpy(&indexed_ino, header + 8, sizeof(indexed_ino));
+        valid = indexed_ino == (guint64)log_st->st_ino;
+    }
+
+    guint count = valid ? (st.st_size - HISTORY_INDEX_HEADER) / sizeof(guint64) : 0;
+    if (count > 0) {
+        gsize length = HISTORY_INDEX_HEADER + (gsize)count * sizeof(guint64);
+        void *map = mmap(NULL, length, PROT_READ, MAP_SHARED, store->index_fd, 0);
+        if (map == MAP_FAILED) {
+            count = 0;
+        } else {
+            store->index_map = (const guint64 *)((const char *)map + HISTORY_INDEX_HEADER);
+            store->index_map_len = length;
+            store->index_map_count = count;
+
+            // The scan resumes after the newline ending the last indexed entry
+            guint64 last = store->index_map[count - 1];
+            const char *newline = NULL;
+            if (last < (guint64)log_st->st_size && map_log(store, log_st->st_size)) {
+                newline = memchr(store->log_map + last, '\n', log_st->st_size - last);
+            }
+            if (newline) {
+                store->scanned_end = newline - store->log_map + 1;
+            } else {
+                munmap(map, length);
+                store->index_map = NULL;
+                store->index_map_len = 0;
+                store->index_map_count = 0;
+                valid = FALSE;
+            }
+        }
+    }
+
+    if (!valid) {
+        reset_index_file(store, log_st->st_ino);
+    }
+}
+
+// Append offsets this session knows about but the on-disk index lacks
+static void persist_index(HistoryStore *store) {
+    if (store->index_fd < 0 || store->tail_offsets->len == 0) return;
+    if (flock(store->index_fd, LOCK_EX) != 0) return;
+
+    struct stat st;
+    if (fstat(store->index_fd, &st) == 0 && st.st_size >= HISTORY_INDEX_HEADER) {
+        guint on_disk = (st.st_size - HISTORY_INDEX_HEADER) / sizeof(guint64);
+        guint total = history_store_count(store);
+        if (on_disk >= store->index_map_count && on_disk < total) {
+            guint first = on_disk - store->index_map_count;
+            const guint64 *offsets = &g_array_index(store->tail_offsets, guint64, first);
+            gsize bytes = (gsize)(total - on_disk) * sizeof(guint64);
+            off_t position = HISTORY_INDEX_HEADER + (off_t)on_disk * sizeof(guint64);
+            if (pwrite(store->index_fd, offsets, bytes, position) != (ssize_t)bytes) {
+                // A short write leaves a partial entry that the next load ignores
+            }
+        }
+    }
+    flock(store->index_fd, LOCK_UN);
+}
+
+// Index any complete entries appended to the log since the last call,
+// whoever wrote them. Returns how many entries were added.
+guint history_store_sync(HistoryStore *store) {
+    if (!store) return 0;
+
+    struct stat st;
+    if (fstat(store->log_fd, &st) != 0 || (guint64)st.st_size <= store->scanned_end) return 0;
+    if (!map_log(store, st.st_size)) return 0;
+
+    guint added = 0;
+    const char *end = store->log_map + st.st_size;
+    const char *p = store->log_map + store->scanned_end;
+    const char *newline;
+    while (p < end && (newline = memchr(p, '\n', end - p)) != NULL) {
+        guint64 offset = p - store->log_map;
+        g_array_append_val(store->tail_offsets, offset);
+        added++;
+        p = newline + 1;
+    }
+    store->scanned_end = p - store->log_map;
+
+    if (added > 0) {
+        persist_index(store);
+    }
+    return added;
+}
+
+// Readable when another process appended to the log; -1 if not watched
+int history_store_watch_fd(HistoryStore *store) {
+    return store ? store->watch_fd : -1;
+}
+
+// Drain pending inotify events and index whatever was appended. Bursts of
+// events collapse into one incremental sync of the new bytes only.
+guint history_store_poll_changes(HistoryStore *store) {
+    if (!store || store->watch_fd < 0) return 0;
+
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (read(store->watch_fd, events, sizeof(events)) > 0) {
+        // Only the fact that the log changed matters
+    }
+    return history_store_sync(store);
+}
+
+// Opens (creating if needed) the history log at path, or at
+// $COMMAND_SPHERE_HISTFILE / ~/.command_sphere_history when path is NULL.
+// If the file cannot be opened, history is kept in memory for the session.
+HistoryStore* history_store_open(const char *path) {
+    HistoryStore *store = g_new0(HistoryStore, 1);
+    store->index_fd = -1;
+    store->watch_fd = -1;
+    store->tail_offsets = g_array_new(FALSE, FALSE, sizeof(guint64));
+
+    if (path) {
+        store->log_path = g_strdup(path);
+    } else if (getenv("COMMAND_SPHERE_HISTFILE")) {
+        store->log_path = g_strdup(getenv("COMMAND_SPHERE_HISTFILE"));
+    } else if (g_get_home_dir()) {
+        store->log_path = g_build_filename(g_get_home_dir(), HISTORY_FILE_NAME, NULL);
+    }
+
+    store->log_fd = store->log_path
+        ? open(store->log_path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600)
+        : -1;
+
+    struct stat st;
+    if (store->log_fd >= 0 && fstat(store->log_fd, &st) == 0) {
+        char *index_path = g_strconcat(store->log_path, HISTORY_INDEX_SUFFIX, NULL);
+        store->index_fd = open(index_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        g_free(index_path);
+        if (store->index_fd >= 0) {
+            load_index(store, &st);
+        }
+
+        store->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (store->watch_fd >= 0 && inotify_add_watch(store->watch_fd, store->log_path, IN_MODIFY) < 0) {
+            close(store->watch_fd);
+            store->watch_fd = -1;
+        }
+    } else {
+        if (store->log_fd >= 0) close(store->log_fd);
+        store->log_fd = memfd_create("command-sphere-history", MFD_CLOEXEC);
+    }
+
+    if (store->log_fd < 0) {
+        history_store_close(store);
+        return NULL;
+    }
+
+    history_store_sync(store);
+    return store;
+}
+
+void history_store_close(HistoryStore *store) {
+    if (!store) return;
+
+    if (store->index_map) {
+        munmap((char *)store->index_map - HISTORY_INDEX_HEADER, store->index_map_len);
+    }
+    if (store->log_map) {
+        munmap((void *)store->log_map, store->log_map_len);
+    }
+    if (store->watch_fd >= 0) close(store->watch_fd);
+    if (store->index_fd >= 0) close(store->index_fd);
+    if (store->log_fd >= 0) close(store->log_fd);
+    g_array_free(store->tail_offsets, TRUE);
+    if (store->col_start) {
+        g_array_free(store->col_start, TRUE);
+        g_array_free(store->col_duration, TRUE);
+        g_array_free(store->col_status, TRUE);
+        g_array_free(store->col_output, TRUE);
+        g_array_free(store->col_cwd, TRUE);
+        g_hash_table_destroy(store->cwd_ids);
+        g_ptr_array_free(store->cwd_names, TRUE);
+    }
+    g_free(store->log_path);
+    g_free(store);
+}
+
+// Whole log line of an entry, metadata prefix included
+static const char* raw_entry(HistoryStore *store, guint index, gsize *length) {
+    if (!store || index >= history_store_count(store)) return NULL;
+
+    guint64 start = entry_offset(store, index);
+    guint64 end = (index + 1 < history_store_count(store))
+        ? entry_offset(store, index + 1) - 1
+        : store->scanned_end - 1;
+    if (end < start || end > store->log_map_len) return NULL;
+
+    *length = end - start;
+    return store->log_map + start;
+}
+
+// Length of the metadata prefix (tab included) of a log line, 0 if none
+static gsize record_prefix_length(const char *line, gsize length) {
+    if (length < 2 || memcmp(line, HISTORY_RECORD_PREFIX, 2) != 0 ||
+        !isdigit((unsigned char)line[2])) return 0;
+    const char *tab = memchr(line, '\t', length);
+    return tab ? (gsize)(tab - line) + 1 : 0;
+}
+
+// Entry text (not NUL-terminated) and its length. The pointer is valid
+// until the next append or sync.
+const char* history_store_peek(HistoryStore *store, guint index, gsize *length) {
+    const char *line = raw_entry(store, index, length);
+    if (!line) return NULL;
+
+    gsize prefix = record_prefix_length(line, *length);
+    *length -= prefix;
+    return line + prefix;
+}
+
+char* history_store_dup(HistoryStore *store, guint index) {
+    gsize length;
+    const char *entry = history_store_peek(store, index, &length);
+    return entry ? g_strndup(entry, length) : NULL;
+}
+
+static void append_sanitized(GString *record, const char *text, gboolean in_prefix) {
+    for (const char *p = text; *p; p++) {
+        gboolean separator = *p == '\n' || *p == '\r' || (in_prefix && *p == '\t');
+        g_string_append_c(record, separator ? ' ' : *p);
+    }
+}
+
+// Appends one entry, with its metadata when record is not NULL, using a
+// single O_APPEND write so concurrent writers never interleave.
+// O(length of the command).
+gboolean history_store_append(HistoryStore *store, const char *command, const HistoryRecord *record) {
+    if (!store || !command || !*command) return FALSE;
+
+    GString *line = g_string_sized_new(strlen(command) + 64);
+    if (record) {
+        g_string_append_printf(line, HISTORY_RECORD_PREFIX "%" G_GINT64_FORMAT ":%u:%d:%" G_GUINT64_FORMAT ":",
+                               record->start_time, record->duration_ms,
+                               record->exit_status, record->output_bytes);
+        append_sanitized(line, record->cwd ? record->cwd : "", TRUE);
+        g_string_append_c(line, '\t');
+    }
+    append_sanitized(line, command, FALSE);
+    g_string_append_c(line, '\n');
+
+    ssize_t written;
+    do {
+        written = write(store->log_fd, line->str, line->len);
+    } while (written < 0 && errno == EINTR);
+    gboolean ok = written == (ssize_t)line->len;
+    g_string_free(line, TRUE);
+
+    if (!ok) return FALSE;
+    history_store_sync(store);
+    return TRUE;
+}
+
+static guint intern_cwd(HistoryStore *store, const char *cwd, gsize length) {
+    if (length == 0) return 0;
+
+    char *name = g_strndup(cwd, length);
+    gpointer id = g_hash_table_lookup(store->cwd_ids, name);
+    if (id) {
+        g_free(name);
+        return GPOINTER_TO_UINT(id);
+    }
+    g_ptr_array_add(store->cwd_names, name);
+    guint new_id = store->cwd_names->len - 1;
+    g_hash_table_insert(store->cwd_ids, name, GUINT_TO_POINTER(new_id));
+    return new_id;
+}
+
+// Decimal field ending at ':' or the tab; advances *p past the separator
+static gint64 parse_field(const char **p, const char *end) {
+    gboolean negative = *p < end && **p == '-';
+    if (negative) (*p)++;
+    gint64 value = 0;
+    while (*p < end && isdigit((unsigned char)**p)) {
+        value = value * 10 + (**p - '0');
+        (*p)++;
+    }
+    if (*p < end && **p == ':') (*p)++;
+    return negative ? -value : value;
+}
+
+// Split the metadata of entries not yet in the columns
+static void update_columns(HistoryStore *store) {
+    if (!store->col_start) {
+        store->col_start = g_array_new(FALSE, FALSE, sizeof(gint64));
+        store->col_duration = g_array_new(FALSE, FALSE, sizeof(guint32));
+        store->col_status = g_array_new(FALSE, FALSE, sizeof(gint32));
+        store->col_output = g_array_new(FALSE, FALSE, sizeof(guint64));
+        store->col_cwd = g_array_new(FALSE, FALSE, sizeof(guint32));
+        store->cwd_names = g_ptr_array_new_with_free_func(g_free);
+        store->cwd_ids = g_hash_table_new(g_str_hash, g_str_equal);
+        g_ptr_array_add(store->cwd_names, NULL);
+    }
+
+    guint first = store->columns_count;
+    guint count = history_store_count(store);
+    if (first >= count) return;
+
+    g_array_set_size(store->col_start, count);
+    g_array_set_size(store->col_duration, count);
+    g_array_set_size(store->col_status, count);
+    g_array_set_size(store->col_output, count);
+    g_array_set_size(store->col_cwd, count);
+    gint64 *start = (gint64 *)store->col_start->data;
+    guint32 *duration = (guint32 *)store->col_duration->data;
+    gint32 *status = (gint32 *)store->col_status->data;
+    guint64 *output = (guint64 *)store->col_output->data;
+    guint32 *cwd = (guint32 *)store->col_cwd->data;
+
+    guint32 last_cwd = first > 0 ? cwd[first - 1] : 0;
+    for (guint i = first; i < count; i++) {
+        start[i] = 0;
+        duration[i] = 0;
+        status[i] = HISTORY_STATUS_UNKNOWN;
+        output[i] = 0;
+        cwd[i] = 0;
+
+        gsize length;
+        const char *line = raw_entry(store, i, &length);
+        gsize prefix = line ? record_prefix_length(line, length) : 0;
+        if (prefix == 0) continue;
+
+        const char *end = line + prefix - 1;  // the tab
+        const char *p = line + 2;
+        start[i] = parse_field(&p, end);
+        duration[i] = parse_field(&p, end);
+        status[i] = parse_field(&p, end);
+        output[i] = parse_field(&p, end);
+
+        // Consecutive commands usually run in the same directory
+        const char *last_name = g_ptr_array_index(store->cwd_names, last_cwd);
+        gsize cwd_len = end - p;
+        if (last_name && strncmp(last_name, p, cwd_len) == 0 && last_name[cwd_len] == '\0') {
+            cwd[i] = last_cwd;
+        } else {
+            cwd[i] = last_cwd = intern_cwd(store, p, cwd_len);
+        }
+    }
+    store->columns_count = count;
+}
+
+// Metadata of an entry; the cwd string lives as long as the store
+gboolean history_store_get_record(HistoryStore *store, guint index, HistoryRecord *record) {
+    if (!store || index >= history_store_count(store)) return FALSE;
+    update_columns(store);
+
+    record->start_time = g_array_index(store->col_start, gint64, index);
+    record->duration_ms = g_array_index(store->col_duration, guint32, index);
+    record->exit_status = g_array_index(store->col_status, gint32, index);
+    record->output_bytes = g_array_index(store->col_output, guint64, index);
+    record->cwd = g_ptr_array_index(store->cwd_names, g_array_index(store->col_cwd, guint32, index));
+    return TRUE;
+}
+
+// Equal durations keep the newer entry first
+static gint compare_duration_desc(gconstpointer a, gconstpointer b, gpointer user_data) {
+    const guint32 *duration = user_data;
+    guint x = *(const guint *)a, y = *(const guint *)b;
+    if (duration[x] != duration[y]) return duration[x] > duration[y] ? -1 : 1;
+    return (x < y) - (x > y);
+}
+
+// Heap order for the --slowest top-N: every parent ranks after its children
+static void slowest_heap_sift_up(GArray *heap, const guint32 *duration) {
+    guint *ids = (guint *)heap->data;
+    guint child = heap->len - 1;
+    while (child > 0) {
+        guint parent = (child - 1) / 2;
+        if (compare_duration_desc(&ids[parent], &ids[child], (gpointer)duration) >= 0) break;
+        guint tmp = ids[parent];
+        ids[parent] = ids[child];
+        ids[child] = tmp;
+        child = parent;
+    }
+}
+
+static void slowest_heap_sift_down(GArray *heap, const guint32 *duration) {
+    guint *ids = (guint *)heap->data;
+    guint parent = 0;
+    for (;;) {
+        guint last = parent;
+        guint left = 2 * parent + 1, right = left + 1;
+        if (left < heap->len && compare_duration_desc(&ids[left], &ids[last], (gpointer)duration) > 0) last = left;
+        if (right < heap->len && compare_duration_desc(&ids[right], &ids[last], (gpointer)duration) > 0) last = right;
+        if (last == parent) break;
+        guint tmp = ids[parent];
+        ids[parent] = ids[last];
+        ids[last] = tmp;
+        parent = last;
+    }
+}
+
+// Ids of the entries matching query, newest first or, with query->slowest,
+// longest running first. A column scan: only the filtered fields are read.
+GArray* history_store_query(HistoryStore *store, const HistoryQuery *query) {
+    GArray *result = g_array_new(FALSE, FALSE, sizeof(guint));
+    if (!store) return result;
+    update_columns(store);
+
+    guint32 cwd_id = 0;
+    if (query->cwd) {
+        cwd_id = GPOINTER_TO_UINT(g_hash_table_lookup(store->cwd_ids, query->cwd));
+        if (cwd_id == 0) return result;
+    }
+
+    const gint64 *start = (const gint64 *)store->col_start->data;
+    const guint32 *duration = (const guint32 *)store->col_duration->data;
+    const gint32 *status = (const gint32 *)store->col_status->data;
+    const guint32 *cwd = (const guint32 *)store->col_cwd->data;
+    guint limit = query->limit ? query->limit : G_MAXUINT;
+
+    // With a limit, --slowest keeps only the best `limit` entries while
+    // scanning, in a heap whose root is the one that currently ranks last
+    gboolean bounded = query->slowest && query->limit > 0;
+
+    for (guint id = store->columns_count; id > 0; id--) {
+        guint i = id - 1;
+        if (query->since && start[i] < query->since) continue;
+        if (query->failed_only && (status[i] == 0 || status[i] == HISTORY_STATUS_UNKNOWN)) continue;
+        if (cwd_id && cwd[i] != cwd_id) continue;
+
+        if (!bounded || result->len < limit) {
+            g_array_append_val(result, i);
+            if (bounded) slowest_heap_sift_up(result, duration);
+            if (!query->slowest && result->len >= limit) break;
+        } else if (compare_duration_desc(&i, &g_array_index(result, guint, 0), (gpointer)duration) < 0) {
+            g_array_index(result, guint, 0) = i;
+            slowest_heap_sift_down(result, duration);
+        }
+    }
+
+    // Longest running first; only the kept entries, or every match for --all
+    if (query->slowest) {
+        g_array_sort_with_data(result, compare_duration_desc, (gpointer)duration);
+    }
+    return result;
+}
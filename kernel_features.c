@@ -27,43 +27,77 @@ void display_system_info() {
 
 // 2) Process Management
 void list_processes_detailed() {
-    DIR *proc_dir;
-    struct dirent *entry;
-    FILE *status_file;
-    char path[256], line[256], name[256];
-    int pid;
-    
-    proc_dir = opendir("/proc");
-    while ((entry = readdir(proc_dir)) != NULL) {
-        pid = atoi(entry->d_name);  //atoi string to integer conversion
-        if (pid > 0) {
-            snprintf(path, sizeof(path), "/proc/%d/status", pid);
-            status_file = fopen(path, "r");
-            if (status_file) {
-                fgets(line, sizeof(line), status_file);
-                sscanf(line, "Name:\t%s", name);
-                printf("PID: %d, Name: %s\n", pid, name);
-                fclose(status_file);
-            }
-        }
+    ProcessInfo *processes;
+    int count = get_process_list(&processes);
+    for (int i = 0; i < count; i++) {
+        printf("PID: %d, Name: %s\n", processes[i].pid, processes[i].name);
+    }
+    free(processes);
+}
+
+// Rates need two samples, so without a running sampler one is started for
+// a single interval. TRUE if the caller has to stop it again.
+static gboolean wait_for_metrics_sample(void) {
+    gboolean started = metrics_sampler_interval() == 0;
+    if (started) {
+        metrics_sampler_start(0);
     }
-    closedir(proc_dir);
+    
+    MetricsSample sample;
+    gint64 deadline = g_get_monotonic_time() + 3 * (gint64)metrics_sampler_interval() * 1000;
+    while (!metrics_sampler_latest(&sample) && g_get_monotonic_time() < deadline) {
+        g_usleep(50 * 1000);
+    }
+    return started;
+}
+
+static void append_memory_line(GString *text, const char *name, guint64 kb) {
+    char *size = g_format_size(kb * 1024);
+    g_string_append_printf(text, "%-14s %12" G_GUINT64_FORMAT " kB  %10s\n", name, kb, size);
+    g_free(size);
+}
+
+// The sampler's reading of /proc/meminfo
+static void format_memory_info(GString *text, const MetricsSample *sample) {
+    append_memory_line(text, "Total:", sample->mem_total_kb);
+    append_memory_line(text, "Available:", sample->mem_available_kb);
+    append_memory_line(text, "Free:", sample->mem_free_kb);
+    append_memory_line(text, "Buffers:", sample->mem_buffers_kb);
+    append_memory_line(text, "Cached:", sample->mem_cached_kb);
+    append_memory_line(text, "Dirty:", sample->mem_dirty_kb);
+    append_memory_line(text, "Swap total:", sample->swap_total_kb);
+    append_memory_line(text, "Swap free:", sample->swap_free_kb);
+    g_string_append_printf(text, "%-14s %12.1f %%\n", "In use:", sample->memory_percent);
 }
 
 // 3) Memory Management
 void display_memory_info() {
-    FILE *meminfo = fopen("/proc/meminfo", "r");
-    char line[256];
-    
+    MetricsSample sample;
+    gboolean started = wait_for_metrics_sample();
+    gboolean have_sample = metrics_sampler_latest(&sample);
+    if (started) {
+        metrics_sampler_stop();
+    }
+
     printf("=== MEMORY INFORMATION ===\n");
-    while (fgets(line, sizeof(line), meminfo)) {
-        if (strncmp(line, "MemTotal:", 9) == 0 ||        //strncmp compares first n characters of two strings               
-            strncmp(line, "MemFree:", 8) == 0 ||
-            strncmp(line, "MemAvailable:", 13) == 0) {
-            printf("%s", line);
-        }
+    if (!have_sample) {
+        printf("No memory sample available\n");
+        return;
     }
-    fclose(meminfo);
+    GString *text = g_string_new(NULL);
+    format_memory_info(text, &sample);
+    fputs(text->str, stdout);
+    g_string_free(text, TRUE);
+}
+
+#define FILESYSTEM_TOP_DIRECTORIES 10
+
+// Largest first
+static int compare_du_nodes(gconstpointer a, gconstpointer b) {
+    DuStats x, y;
+    du_node_stats(*(DuNode **)a, &x);
+    du_node_stats(*(DuNode **)b, &y);
+    return (y.bytes > x.bytes) - (y.bytes < x.bytes);
 }
 
 // 4. File System Analysis
@@ -81,210 +115,309 @@ void analyze_filesystem(const char *path) {
         printf("Free: %lu MB\n", free / 1024 / 1024);
         printf("Usage: %.1f%%\n", (double)used / total * 100);
     }
+
+    // Then where the space under path goes
+    DuScanner *scanner = du_scanner_start(path, TRUE);
+    if (!scanner) {
+        printf("Cannot scan %s: %s\n", path, g_strerror(errno));
+        return;
+    }
+    du_scanner_wait(scanner);
+
+    DuNode *root = du_scanner_root(scanner);
+    DuStats usage;
+    DuProgress progress;
+    du_node_stats(root, &usage);
+    du_scanner_progress(scanner, &progress);
+    char *size = g_format_size(usage.bytes);
+    printf("Scanned: %s in %" G_GUINT64_FORMAT " files, %" G_GUINT64_FORMAT " directories (%.1f s, %u threads)\n",
+           size, usage.files, usage.dirs, progress.elapsed, progress.threads);
+    g_free(size);
+
+    GPtrArray *children = g_ptr_array_new();
+    du_node_children(scanner, root, 0, children);
+    g_ptr_array_sort(children, compare_du_nodes);
+    for (guint i = 0; i < children->len && i < FILESYSTEM_TOP_DIRECTORIES; i++) {
+        DuNode *child = g_ptr_array_index(children, i);
+        du_node_stats(child, &usage);
+        size = g_format_size(usage.bytes);
+        printf("  %10s  %s\n", size, du_node_name(child));
+        g_free(size);
+    }
+    g_ptr_array_free(children, TRUE);
+    du_scanner_free(scanner);
 }
 
 // 5. Network Information
 void display_network_info() {
-    FILE *net_dev = fopen("/proc/net/dev", "r");   // /proc/net/dev contains network interface statistics
-    char line[256];
+    NetInterfaceSet *set = g_new(NetInterfaceSet, 1);
+    guint64 cursor = 0;
+    gboolean started = wait_for_metrics_sample();
+    guint count = metrics_sampler_network_since(&cursor, set, 1);
+    if (started) {
+        metrics_sampler_stop();
+    }
     
-    printf("=== NETWORK INTERFACES ===\n");
-    // Skip header lines
-    fgets(line, sizeof(line), net_dev);
-    fgets(line, sizeof(line), net_dev);
+    if (count == 0) {
+        printf("Cannot access network statistics\n");
+        g_free(set);
+        return;
+    }
     
-    while (fgets(line, sizeof(line), net_dev)) {
-        char interface[16];
-        unsigned long rx_bytes, tx_bytes;
-        
-        sscanf(line, "%[^:]:%lu %*u %*u %*u %*u %*u %*u %*u %lu", 
-               interface, &rx_bytes, &tx_bytes);
-        
-        printf("Interface: %s\n", interface);
-        printf("  RX: %lu KB\n", rx_bytes / 1024);
-        printf("  TX: %lu KB\n", tx_bytes / 1024);
+    printf("=== NETWORK INTERFACES ===\n");
+    printf("%-16s %12s %12s %9s %9s %8s %8s %8s\n",
+           "Interface", "RX Mbit/s", "TX Mbit/s", "RX pkt/s", "TX pkt/s", "errs/s", "drops/s", "link");
+    printf("--------------------------------------------------------------------------------------\n");
+    
+    for (guint i = 0; i < set->count; i++) {
+        const NetInterfaceSample *net = &set->interfaces[i];
+        char link[16] = "-";
+        if (net->speed_mbps > 0) {
+            snprintf(link, sizeof(link), "%.0f%%", net->link_percent);
+        }
+        printf("%-16s %12.2f %12.2f %9.0f %9.0f %8.0f %8.0f %8s\n",
+               net->name, net->rx_bps / 1e6, net->tx_bps / 1e6, net->rx_pps, net->tx_pps,
+               net->rx_errors + net->tx_errors, net->rx_drops + net->tx_drops, link);
     }
-    fclose(net_dev);
+    g_free(set);
 }
 
 // 6. CPU Information
 void display_cpu_info() {
-    FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
-    char line[256];
-    
+    const CpuIdentity *cpu = metrics_sampler_cpu_identity();
+
     printf("=== CPU INFORMATION ===\n");
-    while (fgets(line, sizeof(line), cpuinfo)) {
-        if (strncmp(line, "model name", 10) == 0 ||
-            strncmp(line, "cpu cores", 9) == 0 ||
-            strncmp(line, "cpu MHz", 7) == 0) {
-            printf("%s", line);
-        }
+    printf("Model:      %s\n", cpu->model[0] ? cpu->model : "unknown");
+    printf("Packages:   %u\n", cpu->packages);
+    printf("Cores:      %u\n", cpu->cores);
+    printf("Processors: %u\n", cpu->logical);
+    if (cpu->max_mhz > 0) {
+        printf("Max MHz:    %.0f\n", cpu->max_mhz);
     }
-    fclose(cpuinfo);
 }
 
 // 7. Advanced Process Management with Kill Function
+// Blocks until the process is gone, at most the escalation timeout; the
+// Process Manager uses process_kill_async instead (process_kill.c)
 int kill_process_by_pid(int pid) {
     if (pid <= 0) {
         printf("Invalid PID: %d\n", pid);
         return -1;
     }
     
-    // Check if process exists
-    if (kill(pid, 0) == -1) {
-        printf("Process %d does not exist or no permission\n", pid);
-        return -1;
-    }
-    
-    // Send SIGTERM first (graceful shutdown)
-    if (kill(pid, SIGTERM) == 0) {
-        printf("Sent SIGTERM to process %d\n", pid);
-        sleep(2); // Wait 2 seconds
-        
-        // Check if process still exists
-        if (kill(pid, 0) == 0) {
-            // Process still running, force kill
-            if (kill(pid, SIGKILL) == 0) {
-                printf("Force killed process %d\n", pid);
-                return 0;
-            }
-        } else {
+    ProcessKillResult result = process_kill_sync(pid, process_kill_default_timeout());
+    int error = errno;
+    switch (result) {
+        case PROCESS_KILL_TERMINATED:
             printf("Process %d terminated gracefully\n", pid);
             return 0;
-        }
+        case PROCESS_KILL_KILLED:
+            printf("Force killed process %d\n", pid);
+            return 0;
+        default:
+            printf("Failed to kill process %d: %s\n", pid, strerror(error));
+            return -1;
     }
-    
-    printf("Failed to kill process %d\n", pid);
-    return -1;
 }
 
 // 8. Real-time System Statistics
+// Reads the latest sample from the background sampler (metrics_sampler.c);
+// both figures are 0 until its first interval has elapsed.
 void get_realtime_stats(double *cpu_usage, double *memory_usage) {
-    static unsigned long long prev_idle = 0, prev_total = 0;
-    FILE *stat_file;
-    char line[256];
-    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-    unsigned long long total, total_idle, totald, idled;
-    
-    // CPU Usage calculation
-    stat_file = fopen("/proc/stat", "r");
-    if (stat_file) {
-        fgets(line, sizeof(line), stat_file);
-        sscanf(line, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
-               &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
-        fclose(stat_file);
-        
-        total = user + nice + system + idle + iowait + irq + softirq + steal;
-        total_idle = idle + iowait;
-        
-        totald = total - prev_total;
-        idled = total_idle - prev_idle;
-        
-        if (totald > 0) {
-            *cpu_usage = (double)(totald - idled) / totald * 100.0;
-        } else {
-            *cpu_usage = 0.0;
-        }
-        
-        prev_total = total;
-        prev_idle = total_idle;
-    }
-    
-    // Memory Usage calculation
-    struct sysinfo info;
-    if (sysinfo(&info) == 0) {
-        *memory_usage = (double)(info.totalram - info.freeram) / info.totalram * 100.0;
+    MetricsSample sample;
+    if (metrics_sampler_latest(&sample)) {
+        *cpu_usage = sample.cpu_percent;
+        *memory_usage = sample.memory_percent;
+    } else {
+        *cpu_usage = 0.0;
+        *memory_usage = 0.0;
     }
 }
 
 // 9. Process List with Details
+// The scanner keeps per-process state between calls (proc_scanner.c). When
+// the proc connector is available, process creation and exit arrive as
+// events, so /proc is only listed again as a periodic consistency check.
+// The Process Manager scans on a worker thread while events are applied on
+// the main loop, so the scanner and its rescan state are guarded by a lock.
+#define PROCESS_RESCAN_SECONDS 30
+
+typedef struct {
+    guint id;
+    ProcEventFunc func;
+    gpointer user_data;
+} ProcessWatch;
+
+static GMutex process_scanner_lock;
+static ProcScanner *process_scanner = NULL;
+static ProcEvents *process_events = NULL;   // subscribed only while watched
+static guint process_events_source = 0;
+static gboolean process_rescan_needed = TRUE;
+static gint64 process_last_rescan = 0;
+static GArray *process_watches = NULL;
+static guint process_io_users = 0;     // process_list_track_io() callers
+static guint process_next_watch_id = 1;
+
+static void apply_process_event(ProcChange change, int pid, gpointer user_data) {
+    g_mutex_lock(&process_scanner_lock);
+    proc_scanner_apply(process_scanner, change, pid);
+    g_mutex_unlock(&process_scanner_lock);
+    for (guint i = 0; i < process_watches->len; i++) {
+        ProcessWatch *watch = &g_array_index(process_watches, ProcessWatch, i);
+        watch->func(change, pid, watch->user_data);
+    }
+}
+
+static gboolean on_process_events(gint fd, GIOCondition condition, gpointer user_data) {
+    if (!proc_events_dispatch(process_events, apply_process_event, NULL)) {
+        // Events were dropped; catch up with a full listing next time
+        g_mutex_lock(&process_scanner_lock);
+        process_rescan_needed = TRUE;
+        g_mutex_unlock(&process_scanner_lock);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Called with process_scanner_lock held
+static void ensure_process_scanner(void) {
+    if (process_scanner) return;
+
+    process_scanner = proc_scanner_new();
+}
+
+// Safe to call from any thread
 int get_process_list(ProcessInfo **processes) {
-    DIR *proc_dir;
-    struct dirent *entry;
-    FILE *stat_file, *status_file;
-    char path[512], line[512];
-    ProcessInfo *proc_list = NULL;
-    int count = 0, capacity = 100;
-    
-    proc_list = malloc(capacity * sizeof(ProcessInfo));
-    if (!proc_list) return 0;
-    
-    proc_dir = opendir("/proc");
-    if (!proc_dir) {
-        free(proc_list);
-        return 0;
+    g_mutex_lock(&process_scanner_lock);
+    ensure_process_scanner();
+
+    gint64 now = g_get_monotonic_time();
+    if (!process_events || process_rescan_needed ||
+        now - process_last_rescan >= PROCESS_RESCAN_SECONDS * G_USEC_PER_SEC) {
+        proc_scanner_refresh(process_scanner);
+        process_rescan_needed = FALSE;
+        process_last_rescan = now;
+    } else {
+        proc_scanner_update(process_scanner);
     }
-    
-    while ((entry = readdir(proc_dir)) != NULL) {
-        int pid = atoi(entry->d_name);
-        if (pid <= 0) continue;
-        
-        if (count >= capacity) {
-            capacity *= 2;
-            proc_list = realloc(proc_list, capacity * sizeof(ProcessInfo));
-            if (!proc_list) break;
-        }
-        
-        ProcessInfo *proc = &proc_list[count];
-        proc->pid = pid;
-        
-        // Get process name and state from /proc/[pid]/stat
-        snprintf(path, sizeof(path), "/proc/%d/stat", pid);
-        stat_file = fopen(path, "r");
-        if (stat_file) {
-            fscanf(stat_file, "%*d (%255[^)]) %c %d", proc->name, &proc->state, &proc->ppid);
-            fclose(stat_file);
-        } else {
-            continue;
-        }
-        
-        // Get memory information from /proc/[pid]/status
-        snprintf(path, sizeof(path), "/proc/%d/status", pid);
-        status_file = fopen(path, "r");
-        if (status_file) {
-            while (fgets(line, sizeof(line), status_file)) {
-                if (strncmp(line, "VmRSS:", 6) == 0) {
-                    sscanf(line, "VmRSS: %ld kB", &proc->memory_kb);
-                    break;
-                }
-            }
-            fclose(status_file);
+    int count = proc_scanner_snapshot(process_scanner, processes);
+    g_mutex_unlock(&process_scanner_lock);
+    return count;
+}
+
+// /proc/<pid>/io is only read while somebody shows I/O rates; calls are
+// counted, so every TRUE needs a matching FALSE
+void process_list_track_io(gboolean enabled) {
+    g_mutex_lock(&process_scanner_lock);
+    ensure_process_scanner();
+    if (enabled) {
+        process_io_users++;
+    } else if (process_io_users > 0) {
+        process_io_users--;
+    }
+    proc_scanner_track_io(process_scanner, process_io_users > 0);
+    g_mutex_unlock(&process_scanner_lock);
+}
+
+// Current values of one process as last sampled
+gboolean get_process_info(int pid, ProcessInfo *info) {
+    g_mutex_lock(&process_scanner_lock);
+    ensure_process_scanner();
+    gboolean found = proc_scanner_lookup(process_scanner, pid, info);
+    g_mutex_unlock(&process_scanner_lock);
+    return found;
+}
+
+// Call func for every process start, exec and exit as the kernel reports
+// them. The proc connector is subscribed with the first watch and dropped
+// with the last, so nobody is woken by every fork on the machine while no
+// process view is open. 0 when the kernel cannot deliver the events.
+guint process_list_watch(ProcEventFunc func, gpointer user_data) {
+    g_mutex_lock(&process_scanner_lock);
+    ensure_process_scanner();
+    if (!process_events) {
+        process_events = proc_events_open();
+        if (process_events) {
+            process_events_source = g_unix_fd_add(proc_events_fd(process_events), G_IO_IN,
+                                                  on_process_events, NULL);
+            // Nothing was heard while unsubscribed
+            process_rescan_needed = TRUE;
         }
-        
-        // Get process owner
-        struct stat st;
-        snprintf(path, sizeof(path), "/proc/%d", pid);
-        if (stat(path, &st) == 0) {
-            struct passwd *pw = getpwuid(st.st_uid);
-            if (pw) {
-                strncpy(proc->user, pw->pw_name, sizeof(proc->user) - 1);
-                proc->user[sizeof(proc->user) - 1] = '\0';
-            } else {
-                snprintf(proc->user, sizeof(proc->user), "%d", st.st_uid);
-            }
+    }
+    g_mutex_unlock(&process_scanner_lock);
+    if (!process_events) return 0;
+
+    if (!process_watches) {
+        process_watches = g_array_new(FALSE, FALSE, sizeof(ProcessWatch));
+    }
+    ProcessWatch watch = { process_next_watch_id++, func, user_data };
+    g_array_append_val(process_watches, watch);
+    return watch.id;
+}
+
+void process_list_unwatch(guint id) {
+    for (guint i = 0; process_watches && i < process_watches->len; i++) {
+        if (g_array_index(process_watches, ProcessWatch, i).id == id) {
+            g_array_remove_index(process_watches, i);
+            break;
         }
-        
-        proc->cpu_percent = 0.0; // Would need more complex calculation for real CPU%
-        count++;
     }
-    
-    closedir(proc_dir);
-    *processes = proc_list;
-    return count;
+    if (process_events && process_watches->len == 0) {
+        g_source_remove(process_events_source);
+        process_events_source = 0;
+        g_mutex_lock(&process_scanner_lock);
+        proc_events_close(process_events);
+        process_events = NULL;
+        g_mutex_unlock(&process_scanner_lock);
+    }
 }
 
 // 10. System Call Monitoring (simplified)
+static gint compare_syscall_time(gconstpointer a, gconstpointer b) {
+    const SyscallStats *x = a, *y = b;
+    return (x->total_ns < y->total_ns) - (x->total_ns > y->total_ns);
+}
+
+// Console summary in the style of strace -c, from the built-in tracer
+// (syscall_tracer.c); blocks for duration_seconds
 void monitor_syscalls(int pid, int duration_seconds) {
-    char command[256];
     printf("=== MONITORING SYSCALLS FOR PID %d ===\n", pid);
     printf("Duration: %d seconds\n", duration_seconds);
     
-    // Use strace to monitor system calls
-    snprintf(command, sizeof(command), 
-             "timeout %d strace -p %d -c 2>/dev/null || echo 'Process monitoring completed'", 
-             duration_seconds, pid);
+    SyscallTracer *tracer = syscall_tracer_start(pid);
+    if (!tracer) {
+        printf("Cannot trace process %d: %s\n", pid, strerror(errno));
+        return;
+    }
+    for (int i = 0; i < duration_seconds * 10 && syscall_tracer_running(tracer); i++) {
+        g_usleep(G_USEC_PER_SEC / 10);
+    }
+    syscall_tracer_stop(tracer);
+    if (syscall_tracer_error(tracer) == ENOSYS) {
+        printf("This kernel cannot report syscalls to a tracer (PTRACE_GET_SYSCALL_INFO needs Linux 5.3)\n");
+    }
+    
+    GArray *stats = g_array_new(FALSE, FALSE, sizeof(SyscallStats));
+    syscall_tracer_snapshot(tracer, stats);
+    g_array_sort(stats, compare_syscall_time);
     
-    system(command);
+    guint64 total_ns = 0, calls = 0, errors = 0;
+    for (guint i = 0; i < stats->len; i++) {
+        total_ns += g_array_index(stats, SyscallStats, i).total_ns;
+    }
+    printf("%6s %11s %11s %9s %9s %s\n", "% time", "seconds", "usecs/call", "calls", "errors", "syscall");
+    for (guint i = 0; i < stats->len; i++) {
+        SyscallStats *s = &g_array_index(stats, SyscallStats, i);
+        printf("%6.2f %11.6f %11" G_GUINT64_FORMAT " %9" G_GUINT64_FORMAT " %9" G_GUINT64_FORMAT " %s\n",
+               total_ns ? s->total_ns * 100.0 / total_ns : 0.0, s->total_ns / 1e9,
+               s->total_ns / 1000 / s->count, s->count, s->errors, syscall_name(s->nr));
+        calls += s->count;
+        errors += s->errors;
+    }
+    printf("%6s %11.6f %11s %9" G_GUINT64_FORMAT " %9" G_GUINT64_FORMAT " total\n",
+           "100.00", total_ns / 1e9, "", calls, errors);
+    
+    g_array_free(stats, TRUE);
+    syscall_tracer_free(tracer);
 }
 
 // 11. Kernel Module Information
@@ -312,56 +445,64 @@ void display_loaded_modules() {
 
 // 12. Disk I/O Statistics
 void display_disk_io_stats() {
-    FILE *diskstats = fopen("/proc/diskstats", "r");
-    char line[256], device[32];
-    unsigned long reads, writes;
+    DiskDeviceSample disks[METRICS_MAX_DISKS];
+    gboolean started = wait_for_metrics_sample();
+    guint count = metrics_sampler_disks(disks, METRICS_MAX_DISKS);
+    if (started) {
+        metrics_sampler_stop();
+    }
     
-    if (!diskstats) {
+    if (count == 0) {
         printf("Cannot access disk statistics\n");
         return;
     }
     
     printf("=== DISK I/O STATISTICS ===\n");
-    printf("%-10s %10s %10s\n", "Device", "Reads", "Writes");
-    printf("--------------------------------\n");
-    
-    while (fgets(line, sizeof(line), diskstats)) {
-        if (sscanf(line, "%*d %*d %s %lu %*u %*u %*u %lu", device, &reads, &writes) >= 3) {
-            // Only show actual disks (sda, nvme, etc.)
-            if (strstr(device, "sd") || strstr(device, "nvme") || strstr(device, "hd")) {
-                printf("%-10s %10lu %10lu\n", device, reads, writes);
-            }
-        }
+    printf("%-12s %10s %10s %8s %8s %9s %9s %6s %6s\n",
+           "Device", "rMB/s", "wMB/s", "r/s", "w/s", "r_await", "w_await", "aqu", "%util");
+    printf("----------------------------------------------------------------------------------\n");
+    
+    for (guint i = 0; i < count; i++) {
+        const DiskDeviceSample *disk = &disks[i];
+        printf("%-12s %10.2f %10.2f %8.0f %8.0f %9.2f %9.2f %6.2f %6.1f%s\n",
+               disk->name, disk->read_rate / (1024 * 1024), disk->write_rate / (1024 * 1024),
+               disk->read_iops, disk->write_iops, disk->read_await_ms, disk->write_await_ms,
+               disk->queue_depth, disk->util_percent, disk->stacked ? "  (stacked)" : "");
     }
-    
-    fclose(diskstats);
 }
 
 // 13. Temperature Monitoring (if available)
 void display_temperature_info() {
-    FILE *temp_file;
-    char path[256], line[128];
-    int temp;
+    ThermalSensorSet *set = g_new(ThermalSensorSet, 1);
+    guint64 cursor = 0;
+    gboolean started = wait_for_metrics_sample();
+    guint count = metrics_sampler_sensors_since(&cursor, set, 1);
+    if (started) {
+        metrics_sampler_stop();
+    }
     
     printf("=== TEMPERATURE INFORMATION ===\n");
+    if (count == 0 || set->count == 0) {
+        printf("No temperature sensors found\n");
+        g_free(set);
+        return;
+    }
+    
+    printf("%-16s %-36s %9s %9s\n", "Sensor", "Label", "Temp", "Critical");
+    printf("-------------------------------------------------------------------------\n");
     
-    // Try common temperature paths
-    const char* temp_paths[] = {
-        "/sys/class/thermal/thermal_zone0/temp",
-        "/sys/class/thermal/thermal_zone1/temp",
-        NULL
-    };
-    
-    for (int i = 0; temp_paths[i]; i++) {
-        temp_file = fopen(temp_paths[i], "r");
-        if (temp_file) {
-            if (fgets(line, sizeof(line), temp_file)) {
-                temp = atoi(line) / 1000; // Convert from millidegrees
-                printf("Zone %d: %d°C\n", i, temp);
-            }
-            fclose(temp_file);
+    for (guint i = 0; i < set->count; i++) {
+        const ThermalSensorSample *sensor = &set->sensors[i];
+        char temp[16] = "n/a", critical[16] = "-";
+        if (sensor->valid) {
+            snprintf(temp, sizeof(temp), "%.1f°C", sensor->celsius);
         }
+        if (sensor->critical_celsius > 0) {
+            snprintf(critical, sizeof(critical), "%.1f°C", sensor->critical_celsius);
+        }
+        printf("%-16s %-36s %9s %9s\n", sensor->name, sensor->label, temp, critical);
     }
+    g_free(set);
 }
 
 // 14. GTK Integration Functions for GUI Display
@@ -377,7 +518,7 @@ GtkWidget* create_system_info_dialog(GtkWindow *parent) {
                                          "_Close", GTK_RESPONSE_CLOSE,
                                          NULL);
     
-    gtk_window_set_default_size(GTK_WINDOW(dialog), 500, 400);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 1000, 650);
     gtk_window_set_resizable(GTK_WINDOW(dialog), TRUE);
     
     content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
@@ -432,162 +573,21 @@ GtkWidget* create_system_info_dialog(GtkWindow *parent) {
     label = gtk_label_new(text);
     gtk_grid_attach(GTK_GRID(grid), label, 0, 5, 2, 1);
     
-    gtk_widget_show_all(dialog);
-    return dialog;
-}
-
-// 15. Process Manager Dialog with Kill Functionality
-static void on_kill_process_clicked(GtkButton *button, gpointer user_data) {
-    int pid = GPOINTER_TO_INT(user_data);
-    
-    GtkWidget *confirm_dialog = gtk_message_dialog_new(NULL,
-                                                       GTK_DIALOG_MODAL,
-                                                       GTK_MESSAGE_QUESTION,
-                                                       GTK_BUTTONS_YES_NO,
-                                                       "Are you sure you want to kill process %d?", pid);
-    
-    int response = gtk_dialog_run(GTK_DIALOG(confirm_dialog));
-    gtk_widget_destroy(confirm_dialog);
-    
-    if (response == GTK_RESPONSE_YES) {
-        if (kill_process_by_pid(pid) == 0) {
-            GtkWidget *success_dialog = gtk_message_dialog_new(NULL,
-                                                              GTK_DIALOG_MODAL,
-                                                              GTK_MESSAGE_INFO,
-                                                              GTK_BUTTONS_OK,
-                                                              "Process %d killed successfully", pid);
-            gtk_dialog_run(GTK_DIALOG(success_dialog));
-            gtk_widget_destroy(success_dialog);
-        } else {
-            GtkWidget *error_dialog = gtk_message_dialog_new(NULL,
-                                                            GTK_DIALOG_MODAL,
-                                                            GTK_MESSAGE_ERROR,
-                                                            GTK_BUTTONS_OK,
-                                                            "Failed to kill process %d", pid);
-            gtk_dialog_run(GTK_DIALOG(error_dialog));
-            gtk_widget_destroy(error_dialog);
-        }
-    }
-}
-
-GtkWidget* create_process_manager_dialog(GtkWindow *parent) {
-    GtkWidget *dialog, *content_area, *scrolled, *listbox, *hbox, *label, *button;
-    ProcessInfo *processes;
-    int process_count;
-    char text[512];
-    
-    dialog = gtk_dialog_new_with_buttons("Process Manager",
-                                         parent,
-                                         GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-                                         "_Refresh", 1,
-                                         "_Close", GTK_RESPONSE_CLOSE,
-                                         NULL);
-    
-    gtk_window_set_default_size(GTK_WINDOW(dialog), 1000, 700);
-    gtk_window_set_resizable(GTK_WINDOW(dialog), TRUE);
-    
-    content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
-    
-    // Create scrolled window that fills entire dialog
-    scrolled = gtk_scrolled_window_new(NULL, NULL);
-    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
-                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
-    gtk_widget_set_hexpand(scrolled, TRUE);
-    gtk_widget_set_vexpand(scrolled, TRUE);
-    gtk_widget_set_margin_top(scrolled, 10);
-    gtk_widget_set_margin_bottom(scrolled, 10);
-    gtk_widget_set_margin_left(scrolled, 10);
-    gtk_widget_set_margin_right(scrolled, 10);
-    gtk_container_add(GTK_CONTAINER(content_area), scrolled);
-    
-    // Create list box
-    listbox = gtk_list_box_new();
-    gtk_widget_set_hexpand(listbox, TRUE);
-    gtk_widget_set_vexpand(listbox, TRUE);
-    gtk_container_add(GTK_CONTAINER(scrolled), listbox);
-    
-    // Get process list
-    process_count = get_process_list(&processes);
-    
-    // Add header
-    hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-    label = gtk_label_new("PID");
-    gtk_widget_set_size_request(label, 60, -1);
-    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-    
-    label = gtk_label_new("Name");
-    gtk_widget_set_size_request(label, 200, -1);
-    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-    
-    label = gtk_label_new("User");
-    gtk_widget_set_size_request(label, 100, -1);
-    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-    
-    label = gtk_label_new("Memory (KB)");
-    gtk_widget_set_size_request(label, 100, -1);
-    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
+    // Per-core utilization history
+    GtkWidget *cores_frame = gtk_frame_new("Per-core CPU");
+    gtk_container_add(GTK_CONTAINER(cores_frame), cpu_monitor_new());
+    gtk_grid_attach(GTK_GRID(grid), cores_frame, 0, 6, 2, 1);
     
-    label = gtk_label_new("State");
-    gtk_widget_set_size_request(label, 60, -1);
-    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
+    // Pressure stall information
+    GtkWidget *pressure_frame = gtk_frame_new("Pressure (PSI)");
+    gtk_container_add(GTK_CONTAINER(pressure_frame), psi_panel_new());
+    gtk_grid_attach(GTK_GRID(grid), pressure_frame, 0, 7, 2, 1);
     
-    label = gtk_label_new("Action");
-    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
+    // Thermal zones and hwmon sensors
+    GtkWidget *thermal_frame = gtk_frame_new("Temperatures");
+    gtk_container_add(GTK_CONTAINER(thermal_frame), thermal_panel_new());
+    gtk_grid_attach(GTK_GRID(grid), thermal_frame, 0, 8, 2, 1);
     
-    gtk_list_box_insert(GTK_LIST_BOX(listbox), hbox, 0);
-    
-    // Add processes (show more processes)
-    for (int i = 0; i < process_count && i < 200; i++) { // Show up to 200 processes
-        ProcessInfo *proc = &processes[i];
-        
-        hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-        
-        // PID
-        snprintf(text, sizeof(text), "%d", proc->pid);
-        label = gtk_label_new(text);
-        gtk_widget_set_size_request(label, 60, -1);
-        gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-        
-        // Name (truncated)
-        if (strlen(proc->name) > 25) {
-            snprintf(text, sizeof(text), "%.22s...", proc->name);
-        } else {
-            strcpy(text, proc->name);
-        }
-        label = gtk_label_new(text);
-        gtk_widget_set_size_request(label, 200, -1);
-        gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-        
-        // User
-        label = gtk_label_new(proc->user);
-        gtk_widget_set_size_request(label, 100, -1);
-        gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-        
-        // Memory
-        snprintf(text, sizeof(text), "%ld", proc->memory_kb);
-        label = gtk_label_new(text);
-        gtk_widget_set_size_request(label, 100, -1);
-        gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-        
-        // State
-        snprintf(text, sizeof(text), "%c", proc->state);
-        label = gtk_label_new(text);
-        gtk_widget_set_size_request(label, 60, -1);
-        gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
-        
-        // Kill button (only for non-system processes)
-        if (proc->pid > 1) {
-            button = gtk_button_new_with_label("Kill");
-            gtk_widget_set_size_request(button, 60, -1);
-            g_signal_connect(button, "clicked", G_CALLBACK(on_kill_process_clicked), 
-                           GINT_TO_POINTER(proc->pid));
-            gtk_box_pack_start(GTK_BOX(hbox), button, FALSE, FALSE, 0);
-        }
-        
-        gtk_list_box_insert(GTK_LIST_BOX(listbox), hbox, i + 1);
-    }
-    
-    free(processes);
     gtk_widget_show_all(dialog);
     return dialog;
 }
@@ -603,8 +603,6 @@ void show_system_monitor(AppData *app) {
 GtkWidget* create_memory_info_dialog(GtkWindow *parent) {
     GtkWidget *dialog, *content_area, *scrolled, *textview;
     GtkTextBuffer *text_buffer;
-    FILE *meminfo;
-    char line[256], full_text[4096] = "";
     
     dialog = gtk_dialog_new_with_buttons("Memory Information",
                                          parent,
@@ -612,7 +610,7 @@ GtkWidget* create_memory_info_dialog(GtkWindow *parent) {
                                          "_Close", GTK_RESPONSE_CLOSE,
                                          NULL);
     
-    gtk_window_set_default_size(GTK_WINDOW(dialog), 700, 600);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 900, 650);
     gtk_window_set_resizable(GTK_WINDOW(dialog), TRUE);
     
     content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
@@ -637,21 +635,19 @@ GtkWidget* create_memory_info_dialog(GtkWindow *parent) {
     gtk_widget_set_vexpand(textview, TRUE);
     gtk_container_add(GTK_CONTAINER(scrolled), textview);
     
-    // Read memory information
-    meminfo = fopen("/proc/meminfo", "r");
-    if (meminfo) {
-        strcat(full_text, "=== MEMORY INFORMATION ===\n\n");
-        while (fgets(line, sizeof(line), meminfo)) {
-            strcat(full_text, line);
-        }
-        fclose(meminfo);
+    // Memory figures come from the sampler, never from /proc on this thread
+    MetricsSample sample;
+    GString *text = g_string_new("=== MEMORY INFORMATION ===\n\n");
+    if (metrics_sampler_latest(&sample)) {
+        format_memory_info(text, &sample);
     } else {
-        strcat(full_text, "Error: Cannot read memory information\n");
+        g_string_append(text, "No memory sample yet; try again in a moment\n");
     }
     
     // Set text in buffer
     text_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(textview));
-    gtk_text_buffer_set_text(text_buffer, full_text, -1);
+    gtk_text_buffer_set_text(text_buffer, text->str, -1);
+    g_string_free(text, TRUE);
     
     gtk_widget_show_all(dialog);
     return dialog;
@@ -721,29 +717,18 @@ GtkWidget* create_filesystem_dialog(GtkWindow *parent) {
         }
     }
     
-    // Add disk I/O statistics
-    strcat(full_text, "=== DISK I/O STATISTICS ===\n\n");
-    FILE *diskstats = fopen("/proc/diskstats", "r");
-    if (diskstats) {
-        char line[256], device[32];
-        unsigned long reads, writes;
-        
-        while (fgets(line, sizeof(line), diskstats)) {
-            if (sscanf(line, "%*d %*d %s %lu %*u %*u %*u %lu", device, &reads, &writes) >= 3) {
-                if (strstr(device, "sd") || strstr(device, "nvme") || strstr(device, "hd")) {
-                    snprintf(temp, sizeof(temp), "Device: %s - Reads: %lu, Writes: %lu\n", 
-                            device, reads, writes);
-                    strcat(full_text, temp);
-                }
-            }
-        }
-        fclose(diskstats);
-    }
-    
     // Set text in buffer
     text_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(textview));
     gtk_text_buffer_set_text(text_buffer, full_text, -1);
     
+    // Live disk I/O below the mount points
+    GtkWidget *disk_frame = gtk_frame_new("Disk I/O");
+    gtk_widget_set_margin_bottom(disk_frame, 10);
+    gtk_widget_set_margin_left(disk_frame, 10);
+    gtk_widget_set_margin_right(disk_frame, 10);
+    gtk_container_add(GTK_CONTAINER(disk_frame), disk_panel_new());
+    gtk_box_pack_start(GTK_BOX(content_area), disk_frame, FALSE, FALSE, 0);
+    
     gtk_widget_show_all(dialog);
     return dialog;
 }
@@ -776,4 +761,18 @@ void on_process_manager_clicked(GtkMenuItem *menuitem, gpointer user_data) {
     GtkWidget *dialog = create_process_manager_dialog(GTK_WINDOW(app->window));
     gtk_dialog_run(GTK_DIALOG(dialog));
     gtk_widget_destroy(dialog);
-}
\ No newline at end of file
+}
+
+void on_cgroup_explorer_clicked(GtkMenuItem *menuitem, gpointer user_data) {
+    AppData *app = (AppData *)user_data;
+    GtkWidget *dialog = create_cgroup_explorer_dialog(GTK_WINDOW(app->window));
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
+void on_disk_analyzer_clicked(GtkMenuItem *menuitem, gpointer user_data) {
+    AppData *app = (AppData *)user_data;
+    GtkWidget *dialog = create_disk_analyzer_dialog(GTK_WINDOW(app->window));
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
@@ -3,6 +3,9 @@
 void activate(GtkApplication* app, gpointer user_data) {
     AppData *app_data = g_new0(AppData, 1);
     
+    // Start indexing $PATH in the background for "Did you mean" suggestions
+    command_index_init();
+    
     // Main window
     app_data->window = gtk_application_window_new(app);
     gtk_window_set_title(GTK_WINDOW(app_data->window), "Command Sphere");
@@ -58,6 +61,11 @@ void activate(GtkApplication* app, gpointer user_data) {
     gtk_widget_show(process_manager_item);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), process_manager_item);
     
+    GtkWidget *cgroup_explorer_item = gtk_menu_item_new_with_label("Control Groups");
+    g_signal_connect(cgroup_explorer_item, "activate", G_CALLBACK(on_cgroup_explorer_clicked), app_data);
+    gtk_widget_show(cgroup_explorer_item);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), cgroup_explorer_item);
+    
     GtkWidget *memory_monitor_item = gtk_menu_item_new_with_label("Memory Monitor");
     g_signal_connect(memory_monitor_item, "activate", G_CALLBACK(on_memory_monitor_clicked), app_data);
     gtk_widget_show(memory_monitor_item);
@@ -72,11 +80,21 @@ void activate(GtkApplication* app, gpointer user_data) {
     g_signal_connect(network_info_item, "activate", G_CALLBACK(on_network_info_clicked), app_data);
     gtk_widget_show(network_info_item);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), network_info_item);
+
+    GtkWidget *connections_item = gtk_menu_item_new_with_label("Connections");
+    g_signal_connect(connections_item, "activate", G_CALLBACK(on_connections_clicked), app_data);
+    gtk_widget_show(connections_item);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), connections_item);
     
     GtkWidget *disk_usage_item = gtk_menu_item_new_with_label("Disk Usage");
     g_signal_connect(disk_usage_item, "activate", G_CALLBACK(on_disk_usage_clicked), app_data);
     gtk_widget_show(disk_usage_item);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), disk_usage_item);
+
+    GtkWidget *disk_analyzer_item = gtk_menu_item_new_with_label("Disk Analyzer");
+    g_signal_connect(disk_analyzer_item, "activate", G_CALLBACK(on_disk_analyzer_clicked), app_data);
+    gtk_widget_show(disk_analyzer_item);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), disk_analyzer_item);
     
     // Show the menu
     gtk_widget_show_all(menu);
@@ -137,6 +155,13 @@ void activate(GtkApplication* app, gpointer user_data) {
     // Pack entry box into container
     gtk_box_pack_start(GTK_BOX(entry_container), entry_box, FALSE, FALSE, 0);
     
+    // Reverse history search prompt (Ctrl+R)
+    app_data->rsearch_label = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(app_data->rsearch_label), 0.0);
+    gtk_widget_set_name(app_data->rsearch_label, "rsearch-label");
+    gtk_box_pack_start(GTK_BOX(entry_container), app_data->rsearch_label, FALSE, FALSE, 0);
+    gtk_widget_set_no_show_all(app_data->rsearch_label, TRUE);
+    
     // Auto-suggestion popup
     app_data->suggestion_popup = gtk_scrolled_window_new(NULL, NULL);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(app_data->suggestion_popup),
@@ -151,6 +176,12 @@ void activate(GtkApplication* app, gpointer user_data) {
     // Add entry container to main box
     gtk_box_pack_start(GTK_BOX(vbox), entry_container, FALSE, FALSE, 0);
     
+    // Status line fed by the background metrics sampler
+    app_data->status_label = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(app_data->status_label), 1.0);
+    gtk_widget_set_name(app_data->status_label, "status-label");
+    gtk_box_pack_start(GTK_BOX(vbox), app_data->status_label, FALSE, FALSE, 0);
+    
     // CSS styling for professional appearance
     GtkCssProvider *css_provider = gtk_css_provider_new();
     const char *css_data =
@@ -228,6 +259,17 @@ void activate(GtkApplication* app, gpointer user_data) {
         "  color: white; "
         "  padding: 8px 12px; "
         "} "
+        "#rsearch-label { "
+        "  color: #cccccc; "
+        "  font-family: monospace; "
+        "  padding: 2px 6px; "
+        "} "
+        "#status-label { "
+        "  color: #999999; "
+        "  font-family: monospace; "
+        "  font-size: 11px; "
+        "  padding: 0px 6px 4px 6px; "
+        "} "
         "menuitem:hover { "
         "  background: #444444; "
         "} ";
@@ -240,13 +282,24 @@ void activate(GtkApplication* app, gpointer user_data) {
     // Initialize app data
     app_data->theme_index = 0;
     app_data->css_provider = gtk_css_provider_new();
-    app_data->history_count = 0;
+    app_data->history = history_store_open(NULL);
     app_data->history_index = -1;
+    app_data->history_search = history_search_index_new(app_data->history);
+    if (history_store_watch_fd(app_data->history) >= 0) {
+        app_data->history_watch = g_unix_fd_add(history_store_watch_fd(app_data->history), G_IO_IN,
+                                                on_history_file_changed, app_data);
+    }
+    app_data->rsearch_query = g_string_new(NULL);
+    app_data->rsearch_match = -1;
     app_data->is_recording = FALSE;
     
-    for (int i = 0; i < MAX_HISTORY; i++) {
-        app_data->command_history[i] = NULL;
-    }
+    // System metrics are sampled off the UI thread; dialogs and the status
+    // line only read the sampler's ring buffer
+    metrics_sampler_start(0);
+    psi_monitor_start();
+    metrics_exporter_start();
+    app_data->status_timer = g_timeout_add_seconds(1, update_status_label, app_data);
+    g_signal_connect(app_data->status_label, "destroy", G_CALLBACK(on_status_label_destroy), app_data);
     
     // Create text buffer tags
     gtk_text_buffer_create_tag(app_data->buffer, "default", "foreground", "black", NULL);
@@ -267,7 +320,7 @@ void activate(GtkApplication* app, gpointer user_data) {
     gtk_text_buffer_insert(app_data->buffer, &iter, "\nUnique Features:\n", -1);
     gtk_text_buffer_insert(app_data->buffer, &iter, "- Built-in Calculator (e.g., calc 2+3*5)\n", -1);
     gtk_text_buffer_insert(app_data->buffer, &iter, "- Theme Switching (Light, Dark, Hacker, Solarized)\n", -1);
-    gtk_text_buffer_insert(app_data->buffer, &iter, "- Command History with Up/Down arrows\n", -1);
+    gtk_text_buffer_insert(app_data->buffer, &iter, "- Command History with Up/Down arrows, Ctrl+R to search it\n", -1);
     gtk_text_buffer_insert(app_data->buffer, &iter, "- Real-time Time Display\n", -1);
     gtk_text_buffer_insert(app_data->buffer, &iter, "- Color-coded Command Output\n", -1);
     gtk_text_buffer_insert(app_data->buffer, &iter, "- Voice Recognition (Click MIC button)\n", -1);
@@ -281,6 +334,9 @@ int main(int argc, char **argv) {
     GtkApplication *app = gtk_application_new("org.example.shell", G_APPLICATION_FLAGS_NONE);
     g_signal_connect(app, "activate", G_CALLBACK(activate), NULL);
     int status = g_application_run(G_APPLICATION(app), argc, argv);
+    metrics_exporter_stop();
+    psi_monitor_stop();
+    metrics_sampler_stop();
     g_object_unref(app);
     return status;
 }
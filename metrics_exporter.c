@@ -0,0 +1,557 @@
+// metrics_exporter.c
+// Serves what the metrics sampler holds in the Prometheus text exposition
+// format, so a local agent can scrape the workstation without a separate
+// node exporter. Set COMMAND_SPHERE_METRICS_LISTEN to a port number to
+// serve http://127.0.0.1:<port>/metrics, or to an absolute path to serve
+// the same over a Unix socket (curl --unix-socket <path> localhost/metrics).
+// The endpoint is off when the variable is unset.
+//
+// A scrape only copies samples out of the sampler's rings: CPU overall and
+// per core, memory, pressure, every disk, interface and temperature sensor,
+// and the busiest processes, which the sampler scans for every couple of
+// seconds for as long as the endpoint runs. Nothing touches /proc on behalf
+// of a scrape, so scraping more often than the sampling interval only
+// repeats the last values.
+//
+// One thread accepts and answers connections one at a time; a client gets
+// a few seconds to send its request and read the answer.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <math.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define EXPORTER_TIMEOUT_SECONDS 3
+#define EXPORTER_REQUEST_MAX 4096
+#define EXPORTER_PREFIX "commandsphere_"
+
+typedef struct {
+    GThread *thread;
+    int listen_fd;
+    int stop_fd;                // eventfd, written to stop the thread
+    char *socket_path;          // Unix socket to unlink on stop, or NULL
+} MetricsExporter;
+
+static MetricsExporter *exporter = NULL;
+
+typedef struct {
+    const char *name;           // without EXPORTER_PREFIX
+    const char *type;
+    const char *help;
+} MetricInfo;
+
+// Label set of one item of a table, e.g. device="sda"
+typedef void (*LabelsFunc)(gconstpointer item, guint index, GString *labels);
+// One value per MetricInfo of the table; NAN leaves the sample out
+typedef void (*ValuesFunc)(gconstpointer item, double *values);
+
+static void append_label(GString *labels, const char *key, const char *value) {
+    if (labels->len > 0) g_string_append_c(labels, ',');
+    g_string_append_printf(labels, "%s=\"", key);
+    for (const char *c = value; *c; c++) {
+        if (*c == '\\' || *c == '"') {
+            g_string_append_c(labels, '\\');
+            g_string_append_c(labels, *c);
+        } else if (*c == '\n') {
+            g_string_append(labels, "\\n");
+        } else {
+            g_string_append_c(labels, *c);
+        }
+    }
+    g_string_append_c(labels, '"');
+}
+
+static void append_header(GString *out, const MetricInfo *metric) {
+    g_string_append_printf(out, "# HELP " EXPORTER_PREFIX "%s %s\n# TYPE " EXPORTER_PREFIX "%s %s\n",
+                           metric->name, metric->help, metric->name, metric->type);
+}
+
+static void append_sample(GString *out, const char *name, const char *labels, double value) {
+    // Counters stay exact; rates and percentages keep six digits
+    char number[G_ASCII_DTOSTR_BUF_SIZE];
+    gboolean integral = value == floor(value) && fabs(value) < 9007199254740992.0;
+    g_ascii_formatd(number, sizeof(number), integral ? "%.0f" : "%.6g", value);
+    if (labels && *labels) {
+        g_string_append_printf(out, EXPORTER_PREFIX "%s{%s} %s\n", name, labels, number);
+    } else {
+        g_string_append_printf(out, EXPORTER_PREFIX "%s %s\n", name, number);
+    }
+}
+
+static void append_gauge(GString *out, const char *name, const char *help, double value) {
+    MetricInfo metric = { name, "gauge", help };
+    append_header(out, &metric);
+    append_sample(out, name, NULL, value);
+}
+
+// Every metric of a table over every item. Prometheus wants the samples of
+// one metric together, so the values are computed once and written out
+// metric by metric.
+static void append_table(GString *out, const MetricInfo *metrics, guint metric_count,
+                         gconstpointer items, guint item_count, gsize item_size,
+                         LabelsFunc labels_func, ValuesFunc values_func) {
+    if (item_count == 0) return;
+    double *values = g_new(double, (gsize)item_count * metric_count);
+    GPtrArray *labels = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; i < item_count; i++) {
+        gconstpointer item = (const char *)items + i * item_size;
+        GString *text = g_string_new(NULL);
+        labels_func(item, i, text);
+        g_ptr_array_add(labels, g_string_free(text, FALSE));
+        values_func(item, values + (gsize)i * metric_count);
+    }
+
+    for (guint m = 0; m < metric_count; m++) {
+        append_header(out, &metrics[m]);
+        for (guint i = 0; i < item_count; i++) {
+            double value = values[(gsize)i * metric_count + m];
+            if (!isnan(value)) append_sample(out, metrics[m].name, g_ptr_array_index(labels, i), value);
+        }
+    }
+    g_ptr_array_free(labels, TRUE);
+    g_free(values);
+}
+
+// CPU: item 0 is all cores together, then one per core
+
+static const MetricInfo cpu_metrics[] = {
+    { "cpu_busy_percent", "gauge", "Share of CPU time not idle or in iowait over the last interval" },
+    { "cpu_user_percent", "gauge", "Share of CPU time in user mode, nice included" },
+    { "cpu_system_percent", "gauge", "Share of CPU time in kernel mode" },
+    { "cpu_iowait_percent", "gauge", "Share of CPU time idle with I/O outstanding" },
+    { "cpu_irq_percent", "gauge", "Share of CPU time in hard interrupts" },
+    { "cpu_softirq_percent", "gauge", "Share of CPU time in soft interrupts" },
+    { "cpu_steal_percent", "gauge", "Share of CPU time taken by the hypervisor" },
+};
+
+static void cpu_labels(gconstpointer item, guint index, GString *labels) {
+    char cpu[16];
+    if (index == 0) {
+        g_strlcpy(cpu, "total", sizeof(cpu));
+    } else {
+        snprintf(cpu, sizeof(cpu), "%u", index - 1);
+    }
+    append_label(labels, "cpu", cpu);
+}
+
+static void cpu_values(gconstpointer item, double *values) {
+    const CpuCoreSample *cpu = item;
+    values[0] = cpu->busy;
+    values[1] = cpu->user;
+    values[2] = cpu->system;
+    values[3] = cpu->iowait;
+    values[4] = cpu->irq;
+    values[5] = cpu->softirq;
+    values[6] = cpu->steal;
+}
+
+static const MetricInfo pressure_metrics[] = {
+    { "pressure_some_avg10_percent", "gauge", "Share of time some tasks stalled on the resource, 10 s average" },
+    { "pressure_some_avg60_percent", "gauge", "Share of time some tasks stalled on the resource, 60 s average" },
+    { "pressure_some_avg300_percent", "gauge", "Share of time some tasks stalled on the resource, 300 s average" },
+    { "pressure_full_avg10_percent", "gauge", "Share of time all non-idle tasks stalled on the resource, 10 s average" },
+    { "pressure_full_avg60_percent", "gauge", "Share of time all non-idle tasks stalled on the resource, 60 s average" },
+    { "pressure_full_avg300_percent", "gauge", "Share of time all non-idle tasks stalled on the resource, 300 s average" },
+    { "pressure_some_stalled_seconds_total", "counter", "Time some tasks stalled on the resource since boot" },
+    { "pressure_full_stalled_seconds_total", "counter", "Time all non-idle tasks stalled on the resource since boot" },
+};
+
+static void pressure_labels(gconstpointer item, guint index, GString *labels) {
+    append_label(labels, "resource", psi_resource_name(index));
+}
+
+static void pressure_values(gconstpointer item, double *values) {
+    const PsiSample *psi = item;
+    values[0] = psi->some_avg10;
+    values[1] = psi->some_avg60;
+    values[2] = psi->some_avg300;
+    values[3] = psi->full_avg10;
+    values[4] = psi->full_avg60;
+    values[5] = psi->full_avg300;
+    values[6] = psi->some_total_us / 1e6;
+    values[7] = psi->full_total_us / 1e6;
+}
+
+static const MetricInfo disk_metrics[] = {
+    { "disk_read_bytes_total", "counter", "Bytes read from the block device since boot" },
+    { "disk_written_bytes_total", "counter", "Bytes written to the block device since boot" },
+    { "disk_read_bytes_per_second", "gauge", "Read throughput over the last interval" },
+    { "disk_write_bytes_per_second", "gauge", "Write throughput over the last interval" },
+    { "disk_reads_per_second", "gauge", "Completed reads per second over the last interval" },
+    { "disk_writes_per_second", "gauge", "Completed writes per second over the last interval" },
+    { "disk_await_seconds", "gauge", "Average time per completed request, queueing included" },
+    { "disk_utilization_percent", "gauge", "Share of the interval with requests in flight" },
+    { "disk_queue_depth", "gauge", "Average number of requests in flight" },
+};
+
+static void disk_labels(gconstpointer item, guint index, GString *labels) {
+    const DiskDeviceSample *disk = item;
+    append_label(labels, "device", disk->name);
+    append_label(labels, "stacked", disk->stacked ? "true" : "false");
+}
+
+static void disk_values(gconstpointer item, double *values) {
+    const DiskDeviceSample *disk = item;
+    values[0] = disk->read_bytes;
+    values[1] = disk->write_bytes;
+    values[2] = disk->read_rate;
+    values[3] = disk->write_rate;
+    values[4] = disk->read_iops;
+    values[5] = disk->write_iops;
+    values[6] = disk->await_ms / 1000.0;
+    values[7] = disk->util_percent;
+    values[8] = disk->queue_depth;
+}
+
+static const MetricInfo network_metrics[] = {
+    { "network_receive_bytes_total", "counter", "Bytes received on the interface since boot" },
+    { "network_transmit_bytes_total", "counter", "Bytes transmitted on the interface since boot" },
+    { "network_receive_bits_per_second", "gauge", "Receive rate over the last interval" },
+    { "network_transmit_bits_per_second", "gauge", "Transmit rate over the last interval" },
+    { "network_receive_packets_per_second", "gauge", "Packets received per second over the last interval" },
+    { "network_transmit_packets_per_second", "gauge", "Packets transmitted per second over the last interval" },
+    { "network_errors_per_second", "gauge", "Receive and transmit errors per second over the last interval" },
+    { "network_drops_per_second", "gauge", "Receive and transmit drops per second over the last interval" },
+    { "network_link_speed_bits_per_second", "gauge", "Link speed reported by the driver" },
+    { "network_link_utilization_percent", "gauge", "Busier direction against the link speed" },
+};
+
+static void network_labels(gconstpointer item, guint index, GString *labels) {
+    append_label(labels, "interface", ((const NetInterfaceSample *)item)->name);
+}
+
+static void network_values(gconstpointer item, double *values) {
+    const NetInterfaceSample *net = item;
+    values[0] = net->rx_bytes;
+    values[1] = net->tx_bytes;
+    values[2] = net->rx_bps;
+    values[3] = net->tx_bps;
+    values[4] = net->rx_pps;
+    values[5] = net->tx_pps;
+    values[6] = net->rx_errors + net->tx_errors;
+    values[7] = net->rx_drops + net->tx_drops;
+    values[8] = net->speed_mbps > 0 ? net->speed_mbps * 1e6 : NAN;
+    values[9] = net->speed_mbps > 0 ? net->link_percent : NAN;
+}
+
+static const MetricInfo sensor_metrics[] = {
+    { "temperature_celsius", "gauge", "Temperature of a thermal zone or hwmon sensor" },
+    { "temperature_critical_celsius", "gauge", "Critical trip point of the sensor" },
+};
+
+static void sensor_labels(gconstpointer item, guint index, GString *labels) {
+    const ThermalSensorSample *sensor = item;
+    append_label(labels, "sensor", sensor->name);
+    append_label(labels, "label", sensor->label);
+}
+
+static void sensor_values(gconstpointer item, double *values) {
+    const ThermalSensorSample *sensor = item;
+    values[0] = sensor->valid ? sensor->celsius : NAN;
+    values[1] = sensor->critical_celsius > 0 ? sensor->critical_celsius : NAN;
+}
+
+static const MetricInfo process_metrics[] = {
+    { "process_cpu_percent", "gauge", "CPU use of one of the busiest processes, 100 per core" },
+    { "process_resident_bytes", "gauge", "Resident memory of one of the busiest processes" },
+    { "process_read_bytes_per_second", "gauge", "Storage reads of the process, when its io file is readable" },
+    { "process_write_bytes_per_second", "gauge", "Storage writes of the process, when its io file is readable" },
+};
+
+static void process_labels(gconstpointer item, guint index, GString *labels) {
+    const ProcessInfo *proc = item;
+    char pid[16];
+    snprintf(pid, sizeof(pid), "%d", proc->pid);
+    append_label(labels, "pid", pid);
+    append_label(labels, "name", proc->name);
+    append_label(labels, "user", proc->user);
+}
+
+static void process_values(gconstpointer item, double *values) {
+    const ProcessInfo *proc = item;
+    values[0] = proc->cpu_percent;
+    values[1] = proc->memory_kb * 1024.0;
+    values[2] = proc->io_available ? proc->io_read_rate : NAN;
+    values[3] = proc->io_available ? proc->io_write_rate : NAN;
+}
+
+// The exposition text of the sampler's latest state; empty until the
+// first sample
+static GString* render_metrics(void) {
+    GString *out = g_string_new(NULL);
+    MetricsSample sample;
+    if (!metrics_sampler_latest(&sample)) return out;
+
+    append_gauge(out, "sample_age_seconds", "Time since the sampler took the values below",
+                 (g_get_monotonic_time() - sample.timestamp) / (double)G_USEC_PER_SEC);
+    append_gauge(out, "sample_interval_seconds", "Sampling interval",
+                 metrics_sampler_interval() / 1000.0);
+
+    guint cpu_count = metrics_sampler_cpu_count();
+    CpuCoreSample *cpus = g_new(CpuCoreSample, cpu_count + 1);
+    guint64 cursor = 0;
+    cpus[0] = sample.cpu;
+    guint items = metrics_sampler_cpu_since(&cursor, cpus + 1, 1) == 1 ? cpu_count + 1 : 1;
+    append_table(out, cpu_metrics, G_N_ELEMENTS(cpu_metrics), cpus, items, sizeof(CpuCoreSample),
+                 cpu_labels, cpu_values);
+    g_free(cpus);
+
+    append_gauge(out, "memory_total_bytes", "Physical memory", sample.mem_total_kb * 1024.0);
+    append_gauge(out, "memory_available_bytes", "Memory available to new work without swapping",
+                 sample.mem_available_kb * 1024.0);
+    append_gauge(out, "memory_used_percent", "Share of memory not available", sample.memory_percent);
+
+    if (sample.psi_available) {
+        append_table(out, pressure_metrics, G_N_ELEMENTS(pressure_metrics), sample.psi, PSI_RESOURCES,
+                     sizeof(PsiSample), pressure_labels, pressure_values);
+    }
+
+    DiskDeviceSample *disks = g_new(DiskDeviceSample, METRICS_MAX_DISKS);
+    guint disk_count = metrics_sampler_disks(disks, METRICS_MAX_DISKS);
+    append_table(out, disk_metrics, G_N_ELEMENTS(disk_metrics), disks, disk_count, sizeof(DiskDeviceSample),
+                 disk_labels, disk_values);
+    g_free(disks);
+
+    NetInterfaceSet *net = g_new(NetInterfaceSet, 1);
+    cursor = 0;
+    if (metrics_sampler_network_since(&cursor, net, 1) == 1) {
+        append_table(out, network_metrics, G_N_ELEMENTS(network_metrics), net->interfaces, net->count,
+                     sizeof(NetInterfaceSample), network_labels, network_values);
+    }
+    g_free(net);
+
+    ThermalSensorSet *sensors = g_new(ThermalSensorSet, 1);
+    cursor = 0;
+    if (metrics_sampler_sensors_since(&cursor, sensors, 1) == 1) {
+        append_gauge(out, "temperature_sensors", "Temperature sensors found, including any past the reported limit",
+                     sensors->total);
+        append_table(out, sensor_metrics, G_N_ELEMENTS(sensor_metrics), sensors->sensors, sensors->count,
+                     sizeof(ThermalSensorSample), sensor_labels, sensor_values);
+    }
+    g_free(sensors);
+
+    ProcessTopSet *top = g_new(ProcessTopSet, 1);
+    if (metrics_sampler_top_processes(top)) {
+        append_gauge(out, "processes", "Processes seen by the latest process scan", top->total);
+        append_table(out, process_metrics, G_N_ELEMENTS(process_metrics), top->processes, top->count,
+                     sizeof(ProcessInfo), process_labels, process_values);
+    }
+    g_free(top);
+    return out;
+}
+
+static gboolean write_all(int fd, const char *data, gsize length) {
+    while (length > 0) {
+        gssize n = send(fd, data, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        data += n;
+        length -= n;
+    }
+    return TRUE;
+}
+
+static void send_response(int fd, const char *status, const char *content_type, const char *body,
+                          gsize length, gboolean head) {
+    char header[256];
+    int header_length = snprintf(header, sizeof(header),
+                                 "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %" G_GSIZE_FORMAT "\r\n"
+                                 "Connection: close\r\n\r\n",
+                                 status, content_type, length);
+    if (write_all(fd, header, header_length) && !head) {
+        write_all(fd, body, length);
+    }
+}
+
+// Reads the request head and answers GET (or HEAD) /metrics
+static void serve_client(int fd) {
+    struct timeval timeout = { EXPORTER_TIMEOUT_SECONDS, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[EXPORTER_REQUEST_MAX];
+    gsize length = 0;
+    while (length < sizeof(request) - 1) {
+        gssize n = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        length += n;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+    request[length] = '\0';
+
+    char method[16], target[256];
+    if (sscanf(request, "%15s %255s", method, target) != 2) {
+        static const char text[] = "Bad request\n";
+        send_response(fd, "400 Bad Request", "text/plain", text, sizeof(text) - 1, FALSE);
+        return;
+    }
+    gboolean head = strcmp(method, "HEAD") == 0;
+    if (!head && strcmp(method, "GET") != 0) {
+        static const char text[] = "Only GET is supported\n";
+        send_response(fd, "405 Method Not Allowed", "text/plain", text, sizeof(text) - 1, FALSE);
+        return;
+    }
+    target[strcspn(target, "?")] = '\0';
+    if (strcmp(target, "/metrics") != 0) {
+        static const char text[] = "Metrics are at /metrics\n";
+        send_response(fd, "404 Not Found", "text/plain", text, sizeof(text) - 1, head);
+        return;
+    }
+
+    GString *body = render_metrics();
+    send_response(fd, "200 OK", "text/plain; version=0.0.4; charset=utf-8", body->str, body->len, head);
+    g_string_free(body, TRUE);
+}
+
+static gpointer exporter_thread(gpointer user_data) {
+    MetricsExporter *e = user_data;
+    struct pollfd fds[2] = {
+        { .fd = e->listen_fd, .events = POLLIN },
+        { .fd = e->stop_fd, .events = POLLIN },
+    };
+
+    for (;;) {
+        fds[0].revents = fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int client = accept4(e->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        serve_client(client);
+        close(client);
+    }
+    return NULL;
+}
+
+// Loopback only: the endpoint is meant for an agent on the same machine
+static int listen_tcp(const char *port_text) {
+    char *end;
+    unsigned long port = strtoul(port_text, &end, 10);
+    if (*end != '\0' || port == 0 || port > 65535) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((guint16)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 8) < 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+// A socket left behind by an earlier run is replaced once nothing answers
+// on it; a live one, or any other file at the path, is left alone. The
+// socket is bound under umask 077, so it is owner-only from the start.
+static int listen_unix(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    g_strlcpy(address.sun_path, path, sizeof(address.sun_path));
+
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (probe < 0) return -1;
+        int connected = connect(probe, (struct sockaddr *)&address, sizeof(address));
+        int error = connected == 0 ? EADDRINUSE : errno;
+        close(probe);
+        if (error != ECONNREFUSED) {
+            errno = error;      // another instance is serving there
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    mode_t mask = umask(077);
+    int bound = bind(fd, (struct sockaddr *)&address, sizeof(address));
+    umask(mask);
+    if (bound < 0 || listen(fd, 8) < 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+// Starts serving when COMMAND_SPHERE_METRICS_LISTEN is set. FALSE when it
+// is not, or when the socket cannot be set up.
+gboolean metrics_exporter_start(void) {
+    if (exporter) return TRUE;
+    const char *listen_at = getenv("COMMAND_SPHERE_METRICS_LISTEN");
+    if (!listen_at || !*listen_at) return FALSE;
+
+    gboolean is_path = listen_at[0] == '/';
+    int listen_fd = is_path ? listen_unix(listen_at) : listen_tcp(listen_at);
+    if (listen_fd < 0) {
+        g_warning("metrics endpoint: cannot listen on %s: %s", listen_at, g_strerror(errno));
+        return FALSE;
+    }
+    int stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (stop_fd < 0) {
+        g_warning("metrics endpoint: %s", g_strerror(errno));
+        close(listen_fd);
+        if (is_path) unlink(listen_at);
+        return FALSE;
+    }
+
+    MetricsExporter *e = g_new0(MetricsExporter, 1);
+    e->listen_fd = listen_fd;
+    e->stop_fd = stop_fd;
+    e->socket_path = is_path ? g_strdup(listen_at) : NULL;
+    metrics_sampler_track_processes(TRUE);
+    metrics_sampler_track_sensors(TRUE);
+    e->thread = g_thread_new("metrics-exporter", exporter_thread, e);
+    exporter = e;
+    return TRUE;
+}
+
+void metrics_exporter_stop(void) {
+    MetricsExporter *e = exporter;
+    if (!e) return;
+    exporter = NULL;
+
+    guint64 one = 1;
+    if (write(e->stop_fd, &one, sizeof(one)) < 0) {
+        g_warning("metrics endpoint: cannot wake thread: %s", g_strerror(errno));
+    }
+    g_thread_join(e->thread);
+    metrics_sampler_track_processes(FALSE);
+    metrics_sampler_track_sensors(FALSE);
+    close(e->listen_fd);
+    close(e->stop_fd);
+    if (e->socket_path) unlink(e->socket_path);
+    g_free(e->socket_path);
+    g_free(e);
+}
@@ -0,0 +1,1138 @@
+// metrics_sampler.c
+// Background sampler for system-wide counters. One thread reads /proc/stat,
+// /proc/meminfo, /proc/net/dev and /proc/diskstats through descriptors that
+// stay open, turns the counters into percentages and rates, and publishes a
+// MetricsSample per interval into a ring buffer. The ring has a single
+// producer and lock-free readers: the UI thread copies samples out and then
+// re-checks the head to discard any slot the producer lapped while it was
+// copying, so dialogs never block on, or touch, /proc themselves.
+//
+// Every cpuN line is kept as well: a second ring holds one CpuCoreSample
+// per core for each MetricsSample, so a single saturated core or steal
+// time on one vCPU stays visible on hosts where the aggregate hides it.
+//
+// Block devices are tracked one by one as well. The set comes from
+// /sys/block (loop and ram devices left out), so partitions never count
+// twice. Every diskstats field is kept, giving throughput, IOPS, await,
+// %util and queue depth per device. Stacked devices (dm-*, md*) are shown
+// but left out of the totals, since their I/O also shows up on the disks
+// below them.
+//
+// Network interfaces get the same treatment: bits, packets, errors and
+// drops per second for each line of /proc/net/dev, plus the link speed
+// from sysfs, so a saturated link stands out. Interface sets go into a
+// ring of their own that keeps a couple of minutes for rate graphs.
+//
+// Pressure stall averages from /proc/pressure ride along in each sample;
+// the kernel already smooths them, so they are copied as they are.
+//
+// Temperatures come from every thermal zone and every hwmon tempN_input,
+// read only while something shows or serves them (the Temperatures panel,
+// the metrics endpoint). The sensors are found when the first of those
+// asks, with their labels and critical trip points, and their descriptors
+// stay open: each sample is one pread per sensor. Every few samples the
+// sysfs directories are counted again, so a device that comes or goes
+// (a USB sensor, a GPU driver loaded late) gets the set rebuilt. Sensor
+// sets get a ring like the interface sets, for graphs.
+//
+// While something asks for them (the metrics endpoint), the sampler also
+// scans processes with a ProcScanner of its own and publishes the busiest
+// ones, so readers never scan /proc themselves. A scan costs far more than
+// the rest of a sample, so it runs at most every couple of seconds and
+// only once that sample is already published.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <stdatomic.h>
+
+#define METRICS_RING_CAPACITY 1024     // power of two; ~17 minutes at 1 s
+#define METRICS_DISK_RING_CAPACITY 64
+#define METRICS_NET_RING_CAPACITY 128  // graph history, ~2 minutes at 1 s
+#define METRICS_SENSOR_RING_CAPACITY 128
+#define METRICS_PROCESS_RING_CAPACITY 4
+#define METRICS_PROCESS_SCAN_MS 2000      // between process scans, whatever the interval
+#define METRICS_SENSOR_RESCAN_SAMPLES 10   // between checks for new or removed sensors
+#define METRICS_READ_BUFFER (64 * 1024)     // initial size, grown for larger files
+#define METRICS_MIN_INTERVAL_MS 100
+#define METRICS_MAX_INTERVAL_MS 60000
+
+// Fixed-size slots indexed by a monotonically increasing head
+typedef struct {
+    gsize element_size;
+    guint64 mask;
+    _Atomic guint64 head;   // number of elements ever pushed
+    char *slots;
+} MetricRing;
+
+// Jiffies from a /proc/stat cpu line: user nice system idle iowait irq
+// softirq steal
+#define CPU_FIELDS 8
+
+typedef struct {
+    guint64 fields[CPU_FIELDS];
+} CpuTimes;
+
+// One /proc/diskstats line: "major minor name reads merged sectors ms
+// writes merged sectors ms in_flight io_ms weighted_ms ..."
+typedef struct {
+    char name[32];
+    gboolean stacked;
+    guint64 reads, read_sectors, read_ms;
+    guint64 writes, write_sectors, write_ms;
+    guint64 io_ms, weighted_ms;
+} DiskCounters;
+
+typedef struct {
+    guint count;
+    DiskDeviceSample disks[METRICS_MAX_DISKS];
+} DiskDeviceSet;
+
+// One /proc/net/dev line: "iface: rx_bytes packets errs drop fifo frame
+// compressed multicast tx_bytes packets errs drop ..."
+typedef struct {
+    char name[32];
+    int speed_mbps;
+    guint64 rx_bytes, rx_packets, rx_errors, rx_drops;
+    guint64 tx_bytes, tx_packets, tx_errors, tx_drops;
+} NetCounters;
+
+// A temperature input found at start, held open
+typedef struct {
+    int fd;
+    char name[32];
+    char label[64];
+    float critical_celsius;
+} SensorSource;
+
+// Raw cumulative counters from one pass over /proc
+typedef struct {
+    gint64 time;                // monotonic microseconds
+    CpuTimes cpu;
+    CpuTimes *cores;            // cpu_count entries, owned by the sampler
+    DiskCounters *disks;        // METRICS_MAX_DISKS entries, owned by the sampler
+    guint disk_count;
+    NetCounters *interfaces;    // METRICS_MAX_INTERFACES entries, owned by the sampler
+    guint interface_count;
+    guint64 net_rx, net_tx;     // bytes
+    guint64 disk_read, disk_write;  // 512-byte sectors, physical disks only
+} MetricsCounters;
+
+typedef struct {
+    GThread *thread;
+    GMutex lock;
+    GCond wake;
+    gboolean stopping;
+    guint interval_ms;
+
+    int stat_fd, meminfo_fd, netdev_fd, diskstats_fd;
+    int pressure_fds[PSI_RESOURCES];
+    guint cpu_count;
+    CpuTimes *core_times[2];    // previous and current, swapped per sample
+    CpuCoreSample *core_sample;
+    GHashTable *disks;          // whole-disk name -> 1, or 2 when stacked
+    guint diskstats_lines;      // line count the disk set was built for
+    DiskCounters *disk_counters[2];     // previous and current, swapped per sample
+    DiskDeviceSet *disk_set;
+    GHashTable *link_speeds;    // interface name -> Mb/s, 0 when unknown
+    guint netdev_lines;         // line count the speeds were read for
+    NetCounters *net_counters[2];
+    NetInterfaceSet *net_set;
+    SensorSource *sensors;      // METRICS_MAX_SENSORS entries
+    guint sensor_count;
+    guint sensor_total;         // found, more than sensor_count past the cap
+    guint sensor_devices;       // sysfs entries the set was built for, 0 when not loaded
+    guint sensor_rescan;        // samples until the next hotplug check
+    gboolean sensor_gone;       // a read failed with ENODEV
+    ThermalSensorSet *sensor_set;
+    guint sensor_watchers;      // under lock
+    gboolean track_processes;   // requested, under lock
+    ProcScanner *processes;     // sampler thread only, NULL while not tracking
+    ProcessTopSet *process_top;
+    char *buffer;
+    gsize buffer_size;
+
+    MetricRing *samples;        // MetricsSample
+    MetricRing *cores;          // cpu_count CpuCoreSamples per element
+    MetricRing *disk_sets;      // DiskDeviceSet
+    MetricRing *net_sets;       // NetInterfaceSet
+    MetricRing *sensor_sets;    // ThermalSensorSet
+    MetricRing *process_tops;   // ProcessTopSet
+} MetricsSampler;
+
+static MetricsSampler *sampler = NULL;
+
+static MetricRing* metric_ring_new(gsize element_size, guint capacity) {
+    MetricRing *ring = g_new0(MetricRing, 1);
+    ring->element_size = element_size;
+    ring->mask = capacity - 1;
+    ring->slots = g_malloc0(element_size * capacity);
+    atomic_init(&ring->head, 0);
+    return ring;
+}
+
+static void metric_ring_free(MetricRing *ring) {
+    if (!ring) return;
+    g_free(ring->slots);
+    g_free(ring);
+}
+
+// Producer thread only
+static void metric_ring_push(MetricRing *ring, const void *element) {
+    guint64 head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    memcpy(ring->slots + (head & ring->mask) * ring->element_size, element, ring->element_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Copies the elements pushed after *cursor, at most max of the newest,
+// into out, oldest first, and advances *cursor past them. Returns how many
+// are valid. Safe against a concurrent push.
+static guint metric_ring_read_since(MetricRing *ring, guint64 *cursor, guint max, void *out) {
+    guint64 capacity = ring->mask + 1;
+    guint64 head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    guint64 first = head - MIN(MIN(head, capacity), (guint64)max);
+    if (*cursor > first) first = MIN(*cursor, head);
+    *cursor = head;
+
+    guint count = (guint)(head - first);
+    if (count == 0) return 0;
+    for (guint i = 0; i < count; i++) {
+        memcpy((char *)out + i * ring->element_size,
+               ring->slots + ((first + i) & ring->mask) * ring->element_size,
+               ring->element_size);
+    }
+
+    // The producer may have overwritten the oldest slots meanwhile: the slot
+    // it is writing now (index head_now) aliases index head_now - capacity
+    atomic_thread_fence(memory_order_acquire);
+    guint64 head_now = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    guint64 oldest_intact = head_now >= capacity ? head_now - capacity + 1 : 0;
+    if (first >= oldest_intact) return count;
+    if (oldest_intact >= head) return 0;
+
+    guint skip = (guint)(oldest_intact - first);
+    memmove(out, (char *)out + skip * ring->element_size, (count - skip) * ring->element_size);
+    return count - skip;
+}
+
+// Up to count of the newest elements, oldest first
+static guint metric_ring_read(MetricRing *ring, guint count, void *out) {
+    guint64 cursor = 0;
+    return metric_ring_read_since(ring, &cursor, count, out);
+}
+
+// Whole file into the sampler buffer, NUL-terminated. procfs hands out at
+// most a page per read, so keep reading until EOF; the buffer doubles
+// whenever a file does not fit, e.g. diskstats with thousands of devices.
+static gssize read_file(MetricsSampler *s, int fd) {
+    gssize total = 0;
+    if (fd < 0) return -1;
+    for (;;) {
+        if ((gsize)total == s->buffer_size - 1) {
+            s->buffer_size *= 2;
+            s->buffer = g_realloc(s->buffer, s->buffer_size);
+        }
+        gssize n = pread(fd, s->buffer + total, s->buffer_size - 1 - total, total);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        total += n;
+    }
+    s->buffer[total] = '\0';
+    return total;
+}
+
+static guint64 parse_u64(const char **p) {
+    guint64 value = 0;
+    while (**p == ' ' || **p == '\t') (*p)++;
+    while (**p >= '0' && **p <= '9') {
+        value = value * 10 + (**p - '0');
+        (*p)++;
+    }
+    return value;
+}
+
+static const char* skip_fields(const char *p, int count) {
+    while (count-- > 0 && *p && *p != '\n') {
+        while (*p == ' ') p++;
+        while (*p && *p != ' ' && *p != '\n') p++;
+    }
+    return p;
+}
+
+static const char* next_line(const char *p) {
+    const char *end = strchr(p, '\n');
+    return end ? end + 1 : p + strlen(p);
+}
+
+// "cpu  user nice system idle iowait irq softirq steal ..." followed by
+// one "cpuN ..." line per online core
+static void read_cpu(MetricsSampler *s, MetricsCounters *counters) {
+    if (read_file(s, s->stat_fd) <= 0) return;
+
+    for (const char *p = s->buffer; strncmp(p, "cpu", 3) == 0; p = next_line(p)) {
+        p += 3;
+        CpuTimes *times = &counters->cpu;
+        if (*p != ' ') {
+            guint64 index = parse_u64(&p);
+            if (index >= s->cpu_count) continue;
+            times = &counters->cores[index];
+        }
+        for (int i = 0; i < CPU_FIELDS; i++) times->fields[i] = parse_u64(&p);
+    }
+}
+
+static guint64 delta(guint64 now, guint64 before) {
+    return now >= before ? now - before : 0;    // iowait may step backwards
+}
+
+static void cpu_breakdown(const CpuTimes *now, const CpuTimes *before, CpuCoreSample *out) {
+    guint64 d[CPU_FIELDS], total = 0;
+    for (int i = 0; i < CPU_FIELDS; i++) {
+        d[i] = delta(now->fields[i], before->fields[i]);
+        total += d[i];
+    }
+
+    memset(out, 0, sizeof(*out));
+    if (total == 0) return;
+    float scale = 100.0f / total;
+    out->user = (d[0] + d[1]) * scale;
+    out->system = d[2] * scale;
+    out->iowait = d[4] * scale;
+    out->irq = d[5] * scale;
+    out->softirq = d[6] * scale;
+    out->steal = d[7] * scale;
+    out->busy = (total - d[3] - d[4]) * scale;
+}
+
+static void read_memory(MetricsSampler *s, MetricsSample *sample) {
+    if (read_file(s, s->meminfo_fd) <= 0) return;
+
+    gboolean have_available = FALSE;
+    for (const char *p = s->buffer; *p; p = next_line(p)) {
+        if (strncmp(p, "MemTotal:", 9) == 0) {
+            p += 9;
+            sample->mem_total_kb = parse_u64(&p);
+        } else if (strncmp(p, "MemAvailable:", 13) == 0) {
+            p += 13;
+            sample->mem_available_kb = parse_u64(&p);
+            have_available = TRUE;
+        } else if (strncmp(p, "MemFree:", 8) == 0) {
+            p += 8;
+            sample->mem_free_kb = parse_u64(&p);
+        } else if (strncmp(p, "Buffers:", 8) == 0) {
+            p += 8;
+            sample->mem_buffers_kb = parse_u64(&p);
+        } else if (strncmp(p, "Cached:", 7) == 0) {
+            p += 7;
+            sample->mem_cached_kb = parse_u64(&p);
+        } else if (strncmp(p, "Dirty:", 6) == 0) {
+            p += 6;
+            sample->mem_dirty_kb = parse_u64(&p);
+        } else if (strncmp(p, "SwapTotal:", 10) == 0) {
+            p += 10;
+            sample->swap_total_kb = parse_u64(&p);
+        } else if (strncmp(p, "SwapFree:", 9) == 0) {
+            p += 9;
+            sample->swap_free_kb = parse_u64(&p);
+        }
+    }
+    // Kernels before 3.14 have no MemAvailable
+    if (!have_available) {
+        sample->mem_available_kb = sample->mem_free_kb + sample->mem_buffers_kb + sample->mem_cached_kb;
+    }
+    if (sample->mem_total_kb > 0) {
+        sample->memory_percent = (double)(sample->mem_total_kb - MIN(sample->mem_available_kb, sample->mem_total_kb))
+                                 / sample->mem_total_kb * 100.0;
+    }
+}
+
+// Virtual interfaces have no speed; reading it fails with EINVAL or gives -1
+static int read_link_speed(const char *name) {
+    char path[128], text[32];
+    snprintf(path, sizeof(path), "/sys/class/net/%s/speed", name);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    gssize n = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    text[n] = '\0';
+    int speed = atoi(text);
+    return speed > 0 ? speed : 0;
+}
+
+static int link_speed(MetricsSampler *s, const char *name) {
+    gpointer speed;
+    if (!g_hash_table_lookup_extended(s->link_speeds, name, NULL, &speed)) {
+        speed = GINT_TO_POINTER(read_link_speed(name));
+        g_hash_table_insert(s->link_speeds, g_strdup(name), speed);
+    }
+    return GPOINTER_TO_INT(speed);
+}
+
+// Two header lines, then one line per interface; loopback is left out of
+// the totals
+static void read_network(MetricsSampler *s, MetricsCounters *counters) {
+    if (read_file(s, s->netdev_fd) <= 0) return;
+
+    // Interfaces came or went: look the link speeds up again
+    guint lines = 0;
+    for (const char *p = s->buffer; *p; p = next_line(p)) lines++;
+    if (lines != s->netdev_lines) {
+        g_hash_table_remove_all(s->link_speeds);
+        s->netdev_lines = lines;
+    }
+
+    NetCounters spare;
+    const char *p = next_line(next_line(s->buffer));
+    for (; *p; p = next_line(p)) {
+        while (*p == ' ') p++;
+        const char *colon = strchr(p, ':');
+        if (!colon) break;
+
+        // Interfaces past the cap still count towards the totals
+        NetCounters *net = counters->interface_count < METRICS_MAX_INTERFACES
+            ? &counters->interfaces[counters->interface_count++] : &spare;
+        gsize len = MIN((gsize)(colon - p), sizeof(net->name) - 1);
+        memcpy(net->name, p, len);
+        net->name[len] = '\0';
+
+        p = colon + 1;
+        net->rx_bytes = parse_u64(&p);
+        net->rx_packets = parse_u64(&p);
+        net->rx_errors = parse_u64(&p);
+        net->rx_drops = parse_u64(&p);
+        p = skip_fields(p, 4);
+        net->tx_bytes = parse_u64(&p);
+        net->tx_packets = parse_u64(&p);
+        net->tx_errors = parse_u64(&p);
+        net->tx_drops = parse_u64(&p);
+
+        if (strcmp(net->name, "lo") == 0) continue;
+        if (net != &spare) net->speed_mbps = link_speed(s, net->name);
+        counters->net_rx += net->rx_bytes;
+        counters->net_tx += net->tx_bytes;
+    }
+}
+
+// A device with entries in its slaves directory sits on other block devices
+static gboolean is_stacked(const char *name) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/block/%s/slaves", name);
+    DIR *dir = opendir(path);
+    if (!dir) return FALSE;
+    gboolean stacked = FALSE;
+    struct dirent *entry;
+    while (!stacked && (entry = readdir(dir)) != NULL) {
+        stacked = entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return stacked;
+}
+
+static void load_disks(MetricsSampler *s) {
+    g_hash_table_remove_all(s->disks);
+    DIR *dir = opendir("/sys/block");
+    if (!dir) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        if (strncmp(entry->d_name, "loop", 4) == 0 || strncmp(entry->d_name, "ram", 3) == 0) continue;
+        g_hash_table_insert(s->disks, g_strdup(entry->d_name), GINT_TO_POINTER(is_stacked(entry->d_name) ? 2 : 1));
+    }
+    closedir(dir);
+}
+
+// Only whole disks count, or every partition's I/O would be added a
+// second time
+static void read_disks(MetricsSampler *s, MetricsCounters *counters) {
+    if (read_file(s, s->diskstats_fd) <= 0) return;
+
+    guint lines = 0;
+    for (const char *p = s->buffer; *p; p = next_line(p)) lines++;
+    if (lines != s->diskstats_lines) {
+        load_disks(s);
+        s->diskstats_lines = lines;
+    }
+
+    char name[64];
+    DiskCounters spare;
+    for (const char *p = s->buffer; *p; p = next_line(p)) {
+        const char *q = skip_fields(p, 2);
+        while (*q == ' ') q++;
+        gsize len = 0;
+        while (q[len] && q[len] != ' ' && q[len] != '\n' && len < sizeof(name) - 1) len++;
+        memcpy(name, q, len);
+        name[len] = '\0';
+        int kind = GPOINTER_TO_INT(g_hash_table_lookup(s->disks, name));
+        if (kind == 0) continue;
+
+        // Devices past the cap still count towards the totals
+        DiskCounters *disk = counters->disk_count < METRICS_MAX_DISKS
+            ? &counters->disks[counters->disk_count++] : &spare;
+        g_strlcpy(disk->name, name, sizeof(disk->name));
+        disk->stacked = kind == 2;
+        q += len;
+        disk->reads = parse_u64(&q);
+        q = skip_fields(q, 1);
+        disk->read_sectors = parse_u64(&q);
+        disk->read_ms = parse_u64(&q);
+        disk->writes = parse_u64(&q);
+        q = skip_fields(q, 1);
+        disk->write_sectors = parse_u64(&q);
+        disk->write_ms = parse_u64(&q);
+        q = skip_fields(q, 1);
+        disk->io_ms = parse_u64(&q);
+        disk->weighted_ms = parse_u64(&q);
+
+        if (!disk->stacked) {
+            counters->disk_read += disk->read_sectors;
+            counters->disk_write += disk->write_sectors;
+        }
+    }
+}
+
+// "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456" and a matching
+// "full" line (kernels before 5.13 have none for cpu)
+static void read_pressure(MetricsSampler *s, MetricsSample *sample) {
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        if (read_file(s, s->pressure_fds[r]) <= 0) continue;
+        sample->psi_available = TRUE;
+
+        PsiSample *psi = &sample->psi[r];
+        for (const char *p = s->buffer; *p; p = next_line(p)) {
+            gboolean some = strncmp(p, "some ", 5) == 0;
+            if (!some && strncmp(p, "full ", 5) != 0) continue;
+            float avg10, avg60, avg300;
+            guint64 total;
+            if (sscanf(p + 5, "avg10=%f avg60=%f avg300=%f total=%" G_GUINT64_FORMAT,
+                       &avg10, &avg60, &avg300, &total) != 4) continue;
+            if (some) {
+                psi->some_avg10 = avg10;
+                psi->some_avg60 = avg60;
+                psi->some_avg300 = avg300;
+                psi->some_total_us = total;
+            } else {
+                psi->full_avg10 = avg10;
+                psi->full_avg60 = avg60;
+                psi->full_avg300 = avg300;
+                psi->full_total_us = total;
+            }
+        }
+    }
+}
+
+// Small sysfs attribute, first line only; FALSE when missing or empty
+static gboolean read_attribute(const char *path, char *text, gsize size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return FALSE;
+    gssize n = read(fd, text, size - 1);
+    close(fd);
+    if (n <= 0) return FALSE;
+    text[n] = '\0';
+    text[strcspn(text, "\n")] = '\0';
+    return text[0] != '\0';
+}
+
+static float read_millidegrees(const char *path) {
+    char text[32];
+    return read_attribute(path, text, sizeof(text)) ? atol(text) / 1000.0f : 0;
+}
+
+static SensorSource* add_sensor(MetricsSampler *s, const char *path) {
+    s->sensor_total++;
+    if (s->sensor_count == METRICS_MAX_SENSORS) return NULL;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    SensorSource *sensor = &s->sensors[s->sensor_count++];
+    memset(sensor, 0, sizeof(*sensor));
+    sensor->fd = fd;
+    return sensor;
+}
+
+// thermal_zoneN/temp, labelled with the zone type; the critical
+// temperature is the trip point of type "critical", if there is one
+static void load_thermal_zones(MetricsSampler *s) {
+    DIR *dir = opendir("/sys/class/thermal");
+    if (!dir) return;
+    struct dirent *entry;
+    char path[256], text[64];
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0) continue;
+        snprintf(path, sizeof(path), "/sys/class/thermal/%s/temp", entry->d_name);
+        SensorSource *sensor = add_sensor(s, path);
+        if (!sensor) continue;
+
+        g_strlcpy(sensor->name, entry->d_name, sizeof(sensor->name));
+        snprintf(path, sizeof(path), "/sys/class/thermal/%s/type", entry->d_name);
+        if (!read_attribute(path, sensor->label, sizeof(sensor->label))) {
+            g_strlcpy(sensor->label, entry->d_name, sizeof(sensor->label));
+        }
+        for (int trip = 0; ; trip++) {
+            snprintf(path, sizeof(path), "/sys/class/thermal/%s/trip_point_%d_type", entry->d_name, trip);
+            if (!read_attribute(path, text, sizeof(text))) break;
+            if (strcmp(text, "critical") != 0) continue;
+            snprintf(path, sizeof(path), "/sys/class/thermal/%s/trip_point_%d_temp", entry->d_name, trip);
+            sensor->critical_celsius = read_millidegrees(path);
+            break;
+        }
+    }
+    closedir(dir);
+}
+
+// hwmonN/tempM_input, labelled "chip: tempM_label" (e.g. "coretemp:
+// Package id 0") or "chip: tempM"
+static void load_hwmon(MetricsSampler *s) {
+    DIR *dir = opendir("/sys/class/hwmon");
+    if (!dir) return;
+    struct dirent *entry;
+    char path[512], chip[64], label[64];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "/sys/class/hwmon/%s/name", entry->d_name);
+        if (!read_attribute(path, chip, sizeof(chip))) g_strlcpy(chip, entry->d_name, sizeof(chip));
+
+        snprintf(path, sizeof(path), "/sys/class/hwmon/%s", entry->d_name);
+        DIR *device = opendir(path);
+        if (!device) continue;
+        struct dirent *input;
+        while ((input = readdir(device)) != NULL) {
+            int index;
+            char suffix[8];
+            if (sscanf(input->d_name, "temp%d_%7s", &index, suffix) != 2 || strcmp(suffix, "input") != 0) continue;
+            snprintf(path, sizeof(path), "/sys/class/hwmon/%s/%s", entry->d_name, input->d_name);
+            SensorSource *sensor = add_sensor(s, path);
+            if (!sensor) continue;
+
+            snprintf(sensor->name, sizeof(sensor->name), "%s/temp%d", entry->d_name, index);
+            snprintf(path, sizeof(path), "/sys/class/hwmon/%s/temp%d_label", entry->d_name, index);
+            if (!read_attribute(path, label, sizeof(label))) snprintf(label, sizeof(label), "temp%d", index);
+            snprintf(sensor->label, sizeof(sensor->label), "%s: %s", chip, label);
+            snprintf(path, sizeof(path), "/sys/class/hwmon/%s/temp%d_crit", entry->d_name, index);
+            sensor->critical_celsius = read_millidegrees(path);
+        }
+        closedir(device);
+    }
+    closedir(dir);
+}
+
+static int compare_sensors(const void *a, const void *b) {
+    return strcmp(((const SensorSource *)a)->name, ((const SensorSource *)b)->name);
+}
+
+// thermal_zoneN and hwmonN entries; a change means a device came or went
+static guint count_sensor_devices(void) {
+    guint count = 1;    // never 0, which stands for not loaded
+    const char *dirs[] = { "/sys/class/thermal", "/sys/class/hwmon" };
+    for (gsize i = 0; i < G_N_ELEMENTS(dirs); i++) {
+        DIR *dir = opendir(dirs[i]);
+        if (!dir) continue;
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "thermal_zone", 12) == 0 || strncmp(entry->d_name, "hwmon", 5) == 0) count++;
+        }
+        closedir(dir);
+    }
+    return count;
+}
+
+static void unload_sensors(MetricsSampler *s) {
+    for (guint i = 0; i < s->sensor_count; i++) close(s->sensors[i].fd);
+    s->sensor_count = s->sensor_total = 0;
+    s->sensor_devices = 0;
+    s->sensor_gone = FALSE;
+}
+
+static void load_sensors(MetricsSampler *s) {
+    unload_sensors(s);
+    s->sensor_devices = count_sensor_devices();
+    s->sensor_rescan = METRICS_SENSOR_RESCAN_SAMPLES;
+    load_thermal_zones(s);
+    load_hwmon(s);
+    qsort(s->sensors, s->sensor_count, sizeof(SensorSource), compare_sensors);
+}
+
+// Rebuilds the set when a sensor vanished or the device count changed
+static void check_sensors(MetricsSampler *s) {
+    if (s->sensor_devices == 0 || s->sensor_gone) {
+        load_sensors(s);
+    } else if (--s->sensor_rescan == 0) {
+        s->sensor_rescan = METRICS_SENSOR_RESCAN_SAMPLES;
+        if (count_sensor_devices() != s->sensor_devices) load_sensors(s);
+    }
+}
+
+// Millidegrees Celsius. Reads can fail for a while, e.g. EAGAIN from a
+// GPU that is powered down, which leaves the sensor invalid this time.
+static void read_sensors(MetricsSampler *s, ThermalSensorSet *set) {
+    set->count = s->sensor_count;
+    set->total = s->sensor_total;
+    for (guint i = 0; i < s->sensor_count; i++) {
+        const SensorSource *source = &s->sensors[i];
+        ThermalSensorSample *sensor = &set->sensors[i];
+        g_strlcpy(sensor->name, source->name, sizeof(sensor->name));
+        g_strlcpy(sensor->label, source->label, sizeof(sensor->label));
+        sensor->critical_celsius = source->critical_celsius;
+
+        char text[32];
+        gssize n = pread(source->fd, text, sizeof(text) - 1, 0);
+        if (n < 0 && errno == ENODEV) s->sensor_gone = TRUE;
+        sensor->valid = n > 0;
+        if (n > 0) {
+            text[n] = '\0';
+            sensor->celsius = atol(text) / 1000.0f;
+        }
+    }
+}
+
+static int compare_cpu(const void *a, const void *b) {
+    float ca = ((const ProcessInfo *)a)->cpu_percent, cb = ((const ProcessInfo *)b)->cpu_percent;
+    return (cb > ca) - (cb < ca);
+}
+
+static int compare_memory(const void *a, const void *b) {
+    long ma = ((const ProcessInfo *)a)->memory_kb, mb = ((const ProcessInfo *)b)->memory_kb;
+    return (mb > ma) - (mb < ma);
+}
+
+// Top by CPU, then the rest of the top by memory; the CPU leaders are
+// moved to the front of the list so the second sort skips them
+static void scan_processes(MetricsSampler *s, ProcessTopSet *top) {
+    if (!s->processes) {
+        s->processes = proc_scanner_new();
+        // The exporter publishes the I/O rates of the top processes
+        proc_scanner_track_io(s->processes, TRUE);
+    }
+    proc_scanner_refresh(s->processes);
+    ProcessInfo *list;
+    int count = proc_scanner_snapshot(s->processes, &list);
+
+    top->total = count;
+    top->count = 0;
+    if (!list) return;
+    guint by_cpu = MIN((guint)count, METRICS_TOP_PROCESSES);
+    qsort(list, count, sizeof(ProcessInfo), compare_cpu);
+    guint by_memory = MIN((guint)count - by_cpu, METRICS_TOP_PROCESSES);
+    qsort(list + by_cpu, count - by_cpu, sizeof(ProcessInfo), compare_memory);
+    top->count = by_cpu + by_memory;
+    memcpy(top->processes, list, top->count * sizeof(ProcessInfo));
+    free(list);
+}
+
+static void read_counters(MetricsSampler *s, MetricsCounters *counters, int slot, MetricsSample *sample) {
+    memset(counters, 0, sizeof(*counters));
+    memset(s->core_times[slot], 0, s->cpu_count * sizeof(CpuTimes));
+    counters->cores = s->core_times[slot];
+    counters->disks = s->disk_counters[slot];
+    counters->interfaces = s->net_counters[slot];
+    counters->time = g_get_monotonic_time();
+    read_cpu(s, counters);
+    read_memory(s, sample);
+    read_network(s, counters);
+    read_disks(s, counters);
+    read_pressure(s, sample);
+}
+
+static double rate(guint64 now, guint64 before, double seconds) {
+    return now >= before ? (now - before) / seconds : 0.0;
+}
+
+// Same maths as iostat -x; a device that just appeared reports zeros
+static void disk_breakdown(const DiskCounters *now, const MetricsCounters *previous, double seconds,
+                           DiskDeviceSample *out) {
+    const DiskCounters *before = now;
+    for (guint i = 0; i < previous->disk_count; i++) {
+        if (strcmp(previous->disks[i].name, now->name) == 0) {
+            before = &previous->disks[i];
+            break;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    g_strlcpy(out->name, now->name, sizeof(out->name));
+    out->stacked = now->stacked;
+    out->read_bytes = now->read_sectors * 512;
+    out->write_bytes = now->write_sectors * 512;
+    out->read_rate = rate(now->read_sectors, before->read_sectors, seconds) * 512;
+    out->write_rate = rate(now->write_sectors, before->write_sectors, seconds) * 512;
+
+    guint64 reads = delta(now->reads, before->reads);
+    guint64 writes = delta(now->writes, before->writes);
+    guint64 read_ms = delta(now->read_ms, before->read_ms);
+    guint64 write_ms = delta(now->write_ms, before->write_ms);
+    out->read_iops = reads / seconds;
+    out->write_iops = writes / seconds;
+    if (reads > 0) out->read_await_ms = (float)read_ms / reads;
+    if (writes > 0) out->write_await_ms = (float)write_ms / writes;
+    if (reads + writes > 0) out->await_ms = (float)(read_ms + write_ms) / (reads + writes);
+    out->util_percent = MIN(100.0, delta(now->io_ms, before->io_ms) / (seconds * 10.0));
+    out->queue_depth = delta(now->weighted_ms, before->weighted_ms) / (seconds * 1000.0);
+}
+
+static void net_breakdown(const NetCounters *now, const MetricsCounters *previous, double seconds,
+                          NetInterfaceSample *out) {
+    const NetCounters *before = now;
+    for (guint i = 0; i < previous->interface_count; i++) {
+        if (strcmp(previous->interfaces[i].name, now->name) == 0) {
+            before = &previous->interfaces[i];
+            break;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    g_strlcpy(out->name, now->name, sizeof(out->name));
+    out->loopback = strcmp(now->name, "lo") == 0;
+    out->speed_mbps = now->speed_mbps;
+    out->rx_bytes = now->rx_bytes;
+    out->tx_bytes = now->tx_bytes;
+    out->rx_bps = rate(now->rx_bytes, before->rx_bytes, seconds) * 8;
+    out->tx_bps = rate(now->tx_bytes, before->tx_bytes, seconds) * 8;
+    out->rx_pps = rate(now->rx_packets, before->rx_packets, seconds);
+    out->tx_pps = rate(now->tx_packets, before->tx_packets, seconds);
+    out->rx_errors = rate(now->rx_errors, before->rx_errors, seconds);
+    out->tx_errors = rate(now->tx_errors, before->tx_errors, seconds);
+    out->rx_drops = rate(now->rx_drops, before->rx_drops, seconds);
+    out->tx_drops = rate(now->tx_drops, before->tx_drops, seconds);
+    if (now->speed_mbps > 0) {
+        out->link_percent = MIN(100.0, MAX(out->rx_bps, out->tx_bps) / (now->speed_mbps * 1e4));
+    }
+}
+
+// Model, core counts and top frequency. The sampler reads them as it
+// starts, so dialogs never wait on /proc/cpuinfo.
+const CpuIdentity* metrics_sampler_cpu_identity(void) {
+    static CpuIdentity identity;
+    static gsize initialized = 0;
+    if (!g_once_init_enter(&initialized)) return &identity;
+
+    FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+    GHashTable *packages = g_hash_table_new(g_direct_hash, g_direct_equal);
+    char line[256];
+    guint cores_per_package = 0;
+    while (cpuinfo && fgets(line, sizeof(line), cpuinfo)) {
+        const char *value = strchr(line, ':');
+        if (!value) continue;
+        value++;
+        while (*value == ' ') value++;
+
+        if (strncmp(line, "processor", 9) == 0) {
+            identity.logical++;
+        } else if (strncmp(line, "model name", 10) == 0 && !identity.model[0]) {
+            g_strlcpy(identity.model, value, sizeof(identity.model));
+            identity.model[strcspn(identity.model, "\n")] = '\0';
+        } else if (strncmp(line, "physical id", 11) == 0) {
+            g_hash_table_add(packages, GINT_TO_POINTER(atoi(value) + 1));
+        } else if (strncmp(line, "cpu cores", 9) == 0) {
+            cores_per_package = (guint)atoi(value);
+        }
+    }
+    if (cpuinfo) fclose(cpuinfo);
+
+    // Architectures without these fields count every processor as a core
+    identity.packages = MAX(g_hash_table_size(packages), 1);
+    identity.cores = cores_per_package ? cores_per_package * identity.packages : identity.logical;
+    g_hash_table_destroy(packages);
+
+    char text[32];
+    if (read_attribute("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", text, sizeof(text))) {
+        identity.max_mhz = atol(text) / 1000.0f;
+    }
+    g_once_init_leave(&initialized, 1);
+    return &identity;
+}
+
+static gpointer sampler_thread(gpointer user_data) {
+    MetricsSampler *s = user_data;
+    MetricsCounters previous, current;
+    MetricsSample sample;
+
+    // A baseline first, so the first published CPU figure covers one
+    // interval instead of everything since boot
+    memset(&sample, 0, sizeof(sample));
+    read_counters(s, &previous, 0, &sample);
+    metrics_sampler_cpu_identity();
+
+    g_mutex_lock(&s->lock);
+    gint64 scheduled = g_get_monotonic_time();
+    gint64 process_scan_due = 0;
+    while (!s->stopping) {
+        guint interval_ms = s->interval_ms;
+        gboolean track_processes, track_sensors;
+        gint64 deadline = scheduled + (gint64)interval_ms * 1000;
+        while (!s->stopping && g_cond_wait_until(&s->wake, &s->lock, deadline)) {
+            // Woken early: a new interval counts from the last sample
+            if (s->interval_ms != interval_ms) {
+                interval_ms = s->interval_ms;
+                deadline = scheduled + (gint64)interval_ms * 1000;
+            }
+        }
+        if (s->stopping) break;
+
+        // Keep to the schedule, unless far behind (e.g. after suspend)
+        gint64 now = g_get_monotonic_time();
+        scheduled = now - deadline > (gint64)interval_ms * 1000 ? now : deadline;
+        track_processes = s->track_processes;
+        track_sensors = s->sensor_watchers > 0;
+        g_mutex_unlock(&s->lock);
+
+        memset(&sample, 0, sizeof(sample));
+        read_counters(s, &current, 1, &sample);
+
+        double seconds = (current.time - previous.time) / (double)G_USEC_PER_SEC;
+        if (seconds <= 0) seconds = 1e-6;
+        cpu_breakdown(&current.cpu, &previous.cpu, &sample.cpu);
+        sample.cpu_percent = sample.cpu.busy;
+        for (guint i = 0; i < s->cpu_count; i++) {
+            cpu_breakdown(&current.cores[i], &previous.cores[i], &s->core_sample[i]);
+        }
+        sample.timestamp = current.time;
+        sample.net_rx_bytes = current.net_rx;
+        sample.net_tx_bytes = current.net_tx;
+        sample.net_rx_rate = rate(current.net_rx, previous.net_rx, seconds);
+        sample.net_tx_rate = rate(current.net_tx, previous.net_tx, seconds);
+        sample.disk_read_bytes = current.disk_read * 512;
+        sample.disk_write_bytes = current.disk_write * 512;
+        sample.disk_read_rate = rate(current.disk_read, previous.disk_read, seconds) * 512;
+        sample.disk_write_rate = rate(current.disk_write, previous.disk_write, seconds) * 512;
+        s->disk_set->count = current.disk_count;
+        for (guint i = 0; i < current.disk_count; i++) {
+            disk_breakdown(&current.disks[i], &previous, seconds, &s->disk_set->disks[i]);
+        }
+        s->net_set->timestamp = current.time;
+        s->net_set->count = current.interface_count;
+        for (guint i = 0; i < current.interface_count; i++) {
+            net_breakdown(&current.interfaces[i], &previous, seconds, &s->net_set->interfaces[i]);
+        }
+        if (track_sensors) {
+            check_sensors(s);
+            s->sensor_set->timestamp = current.time;
+            read_sensors(s, s->sensor_set);
+        } else if (s->sensor_devices) {
+            unload_sensors(s);
+        }
+
+        // Details first: a reader that sees the sample also finds its cores,
+        // disks, interfaces and sensors
+        metric_ring_push(s->cores, s->core_sample);
+        metric_ring_push(s->disk_sets, s->disk_set);
+        metric_ring_push(s->net_sets, s->net_set);
+        if (track_sensors) metric_ring_push(s->sensor_sets, s->sensor_set);
+        metric_ring_push(s->samples, &sample);
+
+        // Processes carry their own timestamp and lag the sample slightly
+        if (track_processes && current.time >= process_scan_due) {
+            s->process_top->timestamp = g_get_monotonic_time();
+            scan_processes(s, s->process_top);
+            metric_ring_push(s->process_tops, s->process_top);
+            process_scan_due = current.time + METRICS_PROCESS_SCAN_MS * 1000;
+        } else if (!track_processes) {
+            g_clear_pointer(&s->processes, proc_scanner_free);
+            process_scan_due = 0;
+        }
+        previous = current;
+        CpuTimes *swap = s->core_times[0];
+        s->core_times[0] = s->core_times[1];
+        s->core_times[1] = swap;
+        DiskCounters *disk_swap = s->disk_counters[0];
+        s->disk_counters[0] = s->disk_counters[1];
+        s->disk_counters[1] = disk_swap;
+        NetCounters *net_swap = s->net_counters[0];
+        s->net_counters[0] = s->net_counters[1];
+        s->net_counters[1] = net_swap;
+
+        g_mutex_lock(&s->lock);
+    }
+    g_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+static int open_proc(const char *path) {
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static guint clamp_interval(guint interval_ms) {
+    return CLAMP(interval_ms, METRICS_MIN_INTERVAL_MS, METRICS_MAX_INTERVAL_MS);
+}
+
+// Starts the sampler; interval_ms of 0 takes COMMAND_SPHERE_SAMPLE_MS from
+// the environment, or one second
+void metrics_sampler_start(guint interval_ms) {
+    if (sampler) return;
+
+    if (interval_ms == 0) {
+        const char *env = getenv("COMMAND_SPHERE_SAMPLE_MS");
+        interval_ms = env ? (guint)strtoul(env, NULL, 10) : 0;
+        if (interval_ms == 0) interval_ms = METRICS_DEFAULT_INTERVAL_MS;
+    }
+
+    MetricsSampler *s = g_new0(MetricsSampler, 1);
+    g_mutex_init(&s->lock);
+    g_cond_init(&s->wake);
+    s->interval_ms = clamp_interval(interval_ms);
+    s->stat_fd = open_proc("/proc/stat");
+    s->meminfo_fd = open_proc("/proc/meminfo");
+    s->netdev_fd = open_proc("/proc/net/dev");
+    s->diskstats_fd = open_proc("/proc/diskstats");
+    s->pressure_fds[PSI_CPU] = open_proc("/proc/pressure/cpu");
+    s->pressure_fds[PSI_MEMORY] = open_proc("/proc/pressure/memory");
+    s->pressure_fds[PSI_IO] = open_proc("/proc/pressure/io");
+    s->disks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    s->buffer_size = METRICS_READ_BUFFER;
+    s->buffer = g_malloc(s->buffer_size);
+    s->samples = metric_ring_new(sizeof(MetricsSample), METRICS_RING_CAPACITY);
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    s->cpu_count = cpus > 0 ? (guint)cpus : 1;
+    s->core_times[0] = g_new0(CpuTimes, s->cpu_count);
+    s->core_times[1] = g_new0(CpuTimes, s->cpu_count);
+    s->core_sample = g_new0(CpuCoreSample, s->cpu_count);
+    s->cores = metric_ring_new(sizeof(CpuCoreSample) * s->cpu_count, METRICS_RING_CAPACITY);
+    s->disk_counters[0] = g_new0(DiskCounters, METRICS_MAX_DISKS);
+    s->disk_counters[1] = g_new0(DiskCounters, METRICS_MAX_DISKS);
+    s->disk_set = g_new0(DiskDeviceSet, 1);
+    s->disk_sets = metric_ring_new(sizeof(DiskDeviceSet), METRICS_DISK_RING_CAPACITY);
+    s->link_speeds = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    s->net_counters[0] = g_new0(NetCounters, METRICS_MAX_INTERFACES);
+    s->net_counters[1] = g_new0(NetCounters, METRICS_MAX_INTERFACES);
+    s->net_set = g_new0(NetInterfaceSet, 1);
+    s->net_sets = metric_ring_new(sizeof(NetInterfaceSet), METRICS_NET_RING_CAPACITY);
+    s->sensors = g_new0(SensorSource, METRICS_MAX_SENSORS);
+    s->sensor_set = g_new0(ThermalSensorSet, 1);
+    s->sensor_sets = metric_ring_new(sizeof(ThermalSensorSet), METRICS_SENSOR_RING_CAPACITY);
+    s->process_top = g_new0(ProcessTopSet, 1);
+    s->process_tops = metric_ring_new(sizeof(ProcessTopSet), METRICS_PROCESS_RING_CAPACITY);
+
+    s->thread = g_thread_new("metrics-sampler", sampler_thread, s);
+    sampler = s;
+}
+
+void metrics_sampler_stop(void) {
+    MetricsSampler *s = sampler;
+    if (!s) return;
+
+    g_mutex_lock(&s->lock);
+    s->stopping = TRUE;
+    g_cond_signal(&s->wake);
+    g_mutex_unlock(&s->lock);
+    g_thread_join(s->thread);
+    sampler = NULL;
+
+    int fds[] = { s->stat_fd, s->meminfo_fd, s->netdev_fd, s->diskstats_fd,
+                  s->pressure_fds[PSI_CPU], s->pressure_fds[PSI_MEMORY], s->pressure_fds[PSI_IO] };
+    for (gsize i = 0; i < G_N_ELEMENTS(fds); i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    g_hash_table_destroy(s->disks);
+    g_free(s->buffer);
+    metric_ring_free(s->samples);
+    metric_ring_free(s->cores);
+    metric_ring_free(s->disk_sets);
+    g_free(s->disk_counters[0]);
+    g_free(s->disk_counters[1]);
+    g_free(s->disk_set);
+    metric_ring_free(s->net_sets);
+    g_hash_table_destroy(s->link_speeds);
+    g_free(s->net_counters[0]);
+    g_free(s->net_counters[1]);
+    g_free(s->net_set);
+    unload_sensors(s);
+    g_free(s->sensors);
+    g_free(s->sensor_set);
+    metric_ring_free(s->sensor_sets);
+    proc_scanner_free(s->processes);
+    g_free(s->process_top);
+    metric_ring_free(s->process_tops);
+    g_free(s->core_times[0]);
+    g_free(s->core_times[1]);
+    g_free(s->core_sample);
+    g_mutex_clear(&s->lock);
+    g_cond_clear(&s->wake);
+    g_free(s);
+}
+
+void metrics_sampler_set_interval(guint interval_ms) {
+    if (!sampler) return;
+    g_mutex_lock(&sampler->lock);
+    sampler->interval_ms = clamp_interval(interval_ms);
+    g_cond_signal(&sampler->wake);
+    g_mutex_unlock(&sampler->lock);
+}
+
+guint metrics_sampler_interval(void) {
+    return sampler ? sampler->interval_ms : 0;
+}
+
+// Most recent sample; FALSE until the first interval has elapsed
+gboolean metrics_sampler_latest(MetricsSample *sample) {
+    return sampler && metric_ring_read(sampler->samples, 1, sample) == 1;
+}
+
+// Up to max of the most recent samples, oldest first
+guint metrics_sampler_history(MetricsSample *samples, guint max) {
+    return sampler ? metric_ring_read(sampler->samples, MIN(max, METRICS_RING_CAPACITY), samples) : 0;
+}
+
+guint metrics_sampler_cpu_count(void) {
+    return sampler ? sampler->cpu_count : 0;
+}
+
+// Per-core breakdowns of the samples taken since *cursor (0 for all that
+// are retained), at most max of the newest, oldest first. cores holds
+// max * metrics_sampler_cpu_count() entries; *cursor is advanced.
+guint metrics_sampler_cpu_since(guint64 *cursor, CpuCoreSample *cores, guint max) {
+    return sampler ? metric_ring_read_since(sampler->cores, cursor, MIN(max, METRICS_RING_CAPACITY), cores) : 0;
+}
+
+// Block devices as of the most recent sample, at most max; 0 until the
+// first interval has elapsed
+guint metrics_sampler_disks(DiskDeviceSample *disks, guint max) {
+    if (!sampler) return 0;
+    DiskDeviceSet *set = g_new(DiskDeviceSet, 1);
+    guint count = 0;
+    if (metric_ring_read(sampler->disk_sets, 1, set) == 1) {
+        count = MIN(set->count, max);
+        memcpy(disks, set->disks, count * sizeof(DiskDeviceSample));
+    }
+    g_free(set);
+    return count;
+}
+
+// Interface sets of the samples taken since *cursor (0 for all that are
+// retained), at most max of the newest, oldest first; *cursor is advanced
+guint metrics_sampler_network_since(guint64 *cursor, NetInterfaceSet *sets, guint max) {
+    return sampler ? metric_ring_read_since(sampler->net_sets, cursor, MIN(max, METRICS_NET_RING_CAPACITY), sets) : 0;
+}
+
+// Sensor sets of the samples taken since *cursor (0 for all that are
+// retained), at most max of the newest, oldest first; *cursor is advanced
+guint metrics_sampler_sensors_since(guint64 *cursor, ThermalSensorSet *sets, guint max) {
+    return sampler ? metric_ring_read_since(sampler->sensor_sets, cursor, MIN(max, METRICS_SENSOR_RING_CAPACITY), sets) : 0;
+}
+
+// Temperatures are only read while at least one caller wants them; every
+// TRUE is matched by a FALSE once that caller is done
+void metrics_sampler_track_sensors(gboolean enabled) {
+    if (!sampler) return;
+    g_mutex_lock(&sampler->lock);
+    if (enabled) {
+        sampler->sensor_watchers++;
+    } else if (sampler->sensor_watchers > 0) {
+        sampler->sensor_watchers--;
+    }
+    g_mutex_unlock(&sampler->lock);
+}
+
+// Starts or stops the process scan behind metrics_sampler_top_processes(),
+// from the next sample on
+void metrics_sampler_track_processes(gboolean enabled) {
+    if (!sampler) return;
+    g_mutex_lock(&sampler->lock);
+    sampler->track_processes = enabled;
+    g_mutex_unlock(&sampler->lock);
+}
+
+// Busiest processes as of the most recent scan, at most a couple of
+// seconds old while tracked
+gboolean metrics_sampler_top_processes(ProcessTopSet *set) {
+    return sampler && metric_ring_read(sampler->process_tops, 1, set) == 1;
+}
@@ -0,0 +1,385 @@
+// network_panel.c
+// Live network view for the Network Information dialog: a table with
+// bit and packet rates, errors, drops and link utilization per interface,
+// and a graph of the receive and transmit rate over the last couple of
+// minutes. Everything comes from the metrics sampler's interface ring
+// (metrics_sampler.c), so opening the dialog shows the recent history right
+// away; the graph follows the selected interface, or all interfaces but
+// loopback when nothing is selected.
+
+#include "custom_shell.h"
+
+#define NET_GRAPH_SAMPLES 120
+#define NET_GRAPH_HEIGHT 140
+#define NET_TOTAL_KEY ""            // history of all interfaces but loopback
+
+enum {
+    NET_COL_NAME,
+    NET_COL_RX_BPS,
+    NET_COL_TX_BPS,
+    NET_COL_RX_PPS,
+    NET_COL_TX_PPS,
+    NET_COL_ERRORS,
+    NET_COL_DROPS,
+    NET_COL_LINK,
+    NET_COL_LINK_TEXT,
+    NET_COL_GENERATION,
+    NET_N_COLUMNS
+};
+
+// Receive and transmit bits per second, one slot per sample
+typedef struct {
+    double rx[NET_GRAPH_SAMPLES];
+    double tx[NET_GRAPH_SAMPLES];
+    guint count;                // samples pushed; the next slot is count % NET_GRAPH_SAMPLES
+} NetHistory;
+
+typedef struct {
+    GtkListStore *store;
+    GtkWidget *summary;
+    GtkWidget *graph;
+    GtkWidget *graph_label;
+    guint timer;
+    guint64 cursor;             // position in the sampler's interface ring
+    guint column;               // samples seen, the graph's time axis
+    guint generation;
+    GHashTable *history;        // interface name -> NetHistory*
+    char *selected;             // graphed interface, NULL for the total
+    NetInterfaceSet *sets;      // NET_GRAPH_SAMPLES scratch
+} NetworkPanel;
+
+static void format_bits(double bps, char *text, gsize size) {
+    if (bps >= 1e9) {
+        snprintf(text, size, "%.2f Gbit/s", bps / 1e9);
+    } else if (bps >= 1e6) {
+        snprintf(text, size, "%.2f Mbit/s", bps / 1e6);
+    } else {
+        snprintf(text, size, "%.1f kbit/s", bps / 1e3);
+    }
+}
+
+// Interfaces that were missing from some samples get zeros for them, so
+// every history shares the panel's time axis
+static void push_history(NetworkPanel *panel, const char *name, double rx, double tx) {
+    NetHistory *history = g_hash_table_lookup(panel->history, name);
+    if (!history) {
+        history = g_new0(NetHistory, 1);
+        history->count = panel->column;
+        g_hash_table_insert(panel->history, g_strdup(name), history);
+    }
+    while (history->count < panel->column) {
+        guint slot = history->count++ % NET_GRAPH_SAMPLES;
+        history->rx[slot] = history->tx[slot] = 0;
+    }
+    guint slot = history->count++ % NET_GRAPH_SAMPLES;
+    history->rx[slot] = rx;
+    history->tx[slot] = tx;
+}
+
+static gboolean find_interface_row(GtkTreeModel *model, const char *name, GtkTreeIter *iter) {
+    gboolean valid = gtk_tree_model_get_iter_first(model, iter);
+    while (valid) {
+        char *row_name = NULL;
+        gtk_tree_model_get(model, iter, NET_COL_NAME, &row_name, -1);
+        gboolean same = g_strcmp0(row_name, name) == 0;
+        g_free(row_name);
+        if (same) return TRUE;
+        valid = gtk_tree_model_iter_next(model, iter);
+    }
+    return FALSE;
+}
+
+static void update_rows(NetworkPanel *panel, const NetInterfaceSet *set) {
+    GtkTreeModel *model = GTK_TREE_MODEL(panel->store);
+    panel->generation++;
+
+    for (guint i = 0; i < set->count; i++) {
+        const NetInterfaceSample *net = &set->interfaces[i];
+        char link_text[32] = "n/a";
+        if (net->speed_mbps > 0) {
+            snprintf(link_text, sizeof(link_text), "%.0f%% of %d Mbit/s", net->link_percent, net->speed_mbps);
+        }
+
+        GtkTreeIter iter;
+        if (!find_interface_row(model, net->name, &iter)) {
+            gtk_list_store_append(panel->store, &iter);
+        }
+        gtk_list_store_set(panel->store, &iter,
+                           NET_COL_NAME, net->name,
+                           NET_COL_RX_BPS, net->rx_bps,
+                           NET_COL_TX_BPS, net->tx_bps,
+                           NET_COL_RX_PPS, net->rx_pps,
+                           NET_COL_TX_PPS, net->tx_pps,
+                           NET_COL_ERRORS, net->rx_errors + net->tx_errors,
+                           NET_COL_DROPS, net->rx_drops + net->tx_drops,
+                           NET_COL_LINK, (int)(net->link_percent + 0.5f),
+                           NET_COL_LINK_TEXT, link_text,
+                           NET_COL_GENERATION, panel->generation,
+                           -1);
+    }
+
+    // Interfaces that went away, e.g. a stopped container's veth
+    GtkTreeIter iter;
+    gboolean valid = gtk_tree_model_get_iter_first(model, &iter);
+    while (valid) {
+        guint generation = 0;
+        char *name = NULL;
+        gtk_tree_model_get(model, &iter, NET_COL_GENERATION, &generation, NET_COL_NAME, &name, -1);
+        if (generation == panel->generation) {
+            valid = gtk_tree_model_iter_next(model, &iter);
+        } else {
+            g_hash_table_remove(panel->history, name);
+            valid = gtk_list_store_remove(panel->store, &iter);
+        }
+        g_free(name);
+    }
+}
+
+static void update_summary(NetworkPanel *panel, const NetInterfaceSet *set) {
+    double rx = 0, tx = 0;
+    float errors = 0, drops = 0;
+    for (guint i = 0; i < set->count; i++) {
+        const NetInterfaceSample *net = &set->interfaces[i];
+        if (net->loopback) continue;
+        rx += net->rx_bps;
+        tx += net->tx_bps;
+        errors += net->rx_errors + net->tx_errors;
+        drops += net->rx_drops + net->tx_drops;
+    }
+
+    char rx_text[32], tx_text[32], text[256];
+    format_bits(rx, rx_text, sizeof(rx_text));
+    format_bits(tx, tx_text, sizeof(tx_text));
+    snprintf(text, sizeof(text), "All interfaces: RX %s, TX %s, %.0f errors/s, %.0f drops/s",
+             rx_text, tx_text, errors, drops);
+    gtk_label_set_text(GTK_LABEL(panel->summary), text);
+}
+
+static NetHistory* graphed_history(NetworkPanel *panel, guint *shown) {
+    NetHistory *history = g_hash_table_lookup(panel->history, panel->selected ? panel->selected : NET_TOTAL_KEY);
+    *shown = history ? MIN(history->count, NET_GRAPH_SAMPLES) : 0;
+    return history;
+}
+
+// Top of the graph's scale: the highest rate shown, at least 1 kbit/s
+static double graph_peak(const NetHistory *history, guint shown) {
+    double peak = 1e3;
+    for (guint i = 0; i < shown; i++) {
+        guint slot = (history->count - shown + i) % NET_GRAPH_SAMPLES;
+        peak = MAX(peak, MAX(history->rx[slot], history->tx[slot]));
+    }
+    return peak;
+}
+
+static void update_graph(NetworkPanel *panel) {
+    guint shown;
+    NetHistory *history = graphed_history(panel, &shown);
+    char peak[32], text[80];
+    format_bits(graph_peak(history, shown), peak, sizeof(peak));
+    snprintf(text, sizeof(text), "%s: peak %s", panel->selected ? panel->selected : "All interfaces", peak);
+    gtk_label_set_text(GTK_LABEL(panel->graph_label), text);
+    gtk_widget_queue_draw(panel->graph);
+}
+
+static gboolean network_panel_tick(gpointer user_data) {
+    NetworkPanel *panel = user_data;
+    guint count = metrics_sampler_network_since(&panel->cursor, panel->sets, NET_GRAPH_SAMPLES);
+    if (count == 0) return G_SOURCE_CONTINUE;
+
+    for (guint s = 0; s < count; s++) {
+        const NetInterfaceSet *set = &panel->sets[s];
+        double rx = 0, tx = 0;
+        for (guint i = 0; i < set->count; i++) {
+            const NetInterfaceSample *net = &set->interfaces[i];
+            push_history(panel, net->name, net->rx_bps, net->tx_bps);
+            if (!net->loopback) {
+                rx += net->rx_bps;
+                tx += net->tx_bps;
+            }
+        }
+        push_history(panel, NET_TOTAL_KEY, rx, tx);
+        panel->column++;
+    }
+
+    update_rows(panel, &panel->sets[count - 1]);
+    update_summary(panel, &panel->sets[count - 1]);
+    update_graph(panel);
+    return G_SOURCE_CONTINUE;
+}
+
+static void draw_series(cairo_t *cr, const NetHistory *history, const double *values,
+                        guint shown, double max, double width, double height) {
+    double step = width / (NET_GRAPH_SAMPLES - 1);
+    for (guint i = 0; i < shown; i++) {
+        guint index = history->count - shown + i;
+        double x = width - (shown - 1 - i) * step;
+        double y = height - values[index % NET_GRAPH_SAMPLES] / max * (height - 4);
+        if (i == 0) {
+            cairo_move_to(cr, x, y);
+        } else {
+            cairo_line_to(cr, x, y);
+        }
+    }
+    cairo_stroke(cr);
+}
+
+static gboolean on_graph_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    NetworkPanel *panel = user_data;
+    double width = gtk_widget_get_allocated_width(widget);
+    double height = gtk_widget_get_allocated_height(widget);
+
+    cairo_set_source_rgb(cr, 0.13, 0.13, 0.13);
+    cairo_paint(cr);
+
+    guint shown;
+    NetHistory *history = graphed_history(panel, &shown);
+    double max = graph_peak(history, shown);
+
+    // Quarter grid lines
+    cairo_set_source_rgb(cr, 0.25, 0.25, 0.25);
+    cairo_set_line_width(cr, 1.0);
+    for (int i = 1; i < 4; i++) {
+        cairo_move_to(cr, 0, height * i / 4.0 + 0.5);
+        cairo_line_to(cr, width, height * i / 4.0 + 0.5);
+    }
+    cairo_stroke(cr);
+    if (shown < 2) return TRUE;
+
+    cairo_set_line_width(cr, 1.5);
+    cairo_set_source_rgb(cr, 0.30, 0.69, 0.31);
+    draw_series(cr, history, history->rx, shown, max, width, height);
+    cairo_set_source_rgb(cr, 0.13, 0.59, 0.95);
+    draw_series(cr, history, history->tx, shown, max, width, height);
+    return TRUE;
+}
+
+static void on_interface_selected(GtkTreeSelection *selection, gpointer user_data) {
+    NetworkPanel *panel = user_data;
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+
+    g_clear_pointer(&panel->selected, g_free);
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        gtk_tree_model_get(model, &iter, NET_COL_NAME, &panel->selected, -1);
+    }
+    update_graph(panel);
+}
+
+static void bits_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                           GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    double bps = 0;
+    char text[32];
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &bps, -1);
+    format_bits(bps, text, sizeof(text));
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void count_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                            GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    float value = 0;
+    char text[32];
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &value, -1);
+    snprintf(text, sizeof(text), "%.0f", value);
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void add_network_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer;
+    GtkTreeViewColumn *column;
+
+    if (column_id == NET_COL_NAME) {
+        renderer = gtk_cell_renderer_text_new();
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    } else if (column_id == NET_COL_LINK) {
+        renderer = gtk_cell_renderer_progress_new();
+        column = gtk_tree_view_column_new_with_attributes(title, renderer,
+                                                          "value", NET_COL_LINK,
+                                                          "text", NET_COL_LINK_TEXT,
+                                                          NULL);
+        gtk_tree_view_column_set_expand(column, TRUE);
+    } else {
+        renderer = gtk_cell_renderer_text_new();
+        g_object_set(renderer, "xalign", 1.0, NULL);
+        column = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(column, title);
+        gtk_tree_view_column_pack_start(column, renderer, TRUE);
+        gtk_tree_view_column_set_cell_data_func(column, renderer,
+                                                column_id <= NET_COL_TX_BPS ? bits_cell_data : count_cell_data,
+                                                GINT_TO_POINTER(column_id), NULL);
+    }
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+static void on_network_panel_destroy(GtkWidget *widget, gpointer user_data) {
+    NetworkPanel *panel = user_data;
+    g_source_remove(panel->timer);
+    g_object_unref(panel->store);
+    g_hash_table_destroy(panel->history);
+    g_free(panel->selected);
+    g_free(panel->sets);
+    g_free(panel);
+}
+
+GtkWidget* network_panel_new(void) {
+    if (metrics_sampler_interval() == 0) {
+        return gtk_label_new("Network: sampler not running");
+    }
+
+    NetworkPanel *panel = g_new0(NetworkPanel, 1);
+    panel->history = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    panel->sets = g_new(NetInterfaceSet, NET_GRAPH_SAMPLES);
+    panel->store = gtk_list_store_new(NET_N_COLUMNS,
+                                      G_TYPE_STRING, G_TYPE_DOUBLE, G_TYPE_DOUBLE,
+                                      G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT,
+                                      G_TYPE_INT, G_TYPE_STRING, G_TYPE_UINT);
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    panel->summary = gtk_label_new("All interfaces: waiting for the first sample");
+    gtk_label_set_xalign(GTK_LABEL(panel->summary), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), panel->summary, FALSE, FALSE, 0);
+
+    GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(panel->store));
+    add_network_column(view, "Interface", NET_COL_NAME);
+    add_network_column(view, "RX", NET_COL_RX_BPS);
+    add_network_column(view, "TX", NET_COL_TX_BPS);
+    add_network_column(view, "RX pkt/s", NET_COL_RX_PPS);
+    add_network_column(view, "TX pkt/s", NET_COL_TX_PPS);
+    add_network_column(view, "Errors/s", NET_COL_ERRORS);
+    add_network_column(view, "Drops/s", NET_COL_DROPS);
+    add_network_column(view, "Link", NET_COL_LINK);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(scrolled, -1, 150);
+    gtk_container_add(GTK_CONTAINER(scrolled), view);
+    gtk_box_pack_start(GTK_BOX(box), scrolled, TRUE, TRUE, 0);
+
+    panel->graph_label = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(panel->graph_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), panel->graph_label, FALSE, FALSE, 0);
+
+    GtkWidget *legend = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(legend),
+                         "<span foreground='#4caf50'>■</span> receive  "
+                         "<span foreground='#2196f3'>■</span> transmit  "
+                         "(select an interface to graph it alone)");
+    gtk_label_set_xalign(GTK_LABEL(legend), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), legend, FALSE, FALSE, 0);
+
+    panel->graph = gtk_drawing_area_new();
+    gtk_widget_set_size_request(panel->graph, -1, NET_GRAPH_HEIGHT);
+    g_signal_connect(panel->graph, "draw", G_CALLBACK(on_graph_draw), panel);
+    gtk_box_pack_start(GTK_BOX(box), panel->graph, FALSE, FALSE, 0);
+
+    g_signal_connect(gtk_tree_view_get_selection(GTK_TREE_VIEW(view)), "changed",
+                     G_CALLBACK(on_interface_selected), panel);
+
+    // Backfill from what the sampler already holds, then follow it
+    network_panel_tick(panel);
+    panel->timer = g_timeout_add(metrics_sampler_interval(), network_panel_tick, panel);
+    g_signal_connect(box, "destroy", G_CALLBACK(on_network_panel_destroy), panel);
+    return box;
+}
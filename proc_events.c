@@ -0,0 +1,118 @@
+// proc_events.c
+// Process fork/exec/exit notifications from the kernel's proc connector
+// (NETLINK_CONNECTOR, CN_IDX_PROC). Subscribing needs CAP_NET_ADMIN on most
+// kernels; proc_events_open returns NULL when it is not permitted and the
+// caller keeps polling /proc instead.
+
+#include "custom_shell.h"
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+#define PROC_EVENTS_RCVBUF (4 * 1024 * 1024)
+
+struct _ProcEvents {
+    int fd;
+    char buffer[16384];
+};
+
+static gboolean send_mcast_op(int fd, enum proc_cn_mcast_op op) {
+    struct {
+        struct nlmsghdr header;
+        struct cn_msg message;
+        enum proc_cn_mcast_op op;
+    } __attribute__((packed)) request;
+
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = sizeof(request);
+    request.header.nlmsg_type = NLMSG_DONE;
+    request.message.id.idx = CN_IDX_PROC;
+    request.message.id.val = CN_VAL_PROC;
+    request.message.len = sizeof(enum proc_cn_mcast_op);
+    request.op = op;
+
+    return send(fd, &request, sizeof(request), 0) == sizeof(request);
+}
+
+ProcEvents* proc_events_open(void) {
+    int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd < 0) return NULL;
+
+    struct sockaddr_nl address = { 0 };
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+
+    // Bursts of forks arrive faster than the main loop drains them
+    int rcvbuf = PROC_EVENTS_RCVBUF;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        !send_mcast_op(fd, PROC_CN_MCAST_LISTEN)) {
+        close(fd);
+        return NULL;
+    }
+
+    ProcEvents *events = g_new0(ProcEvents, 1);
+    events->fd = fd;
+    return events;
+}
+
+void proc_events_close(ProcEvents *events) {
+    if (!events) return;
+    send_mcast_op(events->fd, PROC_CN_MCAST_IGNORE);
+    close(events->fd);
+    g_free(events);
+}
+
+int proc_events_fd(ProcEvents *events) {
+    return events ? events->fd : -1;
+}
+
+// Reads every queued message and reports process-level events (thread
+// creation and exit are skipped). Returns FALSE if the kernel dropped
+// events because the socket overflowed, in which case the caller must
+// rescan /proc to catch up.
+gboolean proc_events_dispatch(ProcEvents *events, ProcEventFunc func, gpointer user_data) {
+    gboolean complete = TRUE;
+
+    for (;;) {
+        ssize_t length = recv(events->fd, events->buffer, sizeof(events->buffer), 0);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                complete = FALSE;
+                continue;
+            }
+            break;  // EAGAIN: drained
+        }
+
+        struct nlmsghdr *header = (struct nlmsghdr *)events->buffer;
+        for (; NLMSG_OK(header, (size_t)length); header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) continue;
+
+            struct cn_msg *message = NLMSG_DATA(header);
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) continue;
+
+            struct proc_event *event = (struct proc_event *)message->data;
+            switch (event->what) {
+                case PROC_EVENT_FORK:
+                    if (event->event_data.fork.child_pid == event->event_data.fork.child_tgid) {
+                        func(PROC_CHANGE_STARTED, event->event_data.fork.child_tgid, user_data);
+                    }
+                    break;
+                case PROC_EVENT_EXEC:
+                    func(PROC_CHANGE_EXEC, event->event_data.exec.process_tgid, user_data);
+                    break;
+                case PROC_EVENT_EXIT:
+                    if (event->event_data.exit.process_pid == event->event_data.exit.process_tgid) {
+                        func(PROC_CHANGE_EXITED, event->event_data.exit.process_tgid, user_data);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return complete;
+}
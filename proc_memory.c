@@ -0,0 +1,515 @@
+// proc_memory.c
+// Per-process memory that does not double-count shared pages. RSS charges
+// every shared library and copy-on-write page to each process mapping it,
+// so a pool of forked workers looks many times its real size. The kernel's
+// /proc/<pid>/smaps_rollup gives PSS (shared pages split among their
+// users), the private pages (USS, what exiting would free), anonymous
+// memory and swap. Kernels before 4.14 lack it; the full smaps is summed
+// instead.
+//
+// Walking a process's page tables for smaps is far dearer than reading
+// statm, so the Process Manager never does it on the UI thread: a cache
+// owns a thread that reads the requested pids, each at most once every
+// COMMAND_SPHERE_SMAPS_SECONDS (10 by default), and lookups return
+// whatever was read last. Only rows on screen and the largest processes
+// are requested, so the cost does not grow with the process count.
+//
+// The memory map dialog drills into one process: every mapping with its
+// RSS, PSS, private, anonymous and swap figures, or the same grouped by
+// file, read from /proc/<pid>/smaps on a worker thread.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+
+#define SMAPS_DEFAULT_SECONDS 10
+#define MEMORY_MAP_RESPONSE_REFRESH 1
+
+typedef struct {
+    char range[40];             // "start-end", hex
+    char perms[5];
+    char name[256];             // file, [heap], [stack], ... or "" when anonymous
+    long size_kb;
+    ProcMemory memory;
+} MemoryMapping;
+
+typedef void (*MappingFunc)(const MemoryMapping *mapping, gpointer user_data);
+
+// Reads smaps or smaps_rollup (a single "[rollup]" mapping) and hands each
+// mapping to func. Takes ownership of fd.
+static gboolean parse_smaps(int fd, MappingFunc func, gpointer user_data) {
+    FILE *file = fdopen(fd, "r");
+    if (!file) {
+        close(fd);
+        return FALSE;
+    }
+
+    MemoryMapping mapping;
+    gboolean have_mapping = FALSE;
+    char *line = NULL;
+    size_t capacity = 0;
+    while (getline(&line, &capacity, file) > 0) {
+        // Field lines are "Key:   value kB"; anything else starts a mapping
+        const char *colon = strchr(line, ':');
+        const char *space = strchr(line, ' ');
+        if (!colon || (space && space < colon)) {
+            if (have_mapping) func(&mapping, user_data);
+            memset(&mapping, 0, sizeof(mapping));
+            if (sscanf(line, "%39s %4s %*s %*s %*s %255[^\n]", mapping.range, mapping.perms, mapping.name) >= 2) {
+                g_strstrip(mapping.name);
+                have_mapping = TRUE;
+            }
+            continue;
+        }
+        if (!have_mapping) continue;
+
+        long kb = strtol(colon + 1, NULL, 10);
+        gsize key = colon - line;
+        if (key == 4 && strncmp(line, "Size", 4) == 0) {
+            mapping.size_kb = kb;
+        } else if (key == 3 && strncmp(line, "Rss", 3) == 0) {
+            mapping.memory.rss_kb = kb;
+        } else if (key == 3 && strncmp(line, "Pss", 3) == 0) {
+            mapping.memory.pss_kb = kb;
+        } else if ((key == 13 && strncmp(line, "Private_Clean", 13) == 0) ||
+                   (key == 13 && strncmp(line, "Private_Dirty", 13) == 0)) {
+            mapping.memory.uss_kb += kb;
+        } else if (key == 9 && strncmp(line, "Anonymous", 9) == 0) {
+            mapping.memory.anon_kb = kb;
+        } else if (key == 4 && strncmp(line, "Swap", 4) == 0) {
+            mapping.memory.swap_kb = kb;
+        } else if (key == 7 && strncmp(line, "SwapPss", 7) == 0) {
+            mapping.memory.swap_pss_kb = kb;
+        }
+    }
+    if (have_mapping) func(&mapping, user_data);
+
+    free(line);
+    fclose(file);
+    return TRUE;
+}
+
+static void add_mapping(const MemoryMapping *mapping, gpointer user_data) {
+    ProcMemory *total = user_data;
+    total->rss_kb += mapping->memory.rss_kb;
+    total->pss_kb += mapping->memory.pss_kb;
+    total->uss_kb += mapping->memory.uss_kb;
+    total->anon_kb += mapping->memory.anon_kb;
+    total->swap_kb += mapping->memory.swap_kb;
+    total->swap_pss_kb += mapping->memory.swap_pss_kb;
+}
+
+// PSS, USS, anonymous and swap totals of one process. FALSE with errno
+// set when its smaps cannot be read: gone, or another user's (EACCES).
+gboolean proc_memory_read(int pid, ProcMemory *memory) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT) {
+        snprintf(path, sizeof(path), "/proc/%d/smaps", pid);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) return FALSE;
+
+    memset(memory, 0, sizeof(*memory));
+    return parse_smaps(fd, add_mapping, memory);
+}
+
+// Background cache for the Process Manager
+
+typedef struct {
+    ProcMemory memory;
+    gboolean available;         // FALSE when smaps could not be read
+    gint64 read_at;             // monotonic microseconds
+    guint generation;           // last request that named this pid
+} CachedMemory;
+
+struct _ProcMemoryCache {
+    GThread *thread;
+    GMutex lock;
+    GCond wake;
+    gboolean stopping;
+    GArray *pending;            // pids of the newest request, NULL once taken
+    GHashTable *entries;        // pid -> CachedMemory*
+    guint generation;
+    gint64 max_age;             // microseconds between reads of one pid
+};
+
+static gpointer cache_thread(gpointer user_data) {
+    ProcMemoryCache *cache = user_data;
+
+    g_mutex_lock(&cache->lock);
+    while (!cache->stopping) {
+        if (!cache->pending) {
+            g_cond_wait(&cache->wake, &cache->lock);
+            continue;
+        }
+        GArray *pids = cache->pending;
+        cache->pending = NULL;
+
+        for (guint i = 0; i < pids->len && !cache->stopping; i++) {
+            int pid = g_array_index(pids, int, i);
+            CachedMemory *entry = g_hash_table_lookup(cache->entries, GINT_TO_POINTER(pid));
+            if (entry && g_get_monotonic_time() - entry->read_at < cache->max_age) continue;
+
+            g_mutex_unlock(&cache->lock);
+            ProcMemory memory;
+            gboolean available = proc_memory_read(pid, &memory);
+            g_mutex_lock(&cache->lock);
+
+            // Looked up again: the UI may have pruned it meanwhile
+            entry = g_hash_table_lookup(cache->entries, GINT_TO_POINTER(pid));
+            if (!entry) {
+                entry = g_new0(CachedMemory, 1);
+                entry->generation = cache->generation;
+                g_hash_table_insert(cache->entries, GINT_TO_POINTER(pid), entry);
+            }
+            entry->memory = memory;
+            entry->available = available;
+            entry->read_at = g_get_monotonic_time();
+        }
+        g_array_free(pids, TRUE);
+    }
+    g_mutex_unlock(&cache->lock);
+    return NULL;
+}
+
+ProcMemoryCache* proc_memory_cache_new(void) {
+    ProcMemoryCache *cache = g_new0(ProcMemoryCache, 1);
+    const char *env = getenv("COMMAND_SPHERE_SMAPS_SECONDS");
+    guint seconds = env ? (guint)strtoul(env, NULL, 10) : 0;
+    if (seconds == 0) seconds = SMAPS_DEFAULT_SECONDS;
+    cache->max_age = (gint64)seconds * G_USEC_PER_SEC;
+    cache->entries = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    g_mutex_init(&cache->lock);
+    g_cond_init(&cache->wake);
+    cache->thread = g_thread_new("smaps-reader", cache_thread, cache);
+    return cache;
+}
+
+void proc_memory_cache_free(ProcMemoryCache *cache) {
+    if (!cache) return;
+
+    g_mutex_lock(&cache->lock);
+    cache->stopping = TRUE;
+    g_cond_signal(&cache->wake);
+    g_mutex_unlock(&cache->lock);
+    g_thread_join(cache->thread);
+
+    if (cache->pending) g_array_free(cache->pending, TRUE);
+    g_hash_table_destroy(cache->entries);
+    g_mutex_clear(&cache->lock);
+    g_cond_clear(&cache->wake);
+    g_free(cache);
+}
+
+static gboolean is_forgotten(gpointer key, gpointer value, gpointer user_data) {
+    CachedMemory *entry = value;
+    return entry->generation != GPOINTER_TO_UINT(user_data);
+}
+
+// The pids to keep fresh, replacing any earlier request that was not
+// started yet. Figures of pids left out stay available until dropped by
+// proc_memory_cache_retain.
+void proc_memory_cache_request(ProcMemoryCache *cache, const int *pids, guint count) {
+    g_mutex_lock(&cache->lock);
+    if (cache->pending) g_array_free(cache->pending, TRUE);
+    cache->pending = g_array_sized_new(FALSE, FALSE, sizeof(int), count);
+    g_array_append_vals(cache->pending, pids, count);
+    g_cond_signal(&cache->wake);
+    g_mutex_unlock(&cache->lock);
+}
+
+// Forgets every pid not in pids, i.e. processes that exited
+void proc_memory_cache_retain(ProcMemoryCache *cache, const int *pids, guint count) {
+    g_mutex_lock(&cache->lock);
+    cache->generation++;
+    for (guint i = 0; i < count; i++) {
+        CachedMemory *entry = g_hash_table_lookup(cache->entries, GINT_TO_POINTER(pids[i]));
+        if (entry) entry->generation = cache->generation;
+    }
+    g_hash_table_foreach_remove(cache->entries, is_forgotten, GUINT_TO_POINTER(cache->generation));
+    g_mutex_unlock(&cache->lock);
+}
+
+// Last figures read for pid; FALSE until its first read, or when its smaps
+// is not readable
+gboolean proc_memory_cache_lookup(ProcMemoryCache *cache, int pid, ProcMemory *memory) {
+    g_mutex_lock(&cache->lock);
+    CachedMemory *entry = g_hash_table_lookup(cache->entries, GINT_TO_POINTER(pid));
+    gboolean available = entry && entry->available;
+    if (available) *memory = entry->memory;
+    g_mutex_unlock(&cache->lock);
+    return available;
+}
+
+// Memory map dialog
+
+enum {
+    MAP_COL_RANGE,
+    MAP_COL_PERMS,
+    MAP_COL_NAME,
+    MAP_COL_SIZE,
+    MAP_COL_RSS,
+    MAP_COL_PSS,
+    MAP_COL_PRIVATE,
+    MAP_COL_ANON,
+    MAP_COL_SWAP,
+    MAP_N_COLUMNS
+};
+
+typedef struct {
+    int pid;
+    GtkWidget *dialog;
+    GtkListStore *store;
+    GtkWidget *view;
+    GtkWidget *group_toggle;
+    GtkWidget *status_label;
+    GArray *mappings;           // MemoryMapping of the last read
+    gboolean busy;
+    gboolean closed;
+    int refs;                   // the dialog and a running read
+} MemoryMap;
+
+typedef struct {
+    MemoryMap *map;
+    int fd;
+    GArray *mappings;
+} MemoryMapRead;
+
+static void memory_map_unref(MemoryMap *map) {
+    if (--map->refs > 0) return;
+    if (map->mappings) g_array_free(map->mappings, TRUE);
+    g_object_unref(map->store);
+    g_free(map);
+}
+
+static void append_mapping(const MemoryMapping *mapping, gpointer user_data) {
+    g_array_append_vals(user_data, mapping, 1);
+}
+
+static void insert_mapping_row(MemoryMap *map, const char *range, const char *perms, const char *name,
+                               long size_kb, const ProcMemory *memory) {
+    gtk_list_store_insert_with_values(map->store, NULL, -1,
+                                      MAP_COL_RANGE, range,
+                                      MAP_COL_PERMS, perms,
+                                      MAP_COL_NAME, name,
+                                      MAP_COL_SIZE, size_kb,
+                                      MAP_COL_RSS, memory->rss_kb,
+                                      MAP_COL_PSS, memory->pss_kb,
+                                      MAP_COL_PRIVATE, memory->uss_kb,
+                                      MAP_COL_ANON, memory->anon_kb,
+                                      MAP_COL_SWAP, memory->swap_kb,
+                                      -1);
+}
+
+typedef struct {
+    guint count;
+    long size_kb;
+    ProcMemory memory;
+} MappingGroup;
+
+static void fill_memory_map(MemoryMap *map) {
+    gboolean grouped = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(map->group_toggle));
+    ProcMemory total;
+    memset(&total, 0, sizeof(total));
+
+    gtk_tree_view_set_model(GTK_TREE_VIEW(map->view), NULL);
+    gtk_list_store_clear(map->store);
+    GHashTable *groups = grouped ? g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free) : NULL;
+    for (guint i = 0; i < map->mappings->len; i++) {
+        MemoryMapping *mapping = &g_array_index(map->mappings, MemoryMapping, i);
+        const char *name = mapping->name[0] ? mapping->name : "[anon]";
+        add_mapping(mapping, &total);
+        if (!grouped) {
+            insert_mapping_row(map, mapping->range, mapping->perms, name, mapping->size_kb, &mapping->memory);
+            continue;
+        }
+
+        MappingGroup *group = g_hash_table_lookup(groups, name);
+        if (!group) {
+            group = g_new0(MappingGroup, 1);
+            g_hash_table_insert(groups, (gpointer)name, group);
+        }
+        group->count++;
+        group->size_kb += mapping->size_kb;
+        add_mapping(mapping, &group->memory);
+    }
+    if (grouped) {
+        GHashTableIter iter;
+        gpointer key, value;
+        g_hash_table_iter_init(&iter, groups);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            MappingGroup *group = value;
+            char count[32];
+            snprintf(count, sizeof(count), group->count == 1 ? "%u mapping" : "%u mappings", group->count);
+            insert_mapping_row(map, count, "", key, group->size_kb, &group->memory);
+        }
+        g_hash_table_destroy(groups);
+    }
+    gtk_tree_view_set_model(GTK_TREE_VIEW(map->view), GTK_TREE_MODEL(map->store));
+
+    char text[256];
+    snprintf(text, sizeof(text), "%u mappings: RSS %ld KB, PSS %ld KB, private %ld KB, anonymous %ld KB, swap %ld KB",
+             map->mappings->len, total.rss_kb, total.pss_kb, total.uss_kb, total.anon_kb, total.swap_kb);
+    gtk_label_set_text(GTK_LABEL(map->status_label), text);
+}
+
+static gboolean on_memory_map_read(gpointer user_data) {
+    MemoryMapRead *read = user_data;
+    MemoryMap *map = read->map;
+
+    map->busy = FALSE;
+    if (!map->closed) {
+        if (map->mappings) g_array_free(map->mappings, TRUE);
+        map->mappings = read->mappings;
+        fill_memory_map(map);
+    } else {
+        g_array_free(read->mappings, TRUE);
+    }
+    g_free(read);
+    memory_map_unref(map);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer run_memory_map_read(gpointer user_data) {
+    MemoryMapRead *read = user_data;
+    parse_smaps(read->fd, append_mapping, read->mappings);
+    g_idle_add(on_memory_map_read, read);
+    return NULL;
+}
+
+static int open_smaps(int pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps", pid);
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+// Reads smaps from fd (owned from here on) on a worker thread
+static void start_memory_map_read(MemoryMap *map, int fd) {
+    MemoryMapRead *read = g_new0(MemoryMapRead, 1);
+    read->map = map;
+    read->fd = fd;
+    read->mappings = g_array_new(FALSE, FALSE, sizeof(MemoryMapping));
+    map->busy = TRUE;
+    map->refs++;
+    g_thread_unref(g_thread_new("smaps-map", run_memory_map_read, read));
+}
+
+static void on_memory_map_response(GtkDialog *dialog, gint response_id, gpointer user_data) {
+    MemoryMap *map = user_data;
+    if (response_id != MEMORY_MAP_RESPONSE_REFRESH) return;
+
+    g_signal_stop_emission_by_name(dialog, "response");
+    if (map->busy) return;
+    int fd = open_smaps(map->pid);
+    if (fd < 0) {
+        char text[128];
+        snprintf(text, sizeof(text), "Cannot read process %d: %s", map->pid, g_strerror(errno));
+        gtk_label_set_text(GTK_LABEL(map->status_label), text);
+        return;
+    }
+    gtk_label_set_text(GTK_LABEL(map->status_label), "Reading smaps…");
+    start_memory_map_read(map, fd);
+}
+
+static void on_memory_map_group_toggled(GtkToggleButton *button, gpointer user_data) {
+    MemoryMap *map = user_data;
+    if (map->mappings) fill_memory_map(map);
+}
+
+static void on_memory_map_destroy(GtkWidget *widget, gpointer user_data) {
+    MemoryMap *map = user_data;
+    map->closed = TRUE;
+    memory_map_unref(map);
+}
+
+static void add_map_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    if (column_id >= MAP_COL_SIZE) {
+        g_object_set(renderer, "xalign", 1.0, NULL);
+    }
+    if (column_id == MAP_COL_NAME) {
+        gtk_tree_view_column_set_expand(column, TRUE);
+    }
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+// NULL with errno set when the process's smaps cannot be opened
+GtkWidget* create_memory_map_dialog(GtkWindow *parent, int pid) {
+    int fd = open_smaps(pid);
+    if (fd < 0) return NULL;
+
+    MemoryMap *map = g_new0(MemoryMap, 1);
+    map->pid = pid;
+    map->refs = 1;
+
+    char path[64], comm[64] = "";
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    FILE *file = fopen(path, "r");
+    if (file) {
+        if (fgets(comm, sizeof(comm), file)) g_strchomp(comm);
+        fclose(file);
+    }
+    char title[128];
+    snprintf(title, sizeof(title), "Memory Map: %s (%d)", comm, pid);
+
+    map->dialog = gtk_dialog_new_with_buttons(title,
+                                              parent,
+                                              GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                              "_Refresh", MEMORY_MAP_RESPONSE_REFRESH,
+                                              "_Close", GTK_RESPONSE_CLOSE,
+                                              NULL);
+    gtk_window_set_default_size(GTK_WINDOW(map->dialog), 1000, 600);
+    gtk_window_set_resizable(GTK_WINDOW(map->dialog), TRUE);
+    GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(map->dialog));
+
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_margin_top(hbox, 10);
+    gtk_widget_set_margin_left(hbox, 10);
+    gtk_widget_set_margin_right(hbox, 10);
+    map->group_toggle = gtk_check_button_new_with_label("Group by file");
+    gtk_box_pack_start(GTK_BOX(hbox), map->group_toggle, FALSE, FALSE, 0);
+    map->status_label = gtk_label_new("Reading smaps…");
+    gtk_label_set_ellipsize(GTK_LABEL(map->status_label), PANGO_ELLIPSIZE_END);
+    gtk_box_pack_end(GTK_BOX(hbox), map->status_label, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(content_area), hbox, FALSE, FALSE, 0);
+
+    map->store = gtk_list_store_new(MAP_N_COLUMNS,
+                                    G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                    G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(map->store), MAP_COL_PSS, GTK_SORT_DESCENDING);
+    map->view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(map->store));
+    add_map_column(map->view, "Address", MAP_COL_RANGE);
+    add_map_column(map->view, "Perms", MAP_COL_PERMS);
+    add_map_column(map->view, "Mapping", MAP_COL_NAME);
+    add_map_column(map->view, "Size (KB)", MAP_COL_SIZE);
+    add_map_column(map->view, "RSS (KB)", MAP_COL_RSS);
+    add_map_column(map->view, "PSS (KB)", MAP_COL_PSS);
+    add_map_column(map->view, "Private (KB)", MAP_COL_PRIVATE);
+    add_map_column(map->view, "Anon (KB)", MAP_COL_ANON);
+    add_map_column(map->view, "Swap (KB)", MAP_COL_SWAP);
+    gtk_tree_view_set_enable_search(GTK_TREE_VIEW(map->view), FALSE);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_hexpand(scrolled, TRUE);
+    gtk_widget_set_vexpand(scrolled, TRUE);
+    gtk_widget_set_margin_top(scrolled, 10);
+    gtk_widget_set_margin_bottom(scrolled, 10);
+    gtk_widget_set_margin_left(scrolled, 10);
+    gtk_widget_set_margin_right(scrolled, 10);
+    gtk_container_add(GTK_CONTAINER(scrolled), map->view);
+    gtk_box_pack_start(GTK_BOX(content_area), scrolled, TRUE, TRUE, 0);
+
+    g_signal_connect(map->group_toggle, "toggled", G_CALLBACK(on_memory_map_group_toggled), map);
+    g_signal_connect(map->dialog, "response", G_CALLBACK(on_memory_map_response), map);
+    g_signal_connect(map->dialog, "destroy", G_CALLBACK(on_memory_map_destroy), map);
+    start_memory_map_read(map, fd);
+
+    gtk_widget_show_all(map->dialog);
+    return map->dialog;
+}
@@ -0,0 +1,559 @@
+// proc_scanner.c
+// Incremental /proc reader behind get_process_list. Pids are listed with
+// getdents64 on a /proc dirfd that stays open; each process keeps its stat
+// and statm files open between refreshes, so a refresh costs two preads per
+// process into preallocated buffers, parsed by hand, and a third for its io
+// file while I/O is tracked. Processes past the descriptor budget have their
+// files opened and closed again on every refresh instead. A process is
+// opened (and its owner looked up) only when it first appears. With proc connector
+// events (proc_events.c) even the listing is skipped: known processes are
+// re-read and creations/exits are applied one at a time.
+//
+// CPU% comes from the change in utime+stime between two refreshes over the
+// monotonic time between them. Samples belong to a (pid, starttime) pair,
+// so a reused pid never inherits its predecessor's counters.
+//
+// I/O rates work the same way on the counters of /proc/<pid>/io, which is
+// only opened while proc_scanner_track_io() is on. That file is only
+// readable for the caller's own processes (or with root), so other
+// processes simply report no I/O data; a process seen for the first time
+// reports zero rates until its second sample.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <pwd.h>
+
+#define PROC_DENTS_BUFFER (64 * 1024)
+#define PROC_READ_BUFFER 4096
+
+typedef struct {
+    int pid;
+    guint64 starttime;      // clock ticks after boot; tells a reused pid apart
+    int stat_fd;            // /proc/<pid>/stat, -1 when fds ran out
+    int statm_fd;           // /proc/<pid>/statm
+    int io_fd;              // /proc/<pid>/io, -1 when not readable or not tracked
+    gboolean io_denied;     // opening io failed for good, e.g. EACCES
+    uid_t uid;
+    char name[256];
+    char state;
+    int ppid;
+    long memory_kb;
+    guint64 cpu_ticks;      // utime + stime at the last sample
+    gint64 sampled_at;      // monotonic microseconds of that sample
+    float cpu_percent;
+    gboolean io_available;
+    guint64 io_read_bytes;
+    guint64 io_write_bytes;
+    guint64 io_syscr;
+    guint64 io_syscw;
+    gint64 io_sampled_at;   // 0 until the first readable io sample
+    float io_read_rate;
+    float io_write_rate;
+    float io_syscr_rate;
+    float io_syscw_rate;
+    guint generation;       // last refresh that saw this pid
+} ProcEntry;
+
+struct _ProcScanner {
+    int proc_fd;
+    GHashTable *entries;    // pid -> ProcEntry*
+    GHashTable *users;      // uid -> user name
+    GArray *order;          // ProcEntry* in /proc listing order
+    gboolean order_dirty;   // entries added or removed since order was built
+    guint generation;
+    gboolean track_io;      // read /proc/<pid>/io as well
+    long page_kb;
+    long ticks_per_second;
+    int uptime_fd;          // /proc/uptime, for first-sample averages
+    double uptime;          // seconds, read once per refresh
+    gint64 now;             // monotonic microseconds of this refresh
+    char *dents;
+    char buffer[PROC_READ_BUFFER];
+};
+
+typedef struct {
+    guint64 d_ino;
+    gint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+} LinuxDirent64;
+
+// Descriptors kept open by all scanners, against a budget of half the
+// soft RLIMIT_NOFILE: two per process, three while its I/O is tracked. The
+// limit itself is left alone: children started from the shell inherit it,
+// and select()-based programs break above FD_SETSIZE. Processes beyond the
+// budget are reopened on every refresh.
+static gint cached_fds = 0;
+static gint cached_fd_budget = 0;
+
+static void close_cached_fd(int fd) {
+    if (fd < 0) return;
+    close(fd);
+    g_atomic_int_add(&cached_fds, -1);
+}
+
+static void close_entry_fds(ProcEntry *entry) {
+    close_cached_fd(entry->stat_fd);
+    close_cached_fd(entry->statm_fd);
+    close_cached_fd(entry->io_fd);
+    entry->stat_fd = entry->statm_fd = entry->io_fd = -1;
+}
+
+static void free_entry(gpointer data) {
+    close_entry_fds(data);
+    g_free(data);
+}
+
+static void init_fd_budget(void) {
+    static gsize initialized = 0;
+    if (!g_once_init_enter(&initialized)) return;
+
+    struct rlimit limit;
+    rlim_t soft = getrlimit(RLIMIT_NOFILE, &limit) == 0 ? limit.rlim_cur : 1024;
+    if (soft == RLIM_INFINITY || soft > G_MAXINT) soft = G_MAXINT;
+    cached_fd_budget = (gint)(soft / 2);
+    g_once_init_leave(&initialized, 1);
+}
+
+ProcScanner* proc_scanner_new(void) {
+    int proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd < 0) return NULL;
+
+    init_fd_budget();
+
+    ProcScanner *scanner = g_new0(ProcScanner, 1);
+    scanner->proc_fd = proc_fd;
+    scanner->entries = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_entry);
+    scanner->users = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    scanner->order = g_array_new(FALSE, FALSE, sizeof(ProcEntry *));
+    scanner->page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    scanner->ticks_per_second = sysconf(_SC_CLK_TCK);
+    scanner->uptime_fd = openat(proc_fd, "uptime", O_RDONLY | O_CLOEXEC);
+    scanner->dents = g_malloc(PROC_DENTS_BUFFER);
+    return scanner;
+}
+
+void proc_scanner_free(ProcScanner *scanner) {
+    if (!scanner) return;
+    g_hash_table_destroy(scanner->entries);
+    g_hash_table_destroy(scanner->users);
+    g_array_free(scanner->order, TRUE);
+    g_free(scanner->dents);
+    if (scanner->uptime_fd >= 0) close(scanner->uptime_fd);
+    close(scanner->proc_fd);
+    g_free(scanner);
+}
+
+static const char* user_name(ProcScanner *scanner, uid_t uid) {
+    const char *name = g_hash_table_lookup(scanner->users, GUINT_TO_POINTER(uid));
+    if (name) return name;
+
+    struct passwd pw, *result = NULL;
+    char buf[1024];
+    char *resolved = (getpwuid_r(uid, &pw, buf, sizeof(buf), &result) == 0 && result)
+        ? g_strdup(pw.pw_name)
+        : g_strdup_printf("%u", (unsigned)uid);
+    g_hash_table_insert(scanner->users, GUINT_TO_POINTER(uid), resolved);
+    return resolved;
+}
+
+// Whole file from offset 0 into the scanner buffer, NUL-terminated
+static gssize read_file(ProcScanner *scanner, int fd) {
+    gssize n;
+    do {
+        n = pread(fd, scanner->buffer, sizeof(scanner->buffer) - 1, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n >= 0) scanner->buffer[n] = '\0';
+    return n;
+}
+
+// /proc/<pid>/<name> relative to the /proc dirfd
+static int open_proc_file(ProcScanner *scanner, int pid, const char *name) {
+    char path[64];
+    snprintf(path, sizeof(path), "%d/%s", pid, name);
+    return openat(scanner->proc_fd, path, O_RDONLY | O_CLOEXEC);
+}
+
+static const char* skip_fields(const char *p, int count) {
+    while (count-- > 0 && *p) {
+        while (*p == ' ') p++;
+        while (*p && *p != ' ') p++;
+    }
+    while (*p == ' ') p++;
+    return p;
+}
+
+static guint64 parse_u64(const char **p) {
+    guint64 value = 0;
+    while (**p == ' ') (*p)++;
+    while (**p >= '0' && **p <= '9') {
+        value = value * 10 + (**p - '0');
+        (*p)++;
+    }
+    return value;
+}
+
+// "pid (comm) S ppid ... utime stime ... starttime ..."; comm may itself
+// contain ") ", so fields are counted from the last parenthesis
+static gboolean parse_stat(ProcEntry *entry, const char *text, guint64 *cpu_ticks, guint64 *starttime) {
+    const char *open_paren = strchr(text, '(');
+    const char *close_paren = strrchr(text, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) return FALSE;
+
+    gsize name_len = MIN((gsize)(close_paren - open_paren - 1), sizeof(entry->name) - 1);
+    memcpy(entry->name, open_paren + 1, name_len);
+    entry->name[name_len] = '\0';
+
+    const char *p = close_paren + 1;
+    while (*p == ' ') p++;
+    entry->state = *p ? *p : '?';
+    p = skip_fields(p, 1);
+    entry->ppid = (int)parse_u64(&p);
+
+    // utime and stime are fields 14 and 15, starttime is 22
+    p = skip_fields(p, 9);
+    *cpu_ticks = parse_u64(&p);
+    *cpu_ticks += parse_u64(&p);
+    p = skip_fields(p, 6);
+    *starttime = parse_u64(&p);
+    return TRUE;
+}
+
+// Look up the owner of a newly seen process and keep its files open.
+// FALSE if it already exited.
+static gboolean open_entry(ProcScanner *scanner, ProcEntry *entry, const char *pid_name) {
+    struct stat st;
+    if (fstatat(scanner->proc_fd, pid_name, &st, 0) != 0) return FALSE;
+    entry->uid = st.st_uid;
+
+    // Over budget: left closed, the files are reopened on every refresh
+    if (g_atomic_int_add(&cached_fds, 2) + 2 > cached_fd_budget) {
+        g_atomic_int_add(&cached_fds, -2);
+        return TRUE;
+    }
+
+    entry->stat_fd = open_proc_file(scanner, entry->pid, "stat");
+    if (entry->stat_fd >= 0) {
+        entry->statm_fd = open_proc_file(scanner, entry->pid, "statm");
+    }
+    // Both were counted up front; give back those that did not open
+    g_atomic_int_add(&cached_fds, -((entry->stat_fd < 0) + (entry->statm_fd < 0)));
+    if (entry->stat_fd < 0 || entry->statm_fd < 0) {
+        gboolean out_of_fds = errno == EMFILE || errno == ENFILE;
+        close_entry_fds(entry);
+        // Out of descriptors: the files are reopened on every refresh instead
+        return out_of_fds;
+    }
+    return TRUE;
+}
+
+static void update_cpu(ProcScanner *scanner, ProcEntry *entry, guint64 cpu_ticks) {
+    double cpu_seconds;
+    double elapsed;
+    if (entry->sampled_at) {
+        cpu_seconds = (double)(cpu_ticks - MIN(cpu_ticks, entry->cpu_ticks)) / scanner->ticks_per_second;
+        elapsed = (scanner->now - entry->sampled_at) / (double)G_USEC_PER_SEC;
+    } else {
+        // First sight: average over the process lifetime
+        cpu_seconds = (double)cpu_ticks / scanner->ticks_per_second;
+        elapsed = scanner->uptime - (double)entry->starttime / scanner->ticks_per_second;
+    }
+    if (elapsed > 0) {
+        entry->cpu_percent = cpu_seconds / elapsed * 100.0;
+    }
+    entry->cpu_ticks = cpu_ticks;
+    entry->sampled_at = scanner->now;
+}
+
+static guint64 io_field(const char *text, const char *key) {
+    const char *p = strstr(text, key);
+    if (!p) return 0;
+    p += strlen(key);
+    return parse_u64(&p);
+}
+
+static float io_rate(guint64 value, guint64 previous, double elapsed) {
+    return (float)((value - MIN(value, previous)) / elapsed);
+}
+
+// "rchar: ...\nwchar: ...\nsyscr: ...\nsyscw: ...\nread_bytes: ...\nwrite_bytes: ..."
+static void update_io(ProcScanner *scanner, ProcEntry *entry, int io_fd) {
+    // Reads are permission-checked too, e.g. after exec of a setuid binary
+    entry->io_available = io_fd >= 0 && read_file(scanner, io_fd) > 0;
+    if (!entry->io_available) {
+        entry->io_read_rate = entry->io_write_rate = 0;
+        entry->io_syscr_rate = entry->io_syscw_rate = 0;
+        entry->io_sampled_at = 0;
+        return;
+    }
+
+    const char *text = scanner->buffer;
+    guint64 syscr = io_field(text, "syscr: ");
+    guint64 syscw = io_field(text, "syscw: ");
+    guint64 read_bytes = io_field(text, "\nread_bytes: ");
+    guint64 write_bytes = io_field(text, "\nwrite_bytes: ");
+
+    double elapsed = (scanner->now - entry->io_sampled_at) / (double)G_USEC_PER_SEC;
+    if (entry->io_sampled_at && elapsed > 0) {
+        entry->io_read_rate = io_rate(read_bytes, entry->io_read_bytes, elapsed);
+        entry->io_write_rate = io_rate(write_bytes, entry->io_write_bytes, elapsed);
+        entry->io_syscr_rate = io_rate(syscr, entry->io_syscr, elapsed);
+        entry->io_syscw_rate = io_rate(syscw, entry->io_syscw, elapsed);
+    }
+    entry->io_read_bytes = read_bytes;
+    entry->io_write_bytes = write_bytes;
+    entry->io_syscr = syscr;
+    entry->io_syscw = syscw;
+    entry->io_sampled_at = scanner->now;
+}
+
+// The io file of an entry while I/O is tracked, -1 otherwise. It is kept
+// open next to stat and statm while the budget allows; *transient is set
+// when it was opened for this read only.
+static int open_entry_io(ProcScanner *scanner, ProcEntry *entry, gboolean *transient) {
+    *transient = FALSE;
+    if (!scanner->track_io || entry->io_fd >= 0 || entry->io_denied) return entry->io_fd;
+
+    gboolean cache = entry->stat_fd >= 0;
+    if (cache && g_atomic_int_add(&cached_fds, 1) + 1 > cached_fd_budget) {
+        g_atomic_int_add(&cached_fds, -1);
+        cache = FALSE;
+    }
+    int io_fd = open_proc_file(scanner, entry->pid, "io");
+    if (io_fd < 0) {
+        if (cache) g_atomic_int_add(&cached_fds, -1);
+        // Running out of descriptors passes, EACCES does not
+        entry->io_denied = errno != EMFILE && errno != ENFILE;
+        return -1;
+    }
+    if (cache) {
+        entry->io_fd = io_fd;
+    } else {
+        *transient = TRUE;
+    }
+    return io_fd;
+}
+
+// Read the current values of an entry; FALSE once the process is gone
+static gboolean read_entry(ProcScanner *scanner, ProcEntry *entry) {
+    gboolean transient = entry->stat_fd < 0;
+    int stat_fd = transient ? open_proc_file(scanner, entry->pid, "stat") : entry->stat_fd;
+    int statm_fd = transient ? open_proc_file(scanner, entry->pid, "statm") : entry->statm_fd;
+
+    guint64 cpu_ticks = 0, starttime = 0;
+    gboolean alive = stat_fd >= 0 && read_file(scanner, stat_fd) > 0 &&
+                     parse_stat(entry, scanner->buffer, &cpu_ticks, &starttime) &&
+                     (!entry->starttime || starttime == entry->starttime);
+    if (alive) {
+        entry->starttime = starttime;
+        update_cpu(scanner, entry, cpu_ticks);
+        entry->memory_kb = 0;
+        if (statm_fd >= 0 && read_file(scanner, statm_fd) > 0) {
+            const char *p = scanner->buffer;
+            parse_u64(&p);  // total program size, then resident pages
+            entry->memory_kb = (long)parse_u64(&p) * scanner->page_kb;
+        }
+        gboolean io_transient;
+        int io_fd = open_entry_io(scanner, entry, &io_transient);
+        update_io(scanner, entry, io_fd);
+        if (io_transient) close(io_fd);
+    }
+
+    if (transient) {
+        if (stat_fd >= 0) close(stat_fd);
+        if (statm_fd >= 0) close(statm_fd);
+    }
+    return alive;
+}
+
+// Refresh a process; descriptors that point at an exited process read as
+// ESRCH, so a pid reused since the last refresh is simply reopened
+static ProcEntry* refresh_pid(ProcScanner *scanner, int pid, const char *pid_name) {
+    ProcEntry *entry = g_hash_table_lookup(scanner->entries, GINT_TO_POINTER(pid));
+    if (entry && read_entry(scanner, entry)) return entry;
+
+    if (entry) {
+        g_hash_table_remove(scanner->entries, GINT_TO_POINTER(pid));
+    }
+
+    entry = g_new0(ProcEntry, 1);
+    entry->pid = pid;
+    entry->stat_fd = entry->statm_fd = entry->io_fd = -1;
+    if (!open_entry(scanner, entry, pid_name) || !read_entry(scanner, entry)) {
+        free_entry(entry);
+        return NULL;
+    }
+    g_hash_table_insert(scanner->entries, GINT_TO_POINTER(pid), entry);
+    return entry;
+}
+
+// Read /proc/<pid>/io from the next refresh on, or stop reading it and
+// close the io files kept open
+void proc_scanner_track_io(ProcScanner *scanner, gboolean enabled) {
+    if (!scanner || scanner->track_io == enabled) return;
+    scanner->track_io = enabled;
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, scanner->entries);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        ProcEntry *entry = value;
+        close_cached_fd(entry->io_fd);
+        entry->io_fd = -1;
+        // Counters from before the pause would make the first rate wrong
+        entry->io_sampled_at = 0;
+    }
+}
+
+static gboolean is_stale(gpointer key, gpointer value, gpointer user_data) {
+    ProcEntry *entry = value;
+    return entry->generation != GPOINTER_TO_UINT(user_data);
+}
+
+static void begin_sample(ProcScanner *scanner) {
+    scanner->generation++;
+    scanner->now = g_get_monotonic_time();
+    if (scanner->uptime_fd >= 0 && read_file(scanner, scanner->uptime_fd) > 0) {
+        scanner->uptime = g_ascii_strtod(scanner->buffer, NULL);
+    }
+}
+
+// Rescan /proc; returns the number of live processes
+int proc_scanner_refresh(ProcScanner *scanner) {
+    if (!scanner) return 0;
+
+    begin_sample(scanner);
+    g_array_set_size(scanner->order, 0);
+    scanner->order_dirty = FALSE;
+    lseek(scanner->proc_fd, 0, SEEK_SET);
+
+    long n;
+    while ((n = syscall(SYS_getdents64, scanner->proc_fd, scanner->dents, PROC_DENTS_BUFFER)) > 0) {
+        for (long offset = 0; offset < n;) {
+            LinuxDirent64 *dent = (LinuxDirent64 *)(scanner->dents + offset);
+            offset += dent->d_reclen;
+
+            int pid = 0;
+            const char *c = dent->d_name;
+            while (*c >= '0' && *c <= '9') pid = pid * 10 + (*c++ - '0');
+            if (*c != '\0' || pid <= 0) continue;
+
+            ProcEntry *entry = refresh_pid(scanner, pid, dent->d_name);
+            if (entry) {
+                entry->generation = scanner->generation;
+                g_array_append_val(scanner->order, entry);
+            }
+        }
+    }
+
+    g_hash_table_foreach_remove(scanner->entries, is_stale, GUINT_TO_POINTER(scanner->generation));
+    return scanner->order->len;
+}
+
+// Re-read the processes already known without listing /proc, for when
+// process creation is tracked through proc_scanner_apply
+int proc_scanner_update(ProcScanner *scanner) {
+    if (!scanner) return 0;
+
+    begin_sample(scanner);
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, scanner->entries);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        if (read_entry(scanner, value)) {
+            ((ProcEntry *)value)->generation = scanner->generation;
+        } else {
+            g_hash_table_iter_remove(&iter);
+            scanner->order_dirty = TRUE;
+        }
+    }
+    return g_hash_table_size(scanner->entries);
+}
+
+// Apply a single process event without rescanning
+void proc_scanner_apply(ProcScanner *scanner, ProcChange change, int pid) {
+    if (!scanner || pid <= 0) return;
+
+    scanner->order_dirty = TRUE;
+    if (change == PROC_CHANGE_EXITED) {
+        g_hash_table_remove(scanner->entries, GINT_TO_POINTER(pid));
+        return;
+    }
+
+    // exec may change the owner (setuid), so the process is opened afresh
+    if (change == PROC_CHANGE_EXEC) {
+        g_hash_table_remove(scanner->entries, GINT_TO_POINTER(pid));
+    }
+    char pid_name[16];
+    snprintf(pid_name, sizeof(pid_name), "%d", pid);
+    ProcEntry *entry = refresh_pid(scanner, pid, pid_name);
+    if (entry) {
+        entry->generation = scanner->generation;
+    }
+}
+
+static void fill_process_info(ProcScanner *scanner, ProcEntry *entry, ProcessInfo *proc) {
+    proc->pid = entry->pid;
+    g_strlcpy(proc->name, entry->name, sizeof(proc->name));
+    proc->state = entry->state;
+    proc->ppid = entry->ppid;
+    proc->cpu_percent = entry->cpu_percent;
+    proc->memory_kb = entry->memory_kb;
+    g_strlcpy(proc->user, user_name(scanner, entry->uid), sizeof(proc->user));
+    proc->io_available = entry->io_available;
+    proc->io_read_bytes = entry->io_read_bytes;
+    proc->io_write_bytes = entry->io_write_bytes;
+    proc->io_syscr = entry->io_syscr;
+    proc->io_syscw = entry->io_syscw;
+    proc->io_read_rate = entry->io_read_rate;
+    proc->io_write_rate = entry->io_write_rate;
+    proc->io_syscr_rate = entry->io_syscr_rate;
+    proc->io_syscw_rate = entry->io_syscw_rate;
+}
+
+gboolean proc_scanner_lookup(ProcScanner *scanner, int pid, ProcessInfo *proc) {
+    ProcEntry *entry = scanner ? g_hash_table_lookup(scanner->entries, GINT_TO_POINTER(pid)) : NULL;
+    if (!entry) return FALSE;
+    fill_process_info(scanner, entry, proc);
+    return TRUE;
+}
+
+static gint compare_entry_pid(gconstpointer a, gconstpointer b) {
+    const ProcEntry *ea = *(ProcEntry * const *)a;
+    const ProcEntry *eb = *(ProcEntry * const *)b;
+    return ea->pid - eb->pid;
+}
+
+// Copy of the current table, in /proc (pid) order; free() the array
+int proc_scanner_snapshot(ProcScanner *scanner, ProcessInfo **processes) {
+    if (scanner && scanner->order_dirty) {
+        // Events changed the table since the last listing
+        g_array_set_size(scanner->order, 0);
+        GHashTableIter iter;
+        gpointer value;
+        g_hash_table_iter_init(&iter, scanner->entries);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            g_array_append_val(scanner->order, value);
+        }
+        g_array_sort(scanner->order, compare_entry_pid);
+        scanner->order_dirty = FALSE;
+    }
+
+    int count = scanner ? (int)scanner->order->len : 0;
+    ProcessInfo *list = malloc(MAX(count, 1) * sizeof(ProcessInfo));
+    if (!list) {
+        *processes = NULL;
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        fill_process_info(scanner, g_array_index(scanner->order, ProcEntry *, i), &list[i]);
+    }
+
+    *processes = list;
+    return count;
+}
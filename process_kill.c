@@ -0,0 +1,237 @@
+// process_kill.c
+// Asynchronous process termination. A kill target holds a pidfd opened when
+// the process was picked, so the signals reach that process even if its pid
+// is reused while the user confirms. The kill sends SIGTERM and watches the
+// pidfd from the main loop: it turns readable when the process exits. If it
+// is still alive when the escalation timeout fires, SIGKILL follows. Nothing
+// blocks, so any number of kills can run at once. Kernels without pidfd_open
+// (before 5.3) fall back to kill() and a short polling timer.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <signal.h>
+#include <poll.h>
+#include <sys/syscall.h>
+
+#define KILL_POLL_MS 100            // exit check interval without a pidfd
+#define KILL_GIVE_UP_MS 5000        // after SIGKILL, e.g. stuck in D state
+
+struct _ProcessKillTarget {
+    int pid;
+    int pidfd;                      // -1 when polling with kill(pid, 0)
+    int open_error;                 // pidfd_open failure other than ENOSYS
+};
+
+typedef struct {
+    int pid;
+    int pidfd;                      // -1 when polling with kill(pid, 0)
+    gboolean escalated;
+    guint exit_source;
+    guint timeout_source;
+    ProcessKillFunc func;           // NULL once the caller lost interest
+    gpointer user_data;
+} PendingKill;
+
+static GList *pending_kills = NULL;
+
+static int pidfd_open(int pid) {
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static int pidfd_send_signal(int pidfd, int sig) {
+#ifdef SYS_pidfd_send_signal
+    return syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static int send_signal(PendingKill *pending, int sig) {
+    return pending->pidfd >= 0 ? pidfd_send_signal(pending->pidfd, sig) : kill(pending->pid, sig);
+}
+
+static void finish_kill(PendingKill *pending, ProcessKillResult result, int error) {
+    if (pending->exit_source) g_source_remove(pending->exit_source);
+    if (pending->timeout_source) g_source_remove(pending->timeout_source);
+    if (pending->pidfd >= 0) close(pending->pidfd);
+    pending_kills = g_list_remove(pending_kills, pending);
+
+    if (pending->func) {
+        pending->func(pending->pid, result, error, pending->user_data);
+    }
+    g_free(pending);
+}
+
+static void report_exit(PendingKill *pending) {
+    pending->exit_source = 0;
+    finish_kill(pending, pending->escalated ? PROCESS_KILL_KILLED : PROCESS_KILL_TERMINATED, 0);
+}
+
+static gboolean on_pidfd_readable(gint fd, GIOCondition condition, gpointer user_data) {
+    report_exit(user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean on_exit_poll(gpointer user_data) {
+    PendingKill *pending = user_data;
+    if (kill(pending->pid, 0) == 0 || errno == EPERM) return G_SOURCE_CONTINUE;
+    report_exit(pending);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean on_kill_timeout(gpointer user_data) {
+    PendingKill *pending = user_data;
+    pending->timeout_source = 0;
+
+    if (pending->escalated) {
+        finish_kill(pending, PROCESS_KILL_FAILED, ETIMEDOUT);
+        return G_SOURCE_REMOVE;
+    }
+
+    // ESRCH: it exited just now and the exit is about to be reported
+    if (send_signal(pending, SIGKILL) == 0) {
+        pending->escalated = TRUE;
+    } else if (errno != ESRCH) {
+        finish_kill(pending, PROCESS_KILL_FAILED, errno);
+        return G_SOURCE_REMOVE;
+    }
+    pending->timeout_source = g_timeout_add(KILL_GIVE_UP_MS, on_kill_timeout, pending);
+    return G_SOURCE_REMOVE;
+}
+
+// Escalation timeout used when none is given: COMMAND_SPHERE_KILL_TIMEOUT_MS
+// from the environment, or two seconds
+guint process_kill_default_timeout(void) {
+    const char *env = getenv("COMMAND_SPHERE_KILL_TIMEOUT_MS");
+    guint timeout_ms = env ? (guint)strtoul(env, NULL, 10) : 0;
+    return timeout_ms > 0 ? timeout_ms : PROCESS_KILL_DEFAULT_TIMEOUT_MS;
+}
+
+// Pins the process behind pid for a later process_kill_start. Without
+// pidfd_open the target falls back to the bare pid; if the process is
+// already gone, starting the kill reports that.
+ProcessKillTarget* process_kill_target_new(int pid) {
+    ProcessKillTarget *target = g_new0(ProcessKillTarget, 1);
+    target->pid = pid;
+    target->pidfd = pid > 0 ? pidfd_open(pid) : -1;
+    if (pid <= 0) {
+        target->open_error = EINVAL;
+    } else if (target->pidfd < 0 && errno != ENOSYS) {
+        target->open_error = errno;
+    }
+    return target;
+}
+
+int process_kill_target_pid(const ProcessKillTarget *target) {
+    return target->pid;
+}
+
+void process_kill_target_free(ProcessKillTarget *target) {
+    if (!target) return;
+    if (target->pidfd >= 0) close(target->pidfd);
+    g_free(target);
+}
+
+// Sends SIGTERM to the target and SIGKILL after escalate_ms (0 for the
+// default) if it is still running; func is called from the main loop once
+// the process is gone or the kill failed. Takes ownership of target.
+// Returns FALSE with errno set if the process could not be signalled at all
+// (ESRCH, EPERM), without calling func.
+gboolean process_kill_start(ProcessKillTarget *target, guint escalate_ms, ProcessKillFunc func, gpointer user_data) {
+    PendingKill *pending = g_new0(PendingKill, 1);
+    pending->pid = target->pid;
+    pending->pidfd = target->pidfd;
+    pending->func = func;
+    pending->user_data = user_data;
+    int error = target->open_error;
+    g_free(target);
+
+    if (error == 0 && send_signal(pending, SIGTERM) != 0) error = errno;
+    if (error != 0) {
+        if (pending->pidfd >= 0) close(pending->pidfd);
+        g_free(pending);
+        errno = error;
+        return FALSE;
+    }
+
+    if (pending->pidfd >= 0) {
+        pending->exit_source = g_unix_fd_add(pending->pidfd, G_IO_IN, on_pidfd_readable, pending);
+    } else {
+        pending->exit_source = g_timeout_add(KILL_POLL_MS, on_exit_poll, pending);
+    }
+    pending->timeout_source = g_timeout_add(escalate_ms ? escalate_ms : process_kill_default_timeout(),
+                                            on_kill_timeout, pending);
+    pending_kills = g_list_prepend(pending_kills, pending);
+    return TRUE;
+}
+
+// process_kill_start for a pid picked just now
+gboolean process_kill_async(int pid, guint escalate_ms, ProcessKillFunc func, gpointer user_data) {
+    return process_kill_start(process_kill_target_new(pid), escalate_ms, func, user_data);
+}
+
+// Kills already started keep running, but no longer report to user_data
+void process_kill_forget(gpointer user_data) {
+    for (GList *l = pending_kills; l; l = l->next) {
+        PendingKill *pending = l->data;
+        if (pending->user_data == user_data) pending->func = NULL;
+    }
+}
+
+const char* process_kill_result_name(ProcessKillResult result) {
+    switch (result) {
+        case PROCESS_KILL_TERMINATED: return "terminated";
+        case PROCESS_KILL_KILLED: return "killed";
+        default: return "failed";
+    }
+}
+
+// Blocking variant for callers outside the main loop: waits on the pidfd
+// for up to escalate_ms instead of sleeping a fixed time. errno is set when
+// the result is PROCESS_KILL_FAILED.
+ProcessKillResult process_kill_sync(int pid, guint escalate_ms) {
+    int pidfd = pidfd_open(pid);
+    if (pidfd < 0 && errno != ENOSYS) return PROCESS_KILL_FAILED;
+
+    int sent = pidfd >= 0 ? pidfd_send_signal(pidfd, SIGTERM) : kill(pid, SIGTERM);
+    if (sent != 0) {
+        int error = errno;
+        if (pidfd >= 0) close(pidfd);
+        errno = error;
+        return PROCESS_KILL_FAILED;
+    }
+
+    gboolean exited = FALSE;
+    gint64 deadline = g_get_monotonic_time() + (gint64)escalate_ms * 1000;
+    while (!exited) {
+        gint64 remaining = (deadline - g_get_monotonic_time()) / 1000;
+        if (remaining <= 0) break;
+        if (pidfd >= 0) {
+            struct pollfd pfd = { .fd = pidfd, .events = POLLIN };
+            int ready = poll(&pfd, 1, (int)remaining);
+            if (ready < 0 && errno == EINTR) continue;
+            exited = ready > 0;
+            if (ready < 0) break;
+        } else {
+            exited = kill(pid, 0) != 0 && errno == ESRCH;
+            if (!exited) g_usleep(MIN(remaining, KILL_POLL_MS) * 1000);
+        }
+    }
+
+    ProcessKillResult result = PROCESS_KILL_TERMINATED;
+    int error = 0;
+    if (!exited) {
+        sent = pidfd >= 0 ? pidfd_send_signal(pidfd, SIGKILL) : kill(pid, SIGKILL);
+        error = sent == 0 ? 0 : errno;
+        result = (sent == 0 || error == ESRCH) ? PROCESS_KILL_KILLED : PROCESS_KILL_FAILED;
+    }
+    if (pidfd >= 0) close(pidfd);
+    errno = error;
+    return result;
+}
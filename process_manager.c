@@ -0,0 +1,1278 @@
+// process_manager.c
+// Live Process Manager dialog. Processes live in a GtkListStore that is
+// updated in place on a timer: rows are inserted for new pids, removed for
+// exited ones and only rewritten when a value changed. /proc is scanned on a
+// worker thread and the rows are synced on the main loop once it is done. With proc connector
+// events, starts and exits are applied as they happen. The view runs in
+// fixed-height mode, so GTK only measures and draws the visible rows; the
+// name filter and column sorting are layered on as filter/sort models.
+//
+// Tree mode shows the same processes in a GtkTreeStore nested by ppid, with
+// each row also carrying the CPU and memory of its whole subtree. Each
+// refresh links children to parents through the pid hash, orders the
+// forest once and sums subtrees in reverse of that order, so the rollup is
+// O(n); rows are only moved when a process was reparented. Process events
+// are applied to the tree directly: a start inserts one row under its
+// parent and an exit removes one, re-nesting its children.
+//
+// Several rows can be selected and killed at once; each kill runs
+// asynchronously (process_kill.c) and reports back into the kill label.
+//
+// I/O top mode ranks the flat list by current disk throughput from
+// /proc/<pid>/io and hides processes that did no I/O since the previous
+// refresh, like iotop -o. The io files are only read while the mode is on.
+//
+// The PSS, USS, anonymous and swap columns come from smaps_rollup
+// (proc_memory.c). Reading it walks the page tables, so a background cache
+// reads each process at most every few seconds and the rows pick up
+// whatever it has. Only the rows on screen and the largest processes by
+// RSS are read; Memory Map opens the per-mapping breakdown.
+
+#include "custom_shell.h"
+
+#define PROCESS_REFRESH_SECONDS 2
+#define PROCESS_RESPONSE_REFRESH 1
+#define PROCESS_SMAPS_TOP 32        // largest by RSS, read even when scrolled away
+
+enum {
+    PROCESS_COL_PID,
+    PROCESS_COL_NAME,
+    PROCESS_COL_USER,
+    PROCESS_COL_CPU,
+    PROCESS_COL_MEMORY,
+    PROCESS_COL_STATE,
+    PROCESS_COL_PPID,
+    PROCESS_COL_TREE_CPU,       // subtree totals, tree mode only
+    PROCESS_COL_TREE_MEMORY,
+    PROCESS_COL_IO_TOTAL,       // bytes/s, -1 when /proc/<pid>/io is unreadable
+    PROCESS_COL_IO_READ,
+    PROCESS_COL_IO_WRITE,
+    PROCESS_COL_IO_SYSCALLS,    // read + write syscalls/s
+    PROCESS_COL_PSS,            // KB, -1 until smaps_rollup was read
+    PROCESS_COL_USS,
+    PROCESS_COL_ANON,
+    PROCESS_COL_SWAP,
+    PROCESS_N_COLUMNS
+};
+
+// What the store currently shows for a pid, to skip unchanged rows
+typedef struct {
+    GtkTreeIter iter;       // GtkListStore iters persist while the row exists
+    float cpu_percent;
+    long memory_kb;
+    char state;
+    float io_read_rate;
+    float io_write_rate;
+    float io_syscalls_rate;
+    ProcMemory proportional;    // -1 fields until read
+    guint generation;
+} ProcessRow;
+
+// A process in tree mode
+typedef struct _ProcessNode ProcessNode;
+struct _ProcessNode {
+    int pid;
+    int ppid;
+    char name[256];
+    char user[64];
+    char state;
+    float cpu_percent;
+    long memory_kb;
+    float tree_cpu;         // this process and all its descendants
+    long tree_memory_kb;
+    gboolean matches;       // it or a descendant passes the name filter
+    guint generation;
+
+    GtkTreeIter iter;       // GtkTreeStore iters persist while the row exists
+    gboolean has_row;
+    int shown_parent;       // pid the row is nested under, 0 at top level
+    float shown_cpu;        // values the row holds, to skip unchanged rows
+    float shown_tree_cpu;
+    long shown_memory_kb;
+    long shown_tree_memory_kb;
+    char shown_state;
+    gboolean shown_matches; // as last seen by the filter model
+
+    // Rebuilt on every refresh, kept current by process events in between
+    ProcessNode *parent;
+    ProcessNode *first_child;
+    ProcessNode *next_sibling;
+};
+
+typedef struct {
+    GtkWidget *dialog;
+    GtkListStore *store;
+    GtkTreeModel *filter;
+    GtkTreeModel *sort;
+    GtkTreeStore *tree_store;
+    GtkTreeModel *tree_filter;
+    GtkTreeModel *tree_sort;
+    GHashTable *nodes;      // pid -> ProcessNode*, tree mode only
+    GPtrArray *order;       // ProcessNode* parents before children
+    gboolean tree_mode;
+    GtkTreeViewColumn *tree_columns[2];
+    GtkWidget *tree_toggle;
+    gboolean io_mode;
+    GtkWidget *io_toggle;
+    GtkTreeViewColumn *io_columns[4];
+    double io_read_total;   // bytes/s over all readable processes
+    double io_write_total;
+    int io_unreadable;      // processes whose io file is not readable
+    ProcMemoryCache *memory;    // smaps_rollup figures, read in the background
+    GArray *smaps_top;          // pids of the PROCESS_SMAPS_TOP largest processes
+    GtkTreeViewColumn *memory_columns[4];
+    GtkWidget *view;
+    GtkWidget *search_entry;
+    GtkWidget *status_label;
+    GtkWidget *kill_label;
+    GtkWidget *kill_timeout;    // seconds before SIGTERM escalates to SIGKILL
+    guint kills_pending;
+    guint kills_terminated;
+    guint kills_killed;
+    guint kills_failed;
+    char *kill_error;           // first failure of the current batch
+    GHashTable *rows;       // pid -> ProcessRow*
+    guint generation;
+    guint timer;
+    guint watch;            // process event subscription, 0 when polling
+    guint status_idle;
+    char *filter_text;      // casefolded, NULL when empty
+    gboolean busy;          // a scan is running on the worker
+    gboolean dirty;         // a refresh was asked for while it was running
+    gboolean closed;
+    int refs;               // the dialog and a running scan
+} ProcessManager;
+
+typedef struct {
+    ProcessManager *pm;
+    ProcessInfo *processes;
+    int count;
+} ProcessScan;
+
+static gboolean confirm_kill(GtkWindow *parent, GPtrArray *targets, GPtrArray *names) {
+    GtkWidget *confirm_dialog;
+    if (targets->len == 1) {
+        confirm_dialog = gtk_message_dialog_new(parent,
+                                                GTK_DIALOG_MODAL,
+                                                GTK_MESSAGE_QUESTION,
+                                                GTK_BUTTONS_YES_NO,
+                                                "Are you sure you want to kill process %d (%s)?",
+                                                process_kill_target_pid(g_ptr_array_index(targets, 0)),
+                                                (char *)g_ptr_array_index(names, 0));
+    } else {
+        GString *list = g_string_new(NULL);
+        for (guint i = 0; i < targets->len && i < 10; i++) {
+            g_string_append_printf(list, "%d %s\n", process_kill_target_pid(g_ptr_array_index(targets, i)),
+                                   (char *)g_ptr_array_index(names, i));
+        }
+        if (targets->len > 10) g_string_append_printf(list, "and %u more", targets->len - 10);
+        confirm_dialog = gtk_message_dialog_new(parent,
+                                                GTK_DIALOG_MODAL,
+                                                GTK_MESSAGE_QUESTION,
+                                                GTK_BUTTONS_YES_NO,
+                                                "Are you sure you want to kill %u processes?", targets->len);
+        gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(confirm_dialog), "%s", list->str);
+        g_string_free(list, TRUE);
+    }
+
+    int response = gtk_dialog_run(GTK_DIALOG(confirm_dialog));
+    gtk_widget_destroy(confirm_dialog);
+    return response == GTK_RESPONSE_YES;
+}
+
+static void update_kill_label(ProcessManager *pm) {
+    GString *text = g_string_new(NULL);
+    if (pm->kills_pending > 0) {
+        g_string_append_printf(text, "Killing %u… ", pm->kills_pending);
+    }
+    if (pm->kills_terminated > 0) g_string_append_printf(text, "%u terminated ", pm->kills_terminated);
+    if (pm->kills_killed > 0) g_string_append_printf(text, "%u killed ", pm->kills_killed);
+    if (pm->kills_failed > 0) {
+        g_string_append_printf(text, "%u failed (%s)", pm->kills_failed, pm->kill_error);
+    }
+    gtk_label_set_text(GTK_LABEL(pm->kill_label), text->str);
+    g_string_free(text, TRUE);
+}
+
+static void record_kill_failure(ProcessManager *pm, int pid, int error) {
+    pm->kills_failed++;
+    if (!pm->kill_error) {
+        pm->kill_error = g_strdup_printf("pid %d: %s", pid, g_strerror(error));
+    }
+}
+
+static void update_status(ProcessManager *pm) {
+    char text[256];
+    int total = g_hash_table_size(pm->tree_mode ? pm->nodes : pm->rows);
+    int shown = pm->tree_mode ? total : gtk_tree_model_iter_n_children(pm->filter, NULL);
+    if (pm->io_mode) {
+        char *read = g_format_size((guint64)pm->io_read_total);
+        char *write = g_format_size((guint64)pm->io_write_total);
+        int length = snprintf(text, sizeof(text), "%d of %d processes doing I/O, read %s/s, write %s/s",
+                              shown, total, read, write);
+        if (pm->io_unreadable > 0) {
+            snprintf(text + length, sizeof(text) - length, " (%d not readable without root)", pm->io_unreadable);
+        }
+        g_free(read);
+        g_free(write);
+    } else if (shown == total) {
+        snprintf(text, sizeof(text), "%d processes", total);
+    } else {
+        snprintf(text, sizeof(text), "%d of %d processes", shown, total);
+    }
+    gtk_label_set_text(GTK_LABEL(pm->status_label), text);
+}
+
+// Insert or update the row of one process. exec'd processes also get
+// their name and owner rewritten.
+static void set_process_row(ProcessManager *pm, const ProcessInfo *proc, gboolean exec) {
+    ProcessRow *row = g_hash_table_lookup(pm->rows, GINT_TO_POINTER(proc->pid));
+    char state[2] = { proc->state, '\0' };
+    float io_read = proc->io_available ? proc->io_read_rate : -1;
+    float io_write = proc->io_available ? proc->io_write_rate : -1;
+    float io_syscalls = proc->io_available ? proc->io_syscr_rate + proc->io_syscw_rate : -1;
+    float io_total = proc->io_available ? io_read + io_write : -1;
+    ProcMemory proportional;
+    if (!proc_memory_cache_lookup(pm->memory, proc->pid, &proportional)) {
+        proportional.pss_kb = proportional.uss_kb = proportional.anon_kb = proportional.swap_kb = -1;
+    }
+
+    if (!row) {
+        row = g_new0(ProcessRow, 1);
+        gtk_list_store_insert_with_values(pm->store, &row->iter, -1,
+                                          PROCESS_COL_PID, proc->pid,
+                                          PROCESS_COL_NAME, proc->name,
+                                          PROCESS_COL_USER, proc->user,
+                                          PROCESS_COL_CPU, proc->cpu_percent,
+                                          PROCESS_COL_MEMORY, proc->memory_kb,
+                                          PROCESS_COL_STATE, state,
+                                          PROCESS_COL_PPID, proc->ppid,
+                                          PROCESS_COL_IO_TOTAL, io_total,
+                                          PROCESS_COL_IO_READ, io_read,
+                                          PROCESS_COL_IO_WRITE, io_write,
+                                          PROCESS_COL_IO_SYSCALLS, io_syscalls,
+                                          PROCESS_COL_PSS, proportional.pss_kb,
+                                          PROCESS_COL_USS, proportional.uss_kb,
+                                          PROCESS_COL_ANON, proportional.anon_kb,
+                                          PROCESS_COL_SWAP, proportional.swap_kb,
+                                          -1);
+        g_hash_table_insert(pm->rows, GINT_TO_POINTER(proc->pid), row);
+    } else if (exec) {
+        gtk_list_store_set(pm->store, &row->iter,
+                           PROCESS_COL_NAME, proc->name,
+                           PROCESS_COL_USER, proc->user,
+                           PROCESS_COL_CPU, proc->cpu_percent,
+                           PROCESS_COL_MEMORY, proc->memory_kb,
+                           PROCESS_COL_STATE, state,
+                           PROCESS_COL_IO_TOTAL, io_total,
+                           PROCESS_COL_IO_READ, io_read,
+                           PROCESS_COL_IO_WRITE, io_write,
+                           PROCESS_COL_IO_SYSCALLS, io_syscalls,
+                           PROCESS_COL_PSS, proportional.pss_kb,
+                           PROCESS_COL_USS, proportional.uss_kb,
+                           PROCESS_COL_ANON, proportional.anon_kb,
+                           PROCESS_COL_SWAP, proportional.swap_kb,
+                           -1);
+    } else if (ABS(row->cpu_percent - proc->cpu_percent) >= 0.05f ||
+               row->memory_kb != proc->memory_kb || row->state != proc->state ||
+               row->io_read_rate != io_read || row->io_write_rate != io_write ||
+               row->io_syscalls_rate != io_syscalls ||
+               row->proportional.pss_kb != proportional.pss_kb || row->proportional.uss_kb != proportional.uss_kb ||
+               row->proportional.anon_kb != proportional.anon_kb || row->proportional.swap_kb != proportional.swap_kb) {
+        gtk_list_store_set(pm->store, &row->iter,
+                           PROCESS_COL_CPU, proc->cpu_percent,
+                           PROCESS_COL_MEMORY, proc->memory_kb,
+                           PROCESS_COL_STATE, state,
+                           PROCESS_COL_IO_TOTAL, io_total,
+                           PROCESS_COL_IO_READ, io_read,
+                           PROCESS_COL_IO_WRITE, io_write,
+                           PROCESS_COL_IO_SYSCALLS, io_syscalls,
+                           PROCESS_COL_PSS, proportional.pss_kb,
+                           PROCESS_COL_USS, proportional.uss_kb,
+                           PROCESS_COL_ANON, proportional.anon_kb,
+                           PROCESS_COL_SWAP, proportional.swap_kb,
+                           -1);
+    }
+    row->cpu_percent = proc->cpu_percent;
+    row->memory_kb = proc->memory_kb;
+    row->state = proc->state;
+    row->io_read_rate = io_read;
+    row->io_write_rate = io_write;
+    row->io_syscalls_rate = io_syscalls;
+    row->proportional = proportional;
+    row->generation = pm->generation;
+}
+
+static void remove_process_row(ProcessManager *pm, int pid) {
+    ProcessRow *row = g_hash_table_lookup(pm->rows, GINT_TO_POINTER(pid));
+    if (row) {
+        gtk_list_store_remove(pm->store, &row->iter);
+        g_hash_table_remove(pm->rows, GINT_TO_POINTER(pid));
+    }
+}
+
+static gint compare_memory_desc(gconstpointer a, gconstpointer b) {
+    const ProcessInfo *pa = *(ProcessInfo * const *)a;
+    const ProcessInfo *pb = *(ProcessInfo * const *)b;
+    return (pb->memory_kb > pa->memory_kb) - (pb->memory_kb < pa->memory_kb);
+}
+
+static void remember_largest(ProcessManager *pm, ProcessInfo *processes, int count) {
+    GPtrArray *by_memory = g_ptr_array_sized_new(count);
+    for (int i = 0; i < count; i++) g_ptr_array_add(by_memory, &processes[i]);
+    g_ptr_array_sort(by_memory, compare_memory_desc);
+
+    g_array_set_size(pm->smaps_top, 0);
+    for (guint i = 0; i < by_memory->len && i < PROCESS_SMAPS_TOP; i++) {
+        g_array_append_val(pm->smaps_top, ((ProcessInfo *)g_ptr_array_index(by_memory, i))->pid);
+    }
+    g_ptr_array_free(by_memory, TRUE);
+}
+
+// smaps_rollup is only read for the rows on screen and the largest
+// processes, which sorting by PSS or USS brings to the top anyway
+static void request_proportional_memory(ProcessManager *pm) {
+    GArray *pids = g_array_new(FALSE, FALSE, sizeof(int));
+    g_array_append_vals(pids, pm->smaps_top->data, pm->smaps_top->len);
+
+    GtkTreePath *start, *end;
+    GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(pm->view));
+    if (model == pm->sort && gtk_tree_view_get_visible_range(GTK_TREE_VIEW(pm->view), &start, &end)) {
+        GtkTreeIter iter;
+        gboolean valid = gtk_tree_model_get_iter(model, &iter, start);
+        for (int i = gtk_tree_path_get_indices(start)[0]; valid && i <= gtk_tree_path_get_indices(end)[0]; i++) {
+            int pid = 0;
+            gtk_tree_model_get(model, &iter, PROCESS_COL_PID, &pid, -1);
+            g_array_append_val(pids, pid);
+            valid = gtk_tree_model_iter_next(model, &iter);
+        }
+        gtk_tree_path_free(start);
+        gtk_tree_path_free(end);
+    }
+    proc_memory_cache_request(pm->memory, (int *)pids->data, pids->len);
+    g_array_free(pids, TRUE);
+}
+
+static void on_process_view_scrolled(GtkAdjustment *adjustment, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    if (!pm->tree_mode) request_proportional_memory(pm);
+}
+
+// Sync the list store with a fresh scan, touching only rows that changed
+static void refresh_process_list(ProcessManager *pm, ProcessInfo *processes, int count) {
+    pm->generation++;
+    pm->io_read_total = pm->io_write_total = 0;
+    pm->io_unreadable = 0;
+    int *pids = g_new(int, count);
+    for (int i = 0; i < count; i++) {
+        pids[i] = processes[i].pid;
+        set_process_row(pm, &processes[i], FALSE);
+        if (processes[i].io_available) {
+            pm->io_read_total += processes[i].io_read_rate;
+            pm->io_write_total += processes[i].io_write_rate;
+        } else {
+            pm->io_unreadable++;
+        }
+    }
+    // Read now, shown from the next refresh on
+    proc_memory_cache_retain(pm->memory, pids, count);
+    g_free(pids);
+    remember_largest(pm, processes, count);
+    request_proportional_memory(pm);
+
+    // Drop rows of processes that exited
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, pm->rows);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        ProcessRow *row = value;
+        if (row->generation != pm->generation) {
+            gtk_list_store_remove(pm->store, &row->iter);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+}
+
+static gboolean name_matches(ProcessManager *pm, const char *name) {
+    if (!pm->filter_text) return TRUE;
+    char *folded = g_utf8_casefold(name, -1);
+    gboolean matches = strstr(folded, pm->filter_text) != NULL;
+    g_free(folded);
+    return matches;
+}
+
+// Removing a row takes its descendants' rows with it
+static void forget_tree_rows(ProcessManager *pm, GtkTreeIter *parent) {
+    GtkTreeModel *model = GTK_TREE_MODEL(pm->tree_store);
+    GtkTreeIter child;
+    if (!gtk_tree_model_iter_children(model, &child, parent)) return;
+    do {
+        int pid = 0;
+        gtk_tree_model_get(model, &child, PROCESS_COL_PID, &pid, -1);
+        ProcessNode *node = g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(pid));
+        if (node) node->has_row = FALSE;
+        forget_tree_rows(pm, &child);
+    } while (gtk_tree_model_iter_next(model, &child));
+}
+
+static void remove_tree_row(ProcessManager *pm, ProcessNode *node) {
+    if (!node->has_row) return;
+    forget_tree_rows(pm, &node->iter);
+    gtk_tree_store_remove(pm->tree_store, &node->iter);
+    node->has_row = FALSE;
+}
+
+// Parents are synced before their children, so a parent row always exists
+static void sync_tree_row(ProcessManager *pm, ProcessNode *node) {
+    int parent_pid = node->parent ? node->parent->pid : 0;
+    char state[2] = { node->state, '\0' };
+
+    if (node->has_row && node->shown_parent != parent_pid) {
+        remove_tree_row(pm, node);  // reparented, e.g. to init after its parent exited
+    }
+    if (!node->has_row) {
+        gtk_tree_store_insert_with_values(pm->tree_store, &node->iter,
+                                          node->parent ? &node->parent->iter : NULL, -1,
+                                          PROCESS_COL_PID, node->pid,
+                                          PROCESS_COL_NAME, node->name,
+                                          PROCESS_COL_USER, node->user,
+                                          PROCESS_COL_CPU, node->cpu_percent,
+                                          PROCESS_COL_MEMORY, node->memory_kb,
+                                          PROCESS_COL_STATE, state,
+                                          PROCESS_COL_PPID, node->ppid,
+                                          PROCESS_COL_TREE_CPU, node->tree_cpu,
+                                          PROCESS_COL_TREE_MEMORY, node->tree_memory_kb,
+                                          -1);
+        node->has_row = TRUE;
+        node->shown_parent = parent_pid;
+    } else if (ABS(node->shown_cpu - node->cpu_percent) >= 0.05f ||
+               ABS(node->shown_tree_cpu - node->tree_cpu) >= 0.05f ||
+               node->shown_memory_kb != node->memory_kb ||
+               node->shown_tree_memory_kb != node->tree_memory_kb ||
+               node->shown_state != node->state) {
+        gtk_tree_store_set(pm->tree_store, &node->iter,
+                           PROCESS_COL_CPU, node->cpu_percent,
+                           PROCESS_COL_MEMORY, node->memory_kb,
+                           PROCESS_COL_STATE, state,
+                           PROCESS_COL_TREE_CPU, node->tree_cpu,
+                           PROCESS_COL_TREE_MEMORY, node->tree_memory_kb,
+                           -1);
+    } else {
+        return;
+    }
+    node->shown_cpu = node->cpu_percent;
+    node->shown_tree_cpu = node->tree_cpu;
+    node->shown_memory_kb = node->memory_kb;
+    node->shown_tree_memory_kb = node->tree_memory_kb;
+    node->shown_state = node->state;
+}
+
+// Own match or a descendant's, children first (reverse of pm->order).
+// TRUE if the filter model has to be told about changed flags.
+static gboolean update_tree_matches(ProcessManager *pm) {
+    for (guint i = 0; i < pm->order->len; i++) {
+        ProcessNode *node = g_ptr_array_index(pm->order, i);
+        node->matches = name_matches(pm, node->name);
+    }
+    gboolean changed = FALSE;
+    for (guint i = pm->order->len; i > 0; i--) {
+        ProcessNode *node = g_ptr_array_index(pm->order, i - 1);
+        if (node->matches && node->parent) node->parent->matches = TRUE;
+        if (node->matches != node->shown_matches) changed = TRUE;
+        node->shown_matches = node->matches;
+    }
+    return changed;
+}
+
+// Sync the tree store with a fresh scan
+static void refresh_process_tree(ProcessManager *pm, ProcessInfo *processes, int count) {
+    pm->generation++;
+    for (int i = 0; i < count; i++) {
+        const ProcessInfo *proc = &processes[i];
+        ProcessNode *node = g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(proc->pid));
+        if (!node) {
+            node = g_new0(ProcessNode, 1);
+            node->pid = proc->pid;
+            g_hash_table_insert(pm->nodes, GINT_TO_POINTER(proc->pid), node);
+        } else if (node->has_row && strcmp(node->name, proc->name) != 0) {
+            gtk_tree_store_set(pm->tree_store, &node->iter,
+                               PROCESS_COL_NAME, proc->name,
+                               PROCESS_COL_USER, proc->user,
+                               -1);    // exec'd
+        }
+        g_strlcpy(node->name, proc->name, sizeof(node->name));
+        g_strlcpy(node->user, proc->user, sizeof(node->user));
+        node->ppid = proc->ppid;
+        node->state = proc->state;
+        node->cpu_percent = proc->cpu_percent;
+        node->memory_kb = proc->memory_kb;
+        node->generation = pm->generation;
+        node->first_child = node->next_sibling = NULL;
+    }
+
+    // Exited processes; their surviving children are re-nested below
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, pm->nodes);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        ProcessNode *node = value;
+        if (node->generation != pm->generation) {
+            remove_tree_row(pm, node);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+
+    // Link children to parents, then order the forest parents first
+    GPtrArray *roots = g_ptr_array_new();
+    for (int i = 0; i < count; i++) {
+        ProcessNode *node = g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(processes[i].pid));
+        node->parent = node->ppid != node->pid
+            ? g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(node->ppid))
+            : NULL;
+        if (node->parent) {
+            node->next_sibling = node->parent->first_child;
+            node->parent->first_child = node;
+        } else {
+            g_ptr_array_add(roots, node);
+        }
+    }
+
+    g_ptr_array_set_size(pm->order, 0);
+    GPtrArray *stack = g_ptr_array_new();
+    for (guint i = roots->len; i > 0; i--) {
+        g_ptr_array_add(stack, g_ptr_array_index(roots, i - 1));
+    }
+    while (stack->len > 0) {
+        ProcessNode *node = g_ptr_array_index(stack, stack->len - 1);
+        g_ptr_array_set_size(stack, stack->len - 1);
+        g_ptr_array_add(pm->order, node);
+        for (ProcessNode *child = node->first_child; child; child = child->next_sibling) {
+            g_ptr_array_add(stack, child);
+        }
+    }
+    g_ptr_array_free(stack, TRUE);
+    g_ptr_array_free(roots, TRUE);
+
+    gboolean matches_changed = update_tree_matches(pm);
+
+    // Subtree totals, children before parents
+    for (guint i = 0; i < pm->order->len; i++) {
+        ProcessNode *node = g_ptr_array_index(pm->order, i);
+        node->tree_cpu = node->cpu_percent;
+        node->tree_memory_kb = node->memory_kb;
+    }
+    for (guint i = pm->order->len; i > 0; i--) {
+        ProcessNode *node = g_ptr_array_index(pm->order, i - 1);
+        if (node->parent) {
+            node->parent->tree_cpu += node->tree_cpu;
+            node->parent->tree_memory_kb += node->tree_memory_kb;
+        }
+    }
+
+    for (guint i = 0; i < pm->order->len; i++) {
+        sync_tree_row(pm, g_ptr_array_index(pm->order, i));
+    }
+
+    if (matches_changed && pm->filter_text) {
+        gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(pm->tree_filter));
+    }
+}
+
+static void process_manager_unref(ProcessManager *pm) {
+    if (--pm->refs > 0) return;
+    proc_memory_cache_free(pm->memory);
+    g_array_free(pm->smaps_top, TRUE);
+    g_hash_table_destroy(pm->rows);
+    g_hash_table_destroy(pm->nodes);
+    g_ptr_array_free(pm->order, TRUE);
+    g_object_unref(pm->sort);
+    g_object_unref(pm->filter);
+    g_object_unref(pm->store);
+    g_object_unref(pm->tree_sort);
+    g_object_unref(pm->tree_filter);
+    g_object_unref(pm->tree_store);
+    g_free(pm->filter_text);
+    g_free(pm->kill_error);
+    g_free(pm);
+}
+
+static void refresh_processes(ProcessManager *pm);
+
+// Sync the model on screen with a finished scan
+static void apply_process_scan(ProcessManager *pm, ProcessScan *scan) {
+    // The first fill after opening or switching modes is detached, so the
+    // view is not updated per row
+    gboolean empty = g_hash_table_size(pm->tree_mode ? pm->nodes : pm->rows) == 0;
+    if (empty) gtk_tree_view_set_model(GTK_TREE_VIEW(pm->view), NULL);
+
+    if (pm->tree_mode) {
+        refresh_process_tree(pm, scan->processes, scan->count);
+    } else {
+        refresh_process_list(pm, scan->processes, scan->count);
+    }
+
+    if (empty) {
+        gtk_tree_view_set_model(GTK_TREE_VIEW(pm->view), pm->tree_mode ? pm->tree_sort : pm->sort);
+        if (pm->tree_mode) gtk_tree_view_expand_all(GTK_TREE_VIEW(pm->view));
+    }
+    update_status(pm);
+}
+
+static gboolean on_process_scan_done(gpointer user_data) {
+    ProcessScan *scan = user_data;
+    ProcessManager *pm = scan->pm;
+
+    pm->busy = FALSE;
+    if (!pm->closed) {
+        apply_process_scan(pm, scan);
+        // Asked for while this scan was running, so it may predate the request
+        if (pm->dirty) {
+            pm->dirty = FALSE;
+            refresh_processes(pm);
+        }
+    }
+    free(scan->processes);
+    g_free(scan);
+    process_manager_unref(pm);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer run_process_scan(gpointer user_data) {
+    ProcessScan *scan = user_data;
+    scan->count = get_process_list(&scan->processes);
+    g_idle_add(on_process_scan_done, scan);
+    return NULL;
+}
+
+static void refresh_processes(ProcessManager *pm) {
+    if (pm->busy) {
+        pm->dirty = TRUE;
+        return;
+    }
+
+    ProcessScan *scan = g_new0(ProcessScan, 1);
+    scan->pm = pm;
+    pm->busy = TRUE;
+    pm->refs++;
+    g_thread_unref(g_thread_new("process-scan", run_process_scan, scan));
+}
+
+static gboolean update_status_idle(gpointer user_data) {
+    ProcessManager *pm = user_data;
+    pm->status_idle = 0;
+    update_status(pm);
+    return G_SOURCE_REMOVE;
+}
+
+// Add a subtree's share to every ancestor's totals, or take it away
+static void add_to_ancestors(ProcessManager *pm, ProcessNode *parent, float cpu, long memory_kb) {
+    for (ProcessNode *node = parent; node; node = node->parent) {
+        node->tree_cpu += cpu;
+        node->tree_memory_kb += memory_kb;
+        sync_tree_row(pm, node);
+    }
+}
+
+static void link_tree_node(ProcessNode *node, ProcessNode *parent) {
+    node->parent = parent;
+    if (parent) {
+        node->next_sibling = parent->first_child;
+        parent->first_child = node;
+    }
+}
+
+static void unlink_tree_node(ProcessNode *node) {
+    if (!node->parent) return;
+    ProcessNode **link = &node->parent->first_child;
+    while (*link && *link != node) link = &(*link)->next_sibling;
+    if (*link) *link = node->next_sibling;
+    node->parent = node->next_sibling = NULL;
+}
+
+// Rows of a subtree whose rows went away with an ancestor's
+static void insert_tree_rows(ProcessManager *pm, ProcessNode *node) {
+    sync_tree_row(pm, node);
+    for (ProcessNode *child = node->first_child; child; child = child->next_sibling) {
+        insert_tree_rows(pm, child);
+    }
+}
+
+// A matching row keeps its ancestors visible; TRUE if any of them was hidden
+static gboolean show_tree_ancestors(ProcessNode *node) {
+    gboolean changed = FALSE;
+    for (ProcessNode *parent = node->parent; parent && !parent->matches; parent = parent->parent) {
+        parent->matches = parent->shown_matches = TRUE;
+        changed = TRUE;
+    }
+    return changed;
+}
+
+static gboolean apply_tree_start(ProcessManager *pm, int pid) {
+    ProcessInfo info;
+    if (g_hash_table_contains(pm->nodes, GINT_TO_POINTER(pid)) || !get_process_info(pid, &info)) {
+        return FALSE;
+    }
+    ProcessNode *node = g_new0(ProcessNode, 1);
+    node->pid = pid;
+    node->ppid = info.ppid;
+    g_strlcpy(node->name, info.name, sizeof(node->name));
+    g_strlcpy(node->user, info.user, sizeof(node->user));
+    node->state = info.state;
+    node->cpu_percent = node->tree_cpu = info.cpu_percent;
+    node->memory_kb = node->tree_memory_kb = info.memory_kb;
+    node->generation = pm->generation;
+    g_hash_table_insert(pm->nodes, GINT_TO_POINTER(pid), node);
+    g_ptr_array_add(pm->order, node);   // after its parent, which is already listed
+
+    link_tree_node(node, info.ppid != pid ? g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(info.ppid)) : NULL);
+    node->matches = node->shown_matches = name_matches(pm, node->name);
+    gboolean refilter = node->matches && show_tree_ancestors(node);
+    sync_tree_row(pm, node);
+    add_to_ancestors(pm, node->parent, node->tree_cpu, node->tree_memory_kb);
+    return refilter;
+}
+
+static gboolean apply_tree_exec(ProcessManager *pm, int pid) {
+    ProcessNode *node = g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(pid));
+    ProcessInfo info;
+    if (!node || !get_process_info(pid, &info)) return FALSE;
+    g_strlcpy(node->name, info.name, sizeof(node->name));
+    g_strlcpy(node->user, info.user, sizeof(node->user));
+    if (node->has_row) {
+        gtk_tree_store_set(pm->tree_store, &node->iter,
+                           PROCESS_COL_NAME, node->name,
+                           PROCESS_COL_USER, node->user,
+                           -1);
+    }
+    // A name that stops matching is only hidden by the next refresh
+    if (node->matches || !name_matches(pm, node->name)) return FALSE;
+    node->matches = node->shown_matches = TRUE;
+    show_tree_ancestors(node);
+    return TRUE;
+}
+
+// The kernel has already handed the children to init or a subreaper;
+// their rows are re-nested under whichever parent /proc now reports
+static gboolean apply_tree_exit(ProcessManager *pm, int pid) {
+    ProcessNode *node = g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(pid));
+    if (!node) return FALSE;
+
+    add_to_ancestors(pm, node->parent, -node->tree_cpu, -node->tree_memory_kb);
+    unlink_tree_node(node);
+    remove_tree_row(pm, node);
+
+    gboolean refilter = FALSE;
+    ProcessNode *child = node->first_child;
+    while (child) {
+        ProcessNode *next = child->next_sibling;
+        ProcessInfo info;
+        int ppid = get_process_info(child->pid, &info) ? info.ppid : 1;
+        child->ppid = ppid;
+        child->parent = child->next_sibling = NULL;
+        link_tree_node(child, ppid != child->pid ? g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(ppid)) : NULL);
+        insert_tree_rows(pm, child);
+        add_to_ancestors(pm, child->parent, child->tree_cpu, child->tree_memory_kb);
+        if (child->matches) refilter |= show_tree_ancestors(child);
+        child = next;
+    }
+
+    // pm->order may now list a re-nested child before its new parent;
+    // the next refresh rebuilds it
+    g_ptr_array_remove(pm->order, node);
+    g_hash_table_remove(pm->nodes, GINT_TO_POINTER(pid));
+    return refilter;
+}
+
+// Process started, exec'd or exited, as reported by the kernel
+static void on_process_changed(ProcChange change, int pid, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    ProcessInfo info;
+
+    if (pm->tree_mode) {
+        gboolean refilter;
+        if (change == PROC_CHANGE_EXITED) {
+            refilter = apply_tree_exit(pm, pid);
+        } else if (change == PROC_CHANGE_EXEC) {
+            refilter = apply_tree_exec(pm, pid);
+        } else {
+            refilter = apply_tree_start(pm, pid);
+        }
+        if (refilter && pm->filter_text) {
+            gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(pm->tree_filter));
+        }
+    } else if (change == PROC_CHANGE_EXITED) {
+        remove_process_row(pm, pid);
+    } else if (get_process_info(pid, &info)) {
+        set_process_row(pm, &info, change == PROC_CHANGE_EXEC);
+    }
+
+    // Fork storms deliver many events per main loop iteration
+    if (!pm->status_idle) {
+        pm->status_idle = g_idle_add(update_status_idle, pm);
+    }
+}
+
+static gboolean on_refresh_timer(gpointer user_data) {
+    ProcessManager *pm = user_data;
+    if (!pm->busy) refresh_processes(pm);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean process_visible(GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    if (pm->io_mode) {
+        float io_total = 0;
+        gtk_tree_model_get(model, iter, PROCESS_COL_IO_TOTAL, &io_total, -1);
+        if (io_total <= 0) return FALSE;
+    }
+    if (!pm->filter_text) return TRUE;
+
+    char *name = NULL;
+    gtk_tree_model_get(model, iter, PROCESS_COL_NAME, &name, -1);
+    char *folded = name ? g_utf8_casefold(name, -1) : NULL;
+    gboolean visible = folded && strstr(folded, pm->filter_text) != NULL;
+    g_free(folded);
+    g_free(name);
+    return visible;
+}
+
+// In tree mode a row stays visible while any of its descendants matches
+static gboolean tree_node_visible(GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    if (!pm->filter_text) return TRUE;
+
+    int pid = 0;
+    gtk_tree_model_get(model, iter, PROCESS_COL_PID, &pid, -1);
+    ProcessNode *node = g_hash_table_lookup(pm->nodes, GINT_TO_POINTER(pid));
+    return node && node->matches;
+}
+
+static void on_filter_changed(GtkSearchEntry *entry, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    const char *text = gtk_entry_get_text(GTK_ENTRY(entry));
+
+    g_free(pm->filter_text);
+    pm->filter_text = *text ? g_utf8_casefold(text, -1) : NULL;
+    if (pm->tree_mode) {
+        update_tree_matches(pm);
+        gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(pm->tree_filter));
+        if (pm->filter_text) gtk_tree_view_expand_all(GTK_TREE_VIEW(pm->view));
+    } else {
+        gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(pm->filter));
+    }
+    update_status(pm);
+}
+
+// Only the model on screen is kept current; the other one is emptied and
+// rebuilt from the next scan when switched back to
+static void on_tree_mode_toggled(GtkToggleButton *button, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    pm->tree_mode = gtk_toggle_button_get_active(button);
+    if (pm->tree_mode) {
+        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(pm->io_toggle), FALSE);
+    }
+
+    gtk_tree_view_set_model(GTK_TREE_VIEW(pm->view), NULL);
+    if (pm->tree_mode) {
+        gtk_list_store_clear(pm->store);
+        g_hash_table_remove_all(pm->rows);
+    } else {
+        gtk_tree_store_clear(pm->tree_store);
+        g_hash_table_remove_all(pm->nodes);
+        g_ptr_array_set_size(pm->order, 0);
+    }
+
+    gtk_tree_view_column_set_visible(pm->tree_columns[0], pm->tree_mode);
+    gtk_tree_view_column_set_visible(pm->tree_columns[1], pm->tree_mode);
+    for (gsize i = 0; i < G_N_ELEMENTS(pm->memory_columns); i++) {
+        gtk_tree_view_column_set_visible(pm->memory_columns[i], !pm->tree_mode);
+    }
+    gtk_tree_view_set_model(GTK_TREE_VIEW(pm->view), pm->tree_mode ? pm->tree_sort : pm->sort);
+    refresh_processes(pm);
+}
+
+// I/O top is a view of the flat list: processes doing I/O, busiest first
+static void on_io_mode_toggled(GtkToggleButton *button, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    gboolean io_mode = gtk_toggle_button_get_active(button);
+    if (io_mode == pm->io_mode) return;
+
+    if (io_mode) {
+        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(pm->tree_toggle), FALSE);
+    }
+    pm->io_mode = io_mode;
+    process_list_track_io(io_mode);
+    for (gsize i = 0; i < G_N_ELEMENTS(pm->io_columns); i++) {
+        gtk_tree_view_column_set_visible(pm->io_columns[i], io_mode);
+    }
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(pm->sort),
+                                         io_mode ? PROCESS_COL_IO_TOTAL : PROCESS_COL_CPU,
+                                         GTK_SORT_DESCENDING);
+    gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(pm->filter));
+    update_status(pm);
+    // Rates need two samples of the io files, so take the first one now
+    if (io_mode) refresh_processes(pm);
+}
+
+static void on_kill_finished(int pid, ProcessKillResult result, int error, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    pm->kills_pending--;
+    if (result == PROCESS_KILL_TERMINATED) {
+        pm->kills_terminated++;
+    } else if (result == PROCESS_KILL_KILLED) {
+        pm->kills_killed++;
+    } else {
+        record_kill_failure(pm, pid, error);
+    }
+    update_kill_label(pm);
+
+    // With process events the rows are already gone
+    if (pm->kills_pending == 0 && !pm->watch) {
+        refresh_processes(pm);
+    }
+}
+
+static void on_kill_selected_clicked(GtkButton *button, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(pm->view));
+    GtkTreeModel *model;
+    GList *selected = gtk_tree_selection_get_selected_rows(selection, &model);
+    GPtrArray *targets = g_ptr_array_new_with_free_func((GDestroyNotify)process_kill_target_free);
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+
+    // Pinned now, so a pid reused while the dialog is up is not signalled
+    for (GList *l = selected; l; l = l->next) {
+        GtkTreeIter iter;
+        int pid = 0;
+        char *name = NULL;
+        if (!gtk_tree_model_get_iter(model, &iter, l->data)) continue;
+        gtk_tree_model_get(model, &iter, PROCESS_COL_PID, &pid, PROCESS_COL_NAME, &name, -1);
+        if (pid > 1) {
+            g_ptr_array_add(targets, process_kill_target_new(pid));
+            g_ptr_array_add(names, name);
+        } else {
+            g_free(name);
+        }
+    }
+    g_list_free_full(selected, (GDestroyNotify)gtk_tree_path_free);
+
+    if (targets->len > 0 && confirm_kill(GTK_WINDOW(pm->dialog), targets, names)) {
+        // A new batch starts counting from zero
+        if (pm->kills_pending == 0) {
+            pm->kills_terminated = pm->kills_killed = pm->kills_failed = 0;
+            g_clear_pointer(&pm->kill_error, g_free);
+        }
+        guint timeout_ms = (guint)(gtk_spin_button_get_value(GTK_SPIN_BUTTON(pm->kill_timeout)) * 1000);
+        for (guint i = 0; i < targets->len; i++) {
+            ProcessKillTarget *target = g_ptr_array_index(targets, i);
+            int pid = process_kill_target_pid(target);
+            targets->pdata[i] = NULL;   // owned by the kill from here on
+            if (process_kill_start(target, timeout_ms, on_kill_finished, pm)) {
+                pm->kills_pending++;
+            } else {
+                record_kill_failure(pm, pid, errno);
+            }
+        }
+        update_kill_label(pm);
+    }
+    g_ptr_array_free(targets, TRUE);
+    g_ptr_array_free(names, TRUE);
+}
+
+// Pid of the selected row for per-process views; 0 unless exactly one
+// row is selected
+static int selected_pid(ProcessManager *pm) {
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(pm->view));
+    GtkTreeModel *model;
+    GList *selected = gtk_tree_selection_get_selected_rows(selection, &model);
+    GtkTreeIter iter;
+    int pid = 0;
+
+    if (selected && !selected->next && gtk_tree_model_get_iter(model, &iter, selected->data)) {
+        gtk_tree_model_get(model, &iter, PROCESS_COL_PID, &pid, -1);
+    }
+    g_list_free_full(selected, (GDestroyNotify)gtk_tree_path_free);
+    return pid;
+}
+
+static void on_trace_selected_clicked(GtkButton *button, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    int pid = selected_pid(pm);
+    if (pid <= 0) return;
+
+    GtkWidget *trace_dialog = create_syscall_trace_dialog(GTK_WINDOW(pm->dialog), pid);
+    if (!trace_dialog) {
+        int error = errno;
+        GtkWidget *message = gtk_message_dialog_new(GTK_WINDOW(pm->dialog),
+                                                    GTK_DIALOG_MODAL,
+                                                    GTK_MESSAGE_ERROR,
+                                                    GTK_BUTTONS_CLOSE,
+                                                    "Cannot trace process %d: %s", pid, g_strerror(error));
+        if (error == EPERM) {
+            gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(message),
+                                                     "Tracing needs CAP_SYS_PTRACE, or a process of the same "
+                                                     "user with kernel.yama.ptrace_scope set to 0.");
+        }
+        gtk_dialog_run(GTK_DIALOG(message));
+        gtk_widget_destroy(message);
+        return;
+    }
+    gtk_dialog_run(GTK_DIALOG(trace_dialog));
+    gtk_widget_destroy(trace_dialog);
+}
+
+static void on_memory_map_clicked(GtkButton *button, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    int pid = selected_pid(pm);
+    if (pid <= 0) return;
+
+    GtkWidget *map_dialog = create_memory_map_dialog(GTK_WINDOW(pm->dialog), pid);
+    if (!map_dialog) {
+        int error = errno;
+        GtkWidget *message = gtk_message_dialog_new(GTK_WINDOW(pm->dialog),
+                                                    GTK_DIALOG_MODAL,
+                                                    GTK_MESSAGE_ERROR,
+                                                    GTK_BUTTONS_CLOSE,
+                                                    "Cannot read the memory map of process %d: %s",
+                                                    pid, g_strerror(error));
+        if (error == EACCES || error == EPERM) {
+            gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(message),
+                                                     "Another user's memory map needs CAP_SYS_PTRACE.");
+        }
+        gtk_dialog_run(GTK_DIALOG(message));
+        gtk_widget_destroy(message);
+        return;
+    }
+    gtk_dialog_run(GTK_DIALOG(map_dialog));
+    gtk_widget_destroy(map_dialog);
+}
+
+// Refresh in place instead of closing the dialog
+static void on_process_dialog_response(GtkDialog *dialog, gint response_id, gpointer user_data) {
+    if (response_id == PROCESS_RESPONSE_REFRESH) {
+        refresh_processes(user_data);
+        g_signal_stop_emission_by_name(dialog, "response");
+    }
+}
+
+static void on_process_dialog_destroy(GtkWidget *widget, gpointer user_data) {
+    ProcessManager *pm = user_data;
+    pm->closed = TRUE;
+    process_kill_forget(pm);
+    g_source_remove(pm->timer);
+    if (pm->watch) process_list_unwatch(pm->watch);
+    if (pm->status_idle) g_source_remove(pm->status_idle);
+    if (pm->io_mode) process_list_track_io(FALSE);
+    process_manager_unref(pm);
+}
+
+static void cpu_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                          GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    float cpu = 0;
+    char text[16];
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &cpu, -1);
+    snprintf(text, sizeof(text), "%.1f", cpu);
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void io_rate_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                              GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    float rate = 0;
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &rate, -1);
+    if (rate < 0) {
+        g_object_set(renderer, "text", "-", NULL);
+    } else if (GPOINTER_TO_INT(user_data) == PROCESS_COL_IO_SYSCALLS) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.0f", rate);
+        g_object_set(renderer, "text", text, NULL);
+    } else {
+        char *size = g_format_size((guint64)rate);
+        char *text = g_strdup_printf("%s/s", size);
+        g_object_set(renderer, "text", text, NULL);
+        g_free(text);
+        g_free(size);
+    }
+}
+
+static void memory_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                             GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    long kb = 0;
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &kb, -1);
+    if (kb < 0) {
+        g_object_set(renderer, "text", "-", NULL);
+    } else {
+        char text[32];
+        snprintf(text, sizeof(text), "%ld", kb);
+        g_object_set(renderer, "text", text, NULL);
+    }
+}
+
+static GtkTreeViewColumn* add_process_column(ProcessManager *pm, const char *title, int column_id, int width,
+                                             GtkTreeCellDataFunc data_func) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column;
+
+    if (data_func) {
+        column = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(column, title);
+        gtk_tree_view_column_pack_start(column, renderer, TRUE);
+        gtk_tree_view_column_set_cell_data_func(column, renderer, data_func, GINT_TO_POINTER(column_id), NULL);
+    } else {
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    }
+    if (column_id != PROCESS_COL_NAME && column_id != PROCESS_COL_USER && column_id != PROCESS_COL_STATE) {
+        g_object_set(renderer, "xalign", 1.0, NULL);
+    }
+
+    // Fixed sizing lets the view skip measuring rows that are not shown
+    gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width(column, width);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(pm->view), column);
+    return column;
+}
+
+GtkWidget* create_process_manager_dialog(GtkWindow *parent) {
+    GtkWidget *dialog, *content_area, *scrolled, *hbox, *button, *trace_button, *map_button, *label;
+    ProcessManager *pm = g_new0(ProcessManager, 1);
+    pm->refs = 1;
+
+    dialog = gtk_dialog_new_with_buttons("Process Manager",
+                                         parent,
+                                         GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                         "_Refresh", PROCESS_RESPONSE_REFRESH,
+                                         "_Close", GTK_RESPONSE_CLOSE,
+                                         NULL);
+    pm->dialog = dialog;
+
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 1000, 700);
+    gtk_window_set_resizable(GTK_WINDOW(dialog), TRUE);
+
+    content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+
+    // Filter, kill and status bar
+    hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_margin_top(hbox, 10);
+    gtk_widget_set_margin_left(hbox, 10);
+    gtk_widget_set_margin_right(hbox, 10);
+    pm->search_entry = gtk_search_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(pm->search_entry), "Filter by name");
+    gtk_box_pack_start(GTK_BOX(hbox), pm->search_entry, FALSE, FALSE, 0);
+    button = gtk_button_new_with_label("Kill Selected");
+    gtk_box_pack_start(GTK_BOX(hbox), button, FALSE, FALSE, 0);
+    label = gtk_label_new("SIGKILL after");
+    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
+    pm->kill_timeout = gtk_spin_button_new_with_range(0.1, 60.0, 0.5);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(pm->kill_timeout), 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(pm->kill_timeout), process_kill_default_timeout() / 1000.0);
+    gtk_box_pack_start(GTK_BOX(hbox), pm->kill_timeout, FALSE, FALSE, 0);
+    label = gtk_label_new("s");
+    gtk_box_pack_start(GTK_BOX(hbox), label, FALSE, FALSE, 0);
+    trace_button = gtk_button_new_with_label("Trace Syscalls");
+    gtk_box_pack_start(GTK_BOX(hbox), trace_button, FALSE, FALSE, 0);
+    map_button = gtk_button_new_with_label("Memory Map");
+    gtk_box_pack_start(GTK_BOX(hbox), map_button, FALSE, FALSE, 0);
+    pm->tree_toggle = gtk_check_button_new_with_label("Tree view");
+    gtk_box_pack_start(GTK_BOX(hbox), pm->tree_toggle, FALSE, FALSE, 0);
+    pm->io_toggle = gtk_check_button_new_with_label("I/O top");
+    gtk_box_pack_start(GTK_BOX(hbox), pm->io_toggle, FALSE, FALSE, 0);
+    pm->status_label = gtk_label_new("");
+    gtk_box_pack_end(GTK_BOX(hbox), pm->status_label, FALSE, FALSE, 0);
+    pm->kill_label = gtk_label_new("");
+    gtk_label_set_ellipsize(GTK_LABEL(pm->kill_label), PANGO_ELLIPSIZE_END);
+    gtk_box_pack_end(GTK_BOX(hbox), pm->kill_label, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(content_area), hbox, FALSE, FALSE, 0);
+
+    // The view gets its model after the first fill, so thousands of
+    // initial inserts are not each propagated to it
+    pm->store = gtk_list_store_new(PROCESS_N_COLUMNS,
+                                   G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING,
+                                   G_TYPE_FLOAT, G_TYPE_LONG, G_TYPE_STRING, G_TYPE_INT,
+                                   G_TYPE_FLOAT, G_TYPE_LONG,
+                                   G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT,
+                                   G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG);
+    pm->rows = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    pm->tree_store = gtk_tree_store_new(PROCESS_N_COLUMNS,
+                                        G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING,
+                                        G_TYPE_FLOAT, G_TYPE_LONG, G_TYPE_STRING, G_TYPE_INT,
+                                        G_TYPE_FLOAT, G_TYPE_LONG,
+                                        G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT,
+                                        G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG, G_TYPE_LONG);
+    pm->nodes = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    pm->order = g_ptr_array_new();
+    pm->memory = proc_memory_cache_new();
+    pm->smaps_top = g_array_new(FALSE, FALSE, sizeof(int));
+
+    pm->filter = gtk_tree_model_filter_new(GTK_TREE_MODEL(pm->store), NULL);
+    gtk_tree_model_filter_set_visible_func(GTK_TREE_MODEL_FILTER(pm->filter), process_visible, pm, NULL);
+    pm->sort = gtk_tree_model_sort_new_with_model(pm->filter);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(pm->sort), PROCESS_COL_CPU, GTK_SORT_DESCENDING);
+
+    pm->tree_filter = gtk_tree_model_filter_new(GTK_TREE_MODEL(pm->tree_store), NULL);
+    gtk_tree_model_filter_set_visible_func(GTK_TREE_MODEL_FILTER(pm->tree_filter), tree_node_visible, pm, NULL);
+    pm->tree_sort = gtk_tree_model_sort_new_with_model(pm->tree_filter);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(pm->tree_sort), PROCESS_COL_PID, GTK_SORT_ASCENDING);
+
+    pm->view = gtk_tree_view_new();
+    add_process_column(pm, "PID", PROCESS_COL_PID, 80, NULL);
+    GtkTreeViewColumn *name_column = add_process_column(pm, "Name", PROCESS_COL_NAME, 260, NULL);
+    add_process_column(pm, "User", PROCESS_COL_USER, 120, NULL);
+    add_process_column(pm, "CPU %", PROCESS_COL_CPU, 80, cpu_cell_data);
+    add_process_column(pm, "Memory (KB)", PROCESS_COL_MEMORY, 120, NULL);
+    add_process_column(pm, "State", PROCESS_COL_STATE, 60, NULL);
+    add_process_column(pm, "PPID", PROCESS_COL_PPID, 80, NULL);
+    pm->memory_columns[0] = add_process_column(pm, "PSS (KB)", PROCESS_COL_PSS, 100, memory_cell_data);
+    pm->memory_columns[1] = add_process_column(pm, "USS (KB)", PROCESS_COL_USS, 100, memory_cell_data);
+    pm->memory_columns[2] = add_process_column(pm, "Anon (KB)", PROCESS_COL_ANON, 100, memory_cell_data);
+    pm->memory_columns[3] = add_process_column(pm, "Swap (KB)", PROCESS_COL_SWAP, 100, memory_cell_data);
+    pm->tree_columns[0] = add_process_column(pm, "Tree CPU %", PROCESS_COL_TREE_CPU, 90, cpu_cell_data);
+    pm->tree_columns[1] = add_process_column(pm, "Tree Memory (KB)", PROCESS_COL_TREE_MEMORY, 140, NULL);
+    gtk_tree_view_column_set_visible(pm->tree_columns[0], FALSE);
+    gtk_tree_view_column_set_visible(pm->tree_columns[1], FALSE);
+    pm->io_columns[0] = add_process_column(pm, "Disk/s", PROCESS_COL_IO_TOTAL, 100, io_rate_cell_data);
+    pm->io_columns[1] = add_process_column(pm, "Read/s", PROCESS_COL_IO_READ, 100, io_rate_cell_data);
+    pm->io_columns[2] = add_process_column(pm, "Write/s", PROCESS_COL_IO_WRITE, 100, io_rate_cell_data);
+    pm->io_columns[3] = add_process_column(pm, "Syscalls/s", PROCESS_COL_IO_SYSCALLS, 90, io_rate_cell_data);
+    for (gsize i = 0; i < G_N_ELEMENTS(pm->io_columns); i++) {
+        gtk_tree_view_column_set_visible(pm->io_columns[i], FALSE);
+    }
+    gtk_tree_view_set_expander_column(GTK_TREE_VIEW(pm->view), name_column);
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(pm->view), TRUE);
+    gtk_tree_view_set_enable_search(GTK_TREE_VIEW(pm->view), FALSE);
+    gtk_tree_selection_set_mode(gtk_tree_view_get_selection(GTK_TREE_VIEW(pm->view)), GTK_SELECTION_MULTIPLE);
+
+    gtk_tree_view_set_model(GTK_TREE_VIEW(pm->view), pm->sort);
+
+    // Create scrolled window that fills entire dialog
+    scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_hexpand(scrolled, TRUE);
+    gtk_widget_set_vexpand(scrolled, TRUE);
+    gtk_widget_set_margin_top(scrolled, 10);
+    gtk_widget_set_margin_bottom(scrolled, 10);
+    gtk_widget_set_margin_left(scrolled, 10);
+    gtk_widget_set_margin_right(scrolled, 10);
+    gtk_container_add(GTK_CONTAINER(scrolled), pm->view);
+    gtk_box_pack_start(GTK_BOX(content_area), scrolled, TRUE, TRUE, 0);
+
+    g_signal_connect(gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(scrolled)), "value-changed",
+                     G_CALLBACK(on_process_view_scrolled), pm);
+    g_signal_connect(pm->search_entry, "search-changed", G_CALLBACK(on_filter_changed), pm);
+    g_signal_connect(button, "clicked", G_CALLBACK(on_kill_selected_clicked), pm);
+    g_signal_connect(trace_button, "clicked", G_CALLBACK(on_trace_selected_clicked), pm);
+    g_signal_connect(map_button, "clicked", G_CALLBACK(on_memory_map_clicked), pm);
+    g_signal_connect(pm->tree_toggle, "toggled", G_CALLBACK(on_tree_mode_toggled), pm);
+    g_signal_connect(pm->io_toggle, "toggled", G_CALLBACK(on_io_mode_toggled), pm);
+    g_signal_connect(dialog, "response", G_CALLBACK(on_process_dialog_response), pm);
+    g_signal_connect(dialog, "destroy", G_CALLBACK(on_process_dialog_destroy), pm);
+    refresh_processes(pm);
+    pm->timer = g_timeout_add_seconds(PROCESS_REFRESH_SECONDS, on_refresh_timer, pm);
+    // New and exited processes show up immediately where the kernel reports
+    // them; the timer only refreshes CPU and memory figures
+    pm->watch = process_list_watch(on_process_changed, pm);
+
+    gtk_widget_show_all(dialog);
+    return dialog;
+}
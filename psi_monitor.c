@@ -0,0 +1,229 @@
+// psi_monitor.c
+// Stall notifications from the kernel's PSI triggers. Writing "some
+// <stall us> <window us>" to a /proc/pressure file arms a trigger on that
+// descriptor: once tasks have been stalled for longer than the threshold
+// within a window, the descriptor reports POLLPRI. A thread sleeps in
+// poll() on all of them, so stalls are noticed as they happen rather than
+// by sampling the averages, and nothing runs while the system is calm.
+// The kernel fires a trigger at most once per window.
+//
+// The threshold comes from COMMAND_SPHERE_PSI_STALL_MS (200 ms per 2 s
+// window by default). Unprivileged processes may only use windows that are
+// a multiple of 2 s, hence the fixed window.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#define PSI_WINDOW_US 2000000
+#define PSI_DEFAULT_STALL_MS 200
+#define PSI_MAX_TRIGGERS 5
+#define PSI_EVENT_CAPACITY 64
+
+typedef struct {
+    int fd;
+    PsiResource resource;
+    gboolean full;
+} PsiTrigger;
+
+typedef struct {
+    GThread *thread;
+    int stop_fd;                // eventfd, written to stop the thread
+    PsiTrigger triggers[PSI_MAX_TRIGGERS];
+    guint trigger_count;
+    guint stall_ms;
+    int error;                  // why the first trigger could not be armed
+
+    GMutex lock;
+    PsiStallEvent events[PSI_EVENT_CAPACITY];
+    guint64 event_count;        // events ever recorded
+} PsiMonitor;
+
+static PsiMonitor *monitor = NULL;
+
+static const char *resource_paths[PSI_RESOURCES] = {
+    [PSI_CPU] = "/proc/pressure/cpu",
+    [PSI_MEMORY] = "/proc/pressure/memory",
+    [PSI_IO] = "/proc/pressure/io",
+};
+
+const char* psi_resource_name(PsiResource resource) {
+    static const char *names[PSI_RESOURCES] = { "cpu", "memory", "io" };
+    return resource < PSI_RESOURCES ? names[resource] : "unknown";
+}
+
+static int open_trigger(PsiResource resource, gboolean full, guint stall_ms) {
+    int fd = open(resource_paths[resource], O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    char trigger[64];
+    int length = snprintf(trigger, sizeof(trigger), "%s %u %u",
+                          full ? "full" : "some", stall_ms * 1000, PSI_WINDOW_US);
+    if (write(fd, trigger, length + 1) < 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+// avg10 of the some or full line, read through the trigger's descriptor
+static float trigger_avg10(const PsiTrigger *trigger) {
+    char text[256];
+    gssize n = pread(trigger->fd, text, sizeof(text) - 1, 0);
+    if (n <= 0) return 0;
+    text[n] = '\0';
+
+    const char *line = strstr(text, trigger->full ? "full avg10=" : "some avg10=");
+    return line ? g_ascii_strtod(line + 11, NULL) : 0;
+}
+
+static void record_event(PsiMonitor *m, const PsiTrigger *trigger) {
+    PsiStallEvent event;
+    event.timestamp = g_get_monotonic_time();
+    event.resource = trigger->resource;
+    event.full = trigger->full;
+    event.avg10 = trigger_avg10(trigger);
+
+    g_mutex_lock(&m->lock);
+    m->events[m->event_count % PSI_EVENT_CAPACITY] = event;
+    m->event_count++;
+    g_mutex_unlock(&m->lock);
+}
+
+static gpointer monitor_thread(gpointer user_data) {
+    PsiMonitor *m = user_data;
+    struct pollfd fds[PSI_MAX_TRIGGERS + 1];
+
+    for (guint i = 0; i < m->trigger_count; i++) {
+        fds[i].fd = m->triggers[i].fd;
+        fds[i].events = POLLPRI;
+    }
+    fds[m->trigger_count].fd = m->stop_fd;
+    fds[m->trigger_count].events = POLLIN;
+
+    for (;;) {
+        for (guint i = 0; i <= m->trigger_count; i++) fds[i].revents = 0;
+        if (poll(fds, m->trigger_count + 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[m->trigger_count].revents) break;
+
+        for (guint i = 0; i < m->trigger_count; i++) {
+            if (fds[i].revents & POLLERR) {
+                fds[i].fd = -1;         // trigger destroyed; poll() skips it from now on
+            } else if (fds[i].revents & POLLPRI) {
+                record_event(m, &m->triggers[i]);
+            }
+        }
+    }
+    return NULL;
+}
+
+// Arms the triggers and starts the watching thread. FALSE when none could
+// be armed: no PSI in the kernel, or triggers not permitted.
+gboolean psi_monitor_start(void) {
+    if (monitor) return monitor->trigger_count > 0;
+
+    PsiMonitor *m = g_new0(PsiMonitor, 1);
+    const char *env = getenv("COMMAND_SPHERE_PSI_STALL_MS");
+    m->stall_ms = env ? (guint)strtoul(env, NULL, 10) : 0;
+    if (m->stall_ms == 0) m->stall_ms = PSI_DEFAULT_STALL_MS;
+    m->stall_ms = MIN(m->stall_ms, PSI_WINDOW_US / 1000);
+
+    // cpu "full" is always zero system-wide, so it gets no trigger
+    static const struct {
+        PsiResource resource;
+        gboolean full;
+    } wanted[PSI_MAX_TRIGGERS] = {
+        { PSI_CPU, FALSE },
+        { PSI_MEMORY, FALSE },
+        { PSI_MEMORY, TRUE },
+        { PSI_IO, FALSE },
+        { PSI_IO, TRUE },
+    };
+    for (guint i = 0; i < PSI_MAX_TRIGGERS; i++) {
+        int fd = open_trigger(wanted[i].resource, wanted[i].full, m->stall_ms);
+        if (fd < 0) {
+            if (!m->error) m->error = errno;
+            continue;
+        }
+        PsiTrigger *trigger = &m->triggers[m->trigger_count++];
+        trigger->fd = fd;
+        trigger->resource = wanted[i].resource;
+        trigger->full = wanted[i].full;
+    }
+
+    m->stop_fd = m->trigger_count ? eventfd(0, EFD_CLOEXEC) : -1;
+    if (m->stop_fd < 0) {
+        // Keep the reason around for psi_monitor_triggers()
+        if (!m->error) m->error = errno;
+        for (guint i = 0; i < m->trigger_count; i++) close(m->triggers[i].fd);
+        m->trigger_count = 0;
+        monitor = m;
+        return FALSE;
+    }
+
+    g_mutex_init(&m->lock);
+    m->thread = g_thread_new("psi-monitor", monitor_thread, m);
+    monitor = m;
+    return TRUE;
+}
+
+void psi_monitor_stop(void) {
+    PsiMonitor *m = monitor;
+    if (!m) return;
+    monitor = NULL;
+
+    if (m->thread) {
+        guint64 one = 1;
+        if (write(m->stop_fd, &one, sizeof(one)) < 0) {
+            g_warning("psi monitor: cannot wake thread: %s", g_strerror(errno));
+        }
+        g_thread_join(m->thread);
+        close(m->stop_fd);
+        for (guint i = 0; i < m->trigger_count; i++) close(m->triggers[i].fd);
+        g_mutex_clear(&m->lock);
+    }
+    g_free(m);
+}
+
+// Number of armed triggers, with the threshold they use. When some could
+// not be armed, *error says why.
+guint psi_monitor_triggers(guint *stall_ms, int *error) {
+    if (stall_ms) *stall_ms = monitor ? monitor->stall_ms : 0;
+    if (error) *error = monitor ? monitor->error : 0;
+    return monitor ? monitor->trigger_count : 0;
+}
+
+// Stall events recorded since *cursor (0 for all that are retained), at
+// most max of the newest, oldest first; *cursor is advanced
+guint psi_monitor_events_since(guint64 *cursor, PsiStallEvent *events, guint max) {
+    if (!monitor || !monitor->thread) return 0;
+
+    g_mutex_lock(&monitor->lock);
+    guint64 end = monitor->event_count;
+    guint64 start = MAX(MIN(*cursor, end), end > PSI_EVENT_CAPACITY ? end - PSI_EVENT_CAPACITY : 0);
+    if (end - start > max) start = end - max;
+    guint count = 0;
+    for (guint64 i = start; i < end; i++) {
+        events[count++] = monitor->events[i % PSI_EVENT_CAPACITY];
+    }
+    g_mutex_unlock(&monitor->lock);
+
+    *cursor = end;
+    return count;
+}
+
+gboolean psi_monitor_latest_stall(PsiStallEvent *event) {
+    if (!monitor || !monitor->thread) return FALSE;
+
+    g_mutex_lock(&monitor->lock);
+    gboolean found = monitor->event_count > 0;
+    if (found) *event = monitor->events[(monitor->event_count - 1) % PSI_EVENT_CAPACITY];
+    g_mutex_unlock(&monitor->lock);
+    return found;
+}
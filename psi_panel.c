@@ -0,0 +1,168 @@
+// psi_panel.c
+// Pressure stall view for the System Monitor: the some/full averages over
+// 10, 60 and 300 seconds for cpu, memory and io, taken from the metrics
+// sampler, and the stalls reported by the kernel triggers in
+// psi_monitor.c, newest first. Pressure rises as soon as tasks start
+// waiting, well before CPU% or free memory look alarming.
+
+#include "custom_shell.h"
+
+#define PSI_PANEL_EVENTS 50
+#define PSI_PANEL_COLUMNS 6         // some and full, avg10/60/300 each
+
+enum {
+    PSI_COL_TIME,
+    PSI_COL_RESOURCE,
+    PSI_COL_KIND,
+    PSI_COL_AVG10,
+    PSI_N_COLUMNS
+};
+
+typedef struct {
+    GtkWidget *bars[PSI_RESOURCES];
+    GtkWidget *values[PSI_RESOURCES][PSI_PANEL_COLUMNS];
+    GtkWidget *status;
+    GtkListStore *events;
+    guint64 event_cursor;
+    guint timer;
+} PsiPanel;
+
+static void set_value(GtkWidget *label, float value) {
+    char text[16];
+    snprintf(text, sizeof(text), "%.2f", value);
+    gtk_label_set_text(GTK_LABEL(label), text);
+}
+
+static void add_stall_events(PsiPanel *panel) {
+    PsiStallEvent events[PSI_PANEL_EVENTS];
+    guint count = psi_monitor_events_since(&panel->event_cursor, events, PSI_PANEL_EVENTS);
+
+    // Monotonic timestamps to wall-clock time
+    gint64 offset = g_get_real_time() - g_get_monotonic_time();
+    for (guint i = 0; i < count; i++) {
+        GDateTime *time = g_date_time_new_from_unix_local((events[i].timestamp + offset) / G_USEC_PER_SEC);
+        char *time_text = g_date_time_format(time, "%H:%M:%S");
+        char avg10[16];
+        snprintf(avg10, sizeof(avg10), "%.2f%%", events[i].avg10);
+        gtk_list_store_insert_with_values(panel->events, NULL, 0,
+                                          PSI_COL_TIME, time_text,
+                                          PSI_COL_RESOURCE, psi_resource_name(events[i].resource),
+                                          PSI_COL_KIND, events[i].full ? "full" : "some",
+                                          PSI_COL_AVG10, avg10,
+                                          -1);
+        g_free(time_text);
+        g_date_time_unref(time);
+    }
+
+    // Keep the newest
+    GtkTreeIter iter;
+    while (gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(panel->events), &iter, NULL, PSI_PANEL_EVENTS)) {
+        gtk_list_store_remove(panel->events, &iter);
+    }
+}
+
+static gboolean psi_panel_tick(gpointer user_data) {
+    PsiPanel *panel = user_data;
+    MetricsSample sample;
+    if (metrics_sampler_latest(&sample) && sample.psi_available) {
+        for (int r = 0; r < PSI_RESOURCES; r++) {
+            const PsiSample *psi = &sample.psi[r];
+            float values[PSI_PANEL_COLUMNS] = {
+                psi->some_avg10, psi->some_avg60, psi->some_avg300,
+                psi->full_avg10, psi->full_avg60, psi->full_avg300,
+            };
+            for (int c = 0; c < PSI_PANEL_COLUMNS; c++) set_value(panel->values[r][c], values[c]);
+            gtk_level_bar_set_value(GTK_LEVEL_BAR(panel->bars[r]), MIN(psi->some_avg10, 100.0f));
+        }
+    }
+    add_stall_events(panel);
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_psi_panel_destroy(GtkWidget *widget, gpointer user_data) {
+    PsiPanel *panel = user_data;
+    g_source_remove(panel->timer);
+    g_object_unref(panel->events);
+    g_free(panel);
+}
+
+static void set_trigger_status(PsiPanel *panel) {
+    guint stall_ms = 0;
+    int error = 0;
+    guint triggers = psi_monitor_triggers(&stall_ms, &error);
+    char text[256];
+    if (triggers > 0) {
+        snprintf(text, sizeof(text), "Stall triggers: %u armed, firing after %u ms stalled within 2 s", triggers, stall_ms);
+    } else {
+        snprintf(text, sizeof(text), "Stall triggers unavailable: %s",
+                 error ? g_strerror(error) : "monitor not running");
+    }
+    gtk_label_set_text(GTK_LABEL(panel->status), text);
+}
+
+GtkWidget* psi_panel_new(void) {
+    MetricsSample sample;
+    if (metrics_sampler_interval() == 0) {
+        return gtk_label_new("Pressure: sampler not running");
+    }
+    if (metrics_sampler_latest(&sample) && !sample.psi_available) {
+        return gtk_label_new("Pressure: not available (kernel without CONFIG_PSI, or booted with psi=0)");
+    }
+
+    PsiPanel *panel = g_new0(PsiPanel, 1);
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+
+    GtkWidget *grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(grid), 4);
+    gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
+    static const char *headers[] = {
+        "", "", "some avg10 %", "avg60", "avg300", "full avg10 %", "avg60", "avg300",
+    };
+    for (gsize c = 0; c < G_N_ELEMENTS(headers); c++) {
+        GtkWidget *label = gtk_label_new(headers[c]);
+        gtk_grid_attach(GTK_GRID(grid), label, c, 0, 1, 1);
+    }
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        GtkWidget *name = gtk_label_new(psi_resource_name(r));
+        gtk_label_set_xalign(GTK_LABEL(name), 0.0);
+        gtk_grid_attach(GTK_GRID(grid), name, 0, r + 1, 1, 1);
+
+        panel->bars[r] = gtk_level_bar_new_for_interval(0, 100);
+        gtk_widget_set_hexpand(panel->bars[r], TRUE);
+        gtk_widget_set_valign(panel->bars[r], GTK_ALIGN_CENTER);
+        gtk_grid_attach(GTK_GRID(grid), panel->bars[r], 1, r + 1, 1, 1);
+
+        for (int c = 0; c < PSI_PANEL_COLUMNS; c++) {
+            panel->values[r][c] = gtk_label_new("-");
+            gtk_label_set_xalign(GTK_LABEL(panel->values[r][c]), 1.0);
+            gtk_grid_attach(GTK_GRID(grid), panel->values[r][c], c + 2, r + 1, 1, 1);
+        }
+    }
+    gtk_box_pack_start(GTK_BOX(box), grid, FALSE, FALSE, 0);
+
+    panel->status = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(panel->status), 0.0);
+    set_trigger_status(panel);
+    gtk_box_pack_start(GTK_BOX(box), panel->status, FALSE, FALSE, 0);
+
+    panel->events = gtk_list_store_new(PSI_N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(panel->events));
+    static const char *titles[PSI_N_COLUMNS] = { "Time", "Resource", "Stall", "avg10 at trigger" };
+    for (int c = 0; c < PSI_N_COLUMNS; c++) {
+        GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(titles[c], renderer, "text", c, NULL);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+    }
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(scrolled, -1, 120);
+    gtk_container_add(GTK_CONTAINER(scrolled), view);
+    gtk_box_pack_start(GTK_BOX(box), scrolled, TRUE, TRUE, 0);
+
+    psi_panel_tick(panel);
+    panel->timer = g_timeout_add(metrics_sampler_interval(), psi_panel_tick, panel);
+    g_signal_connect(box, "destroy", G_CALLBACK(on_psi_panel_destroy), panel);
+    return box;
+}
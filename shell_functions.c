@@ -343,17 +343,33 @@ double calculate_expression(const char *expr) {
     return result;
 }
 
+// May arrive after the command's output, once the binary's help is parsed
+static void show_flag_fix(char *flag_fix, gpointer user_data) {
+    AppData *app = (AppData *)user_data;
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(app->buffer, &iter);
+    gtk_text_buffer_insert(app->buffer, &iter, "💡 Did you mean: ", -1);
+    gtk_text_buffer_insert_with_tags_by_name(app->buffer, &iter, flag_fix, -1, "ls", NULL);
+    gtk_text_buffer_insert(app->buffer, &iter, " ?\n", -1);
+    gtk_text_view_scroll_to_iter(GTK_TEXT_VIEW(app->textview), &iter, 0.0, FALSE, 0.0, 0.0);
+    g_free(flag_fix);
+}
+
 void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, GtkTextView *textview) {
     GtkTextIter iter;
+    app->last_exit_status = 0;
+    app->last_output_bytes = 0;
     if (strlen(command) > MAX_COMMAND_LENGTH) {
         gtk_text_buffer_get_end_iter(buffer, &iter);
         gtk_text_buffer_insert(buffer, &iter, "Error: Command too long\n", -1);
+        app->last_exit_status = 1;
         return;
     }
 
     if (!g_utf8_validate(command, -1, NULL)) {
         gtk_text_buffer_get_end_iter(buffer, &iter);
         gtk_text_buffer_insert(buffer, &iter, "Error: Invalid command (contains non-UTF-8 characters)\n", -1);
+        app->last_exit_status = 1;
         return;
     }
 
@@ -459,6 +475,7 @@ void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, G
 
         gtk_text_buffer_get_end_iter(buffer, &iter);
         if (chdir(path_start) != 0) {
+            app->last_exit_status = 1;
             gtk_text_buffer_insert(buffer, &iter, "cd: ", -1);
             gtk_text_buffer_insert(buffer, &iter, strerror(errno), -1);
             gtk_text_buffer_insert(buffer, &iter, "\n", -1);
@@ -513,6 +530,8 @@ void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, G
         gtk_text_buffer_insert(buffer, &iter, "  cat [file]   - Display file contents\n", -1);
         gtk_text_buffer_insert(buffer, &iter, "  calc [expr]  - Evaluate arithmetic expression (e.g., calc 2+3*5)\n", -1);
         gtk_text_buffer_insert(buffer, &iter, "  help [cmd]   - Show this help or command-specific documentation\n", -1);
+        gtk_text_buffer_insert(buffer, &iter, "  history [--failed] [--slowest] [--since 1d] [--cwd [dir]] [-n N]\n", -1);
+        gtk_text_buffer_insert(buffer, &iter, "               - Query past commands with their status, duration and directory\n", -1);
         if (strlen(start) > 5) {
             const char *cmd = start + 5;
             while (*cmd && isspace((unsigned char)*cmd)) cmd++;
@@ -532,6 +551,8 @@ void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, G
                 gtk_text_buffer_insert(buffer, &iter, "  No specific help for this command.\n", -1);
             }
         }
+    } else if (strncmp(start, "history", 7) == 0 && (start[7] == '\0' || isspace((unsigned char)start[7]))) {
+        run_history_command(app, start + 7, buffer);
     } else {
         char full_command[2048];
         snprintf(full_command, sizeof(full_command), "%s 2>&1", start);
@@ -542,13 +563,20 @@ void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, G
             gtk_text_buffer_insert(buffer, &iter, "Failed to execute command: ", -1);
             gtk_text_buffer_insert(buffer, &iter, strerror(errno), -1);
             gtk_text_buffer_insert(buffer, &iter, "\n", -1);
+            app->last_exit_status = 127;
             g_free(sanitized_command);
             return;
         }
 
         gtk_text_buffer_get_end_iter(buffer, &iter);
         char path[1024];
+        // Keep the start of the output for flag correction on failure
+        GString *output = g_string_new(NULL);
         while (fgets(path, sizeof(path), fp)) {
+            app->last_output_bytes += strlen(path);
+            if (output->len < 65536) {
+                g_string_append(output, path);
+            }
             if (!g_utf8_validate(path, -1, NULL)) {
                 char *valid_utf8 = g_utf8_make_valid(path, -1);
                 gtk_text_buffer_insert(buffer, &iter, valid_utf8, -1);
@@ -559,6 +587,15 @@ void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, G
         }
 
         int status = pclose(fp);
+        if (WIFSIGNALED(status)) {
+            app->last_exit_status = 128 + WTERMSIG(status);
+        } else {
+            app->last_exit_status = WEXITSTATUS(status);
+        }
+        // Only commands that worked; a typo that happens to resolve fails
+        if (status == 0) {
+            command_index_note_command(start);
+        }
         if (status != 0) {
             char status_str[32];
             snprintf(status_str, sizeof(status_str), "%d", WEXITSTATUS(status));
@@ -575,7 +612,7 @@ void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, G
                     gtk_text_buffer_insert(buffer, &iter, " ?\n", -1);
                     g_free(typo_fix);
                 } else {
-                    // Try fuzzy matching with common commands
+                    // Try fuzzy matching against $PATH and history commands
                     char* suggestion = suggest_command(start);
                     if (suggestion) {
                         gtk_text_buffer_insert(buffer, &iter, "Did you mean: ", -1);
@@ -590,8 +627,12 @@ void execute_command(AppData *app, const char *command, GtkTextBuffer *buffer, G
                 gtk_text_buffer_insert(buffer, &iter, "Command exited with status: ", -1);
                 gtk_text_buffer_insert(buffer, &iter, status_str, -1);
                 gtk_text_buffer_insert(buffer, &iter, "\n", -1);
+                
+                // Unknown option or subcommand? Suggest the closest valid one
+                suggest_flag_fix(start, output->str, show_flag_fix, app);
             }
         }
+        g_string_free(output, TRUE);
     }
 
     g_free(sanitized_command);
@@ -0,0 +1,616 @@
+// socket_diag.c
+// Connections view. Sockets are listed through NETLINK_SOCK_DIAG: one
+// dump request per family and protocol returns binary inet_diag records,
+// filtered by state in the kernel, with struct tcp_info attached for TCP
+// (RTT, retransmits). That stays fast with hundreds of thousands of
+// sockets where formatting and parsing /proc/net/tcp does not.
+//
+// Owners are found the way ss -p does it, by matching socket inodes
+// against the /proc/<pid>/fd links. Dumping and the owner lookup run on a
+// worker thread; the dialog then updates its rows in place, keyed by
+// socket inode, so scroll position and selection survive each refresh.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+
+#define SOCK_DIAG_BUFFER (64 * 1024)
+#define SOCKET_REFRESH_SECONDS 3
+#define SOCKET_MAX_ROWS 20000       // more would only make the view crawl
+#define SOCKET_RESPONSE_REFRESH 1
+
+static void parse_diag_message(const struct nlmsghdr *nlh, int protocol, GArray *sockets) {
+    const struct inet_diag_msg *msg = NLMSG_DATA(nlh);
+    SocketInfo sock;
+    memset(&sock, 0, sizeof(sock));
+    sock.protocol = protocol;
+    sock.family = msg->idiag_family;
+    sock.state = msg->idiag_state;
+    sock.local_port = ntohs(msg->id.idiag_sport);
+    sock.remote_port = ntohs(msg->id.idiag_dport);
+    gsize addr_len = msg->idiag_family == AF_INET ? 4 : 16;
+    memcpy(sock.local_addr, msg->id.idiag_src, addr_len);
+    memcpy(sock.remote_addr, msg->id.idiag_dst, addr_len);
+    sock.rx_queue = msg->idiag_rqueue;
+    sock.tx_queue = msg->idiag_wqueue;
+    sock.uid = msg->idiag_uid;
+    sock.inode = msg->idiag_inode;
+
+    int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*msg));
+    for (struct rtattr *attr = (struct rtattr *)(msg + 1); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        if (attr->rta_type != INET_DIAG_INFO) continue;
+        // Older kernels send a shorter tcp_info
+        struct tcp_info info;
+        memset(&info, 0, sizeof(info));
+        memcpy(&info, RTA_DATA(attr), MIN(RTA_PAYLOAD(attr), sizeof(info)));
+        sock.has_tcp_info = TRUE;
+        sock.rtt_us = info.tcpi_rtt;
+        sock.rttvar_us = info.tcpi_rttvar;
+        sock.retransmits = info.tcpi_total_retrans;
+    }
+    g_array_append_val(sockets, sock);
+}
+
+static gboolean dump_family(int nl, int family, int protocol, guint32 states, GArray *sockets, char *buffer) {
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len = sizeof(request);
+    request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.req.sdiag_family = family;
+    request.req.sdiag_protocol = protocol;
+    request.req.idiag_states = states;
+    if (protocol == IPPROTO_TCP) {
+        request.req.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+    }
+
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    if (sendto(nl, &request, sizeof(request), 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0) {
+        return FALSE;
+    }
+
+    for (;;) {
+        gssize n = recv(nl, buffer, SOCK_DIAG_BUFFER, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        if (n == 0) return TRUE;
+
+        int remaining = (int)n;
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, remaining);
+             nlh = NLMSG_NEXT(nlh, remaining)) {
+            if (nlh->nlmsg_type == NLMSG_DONE) return TRUE;
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr *err = NLMSG_DATA(nlh);
+                errno = -err->error;
+                return FALSE;
+            }
+            if (nlh->nlmsg_type == SOCK_DIAG_BY_FAMILY) {
+                parse_diag_message(nlh, protocol, sockets);
+            }
+        }
+    }
+}
+
+// Appends the IPv4 and IPv6 sockets of protocol (IPPROTO_TCP or
+// IPPROTO_UDP) whose state is in the states bitmask (1 << TCP_LISTEN and
+// so on). FALSE with errno set on failure, e.g. when the kernel lacks the
+// diag module for that protocol.
+gboolean socket_diag_dump(int protocol, guint32 states, GArray *sockets) {
+    int nl = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (nl < 0) return FALSE;
+
+    char *buffer = g_malloc(SOCK_DIAG_BUFFER);
+    gboolean ok = dump_family(nl, AF_INET, protocol, states, sockets, buffer) &&
+                  dump_family(nl, AF_INET6, protocol, states, sockets, buffer);
+    int error = errno;
+    g_free(buffer);
+    close(nl);
+    errno = error;
+    return ok;
+}
+
+// "socket:[12345]"
+static guint64 socket_link_inode(int dir_fd, const char *name) {
+    char link[64];
+    gssize n = readlinkat(dir_fd, name, link, sizeof(link) - 1);
+    if (n <= 8) return 0;
+    link[n] = '\0';
+    if (strncmp(link, "socket:[", 8) != 0) return 0;
+    return g_ascii_strtoull(link + 8, NULL, 10);
+}
+
+static void read_comm(int pid, char *comm, gsize size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    gssize n = fd >= 0 ? read(fd, comm, size - 1) : -1;
+    if (fd >= 0) close(fd);
+    if (n < 0) n = 0;
+    comm[n] = '\0';
+    g_strchomp(comm);
+}
+
+// Fills in pid and process of every socket whose inode shows up among the
+// open files of a process we may look at. Sockets shared between
+// processes (e.g. after fork) get the first owner found.
+void socket_diag_find_owners(GArray *sockets) {
+    GHashTable *by_inode = g_hash_table_new(g_int64_hash, g_int64_equal);
+    for (guint i = 0; i < sockets->len; i++) {
+        SocketInfo *sock = &g_array_index(sockets, SocketInfo, i);
+        if (sock->inode) g_hash_table_insert(by_inode, &sock->inode, sock);
+    }
+    guint unresolved = g_hash_table_size(by_inode);
+
+    DIR *proc = unresolved ? opendir("/proc") : NULL;
+    struct dirent *entry;
+    while (proc && unresolved > 0 && (entry = readdir(proc)) != NULL) {
+        int pid = atoi(entry->d_name);
+        if (pid <= 0) continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+        int fd_dir = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd_dir < 0) continue;      // exited, or not ours to look at
+        DIR *fds = fdopendir(fd_dir);
+        if (!fds) {
+            close(fd_dir);
+            continue;
+        }
+
+        char comm[16] = "";
+        struct dirent *fd_entry;
+        while (unresolved > 0 && (fd_entry = readdir(fds)) != NULL) {
+            if (fd_entry->d_name[0] == '.') continue;
+            guint64 inode = socket_link_inode(fd_dir, fd_entry->d_name);
+            SocketInfo *sock = inode ? g_hash_table_lookup(by_inode, &inode) : NULL;
+            if (!sock || sock->pid) continue;
+
+            if (!comm[0]) read_comm(pid, comm, sizeof(comm));
+            sock->pid = pid;
+            g_strlcpy(sock->process, comm, sizeof(sock->process));
+            unresolved--;
+        }
+        closedir(fds);
+    }
+    if (proc) closedir(proc);
+    g_hash_table_destroy(by_inode);
+}
+
+const char* socket_state_name(const SocketInfo *sock) {
+    static const char *names[] = {
+        "UNKNOWN", "ESTAB", "SYN-SENT", "SYN-RECV", "FIN-WAIT-1", "FIN-WAIT-2", "TIME-WAIT",
+        "CLOSE", "CLOSE-WAIT", "LAST-ACK", "LISTEN", "CLOSING", "SYN-RECV",
+    };
+    // Unconnected UDP sockets report TCP_CLOSE
+    if (sock->protocol == IPPROTO_UDP && sock->state == TCP_CLOSE) return "UNCONN";
+    return sock->state < G_N_ELEMENTS(names) ? names[sock->state] : "UNKNOWN";
+}
+
+void socket_format_address(const SocketInfo *sock, gboolean remote, char *text, gsize size) {
+    const guint8 *addr = remote ? sock->remote_addr : sock->local_addr;
+    guint16 port = remote ? sock->remote_port : sock->local_port;
+    gsize addr_len = sock->family == AF_INET ? 4 : 16;
+    gboolean any = TRUE;
+    for (gsize i = 0; i < addr_len; i++) {
+        if (addr[i]) any = FALSE;
+    }
+
+    char host[INET6_ADDRSTRLEN] = "*";
+    if (!any) inet_ntop(sock->family, addr, host, sizeof(host));
+    char port_text[8] = "*";
+    if (port) snprintf(port_text, sizeof(port_text), "%u", port);
+
+    if (sock->family == AF_INET6 && !any) {
+        snprintf(text, size, "[%s]:%s", host, port_text);
+    } else {
+        snprintf(text, size, "%s:%s", host, port_text);
+    }
+}
+
+// Connections dialog
+
+enum {
+    SOCKET_COL_PROTOCOL,
+    SOCKET_COL_STATE,
+    SOCKET_COL_LOCAL,
+    SOCKET_COL_REMOTE,
+    SOCKET_COL_RECV_Q,
+    SOCKET_COL_SEND_Q,
+    SOCKET_COL_RTT,             // milliseconds, -1 without tcp_info
+    SOCKET_COL_RETRANS,         // -1 without tcp_info
+    SOCKET_COL_PID,
+    SOCKET_COL_PROCESS,
+    SOCKET_N_COLUMNS
+};
+
+static const struct {
+    const char *label;
+    guint32 states;
+} socket_state_filters[] = {
+    { "All states", SOCKET_STATES_ALL },
+    { "ESTABLISHED", 1 << TCP_ESTABLISHED },
+    { "LISTEN", 1 << TCP_LISTEN },
+    { "TIME-WAIT", 1 << TCP_TIME_WAIT },
+    { "CLOSE-WAIT", 1 << TCP_CLOSE_WAIT },
+    { "SYN-SENT", 1 << TCP_SYN_SENT },
+    { "SYN-RECV", (1 << TCP_SYN_RECV) | (1 << 12) },   // 12: TCP_NEW_SYN_RECV
+    { "FIN-WAIT", (1 << TCP_FIN_WAIT1) | (1 << TCP_FIN_WAIT2) },
+};
+
+typedef struct {
+    GtkWidget *dialog;
+    GtkListStore *store;
+    GtkWidget *view;
+    GtkWidget *protocol_combo;
+    GtkWidget *state_combo;
+    GtkWidget *port_entry;
+    GtkWidget *owners_toggle;
+    GtkWidget *status_label;
+    guint timer;
+    gboolean busy;              // a query is running on the worker
+    gboolean dirty;             // filters changed while it was running
+    gboolean closed;
+    int refs;                   // the dialog and a running query
+    GHashTable *rows;           // socket key -> SocketRow*
+    guint generation;
+} SocketInspector;
+
+// What the store currently shows for a socket, to skip unchanged rows
+typedef struct {
+    GtkTreeIter iter;           // GtkListStore iters persist while the row exists
+    SocketInfo shown;
+    guint generation;
+} SocketRow;
+
+typedef struct {
+    SocketInspector *inspector;
+    gboolean tcp;
+    gboolean udp;
+    guint32 states;
+    int port;                   // local or remote, 0 for any
+    gboolean owners;
+    GArray *sockets;
+    int error;
+    guint total;                // sockets matching, before the row limit
+} SocketQuery;
+
+static void socket_inspector_unref(SocketInspector *si) {
+    if (--si->refs > 0) return;
+    g_hash_table_destroy(si->rows);
+    g_object_unref(si->store);
+    g_free(si);
+}
+
+static gpointer socket_query_thread(gpointer user_data) {
+    SocketQuery *query = user_data;
+
+    if (query->tcp && !socket_diag_dump(IPPROTO_TCP, query->states, query->sockets)) {
+        query->error = errno;
+    }
+    if (query->udp && !socket_diag_dump(IPPROTO_UDP, query->states, query->sockets) && !query->error) {
+        query->error = errno;
+    }
+
+    if (query->port) {
+        guint kept = 0;
+        for (guint i = 0; i < query->sockets->len; i++) {
+            SocketInfo *sock = &g_array_index(query->sockets, SocketInfo, i);
+            if (sock->local_port != query->port && sock->remote_port != query->port) continue;
+            g_array_index(query->sockets, SocketInfo, kept++) = *sock;
+        }
+        g_array_set_size(query->sockets, kept);
+    }
+    query->total = query->sockets->len;
+    if (query->sockets->len > SOCKET_MAX_ROWS) {
+        g_array_set_size(query->sockets, SOCKET_MAX_ROWS);
+    }
+    if (query->owners) {
+        socket_diag_find_owners(query->sockets);
+    }
+    return NULL;
+}
+
+static void start_socket_query(SocketInspector *si);
+
+// Sockets are told apart by inode; TIME-WAIT and other orphans have none
+// and go by protocol and address pair instead
+static char* socket_row_key(const SocketInfo *sock, const char *local, const char *remote) {
+    if (sock->inode) return g_strdup_printf("#%" G_GUINT64_FORMAT, sock->inode);
+    return g_strdup_printf("%u %s %s", sock->protocol, local, remote);
+}
+
+static void set_socket_row(SocketInspector *si, const SocketInfo *sock) {
+    char local[64], remote[64];
+    socket_format_address(sock, FALSE, local, sizeof(local));
+    socket_format_address(sock, TRUE, remote, sizeof(remote));
+    char *key = socket_row_key(sock, local, remote);
+    SocketRow *row = g_hash_table_lookup(si->rows, key);
+    gboolean timed = sock->has_tcp_info && sock->state != TCP_LISTEN;
+
+    if (!row) {
+        row = g_new0(SocketRow, 1);
+        gtk_list_store_insert_with_values(si->store, &row->iter, -1,
+                                          SOCKET_COL_PROTOCOL, sock->protocol == IPPROTO_TCP ? "tcp" : "udp",
+                                          SOCKET_COL_STATE, socket_state_name(sock),
+                                          SOCKET_COL_LOCAL, local,
+                                          SOCKET_COL_REMOTE, remote,
+                                          SOCKET_COL_RECV_Q, sock->rx_queue,
+                                          SOCKET_COL_SEND_Q, sock->tx_queue,
+                                          SOCKET_COL_RTT, timed ? sock->rtt_us / 1000.0f : -1.0f,
+                                          SOCKET_COL_RETRANS, timed ? (int)sock->retransmits : -1,
+                                          SOCKET_COL_PID, sock->pid,
+                                          SOCKET_COL_PROCESS, sock->process,
+                                          -1);
+        g_hash_table_insert(si->rows, key, row);
+    } else {
+        g_free(key);
+        if (memcmp(&row->shown, sock, sizeof(*sock)) != 0) {
+            gtk_list_store_set(si->store, &row->iter,
+                               SOCKET_COL_STATE, socket_state_name(sock),
+                               SOCKET_COL_LOCAL, local,
+                               SOCKET_COL_REMOTE, remote,
+                               SOCKET_COL_RECV_Q, sock->rx_queue,
+                               SOCKET_COL_SEND_Q, sock->tx_queue,
+                               SOCKET_COL_RTT, timed ? sock->rtt_us / 1000.0f : -1.0f,
+                               SOCKET_COL_RETRANS, timed ? (int)sock->retransmits : -1,
+                               SOCKET_COL_PID, sock->pid,
+                               SOCKET_COL_PROCESS, sock->process,
+                               -1);
+        }
+    }
+    row->shown = *sock;
+    row->generation = si->generation;
+}
+
+// Sync the store with a finished query, touching only rows that changed
+static void fill_socket_rows(SocketInspector *si, SocketQuery *query) {
+    // The first fill is detached, so the view is not updated per row
+    gboolean empty = g_hash_table_size(si->rows) == 0;
+    if (empty) gtk_tree_view_set_model(GTK_TREE_VIEW(si->view), NULL);
+
+    si->generation++;
+    for (guint i = 0; i < query->sockets->len; i++) {
+        set_socket_row(si, &g_array_index(query->sockets, SocketInfo, i));
+    }
+
+    // Drop rows of sockets that are gone or filtered out
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, si->rows);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        SocketRow *row = value;
+        if (row->generation != si->generation) {
+            gtk_list_store_remove(si->store, &row->iter);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    if (empty) gtk_tree_view_set_model(GTK_TREE_VIEW(si->view), GTK_TREE_MODEL(si->store));
+
+    char text[256];
+    int length;
+    if (query->total > query->sockets->len) {
+        length = snprintf(text, sizeof(text), "%u sockets, showing the first %u", query->total, query->sockets->len);
+    } else {
+        length = snprintf(text, sizeof(text), "%u sockets", query->total);
+    }
+    if (query->error) {
+        snprintf(text + length, sizeof(text) - length, " (sock_diag: %s)", g_strerror(query->error));
+    }
+    gtk_label_set_text(GTK_LABEL(si->status_label), text);
+}
+
+static gboolean on_socket_query_done(gpointer user_data) {
+    SocketQuery *query = user_data;
+    SocketInspector *si = query->inspector;
+
+    si->busy = FALSE;
+    if (!si->closed) {
+        if (si->dirty) {
+            si->dirty = FALSE;
+            start_socket_query(si);     // filters changed: these rows are stale
+        } else {
+            fill_socket_rows(si, query);
+        }
+    }
+    g_array_free(query->sockets, TRUE);
+    g_free(query);
+    socket_inspector_unref(si);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer run_socket_query(gpointer user_data) {
+    socket_query_thread(user_data);
+    g_idle_add(on_socket_query_done, user_data);
+    return NULL;
+}
+
+static void start_socket_query(SocketInspector *si) {
+    if (si->busy) {
+        si->dirty = TRUE;
+        return;
+    }
+
+    // Anything but a port number would otherwise read as 0, i.e. any port
+    const char *port_text = gtk_entry_get_text(GTK_ENTRY(si->port_entry));
+    char *end;
+    errno = 0;
+    unsigned long port = *port_text ? strtoul(port_text, &end, 10) : 0;
+    if (*port_text && (errno || end == port_text || *end || port == 0 || port > 65535)) {
+        gtk_label_set_text(GTK_LABEL(si->status_label), "Port must be a number from 1 to 65535");
+        return;
+    }
+
+    SocketQuery *query = g_new0(SocketQuery, 1);
+    int protocol = gtk_combo_box_get_active(GTK_COMBO_BOX(si->protocol_combo));
+    int state = gtk_combo_box_get_active(GTK_COMBO_BOX(si->state_combo));
+    query->inspector = si;
+    query->tcp = protocol != 2;
+    query->udp = protocol != 1;
+    query->states = socket_state_filters[MAX(state, 0)].states;
+    query->port = (int)port;
+    query->owners = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(si->owners_toggle));
+    query->sockets = g_array_new(FALSE, FALSE, sizeof(SocketInfo));
+
+    si->busy = TRUE;
+    si->refs++;
+    g_thread_unref(g_thread_new("socket-diag", run_socket_query, query));
+}
+
+static gboolean on_socket_timer(gpointer user_data) {
+    SocketInspector *si = user_data;
+    if (!si->busy) start_socket_query(si);
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_socket_filter_changed(GtkWidget *widget, gpointer user_data) {
+    start_socket_query(user_data);
+}
+
+static void on_socket_dialog_response(GtkDialog *dialog, gint response_id, gpointer user_data) {
+    if (response_id == SOCKET_RESPONSE_REFRESH) {
+        start_socket_query(user_data);
+        g_signal_stop_emission_by_name(dialog, "response");
+    }
+}
+
+static void on_socket_dialog_destroy(GtkWidget *widget, gpointer user_data) {
+    SocketInspector *si = user_data;
+    si->closed = TRUE;
+    g_source_remove(si->timer);
+    socket_inspector_unref(si);
+}
+
+static void optional_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                               GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    int column_id = GPOINTER_TO_INT(user_data);
+    char text[32] = "";
+    if (column_id == SOCKET_COL_RTT) {
+        float rtt = 0;
+        gtk_tree_model_get(model, iter, column_id, &rtt, -1);
+        if (rtt >= 0) snprintf(text, sizeof(text), "%.2f", rtt);
+    } else {
+        int value = 0;
+        gtk_tree_model_get(model, iter, column_id, &value, -1);
+        if (value > 0 || (value == 0 && column_id == SOCKET_COL_RETRANS)) snprintf(text, sizeof(text), "%d", value);
+    }
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void add_socket_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column;
+
+    if (column_id == SOCKET_COL_RTT || column_id == SOCKET_COL_RETRANS || column_id == SOCKET_COL_PID) {
+        column = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(column, title);
+        gtk_tree_view_column_pack_start(column, renderer, TRUE);
+        gtk_tree_view_column_set_cell_data_func(column, renderer, optional_cell_data,
+                                                GINT_TO_POINTER(column_id), NULL);
+    } else {
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    }
+    if (column_id >= SOCKET_COL_RECV_Q && column_id <= SOCKET_COL_PID) {
+        g_object_set(renderer, "xalign", 1.0, NULL);
+    }
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+GtkWidget* create_socket_inspector_dialog(GtkWindow *parent) {
+    SocketInspector *si = g_new0(SocketInspector, 1);
+    si->refs = 1;
+    si->rows = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    si->dialog = gtk_dialog_new_with_buttons("Connections",
+                                             parent,
+                                             GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                             "_Refresh", SOCKET_RESPONSE_REFRESH,
+                                             "_Close", GTK_RESPONSE_CLOSE,
+                                             NULL);
+    gtk_window_set_default_size(GTK_WINDOW(si->dialog), 1000, 650);
+    gtk_window_set_resizable(GTK_WINDOW(si->dialog), TRUE);
+    GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(si->dialog));
+
+    // Filters and status
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_widget_set_margin_top(hbox, 10);
+    gtk_widget_set_margin_left(hbox, 10);
+    gtk_widget_set_margin_right(hbox, 10);
+    si->protocol_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(si->protocol_combo), "TCP and UDP");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(si->protocol_combo), "TCP");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(si->protocol_combo), "UDP");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(si->protocol_combo), 0);
+    gtk_box_pack_start(GTK_BOX(hbox), si->protocol_combo, FALSE, FALSE, 0);
+    si->state_combo = gtk_combo_box_text_new();
+    for (gsize i = 0; i < G_N_ELEMENTS(socket_state_filters); i++) {
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(si->state_combo), socket_state_filters[i].label);
+    }
+    gtk_combo_box_set_active(GTK_COMBO_BOX(si->state_combo), 0);
+    gtk_box_pack_start(GTK_BOX(hbox), si->state_combo, FALSE, FALSE, 0);
+    si->port_entry = gtk_search_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(si->port_entry), "Port");
+    gtk_entry_set_width_chars(GTK_ENTRY(si->port_entry), 8);
+    gtk_box_pack_start(GTK_BOX(hbox), si->port_entry, FALSE, FALSE, 0);
+    si->owners_toggle = gtk_check_button_new_with_label("Show processes");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(si->owners_toggle), TRUE);
+    gtk_box_pack_start(GTK_BOX(hbox), si->owners_toggle, FALSE, FALSE, 0);
+    si->status_label = gtk_label_new("Loading…");
+    gtk_box_pack_end(GTK_BOX(hbox), si->status_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(content_area), hbox, FALSE, FALSE, 0);
+
+    si->store = gtk_list_store_new(SOCKET_N_COLUMNS,
+                                   G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+                                   G_TYPE_UINT, G_TYPE_UINT, G_TYPE_FLOAT, G_TYPE_INT,
+                                   G_TYPE_INT, G_TYPE_STRING);
+    si->view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(si->store));
+    add_socket_column(si->view, "Proto", SOCKET_COL_PROTOCOL);
+    add_socket_column(si->view, "State", SOCKET_COL_STATE);
+    add_socket_column(si->view, "Local Address", SOCKET_COL_LOCAL);
+    add_socket_column(si->view, "Peer Address", SOCKET_COL_REMOTE);
+    add_socket_column(si->view, "Recv-Q", SOCKET_COL_RECV_Q);
+    add_socket_column(si->view, "Send-Q", SOCKET_COL_SEND_Q);
+    add_socket_column(si->view, "RTT ms", SOCKET_COL_RTT);
+    add_socket_column(si->view, "Retrans", SOCKET_COL_RETRANS);
+    add_socket_column(si->view, "PID", SOCKET_COL_PID);
+    add_socket_column(si->view, "Process", SOCKET_COL_PROCESS);
+    gtk_tree_view_set_enable_search(GTK_TREE_VIEW(si->view), FALSE);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_hexpand(scrolled, TRUE);
+    gtk_widget_set_vexpand(scrolled, TRUE);
+    gtk_widget_set_margin_top(scrolled, 10);
+    gtk_widget_set_margin_bottom(scrolled, 10);
+    gtk_widget_set_margin_left(scrolled, 10);
+    gtk_widget_set_margin_right(scrolled, 10);
+    gtk_container_add(GTK_CONTAINER(scrolled), si->view);
+    gtk_box_pack_start(GTK_BOX(content_area), scrolled, TRUE, TRUE, 0);
+
+    g_signal_connect(si->protocol_combo, "changed", G_CALLBACK(on_socket_filter_changed), si);
+    g_signal_connect(si->state_combo, "changed", G_CALLBACK(on_socket_filter_changed), si);
+    g_signal_connect(si->port_entry, "search-changed", G_CALLBACK(on_socket_filter_changed), si);
+    g_signal_connect(si->owners_toggle, "toggled", G_CALLBACK(on_socket_filter_changed), si);
+    g_signal_connect(si->dialog, "response", G_CALLBACK(on_socket_dialog_response), si);
+    g_signal_connect(si->dialog, "destroy", G_CALLBACK(on_socket_dialog_destroy), si);
+
+    start_socket_query(si);
+    si->timer = g_timeout_add_seconds(SOCKET_REFRESH_SECONDS, on_socket_timer, si);
+
+    gtk_widget_show_all(si->dialog);
+    return si->dialog;
+}
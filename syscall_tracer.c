@@ -0,0 +1,610 @@
+// syscall_tracer.c
+// Built-in syscall profiler. A worker thread attaches to every thread of
+// the target with PTRACE_SEIZE (so the target is never stopped by the
+// attach itself), follows new threads through PTRACE_O_TRACECLONE and
+// resumes each stop with PTRACE_SYSCALL. PTRACE_O_TRACESYSGOOD tells
+// syscall stops apart from signals; PTRACE_GET_SYSCALL_INFO gives the
+// number on entry and the error flag on exit, and the time between the
+// two is charged to that syscall. Kernels before 5.3 lack that request;
+// there the number and return value are read from the registers instead.
+// Counters live behind a mutex the dialog snapshots on a timer.
+//
+// Stopping interrupts every tracee and detaches it from the stop it
+// reports, re-injecting any signal that was about to be delivered, so the
+// target carries on as if it had never been traced. The detach runs on the
+// worker; the dialog only asks for it and reaps the thread from a timer
+// once it is done, so the UI never waits for a slow tracee.
+
+#define _GNU_SOURCE
+#include "custom_shell.h"
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/uio.h>
+#include <elf.h>
+
+#define SYSCALL_MAX 512
+#define TRACE_OPTIONS (PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE)
+#define TRACE_DETACH_TIMEOUT_MS 2000
+#define TRACE_REFRESH_MS 500
+#define TRACE_REAP_MS 20            // wake and join interval while stopping
+
+typedef struct {
+    int tid;
+    gboolean in_syscall;
+    int nr;
+    gint64 entered_ns;
+    gboolean listening;         // group-stopped, parked with PTRACE_LISTEN
+} TraceTask;
+
+struct _SyscallTracer {
+    int pid;
+    GThread *thread;
+    pthread_t thread_id;
+    atomic_bool stopping;
+    atomic_bool finished;
+    atomic_int error;           // ENOSYS: syscall stops cannot be decoded here
+    gboolean use_regs;          // no PTRACE_GET_SYSCALL_INFO, worker thread only
+
+    // Attach handshake with syscall_tracer_start
+    GMutex lock;
+    GCond attached;
+    gboolean attach_done;
+    int attach_error;
+
+    GHashTable *tasks;          // tid -> TraceTask*, worker thread only
+    guint task_count;           // mirrored under lock for the UI
+
+    SyscallStats stats[SYSCALL_MAX];    // under lock
+    guint64 total_calls;
+};
+
+static gint64 now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Only there to make the worker's waitpid return EINTR
+static void on_wake_signal(int sig) {
+}
+
+static int wake_signal(void) {
+    return SIGRTMIN + 2;
+}
+
+static TraceTask* add_task(SyscallTracer *tracer, int tid) {
+    TraceTask *task = g_new0(TraceTask, 1);
+    task->tid = tid;
+    g_hash_table_insert(tracer->tasks, GINT_TO_POINTER(tid), task);
+    g_mutex_lock(&tracer->lock);
+    tracer->task_count = g_hash_table_size(tracer->tasks);
+    g_mutex_unlock(&tracer->lock);
+    return task;
+}
+
+static void remove_task(SyscallTracer *tracer, int tid) {
+    g_hash_table_remove(tracer->tasks, GINT_TO_POINTER(tid));
+    g_mutex_lock(&tracer->lock);
+    tracer->task_count = g_hash_table_size(tracer->tasks);
+    g_mutex_unlock(&tracer->lock);
+}
+
+// Seize every thread of the target; FALSE if not even the main one
+static gboolean attach_all(SyscallTracer *tracer) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", tracer->pid);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        errno = ESRCH;
+        return FALSE;
+    }
+
+    struct dirent *entry;
+    int error = ESRCH;
+    while ((entry = readdir(dir)) != NULL) {
+        int tid = atoi(entry->d_name);
+        if (tid <= 0) continue;
+        if (ptrace(PTRACE_SEIZE, tid, NULL, (void *)(long)TRACE_OPTIONS) != 0) {
+            if (tid == tracer->pid) error = errno;
+            continue;
+        }
+        // Syscall tracing starts from the stop this interrupt causes
+        ptrace(PTRACE_INTERRUPT, tid, NULL, NULL);
+        add_task(tracer, tid);
+    }
+    closedir(dir);
+
+    if (!g_hash_table_contains(tracer->tasks, GINT_TO_POINTER(tracer->pid))) {
+        errno = error;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void record_syscall(SyscallTracer *tracer, TraceTask *task, gboolean is_error) {
+    if (task->nr < 0 || task->nr >= SYSCALL_MAX) return;
+    guint64 elapsed = now_ns() - task->entered_ns;
+
+    g_mutex_lock(&tracer->lock);
+    SyscallStats *stats = &tracer->stats[task->nr];
+    stats->count++;
+    if (is_error) stats->errors++;
+    stats->total_ns += elapsed;
+    if (elapsed > stats->max_ns) stats->max_ns = elapsed;
+    tracer->total_calls++;
+    g_mutex_unlock(&tracer->lock);
+}
+
+// Syscall number and return value from the registers, for kernels without
+// PTRACE_GET_SYSCALL_INFO. FALSE with errno ENOSYS on architectures not
+// handled here.
+static gboolean read_syscall_regs(int tid, long *nr, long *ret) {
+#if defined(__x86_64__)
+    struct user_regs_struct regs;
+    if (ptrace(PTRACE_GETREGS, tid, NULL, &regs) != 0) return FALSE;
+    *nr = (long)regs.orig_rax;
+    *ret = (long)regs.rax;
+    return TRUE;
+#elif defined(__aarch64__)
+    struct user_regs_struct regs;
+    struct iovec iov = { &regs, sizeof(regs) };
+    if (ptrace(PTRACE_GETREGSET, tid, (void *)NT_PRSTATUS, &iov) != 0) return FALSE;
+    *nr = (long)regs.regs[8];
+    *ret = (long)regs.regs[0];
+    return TRUE;
+#else
+    errno = ENOSYS;
+    return FALSE;
+#endif
+}
+
+static void enter_syscall(TraceTask *task, int nr) {
+    task->in_syscall = TRUE;
+    task->nr = nr;
+    task->entered_ns = now_ns();
+}
+
+static void exit_syscall(SyscallTracer *tracer, TraceTask *task, gboolean is_error) {
+    if (!task->in_syscall) return;
+    task->in_syscall = FALSE;
+    record_syscall(tracer, task, is_error);
+}
+
+static void handle_syscall_stop(SyscallTracer *tracer, TraceTask *task) {
+    if (!tracer->use_regs) {
+        struct __ptrace_syscall_info info;
+        if (ptrace(PTRACE_GET_SYSCALL_INFO, task->tid, (void *)sizeof(info), &info) > 0) {
+            if (info.op == PTRACE_SYSCALL_INFO_ENTRY) {
+                enter_syscall(task, (int)info.entry.nr);
+            } else if (info.op == PTRACE_SYSCALL_INFO_EXIT) {
+                exit_syscall(tracer, task, info.exit.is_error);
+            }
+            return;
+        }
+        if (errno != EIO && errno != EINVAL) return;    // e.g. ESRCH, killed meanwhile
+        tracer->use_regs = TRUE;                        // before Linux 5.3
+    }
+
+    long nr, ret;
+    if (!read_syscall_regs(task->tid, &nr, &ret)) {
+        if (errno == ENOSYS) {
+            atomic_store(&tracer->error, ENOSYS);
+            atomic_store(&tracer->stopping, TRUE);
+        }
+        return;
+    }
+#if defined(__x86_64__)
+    gboolean entering = ret == -ENOSYS;     // set by the kernel on entry
+#else
+    gboolean entering = !task->in_syscall;  // entry and exit stops alternate
+#endif
+    if (entering) {
+        enter_syscall(task, (int)nr);
+    } else {
+        exit_syscall(tracer, task, ret < 0 && ret >= -4095);
+    }
+}
+
+// One wait status of a traced thread; resumes it unless it went away
+static void handle_status(SyscallTracer *tracer, int tid, int status) {
+    TraceTask *task = g_hash_table_lookup(tracer->tasks, GINT_TO_POINTER(tid));
+
+    if (WIFEXITED(status) || WIFSIGNALED(status)) {
+        remove_task(tracer, tid);
+        return;
+    }
+    if (!WIFSTOPPED(status)) return;
+    if (!task) task = add_task(tracer, tid);   // new thread reported before its clone event
+
+    int sig = WSTOPSIG(status);
+    int event = (unsigned)status >> 16;
+    int inject = 0;
+
+    if (sig == (SIGTRAP | 0x80)) {
+        handle_syscall_stop(tracer, task);
+    } else if (event == PTRACE_EVENT_CLONE) {
+        unsigned long new_tid = 0;
+        ptrace(PTRACE_GETEVENTMSG, tid, NULL, &new_tid);
+        if (new_tid && !g_hash_table_contains(tracer->tasks, GINT_TO_POINTER((int)new_tid))) {
+            add_task(tracer, (int)new_tid);
+        }
+    } else if (event == PTRACE_EVENT_STOP) {
+        // Group stop (SIGSTOP and friends) keeps the thread stopped
+        if (sig == SIGSTOP || sig == SIGTSTP || sig == SIGTTIN || sig == SIGTTOU) {
+            task->listening = TRUE;
+            ptrace(PTRACE_LISTEN, tid, NULL, NULL);
+            return;
+        }
+        task->listening = FALSE;    // our interrupt, or resumed by SIGCONT
+    } else {
+        inject = sig;               // signal-delivery stop: pass it on
+    }
+    ptrace(PTRACE_SYSCALL, tid, NULL, (void *)(long)inject);
+}
+
+// Interrupt every tracee and detach it from the stop it reports. Threads
+// that never report in time are detached by the kernel when this thread
+// exits.
+static void detach_all(SyscallTracer *tracer) {
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, tracer->tasks);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        TraceTask *task = value;
+        ptrace(PTRACE_INTERRUPT, task->tid, NULL, NULL);
+    }
+
+    gint64 deadline = g_get_monotonic_time() + TRACE_DETACH_TIMEOUT_MS * 1000;
+    while (g_hash_table_size(tracer->tasks) > 0 && g_get_monotonic_time() < deadline) {
+        int status;
+        int tid = waitpid(-1, &status, __WALL | __WNOTHREAD | WNOHANG);
+        if (tid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (tid == 0) {
+            g_usleep(1000);
+            continue;
+        }
+        if (WIFSTOPPED(status)) {
+            int sig = WSTOPSIG(status);
+            int event = (unsigned)status >> 16;
+            gboolean deliver = sig != (SIGTRAP | 0x80) && event == 0;
+            ptrace(PTRACE_DETACH, tid, NULL, (void *)(long)(deliver ? sig : 0));
+        }
+        remove_task(tracer, tid);
+    }
+}
+
+static gpointer tracer_thread(gpointer user_data) {
+    SyscallTracer *tracer = user_data;
+    tracer->thread_id = pthread_self();
+
+    gboolean ok = attach_all(tracer);
+    g_mutex_lock(&tracer->lock);
+    tracer->attach_error = ok ? 0 : errno;
+    tracer->attach_done = TRUE;
+    g_cond_signal(&tracer->attached);
+    g_mutex_unlock(&tracer->lock);
+
+    while (ok && !atomic_load(&tracer->stopping) && g_hash_table_size(tracer->tasks) > 0) {
+        int status;
+        // __WNOTHREAD: never reap the shell's own children
+        int tid = waitpid(-1, &status, __WALL | __WNOTHREAD);
+        if (tid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        handle_status(tracer, tid, status);
+    }
+    detach_all(tracer);
+
+    atomic_store(&tracer->finished, TRUE);
+    return NULL;
+}
+
+// Attaches to pid on a new worker thread. Returns NULL with errno set
+// (EPERM without CAP_SYS_PTRACE or under a restrictive ptrace_scope,
+// ESRCH if it is gone) when the process cannot be traced.
+SyscallTracer* syscall_tracer_start(int pid) {
+    static gsize handler_installed = 0;
+    if (g_once_init_enter(&handler_installed)) {
+        struct sigaction action = { 0 };
+        action.sa_handler = on_wake_signal;   // no SA_RESTART: waitpid must fail with EINTR
+        sigemptyset(&action.sa_mask);
+        sigaction(wake_signal(), &action, NULL);
+        g_once_init_leave(&handler_installed, 1);
+    }
+
+    SyscallTracer *tracer = g_new0(SyscallTracer, 1);
+    tracer->pid = pid;
+    tracer->tasks = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    g_mutex_init(&tracer->lock);
+    g_cond_init(&tracer->attached);
+    for (int i = 0; i < SYSCALL_MAX; i++) tracer->stats[i].nr = i;
+
+    tracer->thread = g_thread_new("syscall-tracer", tracer_thread, tracer);
+    g_mutex_lock(&tracer->lock);
+    while (!tracer->attach_done) {
+        g_cond_wait(&tracer->attached, &tracer->lock);
+    }
+    int error = tracer->attach_error;
+    g_mutex_unlock(&tracer->lock);
+
+    if (error) {
+        syscall_tracer_free(tracer);
+        errno = error;
+        return NULL;
+    }
+    return tracer;
+}
+
+// Asks the worker to detach without waiting for it. The worker may be
+// blocked in waitpid on an idle target and the signal can land just
+// before it blocks, so callers repeat this until the tracer stops running.
+void syscall_tracer_request_stop(SyscallTracer *tracer) {
+    if (!tracer || !tracer->thread || atomic_load(&tracer->finished)) return;
+    atomic_store(&tracer->stopping, TRUE);
+    pthread_kill(tracer->thread_id, wake_signal());
+}
+
+// Detaches from the target and waits for the worker; the counters stay
+// readable afterwards
+void syscall_tracer_stop(SyscallTracer *tracer) {
+    if (!tracer || !tracer->thread) return;
+
+    while (!atomic_load(&tracer->finished)) {
+        syscall_tracer_request_stop(tracer);
+        g_usleep(10000);
+    }
+    g_thread_join(tracer->thread);
+    tracer->thread = NULL;
+}
+
+void syscall_tracer_free(SyscallTracer *tracer) {
+    if (!tracer) return;
+    syscall_tracer_stop(tracer);
+    g_hash_table_destroy(tracer->tasks);
+    g_mutex_clear(&tracer->lock);
+    g_cond_clear(&tracer->attached);
+    g_free(tracer);
+}
+
+// FALSE once stopped or once every traced thread has exited
+gboolean syscall_tracer_running(SyscallTracer *tracer) {
+    return tracer && tracer->thread && !atomic_load(&tracer->finished);
+}
+
+// ENOSYS if tracing stopped because syscall stops cannot be decoded on
+// this kernel and architecture, otherwise 0
+int syscall_tracer_error(SyscallTracer *tracer) {
+    return atomic_load(&tracer->error);
+}
+
+// Copies the counters of every syscall seen so far into stats (an array
+// of SyscallStats); returns the number of threads being traced
+guint syscall_tracer_snapshot(SyscallTracer *tracer, GArray *stats) {
+    g_array_set_size(stats, 0);
+    g_mutex_lock(&tracer->lock);
+    for (int i = 0; i < SYSCALL_MAX; i++) {
+        if (tracer->stats[i].count > 0) g_array_append_val(stats, tracer->stats[i]);
+    }
+    guint threads = tracer->task_count;
+    g_mutex_unlock(&tracer->lock);
+    return threads;
+}
+
+// ----------------------------------------------------------------------
+// Live dialog
+
+enum {
+    TRACE_COL_NAME,
+    TRACE_COL_CALLS,
+    TRACE_COL_ERRORS,
+    TRACE_COL_TOTAL_MS,
+    TRACE_COL_AVG_US,
+    TRACE_COL_MAX_US,
+    TRACE_COL_SHARE,            // % of traced time, drawn as a bar
+    TRACE_N_COLUMNS
+};
+
+#define TRACE_RESPONSE_STOP 1
+
+typedef struct {
+    SyscallTracer *tracer;
+    GtkListStore *store;
+    GtkTreeIter rows[SYSCALL_MAX];
+    gboolean has_row[SYSCALL_MAX];
+    GtkWidget *status_label;
+    GtkWidget *dialog;
+    GArray *snapshot;
+    guint timer;
+    gboolean stopping;          // Stop pressed, worker still detaching
+} TraceDialog;
+
+// Joins the worker once it has finished detaching, then frees the tracer
+static gboolean on_tracer_reap(gpointer user_data) {
+    SyscallTracer *tracer = user_data;
+    if (syscall_tracer_running(tracer)) {
+        syscall_tracer_request_stop(tracer);
+        return G_SOURCE_CONTINUE;
+    }
+    syscall_tracer_free(tracer);
+    return G_SOURCE_REMOVE;
+}
+
+static void refresh_trace_dialog(TraceDialog *td) {
+    guint threads = syscall_tracer_snapshot(td->tracer, td->snapshot);
+    guint64 total_ns = 0, calls = 0;
+    for (guint i = 0; i < td->snapshot->len; i++) {
+        total_ns += g_array_index(td->snapshot, SyscallStats, i).total_ns;
+        calls += g_array_index(td->snapshot, SyscallStats, i).count;
+    }
+
+    for (guint i = 0; i < td->snapshot->len; i++) {
+        SyscallStats *stats = &g_array_index(td->snapshot, SyscallStats, i);
+        int share = total_ns ? (int)(stats->total_ns * 100 / total_ns) : 0;
+        if (!td->has_row[stats->nr]) {
+            gtk_list_store_append(td->store, &td->rows[stats->nr]);
+            gtk_list_store_set(td->store, &td->rows[stats->nr], TRACE_COL_NAME, syscall_name(stats->nr), -1);
+            td->has_row[stats->nr] = TRUE;
+        }
+        gtk_list_store_set(td->store, &td->rows[stats->nr],
+                           TRACE_COL_CALLS, stats->count,
+                           TRACE_COL_ERRORS, stats->errors,
+                           TRACE_COL_TOTAL_MS, stats->total_ns / 1e6,
+                           TRACE_COL_AVG_US, stats->total_ns / 1e3 / stats->count,
+                           TRACE_COL_MAX_US, stats->max_ns / 1e3,
+                           TRACE_COL_SHARE, share,
+                           -1);
+    }
+
+    char text[160];
+    if (syscall_tracer_running(td->tracer)) {
+        snprintf(text, sizeof(text), "%s pid %d: %u threads, %" G_GUINT64_FORMAT " syscalls",
+                 td->stopping ? "Detaching from" : "Tracing", td->tracer->pid, threads, calls);
+    } else if (syscall_tracer_error(td->tracer) == ENOSYS) {
+        snprintf(text, sizeof(text), "Stopped: this kernel cannot report syscalls to a tracer "
+                 "(PTRACE_GET_SYSCALL_INFO needs Linux 5.3)");
+    } else {
+        snprintf(text, sizeof(text), "Stopped: %" G_GUINT64_FORMAT " syscalls from pid %d",
+                 calls, td->tracer->pid);
+    }
+    gtk_label_set_text(GTK_LABEL(td->status_label), text);
+}
+
+static gboolean on_trace_timer(gpointer user_data) {
+    TraceDialog *td = user_data;
+    if (td->stopping) syscall_tracer_request_stop(td->tracer);
+    refresh_trace_dialog(td);
+    if (syscall_tracer_running(td->tracer)) return G_SOURCE_CONTINUE;
+
+    syscall_tracer_stop(td->tracer);    // finished, so this only joins
+    gtk_dialog_set_response_sensitive(GTK_DIALOG(td->dialog), TRACE_RESPONSE_STOP, FALSE);
+    td->timer = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static void on_trace_dialog_response(GtkDialog *dialog, gint response_id, gpointer user_data) {
+    TraceDialog *td = user_data;
+    if (response_id != TRACE_RESPONSE_STOP) return;
+
+    // The timer notices when the worker is done
+    td->stopping = TRUE;
+    syscall_tracer_request_stop(td->tracer);
+    gtk_dialog_set_response_sensitive(GTK_DIALOG(td->dialog), TRACE_RESPONSE_STOP, FALSE);
+    if (td->timer) g_source_remove(td->timer);
+    td->timer = g_timeout_add(TRACE_REAP_MS, on_trace_timer, td);
+    g_signal_stop_emission_by_name(dialog, "response");
+}
+
+static void on_trace_dialog_destroy(GtkWidget *widget, gpointer user_data) {
+    TraceDialog *td = user_data;
+    if (td->timer) g_source_remove(td->timer);
+    syscall_tracer_request_stop(td->tracer);
+    g_timeout_add(TRACE_REAP_MS, on_tracer_reap, td->tracer);
+    g_object_unref(td->store);
+    g_array_free(td->snapshot, TRUE);
+    g_free(td);
+}
+
+static void double_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                             GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    double value = 0;
+    char text[32];
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &value, -1);
+    snprintf(text, sizeof(text), "%.1f", value);
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void add_trace_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer;
+    GtkTreeViewColumn *column;
+
+    if (column_id == TRACE_COL_SHARE) {
+        renderer = gtk_cell_renderer_progress_new();
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "value", column_id, NULL);
+        gtk_tree_view_column_set_expand(column, TRUE);
+    } else if (column_id >= TRACE_COL_TOTAL_MS) {
+        renderer = gtk_cell_renderer_text_new();
+        column = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(column, title);
+        gtk_tree_view_column_pack_start(column, renderer, TRUE);
+        gtk_tree_view_column_set_cell_data_func(column, renderer, double_cell_data,
+                                                GINT_TO_POINTER(column_id), NULL);
+    } else {
+        renderer = gtk_cell_renderer_text_new();
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    }
+    if (column_id != TRACE_COL_NAME && column_id != TRACE_COL_SHARE) {
+        g_object_set(renderer, "xalign", 1.0, NULL);
+    }
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+// Traces pid while the dialog is open. Returns NULL (with errno set) if
+// the process cannot be traced.
+GtkWidget* create_syscall_trace_dialog(GtkWindow *parent, int pid) {
+    SyscallTracer *tracer = syscall_tracer_start(pid);
+    if (!tracer) return NULL;
+
+    TraceDialog *td = g_new0(TraceDialog, 1);
+    td->tracer = tracer;
+    td->snapshot = g_array_new(FALSE, FALSE, sizeof(SyscallStats));
+
+    char title[64];
+    snprintf(title, sizeof(title), "System Calls of PID %d", pid);
+    td->dialog = gtk_dialog_new_with_buttons(title,
+                                             parent,
+                                             GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                             "_Stop", TRACE_RESPONSE_STOP,
+                                             "_Close", GTK_RESPONSE_CLOSE,
+                                             NULL);
+    gtk_window_set_default_size(GTK_WINDOW(td->dialog), 800, 600);
+    gtk_window_set_resizable(GTK_WINDOW(td->dialog), TRUE);
+
+    GtkWidget *content_area = gtk_dialog_get_content_area(GTK_DIALOG(td->dialog));
+    td->status_label = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(td->status_label), 0.0);
+    gtk_widget_set_margin_top(td->status_label, 10);
+    gtk_widget_set_margin_left(td->status_label, 10);
+    gtk_box_pack_start(GTK_BOX(content_area), td->status_label, FALSE, FALSE, 0);
+
+    td->store = gtk_list_store_new(TRACE_N_COLUMNS, G_TYPE_STRING, G_TYPE_UINT64, G_TYPE_UINT64,
+                                   G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_INT);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(td->store), TRACE_COL_TOTAL_MS, GTK_SORT_DESCENDING);
+
+    GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(td->store));
+    add_trace_column(view, "Syscall", TRACE_COL_NAME);
+    add_trace_column(view, "Calls", TRACE_COL_CALLS);
+    add_trace_column(view, "Errors", TRACE_COL_ERRORS);
+    add_trace_column(view, "Total (ms)", TRACE_COL_TOTAL_MS);
+    add_trace_column(view, "Avg (µs)", TRACE_COL_AVG_US);
+    add_trace_column(view, "Max (µs)", TRACE_COL_MAX_US);
+    add_trace_column(view, "% Time", TRACE_COL_SHARE);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_hexpand(scrolled, TRUE);
+    gtk_widget_set_vexpand(scrolled, TRUE);
+    gtk_widget_set_margin_top(scrolled, 10);
+    gtk_widget_set_margin_bottom(scrolled, 10);
+    gtk_widget_set_margin_left(scrolled, 10);
+    gtk_widget_set_margin_right(scrolled, 10);
+    gtk_container_add(GTK_CONTAINER(scrolled), view);
+    gtk_box_pack_start(GTK_BOX(content_area), scrolled, TRUE, TRUE, 0);
+
+    refresh_trace_dialog(td);
+    td->timer = g_timeout_add(TRACE_REFRESH_MS, on_trace_timer, td);
+    g_signal_connect(td->dialog, "response", G_CALLBACK(on_trace_dialog_response), td);
+    g_signal_connect(td->dialog, "destroy", G_CALLBACK(on_trace_dialog_destroy), td);
+
+    gtk_widget_show_all(td->dialog);
+    return td->dialog;
+}
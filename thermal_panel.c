@@ -0,0 +1,411 @@
+// thermal_panel.c
+// Temperatures for the System Monitor: every thermal zone and hwmon sensor
+// with its current reading, the lowest and highest seen while the panel is
+// open and its critical trip point, plus a graph of the last couple of
+// minutes. Readings come from the metrics sampler's sensor ring
+// (metrics_sampler.c), which the panel keeps filled while it is open; the
+// graph starts with whatever history the ring already holds, e.g. from the
+// metrics endpoint. With nothing selected every sensor is drawn; selecting one
+// graphs it alone against its critical temperature, which makes a CPU
+// sitting at its throttling point easy to spot.
+
+#include "custom_shell.h"
+#include <math.h>
+
+#define THERMAL_GRAPH_SAMPLES 120
+#define THERMAL_GRAPH_HEIGHT 140
+#define THERMAL_COLORS 6
+
+enum {
+    THERMAL_COL_NAME,
+    THERMAL_COL_LABEL,
+    THERMAL_COL_CELSIUS,
+    THERMAL_COL_MIN,
+    THERMAL_COL_MAX,
+    THERMAL_COL_CRITICAL,
+    THERMAL_COL_VALID,
+    THERMAL_COL_GENERATION,
+    THERMAL_N_COLUMNS
+};
+
+// Degrees Celsius, one slot per sample; NAN where the read failed
+typedef struct {
+    float celsius[THERMAL_GRAPH_SAMPLES];
+    guint count;                // samples pushed; the next slot is count % THERMAL_GRAPH_SAMPLES
+    float low;                  // since the panel opened, NAN until a read succeeded
+    float high;
+    float critical_celsius;
+    guint color;
+} ThermalHistory;
+
+typedef struct {
+    GtkListStore *store;
+    GtkWidget *summary;
+    GtkWidget *graph;
+    GtkWidget *graph_label;
+    guint timer;
+    guint64 cursor;             // position in the sampler's sensor ring
+    guint column;               // samples seen, the graph's time axis
+    guint generation;           // latest update_rows(), to spot removed sensors
+    GHashTable *history;        // sensor name -> ThermalHistory*
+    char *selected;             // graphed sensor, NULL for all of them
+    ThermalSensorSet *sets;     // THERMAL_GRAPH_SAMPLES scratch
+} ThermalPanel;
+
+static const double colors[THERMAL_COLORS][3] = {
+    { 0.96, 0.26, 0.21 },
+    { 1.00, 0.60, 0.00 },
+    { 0.30, 0.69, 0.31 },
+    { 0.13, 0.59, 0.95 },
+    { 0.61, 0.15, 0.69 },
+    { 0.00, 0.74, 0.83 },
+};
+
+// Sensors appear with the panel's time axis already running; the samples
+// before them stay empty
+static void push_history(ThermalPanel *panel, const ThermalSensorSample *sensor) {
+    ThermalHistory *history = g_hash_table_lookup(panel->history, sensor->name);
+    if (!history) {
+        history = g_new0(ThermalHistory, 1);
+        history->count = panel->column;
+        history->color = g_hash_table_size(panel->history) % THERMAL_COLORS;
+        history->low = history->high = NAN;
+        g_hash_table_insert(panel->history, g_strdup(sensor->name), history);
+    }
+    while (history->count < panel->column) {
+        history->celsius[history->count++ % THERMAL_GRAPH_SAMPLES] = NAN;
+    }
+    history->celsius[history->count++ % THERMAL_GRAPH_SAMPLES] = sensor->valid ? sensor->celsius : NAN;
+    history->critical_celsius = sensor->critical_celsius;
+    if (sensor->valid) {
+        history->low = isnan(history->low) ? sensor->celsius : MIN(history->low, sensor->celsius);
+        history->high = isnan(history->high) ? sensor->celsius : MAX(history->high, sensor->celsius);
+    }
+}
+
+static gboolean find_sensor_row(GtkTreeModel *model, const char *name, GtkTreeIter *iter) {
+    gboolean valid = gtk_tree_model_get_iter_first(model, iter);
+    while (valid) {
+        char *row_name = NULL;
+        gtk_tree_model_get(model, iter, THERMAL_COL_NAME, &row_name, -1);
+        gboolean same = g_strcmp0(row_name, name) == 0;
+        g_free(row_name);
+        if (same) return TRUE;
+        valid = gtk_tree_model_iter_next(model, iter);
+    }
+    return FALSE;
+}
+
+// Sensors come and go with hotplug (the sampler rescans sysfs), so rows
+// missing from the latest set are removed together with their history
+static void update_rows(ThermalPanel *panel, const ThermalSensorSet *set) {
+    GtkTreeModel *model = GTK_TREE_MODEL(panel->store);
+    panel->generation++;
+    for (guint i = 0; i < set->count; i++) {
+        const ThermalSensorSample *sensor = &set->sensors[i];
+        const ThermalHistory *history = g_hash_table_lookup(panel->history, sensor->name);
+        GtkTreeIter iter;
+        if (!find_sensor_row(model, sensor->name, &iter)) {
+            gtk_list_store_append(panel->store, &iter);
+        }
+        gtk_list_store_set(panel->store, &iter,
+                           THERMAL_COL_NAME, sensor->name,
+                           THERMAL_COL_LABEL, sensor->label,
+                           THERMAL_COL_CELSIUS, sensor->celsius,
+                           THERMAL_COL_MIN, history->low,
+                           THERMAL_COL_MAX, history->high,
+                           THERMAL_COL_CRITICAL, sensor->critical_celsius,
+                           THERMAL_COL_VALID, sensor->valid,
+                           THERMAL_COL_GENERATION, panel->generation,
+                           -1);
+    }
+
+    GtkTreeIter iter;
+    gboolean valid = gtk_tree_model_get_iter_first(model, &iter);
+    while (valid) {
+        guint generation = 0;
+        gtk_tree_model_get(model, &iter, THERMAL_COL_GENERATION, &generation, -1);
+        valid = generation == panel->generation
+            ? gtk_tree_model_iter_next(model, &iter)
+            : gtk_list_store_remove(panel->store, &iter);
+    }
+
+    // Also drops sensors that came and went between two ticks
+    GHashTableIter history_iter;
+    gpointer name;
+    g_hash_table_iter_init(&history_iter, panel->history);
+    while (g_hash_table_iter_next(&history_iter, &name, NULL)) {
+        guint i = 0;
+        while (i < set->count && strcmp(set->sensors[i].name, name) != 0) i++;
+        if (i == set->count) g_hash_table_iter_remove(&history_iter);
+    }
+}
+
+static void update_summary(ThermalPanel *panel, const ThermalSensorSet *set) {
+    const ThermalSensorSample *hottest = NULL;
+    guint near_critical = 0;
+    for (guint i = 0; i < set->count; i++) {
+        const ThermalSensorSample *sensor = &set->sensors[i];
+        if (!sensor->valid) continue;
+        if (!hottest || sensor->celsius > hottest->celsius) hottest = sensor;
+        if (sensor->critical_celsius > 0 && sensor->celsius >= sensor->critical_celsius - 10) near_critical++;
+    }
+
+    char text[256];
+    int length;
+    if (set->count == 0) {
+        length = snprintf(text, sizeof(text), "No temperature sensors: no thermal zones or hwmon devices in sysfs");
+    } else if (!hottest) {
+        length = snprintf(text, sizeof(text), "%u sensors, none readable", set->count);
+    } else if (near_critical > 0) {
+        length = snprintf(text, sizeof(text), "%u sensors, hottest %s at %.1f °C; %u within 10 °C of critical",
+                          set->count, hottest->label, hottest->celsius, near_critical);
+    } else {
+        length = snprintf(text, sizeof(text), "%u sensors, hottest %s at %.1f °C",
+                          set->count, hottest->label, hottest->celsius);
+    }
+    if (set->total > set->count && length > 0 && (gsize)length < sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, " (first %u of %u shown)", set->count, set->total);
+    }
+    gtk_label_set_text(GTK_LABEL(panel->summary), text);
+}
+
+// Range of the graphed values, padded, and at least 10 °C tall
+static void graph_range(ThermalPanel *panel, float *low, float *high) {
+    *low = G_MAXFLOAT;
+    *high = -G_MAXFLOAT;
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, panel->history);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        ThermalHistory *history = value;
+        if (panel->selected && strcmp(key, panel->selected) != 0) continue;
+        guint shown = MIN(history->count, THERMAL_GRAPH_SAMPLES);
+        for (guint i = 0; i < shown; i++) {
+            float celsius = history->celsius[(history->count - shown + i) % THERMAL_GRAPH_SAMPLES];
+            if (isnan(celsius)) continue;
+            *low = MIN(*low, celsius);
+            *high = MAX(*high, celsius);
+        }
+        if (panel->selected && history->critical_celsius > 0) *high = MAX(*high, history->critical_celsius);
+    }
+    if (*low > *high) {
+        *low = 20;
+        *high = 60;
+    }
+    *low = floorf(*low) - 2;
+    *high = MAX(ceilf(*high) + 2, *low + 10);
+}
+
+static void update_graph(ThermalPanel *panel) {
+    float low, high;
+    graph_range(panel, &low, &high);
+    char text[128];
+    snprintf(text, sizeof(text), "%s: %.0f to %.0f °C", panel->selected ? panel->selected : "All sensors", low, high);
+    gtk_label_set_text(GTK_LABEL(panel->graph_label), text);
+    gtk_widget_queue_draw(panel->graph);
+}
+
+static gboolean thermal_panel_tick(gpointer user_data) {
+    ThermalPanel *panel = user_data;
+    guint count = metrics_sampler_sensors_since(&panel->cursor, panel->sets, THERMAL_GRAPH_SAMPLES);
+    if (count == 0) return G_SOURCE_CONTINUE;
+
+    for (guint s = 0; s < count; s++) {
+        const ThermalSensorSet *set = &panel->sets[s];
+        for (guint i = 0; i < set->count; i++) push_history(panel, &set->sensors[i]);
+        panel->column++;
+    }
+
+    update_rows(panel, &panel->sets[count - 1]);
+    update_summary(panel, &panel->sets[count - 1]);
+    update_graph(panel);
+    return G_SOURCE_CONTINUE;
+}
+
+// Gaps where the sensor could not be read break the line
+static void draw_series(cairo_t *cr, const ThermalHistory *history, float low, float high,
+                        double width, double height) {
+    guint shown = MIN(history->count, THERMAL_GRAPH_SAMPLES);
+    double step = width / (THERMAL_GRAPH_SAMPLES - 1);
+    gboolean drawing = FALSE;
+    for (guint i = 0; i < shown; i++) {
+        float celsius = history->celsius[(history->count - shown + i) % THERMAL_GRAPH_SAMPLES];
+        if (isnan(celsius)) {
+            drawing = FALSE;
+            continue;
+        }
+        double x = width - (shown - 1 - i) * step;
+        double y = height - (celsius - low) / (high - low) * height;
+        if (drawing) {
+            cairo_line_to(cr, x, y);
+        } else {
+            cairo_move_to(cr, x, y);
+            drawing = TRUE;
+        }
+    }
+    cairo_stroke(cr);
+}
+
+static gboolean on_graph_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    ThermalPanel *panel = user_data;
+    double width = gtk_widget_get_allocated_width(widget);
+    double height = gtk_widget_get_allocated_height(widget);
+
+    cairo_set_source_rgb(cr, 0.13, 0.13, 0.13);
+    cairo_paint(cr);
+
+    float low, high;
+    graph_range(panel, &low, &high);
+
+    // Quarter grid lines
+    cairo_set_source_rgb(cr, 0.25, 0.25, 0.25);
+    cairo_set_line_width(cr, 1.0);
+    for (int i = 1; i < 4; i++) {
+        cairo_move_to(cr, 0, height * i / 4.0 + 0.5);
+        cairo_line_to(cr, width, height * i / 4.0 + 0.5);
+    }
+    cairo_stroke(cr);
+
+    cairo_set_line_width(cr, 1.5);
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, panel->history);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        ThermalHistory *history = value;
+        if (panel->selected && strcmp(key, panel->selected) != 0) continue;
+        const double *rgb = colors[history->color];
+        cairo_set_source_rgb(cr, rgb[0], rgb[1], rgb[2]);
+        draw_series(cr, history, low, high, width, height);
+
+        // The selected sensor's critical temperature as a dashed line
+        if (panel->selected && history->critical_celsius > 0) {
+            double y = height - (history->critical_celsius - low) / (high - low) * height;
+            double dash = 4.0;
+            cairo_set_source_rgb(cr, 0.96, 0.26, 0.21);
+            cairo_set_dash(cr, &dash, 1, 0);
+            cairo_move_to(cr, 0, y);
+            cairo_line_to(cr, width, y);
+            cairo_stroke(cr);
+            cairo_set_dash(cr, NULL, 0, 0);
+        }
+    }
+    return TRUE;
+}
+
+static void on_sensor_selected(GtkTreeSelection *selection, gpointer user_data) {
+    ThermalPanel *panel = user_data;
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+
+    g_clear_pointer(&panel->selected, g_free);
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        gtk_tree_model_get(model, &iter, THERMAL_COL_NAME, &panel->selected, -1);
+    }
+    update_graph(panel);
+}
+
+static void celsius_cell_data(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                              GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data) {
+    float celsius = 0;
+    gboolean valid = FALSE;
+    char text[32] = "-";
+    gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &celsius, THERMAL_COL_VALID, &valid, -1);
+    int column_id = GPOINTER_TO_INT(user_data);
+    gboolean shown = column_id == THERMAL_COL_CELSIUS ? valid :
+                     column_id == THERMAL_COL_CRITICAL ? celsius > 0 : !isnan(celsius);
+    if (shown) {
+        snprintf(text, sizeof(text), "%.1f °C", celsius);
+    }
+    g_object_set(renderer, "text", text, NULL);
+}
+
+static void add_thermal_column(GtkWidget *view, const char *title, int column_id) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column;
+
+    if (column_id <= THERMAL_COL_LABEL) {
+        column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column_id, NULL);
+    } else {
+        g_object_set(renderer, "xalign", 1.0, NULL);
+        column = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(column, title);
+        gtk_tree_view_column_pack_start(column, renderer, TRUE);
+        gtk_tree_view_column_set_cell_data_func(column, renderer, celsius_cell_data,
+                                                GINT_TO_POINTER(column_id), NULL);
+    }
+    if (column_id == THERMAL_COL_LABEL) {
+        gtk_tree_view_column_set_expand(column, TRUE);
+    }
+    gtk_tree_view_column_set_sort_column_id(column, column_id);
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+}
+
+static void on_thermal_panel_destroy(GtkWidget *widget, gpointer user_data) {
+    ThermalPanel *panel = user_data;
+    g_source_remove(panel->timer);
+    metrics_sampler_track_sensors(FALSE);
+    g_object_unref(panel->store);
+    g_hash_table_destroy(panel->history);
+    g_free(panel->selected);
+    g_free(panel->sets);
+    g_free(panel);
+}
+
+GtkWidget* thermal_panel_new(void) {
+    if (metrics_sampler_interval() == 0) {
+        return gtk_label_new("Temperatures: sampler not running");
+    }
+
+    ThermalPanel *panel = g_new0(ThermalPanel, 1);
+    panel->history = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    panel->sets = g_new(ThermalSensorSet, THERMAL_GRAPH_SAMPLES);
+    panel->store = gtk_list_store_new(THERMAL_N_COLUMNS,
+                                      G_TYPE_STRING, G_TYPE_STRING,
+                                      G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT, G_TYPE_FLOAT,
+                                      G_TYPE_BOOLEAN, G_TYPE_UINT);
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    panel->summary = gtk_label_new("Temperatures: waiting for the first sample");
+    gtk_label_set_xalign(GTK_LABEL(panel->summary), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), panel->summary, FALSE, FALSE, 0);
+
+    GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(panel->store));
+    add_thermal_column(view, "Sensor", THERMAL_COL_NAME);
+    add_thermal_column(view, "Label", THERMAL_COL_LABEL);
+    add_thermal_column(view, "Now", THERMAL_COL_CELSIUS);
+    add_thermal_column(view, "Min", THERMAL_COL_MIN);
+    add_thermal_column(view, "Max", THERMAL_COL_MAX);
+    add_thermal_column(view, "Critical", THERMAL_COL_CRITICAL);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(scrolled, -1, 150);
+    gtk_container_add(GTK_CONTAINER(scrolled), view);
+    gtk_box_pack_start(GTK_BOX(box), scrolled, TRUE, TRUE, 0);
+
+    panel->graph_label = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(panel->graph_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), panel->graph_label, FALSE, FALSE, 0);
+
+    GtkWidget *legend = gtk_label_new("Select a sensor to graph it alone against its critical temperature");
+    gtk_label_set_xalign(GTK_LABEL(legend), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), legend, FALSE, FALSE, 0);
+
+    panel->graph = gtk_drawing_area_new();
+    gtk_widget_set_size_request(panel->graph, -1, THERMAL_GRAPH_HEIGHT);
+    g_signal_connect(panel->graph, "draw", G_CALLBACK(on_graph_draw), panel);
+    gtk_box_pack_start(GTK_BOX(box), panel->graph, FALSE, FALSE, 0);
+
+    g_signal_connect(gtk_tree_view_get_selection(GTK_TREE_VIEW(view)), "changed",
+                     G_CALLBACK(on_sensor_selected), panel);
+
+    // Backfill from what the sampler already holds, then follow it
+    metrics_sampler_track_sensors(TRUE);
+    thermal_panel_tick(panel);
+    panel->timer = g_timeout_add(metrics_sampler_interval(), thermal_panel_tick, panel);
+    g_signal_connect(box, "destroy", G_CALLBACK(on_thermal_panel_destroy), panel);
+    return box;
+}
@@ -1,32 +1,209 @@
 #include "custom_shell.h"
 
-void add_to_history(AppData *app, const char *command) {
-    if (app->history_count < MAX_HISTORY) {
-        app->command_history[app->history_count] = g_strdup(command);
-        app->history_count++;
-    } else {
-        g_free(app->command_history[0]);
-        for (int i = 0; i < MAX_HISTORY - 1; i++) {
-            app->command_history[i] = app->command_history[i + 1];
+#define SHOW_HISTORY_ENTRIES 100
+#define HISTORY_QUERY_DEFAULT_LIMIT 20
+
+void add_to_history(AppData *app, const char *command, const HistoryRecord *record) {
+    history_store_append(app->history, command, record);
+    history_search_index_update(app->history_search);
+    app->history_index = history_store_count(app->history);
+}
+
+// Another window appended to the shared history file
+gboolean on_history_file_changed(gint fd, GIOCondition condition, gpointer user_data) {
+    AppData *app = user_data;
+    int previous = history_store_count(app->history);
+    
+    if (history_store_poll_changes(app->history) > 0) {
+        history_search_index_update(app->history_search);
+        // Keep Up-arrow starting from the newest entry, whoever ran it
+        if (app->history_index == previous) {
+            app->history_index = history_store_count(app->history);
         }
-        app->command_history[MAX_HISTORY - 1] = g_strdup(command);
     }
-    app->history_index = app->history_count - 1;
+    return G_SOURCE_CONTINUE;
 }
 
 void show_history(AppData *app) {
     GtkTextIter iter;
     gtk_text_buffer_get_end_iter(app->buffer, &iter);
     gtk_text_buffer_insert(app->buffer, &iter, "\nCommand History:\n", -1);
-    for (int i = 0; i < app->history_count; i++) {
-        char num[5];
-        snprintf(num, sizeof(num), "%d. ", i + 1);
-        gtk_text_buffer_insert(app->buffer, &iter, num, -1);
-        gtk_text_buffer_insert(app->buffer, &iter, app->command_history[i], -1);
-        gtk_text_buffer_insert(app->buffer, &iter, "\n", -1);
+    
+    // The history is unbounded, so only the most recent entries are listed
+    guint count = history_store_count(app->history);
+    guint first = count > SHOW_HISTORY_ENTRIES ? count - SHOW_HISTORY_ENTRIES : 0;
+    GString *text = g_string_new(NULL);
+    for (guint i = first; i < count; i++) {
+        gsize length;
+        const char *entry = history_store_peek(app->history, i, &length);
+        if (entry) {
+            g_string_append_printf(text, "%u. %.*s\n", i + 1, (int)length, entry);
+        }
+    }
+    gtk_text_buffer_insert(app->buffer, &iter, text->str, -1);
+    g_string_free(text, TRUE);
+}
+
+// "90", "30s", "15m", "2h", "1d", "1w" -> seconds, -1 if malformed
+static gint64 parse_age(const char *text) {
+    char *end;
+    gint64 value = g_ascii_strtoll(text, &end, 10);
+    if (end == text || value < 0) return -1;
+    switch (*end) {
+        case '\0': case 's': break;
+        case 'm': value *= 60; break;
+        case 'h': value *= 3600; break;
+        case 'd': value *= 86400; break;
+        case 'w': value *= 7 * 86400; break;
+        default: return -1;
+    }
+    return (*end && end[1]) ? -1 : value;
+}
+
+static void format_duration(char *buf, gsize size, guint32 ms) {
+    if (ms < 1000) {
+        snprintf(buf, size, "%ums", ms);
+    } else if (ms < 60000) {
+        snprintf(buf, size, "%.2fs", ms / 1000.0);
+    } else if (ms < 3600000) {
+        snprintf(buf, size, "%um%02us", ms / 60000, (ms / 1000) % 60);
+    } else {
+        snprintf(buf, size, "%uh%02um", ms / 3600000, (ms / 60000) % 60);
+    }
+}
+
+static void append_history_row(GString *text, AppData *app, guint id) {
+    HistoryRecord record;
+    char *command = history_store_dup(app->history, id);
+    if (!command || !history_store_get_record(app->history, id, &record)) {
+        g_free(command);
+        return;
+    }
+
+    g_string_append_printf(text, "%6u  ", id + 1);
+    if (record.exit_status == HISTORY_STATUS_UNKNOWN) {
+        // Entry from before metadata was recorded
+        g_string_append_printf(text, "%-16s  %8s  %-7s  %9s  ", "-", "-", "-", "-");
+    } else {
+        char when[32] = "-";
+        char took[32];
+        time_t start = record.start_time;
+        struct tm tm_start;
+        if (start && localtime_r(&start, &tm_start)) {
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M", &tm_start);
+        }
+        format_duration(took, sizeof(took), record.duration_ms);
+        char status[16];
+        if (record.exit_status == 0) {
+            g_strlcpy(status, "ok", sizeof(status));
+        } else {
+            snprintf(status, sizeof(status), "exit %d", record.exit_status);
+        }
+        char *size = g_format_size(record.output_bytes);
+        g_string_append_printf(text, "%-16s  %8s  %-7s  %9s  ", when, took, status, size);
+        g_free(size);
     }
+    g_string_append(text, command);
+
+    if (record.cwd) {
+        const char *home = g_get_home_dir();
+        gsize home_len = home ? strlen(home) : 0;
+        if (home_len > 1 && strncmp(record.cwd, home, home_len) == 0 &&
+            (record.cwd[home_len] == '/' || record.cwd[home_len] == '\0')) {
+            g_string_append_printf(text, "  [~%s]", record.cwd + home_len);
+        } else {
+            g_string_append_printf(text, "  [%s]", record.cwd);
+        }
+    }
+    g_string_append_c(text, '\n');
+    g_free(command);
 }
 
+// history [--failed] [--slowest] [--since AGE] [--cwd [DIR]] [-n N]
+void run_history_command(AppData *app, const char *args, GtkTextBuffer *buffer) {
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(buffer, &iter);
+
+    HistoryQuery query = { 0 };
+    query.limit = HISTORY_QUERY_DEFAULT_LIMIT;
+    char *cwd = NULL;
+    const char *error = NULL;
+
+    int argc = 0;
+    char **argv = NULL;
+    while (args && isspace((unsigned char)*args)) args++;
+    if (args && *args && !g_shell_parse_argv(args, &argc, &argv, NULL)) {
+        error = "history: could not parse arguments";
+    }
+
+    for (int i = 0; i < argc && !error; i++) {
+        if (strcmp(argv[i], "--failed") == 0) {
+            query.failed_only = TRUE;
+        } else if (strcmp(argv[i], "--slowest") == 0) {
+            query.slowest = TRUE;
+        } else if (strcmp(argv[i], "--since") == 0) {
+            gint64 age = (i + 1 < argc) ? parse_age(argv[++i]) : -1;
+            if (age < 0) {
+                error = "history: --since expects an age such as 30m, 2h, 1d or 1w";
+            } else {
+                query.since = g_get_real_time() / G_USEC_PER_SEC - age;
+            }
+        } else if (strcmp(argv[i], "--cwd") == 0) {
+            // Defaults to the current directory
+            const char *dir = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : ".";
+            g_free(cwd);
+            cwd = realpath(dir, NULL);
+            if (!cwd) cwd = g_strdup(dir);
+        } else if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--limit") == 0) {
+            // 0 means unlimited, so anything that is not a positive count is an error
+            const char *count = (i + 1 < argc) ? argv[++i] : "";
+            char *end = NULL;
+            errno = 0;
+            unsigned long limit = strtoul(count, &end, 10);
+            if (!isdigit((unsigned char)*count) || *end != '\0' || errno || limit == 0 || limit > G_MAXUINT) {
+                error = "history: -n expects a positive number of entries (--all for no limit)";
+            } else {
+                query.limit = (guint)limit;
+            }
+        } else if (strcmp(argv[i], "--all") == 0) {
+            query.limit = 0;
+        } else {
+            error = "Usage: history [--failed] [--slowest] [--since AGE] [--cwd [DIR]] [-n N | --all]";
+        }
+    }
+    g_strfreev(argv);
+
+    if (error) {
+        gtk_text_buffer_insert(buffer, &iter, error, -1);
+        gtk_text_buffer_insert(buffer, &iter, "\n", -1);
+        g_free(cwd);
+        return;
+    }
+
+    query.cwd = cwd;
+    gint64 started = g_get_monotonic_time();
+    GArray *ids = history_store_query(app->history, &query);
+    gint64 elapsed = g_get_monotonic_time() - started;
+
+    GString *text = g_string_new(NULL);
+    g_string_append_printf(text, "%u of %u entries (%.1f ms)\n", ids->len,
+                           history_store_count(app->history), elapsed / 1000.0);
+    if (query.slowest) {
+        for (guint i = 0; i < ids->len; i++) {
+            append_history_row(text, app, g_array_index(ids, guint, i));
+        }
+    } else {
+        // Oldest first, so the newest ends up next to the prompt
+        for (guint i = ids->len; i > 0; i--) {
+            append_history_row(text, app, g_array_index(ids, guint, i - 1));
+        }
+    }
+    gtk_text_buffer_insert(buffer, &iter, text->str, -1);
+
+    g_string_free(text, TRUE);
+    g_array_free(ids, TRUE);
+    g_free(cwd);
+}
 
 void destroy_app_data(AppData *app_data) {
     if (!app_data) return;
@@ -37,11 +214,16 @@ void destroy_app_data(AppData *app_data) {
         g_object_unref(app_data->css_provider);
     }
 
-    for (int i = 0; i < app_data->history_count; i++) {
-        if (app_data->command_history[i]) {
-            g_free(app_data->command_history[i]);
-        }
+    // The watch must not fire on the store's fd once it is closed
+    if (app_data->history_watch) {
+        g_source_remove(app_data->history_watch);
+    }
+    history_search_index_free(app_data->history_search);
+    history_store_close(app_data->history);
+    if (app_data->rsearch_query) {
+        g_string_free(app_data->rsearch_query, TRUE);
     }
+    g_free(app_data->rsearch_saved_text);
 
     clear_suggestions(app_data);
 